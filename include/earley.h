@@ -2,5 +2,6 @@
 #define EARLEY_H
 
 #include <earley/grammar.h>
+#include <earley/recognizer.h>
 
 #endif /* EARLEY_H */
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 #include <earley/export.h>
 #include <genericLogger.h>
@@ -54,14 +55,35 @@ typedef struct earleyGrammarRuleOption {
   int    minimumi;       /* Default: 0. Mininimum - must be 0 or 1                  */
 } earleyGrammarRuleOption_t;
 
+/* ---------------------------------------------------------------------- */
+/* Memory hooks. They are all given the allocatorUserDatavp general option */
+/* ---------------------------------------------------------------------- */
+typedef void *(*earleyGrammar_malloc_t)(void *userDatavp, size_t sizel);
+typedef void *(*earleyGrammar_realloc_t)(void *userDatavp, void *p, size_t sizel);
+typedef void  (*earleyGrammar_free_t)(void *userDatavp, void *p);
+
 /* --------------- */
 /* General options */
 /* --------------- */
 typedef struct earleyGrammarOption {
-  genericLogger_t *genericLoggerp;             /* Default: NULL.                                      */
-  short            warningIsErrorb;            /* Default: 0. Have precedence over warningIsIgnoredb  */
-  short            warningIsIgnoredb;          /* Default: 0.                                         */
-  short            autorankb;                  /* Default: 0.                                         */
+  genericLogger_t         *genericLoggerp;      /* Default: NULL.                                      */
+  short                    warningIsErrorb;     /* Default: 0. Have precedence over warningIsIgnoredb  */
+  short                    warningIsIgnoredb;   /* Default: 0.                                         */
+  short                    autorankb;           /* Default: 0.                                         */
+  earleyGrammar_malloc_t   mallocp;             /* Default: NULL. Must be set with reallocp and freep  */
+  earleyGrammar_realloc_t  reallocp;            /* Default: NULL.                                      */
+  earleyGrammar_free_t     freep;               /* Default: NULL.                                      */
+  void                    *allocatorUserDatavp; /* Default: NULL. User context of the memory hooks     */
+  short                    arenab;              /* Default: 0. Grammar memory comes from large chunks  */
+                                                /*             that are all released at once           */
+  size_t                   symbolCapacityl;     /* Default: 0. Expected number of symbols              */
+  size_t                   ruleCapacityl;       /* Default: 0. Expected number of rules                */
+  size_t                   rhsCapacityl;        /* Default: 0. Expected sum of all RHS lengths         */
+  short                    dfab;                /* Default: 0. Precompute also the split LR(0) epsilon */
+                                                /*             DFA, for a state-based recognizer       */
+  int                      nThreadi;            /* Default: 0. Threads sharing the precompute, 0 or 1  */
+                                                /*             meaning the calling thread only. Memory */
+                                                /*             hooks must then be thread-safe          */
 } earleyGrammarOption_t;
 
 typedef enum earleySymbolProperty {
@@ -81,10 +103,24 @@ typedef enum earleyRuleProperty {
   EARLEY_RULE_IS_PRODUCTIVE = 0x10
 } earleyRuleProperty_t;
 
+/* ----------------------------------------------------------------- */
+/* Precomputed sets are read-only bitsets of 64-bit words: bit i is  */
+/* in word i / 64 at position i % 64.                                */
+/* ----------------------------------------------------------------- */
+typedef uint64_t earleyGrammarBitWord_t;
+#define EARLEYGRAMMAR_BITWORD_BITS 64
+#define EARLEYGRAMMAR_BITSET_WORDL(bitl) (((size_t) (bitl) + EARLEYGRAMMAR_BITWORD_BITS - 1) / EARLEYGRAMMAR_BITWORD_BITS)
+#define EARLEYGRAMMAR_BITSET_GETB(bitSetp, biti) ((short) (((bitSetp)[(biti) / EARLEYGRAMMAR_BITWORD_BITS] >> ((biti) % EARLEYGRAMMAR_BITWORD_BITS)) & 1))
+
 typedef short (*earleyGrammar_grammarOptionSetter_t)(void *userDatavp, earleyGrammarOption_t *earleyGrammarOptionp);
 typedef short (*earleyGrammar_symbolOptionSetter_t)(void *userDatavp, int symboli, earleyGrammarSymbolOption_t *earleyGrammarSymbolOptionp);
 typedef short (*earleyGrammar_ruleOptionSetter_t)(void *userDatavp, int rulei, earleyGrammarRuleOption_t *earleyGrammarRuleOptionp);
 
+/* ----------------------------------------------------------------------- */
+/* Clone options. A clone shares the tables of its origin until it is      */
+/* modified: setters may only change symbol eventSeti and rule ranki and   */
+/* nullRanksHighb, anything else is an error.                              */
+/* ----------------------------------------------------------------------- */
 typedef struct earleyGrammarCloneOption {
   void                                *userDatavp;           /* Default: NULL. User context */
   earleyGrammar_grammarOptionSetter_t  grammarOptionSetterp; /* Default: NULL. Overwrite grammar option */
@@ -92,12 +128,90 @@ typedef struct earleyGrammarCloneOption {
   earleyGrammar_ruleOptionSetter_t     ruleOptionSetterp;    /* Default: NULL. Overwrite event rule option */
 } earleyGrammarCloneOption_t;
 
+/* ----------------------------------------------------------------------- */
+/* Tables of a precomputed grammar compiled in the program, as written by  */
+/* earleyGrammar_generateb: every pointer is a named static const array of */
+/* the generated file, NULL when empty. They are used in place, never      */
+/* copied nor validated. Pointers are in the order of the image sections.  */
+/* ----------------------------------------------------------------------- */
+#define EARLEYGRAMMAR_STATIC_VERSION 1
+
+typedef struct earleyGrammarStatic {
+  int                                versioni;          /* EARLEYGRAMMAR_STATIC_VERSION at generation */
+  int                                nSymboli;
+  int                                nRulei;
+  int                                nRhsi;
+  int                                startSymboli;
+  int                                nClosureRowi;
+  int                                nPredictionRowi;
+  int                                nNnfSymboli;
+  int                                nNnfRulei;
+  int                                nNnfRhsi;
+  int                                nDfaStatei;
+  int                                nDfaItemi;
+  int                                nDfaTransitioni;
+  int                                nLookaheadRowi;
+  const int                         *symbolPropertyBitSetip;
+  const int                         *symbolEventBitSetip;
+  const earleyGrammarSymbolOption_t *symbolOptionp;
+  const int                         *ruleLhsSymbolip;
+  const int                         *ruleRhsOffsetip;
+  const int                         *ruleRhsLengthip;
+  const int                         *rulePropertyBitSetip;
+  const earleyGrammarRuleOption_t   *ruleOptionp;
+  const int                         *rhsSymbolip;
+  const int                         *symbolLhsRuleOffsetip;
+  const int                         *lhsRuleip;
+  const int                         *symbolRhsRuleOffsetip;
+  const int                         *rhsRuleip;
+  const int                         *symbolClosureRowip;
+  const earleyGrammarBitWord_t      *closurep;
+  const int                         *symbolPredictionRowip;
+  const earleyGrammarBitWord_t      *predictionp;
+  const int                         *nnfRuleLhsSymbolip;
+  const int                         *nnfRuleRhsOffsetip;
+  const int                         *nnfRuleRhsLengthip;
+  const int                         *nnfRuleUserip;
+  const int                         *nnfRuleNulledip;
+  const int                         *nnfRhsSymbolip;
+  const int                         *dfaStateItemOffsetip;
+  const int                         *dfaItemRuleip;
+  const int                         *dfaItemDotip;
+  const int                         *dfaStateNonKernelip;
+  const int                         *dfaStateTransitionOffsetip;
+  const int                         *dfaTransitionSymbolip;
+  const int                         *dfaTransitionStateip;
+  const earleyGrammarBitWord_t      *firstp;
+  const int                         *dottedLookaheadRowip;
+  const earleyGrammarBitWord_t      *lookaheadp;
+} earleyGrammarStatic_t;
+
+/* Room for a grammar on static tables and for its core, e.g. a static or automatic variable */
+#define EARLEYGRAMMAR_STORAGE_WORDL 96
+
+typedef struct earleyGrammarStorage {
+  uint64_t wordp[EARLEYGRAMMAR_STORAGE_WORDL];
+} earleyGrammarStorage_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
   earley_EXPORT earleyGrammar_t *earleyGrammar_newp(earleyGrammarOption_t *earleyGrammarOptionp);
   earley_EXPORT earleyGrammar_t *earleyGrammar_clonep(earleyGrammar_t *earleyGrammarOriginp, earleyGrammarCloneOption_t *earleyGrammarCloneOptionp);
   earley_EXPORT void             earleyGrammar_freev(earleyGrammar_t *earleyGrammarp);
+  /* Binary image of a precomputed grammar. It is only portable between hosts with the same ABI. */
+  /* loadp maps the image and uses it in place; the returned grammar is precomputed.             */
+  earley_EXPORT short            earleyGrammar_saveb(earleyGrammar_t *earleyGrammarp, const char *pathp);
+  earley_EXPORT earleyGrammar_t *earleyGrammar_loadp(const char *pathp, earleyGrammarOption_t *earleyGrammarOptionp);
+  /* Same with an 8-byte aligned image in memory, that must outlive the grammar */
+  earley_EXPORT earleyGrammar_t *earleyGrammar_load_imagep(const void *imagep, size_t imagel, earleyGrammarOption_t *earleyGrammarOptionp);
+  /* Precomputed grammar on static tables. With a NULL storagep the grammar and its core are allocated, else they   */
+  /* are built in storagep and nothing is allocated: storagep must then outlive the grammar and its clones.        */
+  earley_EXPORT earleyGrammar_t *earleyGrammar_staticp(const earleyGrammarStatic_t *staticp, earleyGrammarStorage_t *storagep, earleyGrammarOption_t *earleyGrammarOptionp);
+  /* Writes the tables as named static const C arrays, with two constructors using earleyGrammar_staticp:         */
+  /* earleyGrammar_t *<prefixp>_newp(earleyGrammarOption_t *) and                                                 */
+  /* earleyGrammar_t *<prefixp>_initp(earleyGrammarStorage_t *, earleyGrammarOption_t *), that allocates nothing.   */
+  earley_EXPORT short            earleyGrammar_generateb(earleyGrammar_t *earleyGrammarp, const char *prefixp, const char *cPathp, const char *hPathp);
 
   earley_EXPORT short            earleyGrammar_errorb(earleyGrammar_t *earleyGrammarp, int *errorip);
   earley_EXPORT short            earleyGrammar_error_clearb(earleyGrammar_t *earleyGrammarp);
@@ -105,20 +219,66 @@ extern "C" {
   earley_EXPORT int              earleyGrammar_newSymboli(earleyGrammar_t *earleyGrammarp, earleyGrammarSymbolOption_t *earleyGrammarSymbolOptionp);
   earley_EXPORT short            earleyGrammar_symbolPropertyb(earleyGrammar_t *earleyGrammarp, int symboli, int *earleySymbolPropertyBitSetp);
   earley_EXPORT short            earleyGrammar_symbolEventb(earleyGrammar_t *earleyGrammarp, int symboli, int *earleySymbolEventBitSetp);
+  /* Runtime activation of events, on top of the event set of a symbol: the EARLEYGRAMMAR_EVENTTYPE_* bits of eventSeti */
+  /* are switched on or off. This costs a bit flip: the grammar stays precomputed and clones are not affected.          */
+  earley_EXPORT short            earleyGrammar_symbolEvent_activateb(earleyGrammar_t *earleyGrammarp, int symboli, int eventSeti, short activeb);
+  earley_EXPORT short            earleyGrammar_symbolEvent_activeb(earleyGrammar_t *earleyGrammarp, int symboli, int *eventSetip);
   earley_EXPORT int              earleyGrammar_newRulei(earleyGrammar_t *earleyGrammarp, earleyGrammarRuleOption_t *earleyGrammarRuleOptionp,
 										int lhsSymboli,
 										size_t rhsSymboll, int *rhsSymbolip
 										);
   earley_EXPORT short            earleyGrammar_rulePropertyb(earleyGrammar_t *earleyGrammarp, int rulei, int *earleyRulePropertyBitSetp);
+  /* Read-only view on the RHS of a rule: *rhsSymbolipp points to *rhsSymbollp symbol ids, valid until the next rule creation */
+  earley_EXPORT short            earleyGrammar_ruleRhsb(earleyGrammar_t *earleyGrammarp, int rulei, size_t *rhsSymbollp, const int **rhsSymbolipp);
   /* Handy methods to create symbols and rules that I find more user-friendly */
   earley_EXPORT int              earleyGrammar_newSymbolExti(earleyGrammar_t *earleyGrammarp, short terminalb, short startb, int eventSeti);
   earley_EXPORT int              earleyGrammar_newRuleExti(earleyGrammar_t *earleyGrammarp, int ranki, short nullRanksHighb, int lhsSymboli, ...);
   earley_EXPORT int              earleyGrammar_newSequenceExti(earleyGrammar_t *earleyGrammarp, int ranki, short nullRanksHighb,
 										       int lhsSymboli,
 										       int rhsSymboli, int minimumi, int separatorSymboli, short properb);
+  /* Bulk creation of symboll symbols and rulel rules, all or nothing.                                     */
+  /* - New symbols get consecutive ids starting at *firstSymbolip, and rules can already refer to them.    */
+  /* - RHS of rule k is rhsSymbolip[rhsOffsetip[k]] up to rhsSymbolip[rhsOffsetip[k+1]] excluded, i.e.     */
+  /*   rhsOffsetip has rulel+1 elements.                                                                   */
+  /* - symbolOptionp and ruleOptionp are either NULL (default options) or arrays of symboll/rulel options. */
+  earley_EXPORT short            earleyGrammar_newBulkb(earleyGrammar_t *earleyGrammarp,
+                                                        size_t symboll, earleyGrammarSymbolOption_t *symbolOptionp,
+                                                        size_t rulel, int *lhsSymbolip, int *rhsOffsetip, int *rhsSymbolip, earleyGrammarRuleOption_t *ruleOptionp,
+                                                        int *firstSymbolip, int *firstRuleip);
   
+  /* Symbols and rules can still be added to a precomputed grammar: precomputing it again with the same start   */
+  /* symbol then updates the tables from the new rules, unless an old terminal became a LHS:                    */
+  /* - properties, prediction rows, FIRST, FOLLOW and lookahead rows are updated incrementally, from what the   */
+  /*   new rules change. Unused lookahead rows are dropped by a full build once they are as many as used ones,  */
+  /* - the index, loops, normal form and, with the dfab option, the DFA are built again in full.                */
   earley_EXPORT short            earleyGrammar_precomputeb(earleyGrammar_t *earleyGrammarp);
   earley_EXPORT short            earleyGrammar_precompute_startb(earleyGrammar_t *earleyGrammarp, int starti);
+  /* Prediction closure of a symbol, on a precomputed grammar: the rules predicted when symboli is expected, */
+  /* and the symbols that can then be expected, symboli included. Terminals predict no rule.                 */
+  earley_EXPORT short            earleyGrammar_predictedRulesb(earleyGrammar_t *earleyGrammarp, int symboli, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp);
+  earley_EXPORT short            earleyGrammar_predictedSymbolsb(earleyGrammar_t *earleyGrammarp, int symboli, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp);
+  /* One-token lookahead over the terminals of a precomputed grammar, as bitsets of nSymboli+1 bits where bit   */
+  /* nSymboli is the end of input: FIRST of a symbol, and what can follow the dot before RHS position doti of a */
+  /* rule, doti being in [0, RHS length].                                                                       */
+  earley_EXPORT short            earleyGrammar_firstb(earleyGrammar_t *earleyGrammarp, int symboli, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp);
+  earley_EXPORT short            earleyGrammar_lookaheadb(earleyGrammar_t *earleyGrammarp, int rulei, int doti, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp);
+  /* Nihilist normal form of a precomputed grammar: no internal rule derives the empty string, a nullable RHS */
+  /* symbol is instead dropped in a variant of its rule. Rules with many nullables are factored (CHAF) with   */
+  /* internal symbols, numbered after the user symbols. Internal rule nnfRulei stands for user rule *ruleip   */
+  /* with *nulledip of its RHS symbols nulled, and completes it when its LHS is a user symbol.                */
+  earley_EXPORT short            earleyGrammar_nnfb(earleyGrammar_t *earleyGrammarp, int *nSymbolip, int *nRuleip);
+  earley_EXPORT short            earleyGrammar_nnfRuleb(earleyGrammar_t *earleyGrammarp, int nnfRulei, int *ruleip, int *lhsSymbolip, size_t *rhsSymbollp, const int **rhsSymbolipp, int *nulledip);
+  /* Split LR(0) epsilon-DFA of the normal form, when precomputed with the dfab option. State 0 is the start */
+  /* state. A state is a sorted list of (internal rule, dot position) items: kernel states have their dots   */
+  /* after the first position, and their predictions are the separate state *nonKernelStateip, or -1.       */
+  /* Goto on symboli gives *targetStateip, -1 when there is no transition.                                   */
+  earley_EXPORT short            earleyGrammar_dfab(earleyGrammar_t *earleyGrammarp, int *nStateip);
+  earley_EXPORT short            earleyGrammar_dfaStateb(earleyGrammar_t *earleyGrammarp, int statei, size_t *itemlp, const int **nnfRuleipp, const int **dotipp, int *nonKernelStateip);
+  earley_EXPORT short            earleyGrammar_dfaGotob(earleyGrammar_t *earleyGrammarp, int statei, int symboli, int *targetStateip);
+  /* Events triggered for the symbols whose event set asks for them: completed, then nulled, then expected, each */
+  /* by increasing symbol id, and the exhaustion last when exhaustionEventb is set. *eventpp points to a buffer  */
+  /* owned by the grammar, valid until the next call: it is reused, so polling does not allocate once it is     */
+  /* large enough. The buffer is filled again when something was triggered since, or when forceReloadb is set.  */
   earley_EXPORT short            earleyGrammar_eventb(earleyGrammar_t *earleyGrammarp, size_t *eventlp, earleyGrammarEvent_t **eventpp, short exhaustionEventb, short forceReloadb);
 #ifdef __cplusplus
 }
@@ -0,0 +1,123 @@
+#ifndef EARLEY_INTERNAL_GRAMMAR_H
+#define EARLEY_INTERNAL_GRAMMAR_H
+
+#include <errno.h>
+#include <limits.h>
+
+#include "earley/internal/structures.h"
+
+/* ------------------------------------------------------------------------ */
+/* Grammar internals that the recognizer shares. Nothing here is exported.  */
+/* ------------------------------------------------------------------------ */
+
+/* Event rows: completed, nulled and expected, like earleyGrammarEvent_t. */
+/* Row eventi is for the event type 1 << eventi.                         */
+#define EARLEYGRAMMAR_EVENT_ROWI 3
+
+short earleyGrammar_event_resetb(earleyGrammar_t *earleyGrammarp);
+
+/****************************************************************************/
+static inline int earleyGrammar_bitWord_counti(earleyGrammarBitWord_t wordl)
+/****************************************************************************/
+{
+#if defined(__GNUC__)
+  return __builtin_popcountll((unsigned long long) wordl);
+#else
+  int counti = 0;
+
+  while (wordl != 0) {
+    wordl &= wordl - 1;
+    counti++;
+  }
+  return counti;
+#endif
+}
+
+/****************************************************************************/
+static inline int earleyGrammar_bitWord_lowi(earleyGrammarBitWord_t wordl)
+/****************************************************************************/
+/* Lowest bit set of a non-zero word                                        */
+/****************************************************************************/
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll((unsigned long long) wordl);
+#else
+  int lowi = 0;
+
+  while ((wordl & 1) == 0) {
+    wordl >>= 1;
+    lowi++;
+  }
+  return lowi;
+#endif
+}
+
+/****************************************************************************/
+static inline uint64_t earleyGrammar_hash_mixl(uint64_t hashl)
+/****************************************************************************/
+/* Hash slots are low bits: fold the high bits in first, e.g. those of an  */
+/* FNV-1a or of a packed key (murmur3 finalizer).                          */
+/****************************************************************************/
+{
+  hashl ^= hashl >> 33;
+  hashl *= 0xff51afd7ed558ccdULL;
+  hashl ^= hashl >> 33;
+
+  return hashl;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_scratch_reserveb(earleyAllocator_t *allocatorp, void **pp, size_t *alloclp, size_t wantedl, size_t sizel)
+/****************************************************************************/
+/* Geometric growth of a scratch array, that never comes from the arena    */
+/****************************************************************************/
+{
+  size_t  allocl;
+  void   *p;
+
+  if (wantedl <= *alloclp) {
+    return 1;
+  }
+
+  if (wantedl > (size_t) INT_MAX) {
+    errno = ENOMEM;
+    return 0;
+  }
+  allocl = (*alloclp > 0) ? *alloclp : 16;
+  while (allocl < wantedl) {
+    allocl *= 2;
+  }
+
+  p = allocatorp->reallocp(allocatorp->userDatavp, *pp, allocl * sizel);
+  if (p == NULL) {
+    return 0;
+  }
+  *pp      = p;
+  *alloclp = allocl;
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_event_triggerv(earleyGrammar_t *earleyGrammarp, int eventi, int symboli)
+/****************************************************************************/
+/* eventi is EARLEYGRAMMAR_EVENT_COMPLETED, _NULLED or _EXPECTED. Masks are */
+/* applied on delivery, so that they can change in between.                */
+/* earleyGrammar_event_resetb() must have been called once before.          */
+/****************************************************************************/
+{
+  size_t wordl = EARLEYGRAMMAR_BITSET_WORDL(earleyGrammarp->nEventSymboli);
+
+  earleyGrammarp->eventBitSetp[(EARLEYGRAMMAR_EVENT_ROWI + (size_t) eventi) * wordl + symboli / EARLEYGRAMMAR_BITWORD_BITS] |= ((earleyGrammarBitWord_t) 1) << (symboli % EARLEYGRAMMAR_BITWORD_BITS);
+  earleyGrammarp->eventReloadb = 1;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_event_exhaustedv(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+{
+  earleyGrammarp->exhaustedb   = 1;
+  earleyGrammarp->eventReloadb = 1;
+}
+
+#endif /* EARLEY_INTERNAL_GRAMMAR_H */
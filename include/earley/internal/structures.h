@@ -1,65 +1,257 @@
 #ifndef EARLEY_INTERNAL_STRUCTURES_H
 #define EARLEY_INTERNAL_STRUCTURES_H
 
-#include <genericStack.h>
-
 #include "earley.h"
 
-typedef struct earleySymbol earleySymbol_t;
-typedef struct earleyRule   earleyRule_t;
-
-earleyGrammarOption_t earleyGrammarOptionDefault = {
-  0, /* warningIsErrorb */
-  0, /* warningIsIgnoredb */
-  0  /* autorankb */
+/* ------------------------------------------------------------------------ */
+/* Every byte owned by a grammar goes through its allocator. In arena mode  */
+/* memory is carved out of chunks of geometrically increasing size, it is  */
+/* never given back individually, and all chunks are released at once.     */
+/* ------------------------------------------------------------------------ */
+typedef struct earleyArenaChunk earleyArenaChunk_t;
+struct earleyArenaChunk {
+  earleyArenaChunk_t *nextp;   /* Previous chunk, i.e. the list goes backwards */
+  size_t              sizel;   /* Usable bytes after the header                */
+  size_t              usedl;   /* Used bytes after the header                  */
 };
 
-earleyGrammarCloneOption_t earleyGrammarCloneOptionDefault = {
-  NULL, /* userDatavp */
-  NULL, /* grammarOptionSetterp */
-  NULL, /* symbolOptionSetterp */
-  NULL /* ruleOptionSetterp */
-};
+typedef struct earleyAllocator {
+  earleyGrammar_malloc_t   mallocp;
+  earleyGrammar_realloc_t  reallocp;
+  earleyGrammar_free_t     freep;
+  void                    *userDatavp;
+  short                    arenab;
+  earleyArenaChunk_t      *chunkp;  /* Current chunk */
+} earleyAllocator_t;
 
-earleyGrammarSymbolOption_t earleyGrammarSymbolOptionDefault = {
-  0, /* terminalb */
-  0, /* startb */
-  EARLEYGRAMMAR_EVENTTYPE_NONE /* eventSeti */
-};
+/* ------------------------------------------------------------------------ */
+/* Symbols and rules are not objects: they are indexes into tables that are */
+/* stored as parallel arrays (struct-of-arrays). Every array of a table has */
+/* the same number of allocated slots, and is grown geometrically.          */
+/*                                                                          */
+/* Tables live in a core that is reference counted: clones share the core   */
+/* of their origin, which is then read-only. Any grammar about to modify a  */
+/* shared core first gets its own copy of it.                               */
+/* ------------------------------------------------------------------------ */
+/* Where the tables of a core come from */
+typedef enum earleyGrammarCoreImage {
+  EARLEYGRAMMARCORE_IMAGE_NONE = 0, /* Tables are owned by the core         */
+  EARLEYGRAMMARCORE_IMAGE_MMAP,     /* Tables point into a mapped file      */
+  EARLEYGRAMMARCORE_IMAGE_HEAP,     /* Tables point into a copy of the file */
+  EARLEYGRAMMARCORE_IMAGE_STATIC    /* Tables point into user memory        */
+} earleyGrammarCoreImage_t;
 
-earleyGrammarRuleOption_t earleyGrammarRuleOptionDefault = {
-   0, /* ranki */
-   0, /* nullRanksHighb */
-   0, /* sequenceb */
-  -1, /* separatorSymboli */
-   0, /* properb */
-   0  /* minimumi */
-};
+typedef struct earleyGrammarCore {
+  int                          refcounti;
+  earleyAllocator_t            allocator;
+  /* Read-only image the tables point into, if any */
+  earleyGrammarCoreImage_t     imagei;
+  void                        *imagep;
+  size_t                       imagel;
+  short                        storageb;               /* The core is in user storage: it is never freed */
+  /* Symbol table */
+  int                          nSymboli;               /* Number of symbols */
+  size_t                       symbolAllocl;           /* Allocated slots   */
+  int                         *symbolPropertyBitSetip;
+  int                         *symbolEventBitSetip;
+  earleyGrammarSymbolOption_t *symbolOptionp;
+  /* Rule table */
+  int                          nRulei;                 /* Number of rules   */
+  size_t                       ruleAllocl;             /* Allocated slots   */
+  int                         *ruleLhsSymbolip;
+  int                         *ruleRhsOffsetip;        /* Offset of the RHS in rhsSymbolip */
+  int                         *ruleRhsLengthip;        /* Length of the RHS                */
+  int                         *rulePropertyBitSetip;
+  earleyGrammarRuleOption_t   *ruleOptionp;
+  /* RHS pool: the RHS of all rules, back to back (compressed sparse rows) */
+  int                          nRhsi;                  /* Number of used slots */
+  size_t                       rhsAllocl;              /* Allocated slots      */
+  int                         *rhsSymbolip;
+  /* Precomputed indexes, in the same compressed sparse rows layout */
+  int                          startSymboli;           /* -1 when not precomputed */
+  int                          nPrecomputedSymboli;    /* Sizes at the last precompute, for incremental */
+  int                          nPrecomputedRulei;      /* updates: -1 when the tables are not valid     */
+  size_t                       precomputeGenerationl;  /* Incremented by every precompute, and kept by copies of the core */
+  int                         *symbolLhsRuleOffsetip;  /* nSymboli+1: rules of LHS s are lhsRuleip[offset[s]..offset[s+1][ */
+  int                         *lhsRuleip;              /* nRulei */
+  int                         *symbolRhsRuleOffsetip;  /* nSymboli+1: same for the RHS occurrences of s */
+  int                         *rhsRuleip;              /* nRhsi, one entry per RHS position */
+  /* Prediction closure. Symbols of a same cycle share their rows.  */
+  int                          nClosureRowi;
+  int                         *symbolClosureRowip;     /* nSymboli */
+  earleyGrammarBitWord_t      *closurep;               /* nClosureRowi rows of nSymboli bits */
+  int                          nPredictionRowi;        /* The last row is empty, for terminals */
+  int                         *symbolPredictionRowip;  /* nSymboli */
+  earleyGrammarBitWord_t      *predictionp;            /* nPredictionRowi rows of nRulei bits */
+  /* Lookahead, in rows of nSymboli+1 bits. Dotted rule (r, d) is number ruleRhsOffsetip[r]+r+d. */
+  earleyGrammarBitWord_t      *firstp;                 /* nClosureRowi rows, i.e. same row as the closure */
+  int                          nLookaheadRowi;
+  int                         *dottedLookaheadRowip;   /* nRhsi+nRulei */
+  earleyGrammarBitWord_t      *lookaheadp;             /* nLookaheadRowi rows */
+  int                         *symbolFollowRowip;      /* nSymboli: FOLLOW of nonterminals, for incremental updates. -1 for terminals, or empty */
+  int                          nLookaheadFullRowi;     /* Rows of the last full build: updates leave unused rows behind */
+  /* Nihilist normal form: internal rules, with symbols from nSymboli on being CHAF factors */
+  int                          nNnfSymboli;
+  int                          nNnfRulei;
+  int                          nNnfRhsi;
+  int                         *nnfRuleLhsSymbolip;     /* nNnfRulei */
+  int                         *nnfRuleRhsOffsetip;     /* nNnfRulei */
+  int                         *nnfRuleRhsLengthip;     /* nNnfRulei */
+  int                         *nnfRuleUserip;          /* nNnfRulei: the user rule */
+  int                         *nnfRuleNulledip;        /* nNnfRulei: number of nulled user RHS symbols */
+  int                         *nnfRhsSymbolip;         /* nNnfRhsi */
+  /* Split LR(0) epsilon-DFA on the normal form, nDfaStatei is 0 when not built */
+  int                          nDfaStatei;
+  int                          nDfaItemi;
+  int                          nDfaTransitioni;
+  int                         *dfaStateItemOffsetip;       /* nDfaStatei+1 */
+  int                         *dfaItemRuleip;              /* nDfaItemi: internal rule */
+  int                         *dfaItemDotip;               /* nDfaItemi: dot position */
+  int                         *dfaStateNonKernelip;        /* nDfaStatei: -1 when none */
+  int                         *dfaStateTransitionOffsetip; /* nDfaStatei+1 */
+  int                         *dfaTransitionSymbolip;      /* nDfaTransitioni, sorted within a state */
+  int                         *dfaTransitionStateip;       /* nDfaTransitioni */
+} earleyGrammarCore_t;
 
-struct earleySymbol {
-  int                         idi;
-  int                         propertyBitSeti;
-  int                         eventBitSeti;
-  earleyGrammarSymbolOption_t option;
+struct earleyGrammar {
+  earleyGrammarCore_t         *corep;
+  /* Per-grammar overlays, NULL unless a clone option setter changed something. */
+  /* They always have corep->nSymboli or corep->nRulei elements.                */
+  earleyGrammarSymbolOption_t *symbolOptionOverlayp;
+  int                         *symbolEventBitSetOverlayip;
+  earleyGrammarRuleOption_t   *ruleOptionOverlayp;
+  /* Grammar */
+  earleyAllocator_t            allocator;              /* For the overlays */
+  short                        storageb;               /* The grammar is in user storage: it is never freed */
+  int                          errori;
+  earleyGrammarOption_t        option;
+  short                        precomputedb;
+  /* Events. Rows of symbol bits, one per event type in the order of        */
+  /* earleyGrammarEvent_t: the effective event sets, and what was triggered. */
+  /* They are scratch arrays: they never come from the arena.                */
+  earleyGrammarBitWord_t      *eventBitSetp;           /* Masks, then triggers */
+  size_t                       eventBitSetl;           /* Allocated words */
+  int                          nEventSymboli;          /* Symbols in the rows, -1 when they must be built */
+  short                        exhaustedb;
+  short                        eventReloadb;           /* Triggers changed since the buffer was filled */
+  short                        eventExhaustionb;       /* exhaustionEventb of the last fill */
+  earleyGrammarEvent_t        *eventp;                 /* Reusable buffer given by earleyGrammar_eventb */
+  size_t                       eventl;                 /* Allocated events */
+  size_t                       nEventl;
 };
 
-struct earleyRule {
-  int                       idi;
-  earleySymbol_t           *lshSymbolp; /* Shallow */
-  genericStack_t            _rhsStack;
-  genericStack_t            *rhsStackp;
-  int                        propertyBitSeti;
-  earleyGrammarRuleOption_t  option;
-};
+/* ------------------------------------------------------------------------ */
+/* Recognizer. An Earley item is packed in 64 bits: the origin set in the   */
+/* high half, the dotted rule in the low one, numbered rule by rule. The    */
+/* index of a set is its earleme, unless sets are recycled: a set is then   */
+/* kept while it is current, or the origin of a kept set, or the start of a */
+/* token to scan. Set 0 is always kept.                                     */
+/* A sequence rule has three dotted rules, that are the states of its       */
+/* repetition: before the first item, after an item and after a separator.  */
+/* Each expects one symbol and can be complete too, so that a sequence is   */
+/* a single item per origin in a set, whatever its length.                  */
+/* The items of a set are contiguous. Once a set is complete, its items     */
+/* are grouped by postdot symbol, those without one first, and the groups   */
+/* are indexed by symbol: this is all completion and scanning need.         */
+/* A group with a single item, whose rule is then complete, is a            */
+/* deterministic reduction and gets a Leo item: the top of the chain of     */
+/* such reductions, that completion adds directly.                          */
+/* ------------------------------------------------------------------------ */
+typedef uint64_t earleyRecognizerItem_t;
 
-struct earleyGrammar {
-  genericStack_t        _symbolStack;
-  genericStack_t       *symbolStackp;
-  genericStack_t        _ruleStack;
-  genericStack_t       *ruleStackp;
-  int                   errori;
-  earleyGrammarOption_t option;
-  short                 precomputedb;
+/* A terminal read in set startSetl and not yet scanned: this is done when  */
+/* the set at earleme endl is opened.                                       */
+typedef struct earleyRecognizerToken {
+  int                          symboli;
+  size_t                       startSetl;
+  size_t                       endl;
+  size_t                       readl;                  /* Terminals read before it */
+} earleyRecognizerToken_t;
+
+typedef struct earleyRecognizerSet {
+  earleyRecognizerItem_t      *itemp;
+  size_t                       iteml;                  /* Allocated items */
+  int                          nItemi;
+  int                         *postdotip;              /* nPostdoti (symbol, first item) pairs, sorted by symbol */
+  size_t                       postdotl;               /* Allocated ints */
+  int                          nPostdoti;
+  earleyRecognizerItem_t      *leop;                   /* nPostdoti Leo items, all bits set when none */
+  size_t                       leol;                   /* Allocated items */
+  size_t                       earlemel;
+  /* When recognizing only: references to the set, and the distinct origin */
+  /* sets of its items, that it references. Items expecting a nonterminal  */
+  /* can be completed at any later earleme, and keep their origin sets as  */
+  /* long as the set lives. Items expecting a terminal can only be scanned */
+  /* while the set is pinned, i.e. current or the start of a pending       */
+  /* token: their origin sets are released when it is not anymore.         */
+  int                          refcounti;              /* Pins included */
+  int                          pinCounti;
+  size_t                       refStampl;              /* Stamp of the last set that referenced it */
+  size_t                      *originSetlp;
+  size_t                       originSetl;             /* Allocated origin sets */
+  size_t                       nOriginSetl;
+  size_t                       scanStampl;             /* Same, for the origins of items expecting a terminal */
+  size_t                      *scanOriginSetlp;
+  size_t                       scanOriginSetl;
+  size_t                       nScanOriginSetl;
+} earleyRecognizerSet_t;
+
+struct earleyRecognizer {
+  earleyGrammar_t             *earleyGrammarp;
+  earleyGrammarCore_t         *corep;                  /* The core at creation: the grammar must keep it */
+  size_t                       precomputeGenerationl;  /* The one of the core at creation: the tables are sized for it */
+  earleyAllocator_t            allocator;              /* The one of the grammar. Nothing comes from the arena */
+  earleyRecognizerOption_t     option;
+  /* Dotted rules */
+  int                          nDottedi;
+  int                         *ruleDottedip;           /* nRulei: first dotted rule */
+  int                         *dottedRuleip;           /* nDottedi */
+  int                         *dottedPostdotip;        /* nDottedi: symbol after the dot, -1 at the end */
+  int                         *dottedNextip;           /* nDottedi: dotted rule after the postdot symbol, -1 at the end */
+  char                        *dottedCompletedbp;      /* nDottedi: the rule is complete */
+  /* Work done in the open set, stamped with the number of sets opened  */
+  /* so far: it only increases, even across resets.                     */
+  size_t                       stampl;
+  size_t                      *rowStamplp;             /* nPredictionRowi */
+  size_t                      *ruleStamplp;            /* nRulei */
+  size_t                      *symbolStamplp;          /* nSymboli+1: grouping, completed items being symbol -1 */
+  int                         *symbolCountip;          /* nSymboli+1 */
+  /* Sets. Those not kept are recycled with their arrays, when recognizing only */
+  earleyRecognizerSet_t       *setp;
+  size_t                       setl;                   /* Allocated sets */
+  size_t                       nSetl;                  /* Sets ever used */
+  size_t                      *freeSetlp;              /* Recycled sets, room for nSetl */
+  size_t                       freeSetl;               /* Allocated */
+  size_t                       nFreeSetl;
+  size_t                       currentSetl;
+  size_t                       openSetl;               /* Receiving items, while moving to the next earleme */
+  size_t                       earlemel;               /* Current earleme */
+  /* Terminals read and not yet scanned */
+  earleyRecognizerToken_t     *tokenp;
+  size_t                       tokenl;                 /* Allocated tokens */
+  size_t                       nTokenl;
+  size_t                       nReadl;                 /* Terminals read */
+  size_t                       nResetl;                /* Resets: checkpoints from before the last one are stale */
+  /* Terminals scanned, by earleme, so that rewinding can restore them. */
+  /* Not kept when recognizing only.                                    */
+  earleyRecognizerToken_t     *scannedp;
+  size_t                       scannedl;               /* Allocated tokens */
+  size_t                       nScannedl;
+  /* Duplicate detection in the open set: open addressing on packed items, */
+  /* and the used slots so that clearing costs what was inserted.          */
+  earleyRecognizerItem_t      *hashp;
+  size_t                       hashl;                  /* Slots, a power of two */
+  size_t                      *hashSlotlp;
+  size_t                       hashSlotl;              /* Allocated */
+  size_t                       nHashSlotl;
+  /* Grouping scratch */
+  earleyRecognizerItem_t      *groupp;
+  size_t                       groupl;
+  int                         *groupSymbolip;
+  size_t                       groupSymboll;
+  short                        acceptedb;
+  short                        exhaustedb;
+  earleyGrammarBitWord_t      *expectedBitSetp;        /* nSymboli bits: terminals expected in the current set */
 };
 
 #endif /* EARLEY_INTERNAL_STRUCTURES_H */
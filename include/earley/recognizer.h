@@ -0,0 +1,79 @@
+#ifndef EARLEY_RECOGNIZER_H
+#define EARLEY_RECOGNIZER_H
+
+#include <stddef.h>
+
+#include <earley/export.h>
+#include <earley/grammar.h>
+#include <genericLogger.h>
+
+/* ---------------- */
+/* Opaque structure */
+/* ---------------- */
+typedef struct earleyRecognizer earleyRecognizer_t;
+
+/* --------------- */
+/* General options */
+/* --------------- */
+typedef struct earleyRecognizerOption {
+  genericLogger_t *genericLoggerp;   /* Default: NULL. */
+  short            recognizeOnlyb;   /* Default: 0. Accept/reject and events only: Earley sets that cannot be referenced anymore are */
+                                     /* recycled, so that memory is bounded by the live origin window, not by the input length.     */
+} earleyRecognizerOption_t;
+
+/* ---------------------------------------------------- */
+/* Alternative terminal, spanning lengthl earlemes >= 1 */
+/* ---------------------------------------------------- */
+typedef struct earleyRecognizerAlternative {
+  int    symboli;
+  size_t lengthl;
+} earleyRecognizerAlternative_t;
+
+/* ----------------------------------------------------------------------- */
+/* Checkpoint: the current earleme and the number of terminals read so far */
+/* ----------------------------------------------------------------------- */
+typedef struct earleyRecognizerCheckpoint {
+  size_t earlemel;
+  size_t readl;
+  size_t resetl;   /* Number of resets, so that a checkpoint from before one is rejected */
+} earleyRecognizerCheckpoint_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  /* A recognizer runs a precomputed grammar, that must outlive it and must not be modified in the meantime. */
+  /* Memory comes from the hooks of the grammar. Events are given by earleyGrammar_eventb() on the grammar,  */
+  /* and are those of the current earleme.                                                                   */
+  earley_EXPORT earleyRecognizer_t *earleyRecognizer_newp(earleyGrammar_t *earleyGrammarp, earleyRecognizerOption_t *earleyRecognizerOptionp);
+  earley_EXPORT void                earleyRecognizer_freev(earleyRecognizer_t *earleyRecognizerp);
+  /* Back to earleme 0, for another input. Allocated memory is kept: once a parse as large has run, nothing is allocated. */
+  earley_EXPORT short               earleyRecognizer_resetb(earleyRecognizer_t *earleyRecognizerp);
+  /* Reads a terminal of length 1 at the current earleme. It can be called several times per earleme, for ambiguous tokens. */
+  /* Returns 0 with errno set to ENOENT when the terminal is not expected: the recognizer is left unchanged.                */
+  earley_EXPORT short               earleyRecognizer_readb(earleyRecognizer_t *earleyRecognizerp, int symboli);
+  /* Reads all the alternatives at the current earleme, each with its length, and moves to the next earleme, in one pass.  */
+  /* Alternatives that are not expected are ignored. Returns 0 with errno set to ENOENT when none is: the recognizer is     */
+  /* left unchanged.                                                                                                        */
+  earley_EXPORT short               earleyRecognizer_alternativesb(earleyRecognizer_t *earleyRecognizerp, earleyRecognizerAlternative_t *alternativep, size_t nAlternativel);
+  /* Moves to the next earleme, with what was read and ends there. Nothing that ends at or after it means that the          */
+  /* recognizer is exhausted.                                                                                               */
+  earley_EXPORT short               earleyRecognizer_completeb(earleyRecognizer_t *earleyRecognizerp);
+  earley_EXPORT short               earleyRecognizer_earlemeb(earleyRecognizer_t *earleyRecognizerp, size_t *earlemelp);
+  earley_EXPORT short               earleyRecognizer_acceptedb(earleyRecognizer_t *earleyRecognizerp, short *acceptedbp);
+  earley_EXPORT short               earleyRecognizer_exhaustedb(earleyRecognizer_t *earleyRecognizerp, short *exhaustedbp);
+  /* Speculative parsing: rewinding goes back to the state at the checkpoint, in a time proportional to what is undone.  */
+  /* A checkpoint is valid until the recognizer is reset, or rewound to an earlier one: rewinding to a checkpoint from   */
+  /* before a reset fails with errno set to EINVAL. Both fail the same way when recognizing only, since the Earley sets  */
+  /* are then not all kept.                                                                                              */
+  earley_EXPORT short               earleyRecognizer_checkpointb(earleyRecognizer_t *earleyRecognizerp, earleyRecognizerCheckpoint_t *checkpointp);
+  earley_EXPORT short               earleyRecognizer_rewindb(earleyRecognizer_t *earleyRecognizerp, earleyRecognizerCheckpoint_t *checkpointp);
+  /* Terminals expected at the current earleme, as a bitset of nSymboli bits, e.g. for a lexer to try only those. It is */
+  /* owned by the recognizer and updated in place when moving to another earleme: the pointer stays valid.               */
+  earley_EXPORT short               earleyRecognizer_expectedTerminalsb(earleyRecognizer_t *earleyRecognizerp, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp);
+  /* Number of Earley items of the set at earleme earlemel */
+  earley_EXPORT short               earleyRecognizer_itemCountb(earleyRecognizer_t *earleyRecognizerp, size_t earlemel, size_t *itemlp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EARLEY_RECOGNIZER_H */
@@ -0,0 +1,55 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <genericLogger.h>
+
+#include "earley/grammar.h"
+
+/****************************************************************************/
+/* Usage: earleyGrammarToC image prefix output.c output.h                   */
+/*                                                                          */
+/* image is a precomputed grammar from earleyGrammar_saveb. The generated   */
+/* files define <prefix>_newp() and <prefix>_initp(), which return the      */
+/* grammar without building nor precomputing it: its tables are named       */
+/* static const arrays, and <prefix>_initp() allocates nothing.             */
+/****************************************************************************/
+int main(int argc, char **argv)
+{
+  genericLogger_t       *genericLoggerp;
+  earleyGrammarOption_t  earleyGrammarOption;
+  earleyGrammar_t       *earleyGrammarp = NULL;
+  int                    rci;
+
+  if (argc != 5) {
+    fprintf(stderr, "Usage: %s image prefix output.c output.h\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  genericLoggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_WARNING);
+
+  memset(&earleyGrammarOption, 0, sizeof(earleyGrammarOption));
+  earleyGrammarOption.genericLoggerp = genericLoggerp;
+
+  earleyGrammarp = earleyGrammar_loadp(argv[1], &earleyGrammarOption);
+  if (earleyGrammarp == NULL) {
+    fprintf(stderr, "%s: cannot load grammar image, %s\n", argv[1], strerror(errno));
+    goto err;
+  }
+
+  if (! earleyGrammar_generateb(earleyGrammarp, argv[2], argv[3], argv[4])) {
+    fprintf(stderr, "%s: generation failure\n", argv[1]);
+    goto err;
+  }
+
+  rci = EXIT_SUCCESS;
+  goto done;
+
+ err:
+  rci = EXIT_FAILURE;
+
+ done:
+  earleyGrammar_freev(earleyGrammarp);
+  GENERICLOGGER_FREE(genericLoggerp);
+  return rci;
+}
@@ -1,18 +1,415 @@
 #include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <genericLogger.h>
-#include <genericStack.h>
 
 #include "earley/grammar.h"
 #include "earley/internal/config.h"
 #include "earley/internal/structures.h"
+#include "earley/internal/grammar.h"
 
-static inline earleySymbol_t *earleySymbol_getp(earleyGrammar_t *earleyGrammarp, int symboli);
-static inline earleyRule_t   *earleyRule_getp(earleyGrammar_t *earleyGrammarp, int rulei);
-static inline void            earleySymbol_freev(earleySymbol_t *earleySymbolp);
-static inline void            earleyRule_freev(earleyRule_t *earleyRulep);
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_FCNTL_H) && defined(HAVE_UNISTD_H)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define EARLEYGRAMMAR_IMAGE_MMAP 1
+#endif
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#define EARLEYGRAMMAR_THREAD 1
+#endif
+
+earleyGrammarOption_t earleyGrammarOptionDefault = {
+  NULL, /* genericLoggerp */
+  0,    /* warningIsErrorb */
+  0,    /* warningIsIgnoredb */
+  0,    /* autorankb */
+  NULL, /* mallocp */
+  NULL, /* reallocp */
+  NULL, /* freep */
+  NULL, /* allocatorUserDatavp */
+  0,    /* arenab */
+  0,    /* symbolCapacityl */
+  0,    /* ruleCapacityl */
+  0,    /* rhsCapacityl */
+  0,    /* dfab */
+  0     /* nThreadi */
+};
+
+earleyGrammarCloneOption_t earleyGrammarCloneOptionDefault = {
+  NULL, /* userDatavp */
+  NULL, /* grammarOptionSetterp */
+  NULL, /* symbolOptionSetterp */
+  NULL /* ruleOptionSetterp */
+};
+
+earleyGrammarSymbolOption_t earleyGrammarSymbolOptionDefault = {
+  0, /* terminalb */
+  0, /* startb */
+  EARLEYGRAMMAR_EVENTTYPE_NONE /* eventSeti */
+};
+
+earleyGrammarRuleOption_t earleyGrammarRuleOptionDefault = {
+   0, /* ranki */
+   0, /* nullRanksHighb */
+   0, /* sequenceb */
+  -1, /* separatorSymboli */
+   0, /* properb */
+   0  /* minimumi */
+};
+
+static inline void *earleyAllocator_default_mallocp(void *userDatavp, size_t sizel);
+static inline void *earleyAllocator_default_reallocp(void *userDatavp, void *p, size_t sizel);
+static inline void  earleyAllocator_default_freev(void *userDatavp, void *p);
+static inline short earleyAllocator_initb(earleyAllocator_t *earleyAllocatorp, earleyGrammarOption_t *optionp);
+static inline void *earleyAllocator_mallocp(earleyAllocator_t *earleyAllocatorp, size_t sizel);
+static inline void *earleyAllocator_reallocp(earleyAllocator_t *earleyAllocatorp, void *p, size_t oldl, size_t newl);
+static inline void  earleyAllocator_freev(earleyAllocator_t *earleyAllocatorp, void *p);
+static inline void  earleyAllocator_releasev(earleyAllocator_t *earleyAllocatorp);
+static inline earleyGrammarCore_t *earleyGrammarCore_newp(earleyAllocator_t *allocatorp);
+static inline void                 earleyGrammarCore_initv(earleyGrammarCore_t *corep, earleyAllocator_t *allocatorp);
+static inline void                 earleyGrammarCore_unrefv(earleyGrammarCore_t *corep);
+static inline earleyGrammar_t     *earleyGrammar_allocp(earleyGrammarOption_t *optionp);
+static inline void                 earleyGrammar_initv(earleyGrammar_t *earleyGrammarp, earleyAllocator_t *allocatorp, earleyGrammarOption_t *optionp);
+static inline short                earleyGrammar_core_ownb(earleyGrammar_t *earleyGrammarp);
+static inline short                earleyGrammar_symbolOverlay_ensureb(earleyGrammar_t *earleyGrammarp);
+static inline short                earleyGrammar_ruleOverlay_ensureb(earleyGrammar_t *earleyGrammarp);
+static inline int                  earleyGrammar_symbolEvent_computei(earleyGrammarSymbolOption_t *optionp);
+static inline uint64_t             earleyGrammar_image_checksuml(uint64_t checksuml, const void *p, size_t sizel);
+static inline const void          *earleyGrammar_image_sectionp(earleyGrammar_t *earleyGrammarp, int sectioni, size_t *sizelp);
+static inline void                *earleyGrammar_image_buildp(earleyGrammar_t *earleyGrammarp, size_t *imagelp);
+static inline void                *earleyGrammar_image_readp(earleyGrammar_t *earleyGrammarp, const char *pathp, size_t *sizelp, earleyGrammarCoreImage_t *imageip);
+static inline short                earleyGrammar_image_openb(earleyGrammar_t *earleyGrammarp, earleyGrammarCore_t *corep);
+static inline short                earleyGrammar_static_openb(earleyGrammar_t *earleyGrammarp, earleyGrammarCore_t *corep, const earleyGrammarStatic_t *staticp);
+static inline void                 earleyGrammar_static_writev(FILE *fp, const char *prefixp, int sectioni, const void *p, size_t sizel);
+static inline short earleySymbol_existb(earleyGrammar_t *earleyGrammarp, int symboli);
+static inline short earleyRule_existb(earleyGrammar_t *earleyGrammarp, int rulei);
+static inline short earleyGrammar_symbolTable_reserveb(earleyGrammar_t *earleyGrammarp, size_t wantedl);
+static inline short earleyGrammar_ruleTable_reserveb(earleyGrammar_t *earleyGrammarp, size_t wantedl);
+static inline short earleyGrammar_rhsPool_reserveb(earleyGrammar_t *earleyGrammarp, size_t wantedl);
+static inline short earleyGrammar_rule_checkb(earleyGrammar_t *earleyGrammarp, earleyGrammarRuleOption_t *optionp, int lhsSymboli, int rhsSymboli, int *rhsSymbolip, int nSymboli);
+static inline void  earleyGrammar_rule_storev(earleyGrammar_t *earleyGrammarp, earleyGrammarRuleOption_t *optionp, int lhsSymboli, int rhsOffseti, int rhsSymboli);
+static inline short earleyGrammar_image_indexb(int *offsetip, int nOffseti, int *entryip, int nEntryi, int maxi);
+static inline short earleyGrammar_precompute_indexb(earleyGrammar_t *earleyGrammarp);
+static inline void  earleyGrammar_precompute_propagatev(earleyGrammarCore_t *corep, int *counterip, int *worklistip, int nWorklisti, int symbolPropertyi, int rulePropertyi);
+static inline short earleyGrammar_sccb(earleyAllocator_t *allocatorp, int nNodei, int *offsetip, int *targetip, int *componentip, int *nComponentip);
+static inline short earleyGrammar_precompute_loopb(earleyGrammar_t *earleyGrammarp, short *warningbp);
+static inline short earleyGrammar_precompute_predictionb(earleyGrammar_t *earleyGrammarp);
+static inline void  earleyGrammar_bitset_orv(earleyGrammarBitWord_t *restrict dstp, const earleyGrammarBitWord_t *restrict srcp, size_t wordl);
+static inline short earleyGrammar_image_rowb(int *rowip, int nRowi, int maxi);
+static inline short earleyGrammar_precompute_nnfb(earleyGrammar_t *earleyGrammarp);
+static inline void  earleyGrammar_nnf_rulev(earleyGrammarCore_t *corep, int passi, int lhsSymboli, int *rhsSymbolip, int rhsSymboli, int userRulei, int nulledi);
+static inline short earleyGrammar_precompute_dfab(earleyGrammar_t *earleyGrammarp);
+static inline int   earleyGrammar_dfa_item_cmpi(const void *p1, const void *p2);
+static inline int   earleyGrammar_dfa_pair_cmpi(const void *p1, const void *p2);
+static inline uint64_t earleyGrammar_dfa_hashl(const int *itemip, int nItemi);
+static inline short earleyGrammar_precompute_lookaheadb(earleyGrammar_t *earleyGrammarp);
+static inline void  earleyGrammar_precompute_separatorv(earleyGrammarCore_t *corep, int *separatorOffsetip, int *separatorip);
+static inline void  earleyGrammar_precompute_nonEmptyv(earleyGrammarCore_t *corep, char *nonEmptybp, int *worklistip, int nWorklisti, int *separatorOffsetip, int *separatorip, char *symbolFlagbp);
+static inline short earleyGrammar_precompute_rule_nonEmptyb(earleyGrammarCore_t *corep, int rulei, char *nonEmptybp);
+static inline void  earleyGrammar_precompute_accessiblev(earleyGrammarCore_t *corep, int *worklistip, int nWorklisti);
+static inline short earleyGrammar_precompute_propertyb(earleyGrammar_t *earleyGrammarp, int starti);
+static inline short earleyGrammar_incremental_ruleb(earleyGrammarCore_t *corep, int rulei, int symbolPropertyi);
+static inline void  earleyGrammar_incremental_propagatev(earleyGrammarCore_t *corep, int *worklistip, int nWorklisti, int firstRulei, int symbolPropertyi, int rulePropertyi,
+                                                         int *ruleip, int *nRuleip, char *symbolFlagbp, char flagb);
+static inline short earleyGrammar_precompute_incrementalb(earleyGrammar_t *earleyGrammarp, int starti, short *incrementalbp);
+static inline short earleyGrammar_incremental_predictionb(earleyGrammar_t *earleyGrammarp, int firstSymboli, int firstRulei, int *productiveRuleip, int nProductiveRulei, int *edgeRuleip, int nEdgeRulei);
+static inline short earleyGrammar_incremental_lookaheadb(earleyGrammar_t *earleyGrammarp, int firstSymboli, int firstRulei, int *oldSymbolPropertyip, int *oldRulePropertyip, short *donebp);
+static inline void  earleyGrammar_lookahead_widenv(earleyGrammarBitWord_t *dstp, size_t wordl, const earleyGrammarBitWord_t *srcp, size_t oldWordl, int oldEndi, int endi);
+static inline short earleyGrammar_event_maskb(earleyGrammar_t *earleyGrammarp);
+
+/* Parallel precompute: a job runs once per thread, that owns one slice of */
+/* the work. Slices depend only on the number of threads, and a job never  */
+/* reads what another slice writes, so that results are always the same.   */
+#define EARLEYGRAMMAR_THREAD_MAX   64
+#define EARLEYGRAMMAR_THREAD_WORDL 32     /* Minimum columns of a slice, in words */
+#define EARLEYGRAMMAR_THREAD_RULEL 4096   /* Minimum rules of a slice             */
+
+typedef void (*earleyGrammar_job_t)(void *contextp, int threadi, int nThreadi);
+
+typedef struct earleyGrammarThread {
+  earleyGrammar_job_t  jobp;
+  void                *contextp;
+  int                  threadi;
+  int                  nThreadi;
+} earleyGrammarThread_t;
+
+static inline int   earleyGrammar_thread_counti(earleyGrammar_t *earleyGrammarp, size_t workl, size_t minWorkl);
+static inline void  earleyGrammar_thread_slicev(size_t workl, int threadi, int nThreadi, size_t *firstlp, size_t *endlp);
+static inline void  earleyGrammar_thread_runv(earleyGrammar_job_t jobp, void *contextp, int nThreadi);
+#ifdef EARLEYGRAMMAR_THREAD
+static void        *earleyGrammar_thread_startp(void *argp);
+#endif
+
+/* Closure and prediction rows, by slices of columns */
+typedef struct earleyGrammarClosureJob {
+  earleyGrammarCore_t *corep;
+  int                  nComponenti;
+  int                  nPredictionRowi;
+  int                 *edgeOffsetip;
+  int                 *edgeTargetip;
+  int                 *componentip;
+  int                 *memberOffsetip;
+  int                 *memberip;
+  int                 *seenip;              /* nSymboli+1 per thread */
+} earleyGrammarClosureJob_t;
+
+static inline void earleyGrammar_closure_jobv(void *contextp, int threadi, int nThreadi);
+
+/* What changed during an incremental precompute, by symbol and by rule */
+#define EARLEYGRAMMAR_INCREMENTAL_NULLABLE   0x01
+#define EARLEYGRAMMAR_INCREMENTAL_PRODUCTIVE 0x02
+#define EARLEYGRAMMAR_INCREMENTAL_NONEMPTY   0x04
+#define EARLEYGRAMMAR_INCREMENTAL_ACCESSIBLE 0x08
+#define EARLEYGRAMMAR_INCREMENTAL_FIRST      0x10   /* FIRST or nullability */
+#define EARLEYGRAMMAR_INCREMENTAL_FOLLOW     0x20
+#define EARLEYGRAMMAR_INCREMENTAL_QUEUED     0x40
+#define EARLEYGRAMMAR_INCREMENTAL_NULLING    0x01
+#define EARLEYGRAMMAR_INCREMENTAL_EDGE       0x02
+#define EARLEYGRAMMAR_INCREMENTAL_LOOKAHEAD  0x04
+
+/* Scratch state of the DFA construction */
+typedef struct earleyGrammarDfaBuild {
+  earleyAllocator_t *allocatorp;
+  int               *stateItemOffsetip;
+  size_t             stateItemOffsetl;
+  int               *stateItemip;
+  size_t             stateIteml;
+  int               *stateNonKernelip;
+  size_t             stateNonKernell;
+  int               *stateTransitionOffsetip;
+  size_t             stateTransitionOffsetl;
+  int               *transitionSymbolip;
+  size_t             transitionSymboll;
+  int               *transitionStateip;
+  size_t             transitionStatel;
+  int               *haship;                  /* Open addressing on the items of the states */
+  size_t             hashl;                   /* Power of 2 */
+  int                nStatei;
+  int                nStateItemi;
+  int                nTransitioni;
+} earleyGrammarDfaBuild_t;
+
+static inline int earleyGrammar_dfa_statei(earleyGrammarDfaBuild_t *buildp, int nNewItemi);
+
+/* Deduplicated bitset rows */
+typedef struct earleyGrammarRowSet {
+  earleyAllocator_t      *allocatorp;
+  size_t                  wordl;                /* Words per row */
+  earleyGrammarBitWord_t *rowp;
+  size_t                  rowl;                 /* Allocated words */
+  int                     nRowi;
+  uint64_t               *rowHashlp;            /* Hash of every row */
+  size_t                  rowHashl;             /* Allocated hashes */
+  int                    *haship;               /* Open addressing on the rows */
+  size_t                  hashl;                /* Power of 2 */
+} earleyGrammarRowSet_t;
+
+static inline int earleyGrammar_rowSet_addi(earleyGrammarRowSet_t *rowSetp, const earleyGrammarBitWord_t *rowp);
+static inline int earleyGrammar_rowSet_add_hashi(earleyGrammarRowSet_t *rowSetp, const earleyGrammarBitWord_t *rowp, uint64_t rowHashl);
+
+/* FIRST and FOLLOW rows by slices of columns, then dotted rows by slices */
+/* of rules: each slice has its own row set, merged in slice order.       */
+typedef struct earleyGrammarLookaheadJob {
+  earleyGrammarCore_t    *corep;
+  size_t                  wordl;
+  size_t                  closureWordl;
+  earleyGrammarBitWord_t *terminalp;
+  earleyGrammarBitWord_t *followp;
+  earleyGrammarBitWord_t *suffixp;          /* wordl per thread */
+  int                     nComponenti;
+  int                    *edgeOffsetip;
+  int                    *edgeTargetip;
+  int                    *componentip;
+  int                    *memberOffsetip;
+  int                    *memberip;
+  int                    *seenip;           /* nSymboli+1 per thread */
+  earleyGrammarRowSet_t  *rowSetp;          /* One per thread */
+  short                  *okbp;             /* One per thread */
+} earleyGrammarLookaheadJob_t;
+
+static inline void earleyGrammar_follow_jobv(void *contextp, int threadi, int nThreadi);
+static inline void earleyGrammar_dotted_jobv(void *contextp, int threadi, int nThreadi);
+static inline short earleyGrammar_lookahead_ruleb(earleyGrammarCore_t *corep, earleyGrammarRowSet_t *rowSetp, int firstRowi, short updateb, earleyGrammarBitWord_t *suffixp, size_t wordl, const earleyGrammarBitWord_t *lhsFollowp, int rulei);
+static inline short earleyGrammar_lookahead_rowb(earleyGrammarCore_t *corep, earleyGrammarRowSet_t *rowSetp, int firstRowi, short updateb, const earleyGrammarBitWord_t *rowp, size_t wordl, int *rowip);
+
+/* FOLLOW rows of an incremental precompute, loaded on demand */
+typedef struct earleyGrammarFollowUpdate {
+  earleyGrammarCore_t    *corep;
+  size_t                  wordl;
+  int                     firstSymboli;     /* Symbols before it have a row in symbolFollowRowip */
+  int                    *symbolRowip;      /* nSymboli: row in rowp, -1 when not loaded */
+  earleyGrammarBitWord_t *rowp;
+  size_t                  rowl;             /* Allocated words */
+  int                     nRowi;
+  char                   *symbolFlagbp;
+  int                    *worklistip;       /* Symbols whose FOLLOW grew */
+  int                     nWorklisti;
+} earleyGrammarFollowUpdate_t;
+
+static inline earleyGrammarBitWord_t *earleyGrammar_follow_rowp(earleyGrammarFollowUpdate_t *updatep, int symboli);
+static inline short earleyGrammar_follow_orb(earleyGrammarFollowUpdate_t *updatep, int symboli, const earleyGrammarBitWord_t *srcp, int srcSymboli);
+static inline short earleyGrammar_follow_edgeb(earleyGrammarFollowUpdate_t *updatep, int rulei);
+
+/* Binary image. Sections are numbered from 1 to EARLEYGRAMMAR_IMAGE_SECTION_MAX. */
+#define EARLEYGRAMMAR_IMAGE_MAGIC      "EARLEYG"
+#define EARLEYGRAMMAR_IMAGE_VERSION    6
+#define EARLEYGRAMMAR_IMAGE_ENDIAN     0x01020304
+#define EARLEYGRAMMAR_IMAGE_ALIGNL     8
+#define EARLEYGRAMMAR_IMAGE_ALIGN(sizel) ((((sizel) + EARLEYGRAMMAR_IMAGE_ALIGNL - 1) / EARLEYGRAMMAR_IMAGE_ALIGNL) * EARLEYGRAMMAR_IMAGE_ALIGNL)
+#define EARLEYGRAMMAR_IMAGE_FNV_OFFSET 0xcbf29ce484222325ULL
+#define EARLEYGRAMMAR_IMAGE_FNV_PRIME  0x100000001b3ULL
+
+enum {
+  EARLEYGRAMMAR_IMAGE_SECTION_SYMBOLPROPERTY = 1,
+  EARLEYGRAMMAR_IMAGE_SECTION_SYMBOLEVENT,
+  EARLEYGRAMMAR_IMAGE_SECTION_SYMBOLOPTION,
+  EARLEYGRAMMAR_IMAGE_SECTION_RULELHS,
+  EARLEYGRAMMAR_IMAGE_SECTION_RULERHSOFFSET,
+  EARLEYGRAMMAR_IMAGE_SECTION_RULERHSLENGTH,
+  EARLEYGRAMMAR_IMAGE_SECTION_RULEPROPERTY,
+  EARLEYGRAMMAR_IMAGE_SECTION_RULEOPTION,
+  EARLEYGRAMMAR_IMAGE_SECTION_RHSSYMBOL,
+  EARLEYGRAMMAR_IMAGE_SECTION_LHSRULEOFFSET,
+  EARLEYGRAMMAR_IMAGE_SECTION_LHSRULE,
+  EARLEYGRAMMAR_IMAGE_SECTION_RHSRULEOFFSET,
+  EARLEYGRAMMAR_IMAGE_SECTION_RHSRULE,
+  EARLEYGRAMMAR_IMAGE_SECTION_CLOSUREROW,
+  EARLEYGRAMMAR_IMAGE_SECTION_CLOSURE,
+  EARLEYGRAMMAR_IMAGE_SECTION_PREDICTIONROW,
+  EARLEYGRAMMAR_IMAGE_SECTION_PREDICTION,
+  EARLEYGRAMMAR_IMAGE_SECTION_NNFRULELHS,
+  EARLEYGRAMMAR_IMAGE_SECTION_NNFRULERHSOFFSET,
+  EARLEYGRAMMAR_IMAGE_SECTION_NNFRULERHSLENGTH,
+  EARLEYGRAMMAR_IMAGE_SECTION_NNFRULEUSER,
+  EARLEYGRAMMAR_IMAGE_SECTION_NNFRULENULLED,
+  EARLEYGRAMMAR_IMAGE_SECTION_NNFRHSSYMBOL,
+  EARLEYGRAMMAR_IMAGE_SECTION_DFASTATEITEMOFFSET,
+  EARLEYGRAMMAR_IMAGE_SECTION_DFAITEMRULE,
+  EARLEYGRAMMAR_IMAGE_SECTION_DFAITEMDOT,
+  EARLEYGRAMMAR_IMAGE_SECTION_DFASTATENONKERNEL,
+  EARLEYGRAMMAR_IMAGE_SECTION_DFASTATETRANSITIONOFFSET,
+  EARLEYGRAMMAR_IMAGE_SECTION_DFATRANSITIONSYMBOL,
+  EARLEYGRAMMAR_IMAGE_SECTION_DFATRANSITIONSTATE,
+  EARLEYGRAMMAR_IMAGE_SECTION_FIRST,
+  EARLEYGRAMMAR_IMAGE_SECTION_DOTTEDLOOKAHEADROW,
+  EARLEYGRAMMAR_IMAGE_SECTION_LOOKAHEAD,
+  EARLEYGRAMMAR_IMAGE_SECTION_MAX = EARLEYGRAMMAR_IMAGE_SECTION_LOOKAHEAD
+};
+
+/* Static tables: the C array of every section, in the order of earleyGrammarStatic_t */
+typedef enum earleyGrammarStaticType {
+  EARLEYGRAMMAR_STATIC_INT = 0,
+  EARLEYGRAMMAR_STATIC_BITWORD,
+  EARLEYGRAMMAR_STATIC_SYMBOLOPTION,
+  EARLEYGRAMMAR_STATIC_RULEOPTION
+} earleyGrammarStaticType_t;
+
+typedef struct earleyGrammarStaticArray {
+  const char                *namep;
+  earleyGrammarStaticType_t  typei;
+} earleyGrammarStaticArray_t;
+
+static const earleyGrammarStaticArray_t earleyGrammarStaticArrayp[EARLEYGRAMMAR_IMAGE_SECTION_MAX + 1] = {
+  { NULL,                         EARLEYGRAMMAR_STATIC_INT },
+  { "symbolPropertyBitSetip",     EARLEYGRAMMAR_STATIC_INT },
+  { "symbolEventBitSetip",        EARLEYGRAMMAR_STATIC_INT },
+  { "symbolOptionp",              EARLEYGRAMMAR_STATIC_SYMBOLOPTION },
+  { "ruleLhsSymbolip",            EARLEYGRAMMAR_STATIC_INT },
+  { "ruleRhsOffsetip",            EARLEYGRAMMAR_STATIC_INT },
+  { "ruleRhsLengthip",            EARLEYGRAMMAR_STATIC_INT },
+  { "rulePropertyBitSetip",       EARLEYGRAMMAR_STATIC_INT },
+  { "ruleOptionp",                EARLEYGRAMMAR_STATIC_RULEOPTION },
+  { "rhsSymbolip",                EARLEYGRAMMAR_STATIC_INT },
+  { "symbolLhsRuleOffsetip",      EARLEYGRAMMAR_STATIC_INT },
+  { "lhsRuleip",                  EARLEYGRAMMAR_STATIC_INT },
+  { "symbolRhsRuleOffsetip",      EARLEYGRAMMAR_STATIC_INT },
+  { "rhsRuleip",                  EARLEYGRAMMAR_STATIC_INT },
+  { "symbolClosureRowip",         EARLEYGRAMMAR_STATIC_INT },
+  { "closurep",                   EARLEYGRAMMAR_STATIC_BITWORD },
+  { "symbolPredictionRowip",      EARLEYGRAMMAR_STATIC_INT },
+  { "predictionp",                EARLEYGRAMMAR_STATIC_BITWORD },
+  { "nnfRuleLhsSymbolip",         EARLEYGRAMMAR_STATIC_INT },
+  { "nnfRuleRhsOffsetip",         EARLEYGRAMMAR_STATIC_INT },
+  { "nnfRuleRhsLengthip",         EARLEYGRAMMAR_STATIC_INT },
+  { "nnfRuleUserip",              EARLEYGRAMMAR_STATIC_INT },
+  { "nnfRuleNulledip",            EARLEYGRAMMAR_STATIC_INT },
+  { "nnfRhsSymbolip",             EARLEYGRAMMAR_STATIC_INT },
+  { "dfaStateItemOffsetip",       EARLEYGRAMMAR_STATIC_INT },
+  { "dfaItemRuleip",              EARLEYGRAMMAR_STATIC_INT },
+  { "dfaItemDotip",               EARLEYGRAMMAR_STATIC_INT },
+  { "dfaStateNonKernelip",        EARLEYGRAMMAR_STATIC_INT },
+  { "dfaStateTransitionOffsetip", EARLEYGRAMMAR_STATIC_INT },
+  { "dfaTransitionSymbolip",      EARLEYGRAMMAR_STATIC_INT },
+  { "dfaTransitionStateip",       EARLEYGRAMMAR_STATIC_INT },
+  { "firstp",                     EARLEYGRAMMAR_STATIC_BITWORD },
+  { "dottedLookaheadRowip",       EARLEYGRAMMAR_STATIC_INT },
+  { "lookaheadp",                 EARLEYGRAMMAR_STATIC_BITWORD }
+};
+
+/* What an earleyGrammarStorage_t holds. Its size is checked at compile time. */
+typedef struct earleyGrammarStorageLayout {
+  earleyGrammar_t     grammar;
+  earleyGrammarCore_t core;
+} earleyGrammarStorageLayout_t;
+
+typedef char earleyGrammarStorage_checkc[(sizeof(earleyGrammarStorageLayout_t) <= sizeof(earleyGrammarStorage_t)) ? 1 : -1];
+
+/* Sizes are multiple of EARLEYGRAMMAR_IMAGE_ALIGNL, so that everything after the header is 8-byte aligned */
+typedef struct earleyGrammarImageHeader {
+  char     magics[8];
+  uint32_t endiani;           /* EARLEYGRAMMAR_IMAGE_ENDIAN in the byte order of the writer */
+  uint32_t versioni;
+  uint32_t intSizei;
+  uint32_t symbolOptionSizei;
+  uint32_t ruleOptionSizei;
+  uint32_t sectioni;          /* Number of entries in the section directory */
+  uint64_t imagel;            /* Total image size */
+  uint64_t checksuml;         /* Of everything after the header */
+  int32_t  nSymboli;
+  int32_t  nRulei;
+  int32_t  nRhsi;
+  int32_t  startSymboli;
+  int32_t  nClosureRowi;
+  int32_t  nPredictionRowi;
+  int32_t  nNnfSymboli;
+  int32_t  nNnfRulei;
+  int32_t  nNnfRhsi;
+  int32_t  nDfaStatei;
+  int32_t  nDfaItemi;
+  int32_t  nDfaTransitioni;
+  int32_t  nLookaheadRowi;
+  int32_t  reservedi;
+} earleyGrammarImageHeader_t;
+
+typedef struct earleyGrammarImageSection {
+  uint32_t idi;
+  uint32_t reservedi;
+  uint64_t offsetl;           /* From the start of the image */
+  uint64_t sizel;
+} earleyGrammarImageSection_t;
+
+/* Totally subjective -; */
+#define EARLEYGRAMMAR_TABLE_START_ALLOCL 64
+#define EARLEYALLOCATOR_CHUNK_START_SIZEL 65536
+
+/* Arena allocations are aligned on the most demanding basic type */
+typedef union earleyAllocatorAlign {
+  long double ld;
+  double      d;
+  long        l;
+  void       *p;
+  void      (*f)(void);
+} earleyAllocatorAlign_t;
+#define EARLEYALLOCATOR_ALIGN(sizel) ((((sizel) + sizeof(earleyAllocatorAlign_t) - 1) / sizeof(earleyAllocatorAlign_t)) * sizeof(earleyAllocatorAlign_t))
+#define EARLEYALLOCATOR_CHUNK_HEADER_SIZEL EARLEYALLOCATOR_ALIGN(sizeof(earleyArenaChunk_t))
 
 #define EARLEYGRAMMAR_ERROR(earleyGrammarp, strings) do {               \
     if ((earleyGrammarp != NULL) && (earleyGrammarp->option.genericLoggerp != NULL)) { \
@@ -26,356 +423,6235 @@ static inline void            earleyRule_freev(earleyRule_t *earleyRulep);
     }                                                                   \
   } while (0)
 
+/* Logged as an error when warningIsErrorb, not at all when warningIsIgnoredb */
+#define EARLEYGRAMMAR_WARNF(earleyGrammarp, fmts, ...) do {             \
+    if ((earleyGrammarp != NULL) && (earleyGrammarp->option.genericLoggerp != NULL)) { \
+      if (earleyGrammarp->option.warningIsErrorb) {                     \
+        GENERICLOGGER_ERRORF(earleyGrammarp->option.genericLoggerp, fmts, __VA_ARGS__); \
+      } else if (! earleyGrammarp->option.warningIsIgnoredb) {          \
+        GENERICLOGGER_WARNF(earleyGrammarp->option.genericLoggerp, fmts, __VA_ARGS__); \
+      }                                                                 \
+    }                                                                   \
+  } while (0)
+
+/* Grows one array of a core table from oldl to newl slots, the old content being preserved */
+#define EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, arrayp, type, oldl, newl) do { \
+    type *_tmpp = (type *) earleyAllocator_reallocp(&(earleyGrammarp->corep->allocator), (arrayp), (oldl) * sizeof(type), (newl) * sizeof(type)); \
+    if (_tmpp == NULL) {                                                \
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno)); \
+      goto err;                                                         \
+    }                                                                   \
+    (arrayp) = _tmpp;                                                   \
+  } while (0)
+
+#define EARLEYGRAMMAR_TABLE_FREE(allocatorp, arrayp) do {              \
+    if ((arrayp) != NULL) {                                             \
+      earleyAllocator_freev((allocatorp), (arrayp));                    \
+    }                                                                   \
+  } while (0)
+
+/* Effective options and events: the grammar overlay if any, the core otherwise */
+#define EARLEYGRAMMAR_SYMBOLOPTIONP(earleyGrammarp, symboli) (((earleyGrammarp)->symbolOptionOverlayp != NULL) ? &((earleyGrammarp)->symbolOptionOverlayp[symboli]) : &((earleyGrammarp)->corep->symbolOptionp[symboli]))
+#define EARLEYGRAMMAR_SYMBOLEVENTI(earleyGrammarp, symboli) (((earleyGrammarp)->symbolEventBitSetOverlayip != NULL) ? (earleyGrammarp)->symbolEventBitSetOverlayip[symboli] : (earleyGrammarp)->corep->symbolEventBitSetip[symboli])
+#define EARLEYGRAMMAR_RULEOPTIONP(earleyGrammarp, rulei) (((earleyGrammarp)->ruleOptionOverlayp != NULL) ? &((earleyGrammarp)->ruleOptionOverlayp[rulei]) : &((earleyGrammarp)->corep->ruleOptionp[rulei]))
+
+/* Core reference counting is atomic when the compiler allows it */
+#if defined(__GNUC__)
+#define EARLEYGRAMMARCORE_REF(corep)   __sync_add_and_fetch(&((corep)->refcounti), 1)
+#define EARLEYGRAMMARCORE_UNREF(corep) __sync_sub_and_fetch(&((corep)->refcounti), 1)
+#else
+#define EARLEYGRAMMARCORE_REF(corep)   (++((corep)->refcounti))
+#define EARLEYGRAMMARCORE_UNREF(corep) (--((corep)->refcounti))
+#endif
+
 /****************************************************************************/
-static inline earleySymbol_t *earleySymbol_getp(earleyGrammar_t *earleyGrammarp, int symboli)
+static inline void *earleyAllocator_default_mallocp(void *userDatavp, size_t sizel)
 /****************************************************************************/
 {
-  genericStack_t *symbolStackp;
-  earleySymbol_t *earleySymbolp;
+  (void) userDatavp;
+  return malloc(sizel);
+}
 
-  if (earleyGrammarp == NULL) {
-    errno = EINVAL;
-    goto err;
+/****************************************************************************/
+static inline void *earleyAllocator_default_reallocp(void *userDatavp, void *p, size_t sizel)
+/****************************************************************************/
+{
+  (void) userDatavp;
+  return realloc(p, sizel);
+}
+
+/****************************************************************************/
+static inline void earleyAllocator_default_freev(void *userDatavp, void *p)
+/****************************************************************************/
+{
+  (void) userDatavp;
+  free(p);
+}
+
+/****************************************************************************/
+static inline short earleyAllocator_initb(earleyAllocator_t *earleyAllocatorp, earleyGrammarOption_t *optionp)
+/****************************************************************************/
+{
+  /* Hooks go together */
+  if ((optionp->mallocp != NULL) || (optionp->reallocp != NULL) || (optionp->freep != NULL)) {
+    if ((optionp->mallocp == NULL) || (optionp->reallocp == NULL) || (optionp->freep == NULL)) {
+      errno = EINVAL;
+      return 0;
+    }
+    earleyAllocatorp->mallocp  = optionp->mallocp;
+    earleyAllocatorp->reallocp = optionp->reallocp;
+    earleyAllocatorp->freep    = optionp->freep;
+  } else {
+    earleyAllocatorp->mallocp  = earleyAllocator_default_mallocp;
+    earleyAllocatorp->reallocp = earleyAllocator_default_reallocp;
+    earleyAllocatorp->freep    = earleyAllocator_default_freev;
+  }
+  earleyAllocatorp->userDatavp = optionp->allocatorUserDatavp;
+  earleyAllocatorp->arenab     = optionp->arenab;
+  earleyAllocatorp->chunkp     = NULL;
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline void *earleyAllocator_mallocp(earleyAllocator_t *earleyAllocatorp, size_t sizel)
+/****************************************************************************/
+{
+  earleyArenaChunk_t *chunkp;
+  size_t              chunkl;
+  void               *p;
+
+  if (! earleyAllocatorp->arenab) {
+    return earleyAllocatorp->mallocp(earleyAllocatorp->userDatavp, sizel);
+  }
+
+  sizel = EARLEYALLOCATOR_ALIGN(sizel);
+  chunkp = earleyAllocatorp->chunkp;
+  if ((chunkp == NULL) || ((chunkp->sizel - chunkp->usedl) < sizel)) {
+    /* New chunk, at least twice as large as the previous one */
+    chunkl = (chunkp != NULL) ? chunkp->sizel * 2 : EARLEYALLOCATOR_CHUNK_START_SIZEL;
+    while (chunkl < sizel) {
+      chunkl *= 2;
+    }
+    chunkp = (earleyArenaChunk_t *) earleyAllocatorp->mallocp(earleyAllocatorp->userDatavp, EARLEYALLOCATOR_CHUNK_HEADER_SIZEL + chunkl);
+    if (chunkp == NULL) {
+      return NULL;
+    }
+    chunkp->nextp = earleyAllocatorp->chunkp;
+    chunkp->sizel = chunkl;
+    chunkp->usedl = 0;
+    earleyAllocatorp->chunkp = chunkp;
+  }
+
+  p = (void *) (((char *) chunkp) + EARLEYALLOCATOR_CHUNK_HEADER_SIZEL + chunkp->usedl);
+  chunkp->usedl += sizel;
+
+  return p;
+}
+
+/****************************************************************************/
+static inline void *earleyAllocator_reallocp(earleyAllocator_t *earleyAllocatorp, void *p, size_t oldl, size_t newl)
+/****************************************************************************/
+{
+  earleyArenaChunk_t *chunkp;
+  char               *lastp;
+  void               *newp;
+
+  if (! earleyAllocatorp->arenab) {
+    return earleyAllocatorp->reallocp(earleyAllocatorp->userDatavp, p, newl);
+  }
+
+  if (p == NULL) {
+    return earleyAllocator_mallocp(earleyAllocatorp, newl);
+  }
+
+  /* The most recent allocation can grow in place */
+  chunkp = earleyAllocatorp->chunkp;
+  oldl   = EARLEYALLOCATOR_ALIGN(oldl);
+  lastp  = ((char *) chunkp) + EARLEYALLOCATOR_CHUNK_HEADER_SIZEL + chunkp->usedl - oldl;
+  if (((char *) p == lastp) && ((chunkp->sizel - chunkp->usedl + oldl) >= EARLEYALLOCATOR_ALIGN(newl))) {
+    chunkp->usedl += EARLEYALLOCATOR_ALIGN(newl);
+    chunkp->usedl -= oldl;
+    return p;
+  }
+
+  /* Otherwise the old area is simply abandoned */
+  newp = earleyAllocator_mallocp(earleyAllocatorp, newl);
+  if (newp != NULL) {
+    memcpy(newp, p, (oldl < newl) ? oldl : newl);
+  }
+
+  return newp;
+}
+
+/****************************************************************************/
+static inline void earleyAllocator_freev(earleyAllocator_t *earleyAllocatorp, void *p)
+/****************************************************************************/
+{
+  /* In arena mode memory is only released by earleyAllocator_releasev() */
+  if (! earleyAllocatorp->arenab) {
+    earleyAllocatorp->freep(earleyAllocatorp->userDatavp, p);
   }
+}
+
+/****************************************************************************/
+static inline void earleyAllocator_releasev(earleyAllocator_t *earleyAllocatorp)
+/****************************************************************************/
+{
+  earleyArenaChunk_t *chunkp;
+  earleyArenaChunk_t *nextp;
 
-  symbolStackp = earleyGrammarp->symbolStackp;
+  for (chunkp = earleyAllocatorp->chunkp; chunkp != NULL; chunkp = nextp) {
+    nextp = chunkp->nextp;
+    earleyAllocatorp->freep(earleyAllocatorp->userDatavp, chunkp);
+  }
+  earleyAllocatorp->chunkp = NULL;
+}
 
-  if (! GENERICSTACK_IS_PTR(symbolStackp, symboli)) {
+/****************************************************************************/
+static inline short earleySymbol_existb(earleyGrammar_t *earleyGrammarp, int symboli)
+/****************************************************************************/
+{
+  if ((symboli < 0) || (symboli >= earleyGrammarp->corep->nSymboli)) {
     EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such symbol %d\n", symboli);
     errno = ENOENT;
-    goto err;
+    return 0;
   }
 
-  earleySymbolp = GENERICSTACK_GET_PTR(symbolStackp, symboli);
-  if (GENERICSTACK_ERROR(symbolStackp)) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "GENERICSTACK_GET_PTR failure, %s\n", strerror(errno));
-    goto err;
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRule_existb(earleyGrammar_t *earleyGrammarp, int rulei)
+/****************************************************************************/
+{
+  if ((rulei < 0) || (rulei >= earleyGrammarp->corep->nRulei)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such rule %d\n", rulei);
+    errno = ENOENT;
+    return 0;
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_symbolTable_reserveb(earleyGrammar_t *earleyGrammarp, size_t wantedl)
+/****************************************************************************/
+{
+  size_t allocl;
+  short  rcb;
+
+  if (wantedl <= earleyGrammarp->corep->symbolAllocl) {
+    goto ok;
+  }
+
+  allocl = (earleyGrammarp->corep->symbolAllocl > 0) ? earleyGrammarp->corep->symbolAllocl : EARLEYGRAMMAR_TABLE_START_ALLOCL;
+  while (allocl < wantedl) {
+    /* Detect very improbable turnaround */
+    if ((allocl * 2) < allocl) {
+      EARLEYGRAMMAR_ERROR(earleyGrammarp, "size_t turnaround\n");
+      errno = EINVAL;
+      goto err;
+    }
+    allocl *= 2;
   }
 
+  /* A partial failure is harmless: arrays that were grown are just larger than symbolAllocl */
+  EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, earleyGrammarp->corep->symbolPropertyBitSetip, int,                         earleyGrammarp->corep->symbolAllocl, allocl);
+  EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, earleyGrammarp->corep->symbolEventBitSetip,    int,                         earleyGrammarp->corep->symbolAllocl, allocl);
+  EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, earleyGrammarp->corep->symbolOptionp,          earleyGrammarSymbolOption_t, earleyGrammarp->corep->symbolAllocl, allocl);
+  earleyGrammarp->corep->symbolAllocl = allocl;
+
+ ok:
+  rcb = 1;
   goto done;
 
  err:
-  earleySymbolp = NULL;
+  rcb = 0;
 
  done:
-  return earleySymbolp;
+  return rcb;
 }
 
 /****************************************************************************/
-static inline earleyRule_t *earleyRule_getp(earleyGrammar_t *earleyGrammarp, int rulei)
+static inline short earleyGrammar_ruleTable_reserveb(earleyGrammar_t *earleyGrammarp, size_t wantedl)
 /****************************************************************************/
 {
-  genericStack_t *ruleStackp;
-  earleyRule_t   *earleyRulep;
+  size_t allocl;
+  short  rcb;
 
-  if (earleyGrammarp == NULL) {
-    errno = EINVAL;
-    goto err;
+  if (wantedl <= earleyGrammarp->corep->ruleAllocl) {
+    goto ok;
+  }
+
+  allocl = (earleyGrammarp->corep->ruleAllocl > 0) ? earleyGrammarp->corep->ruleAllocl : EARLEYGRAMMAR_TABLE_START_ALLOCL;
+  while (allocl < wantedl) {
+    /* Detect very improbable turnaround */
+    if ((allocl * 2) < allocl) {
+      EARLEYGRAMMAR_ERROR(earleyGrammarp, "size_t turnaround\n");
+      errno = EINVAL;
+      goto err;
+    }
+    allocl *= 2;
   }
 
-  ruleStackp = earleyGrammarp->ruleStackp;
+  /* A partial failure is harmless: arrays that were grown are just larger than ruleAllocl */
+  EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, earleyGrammarp->corep->ruleLhsSymbolip,      int,                       earleyGrammarp->corep->ruleAllocl, allocl);
+  EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, earleyGrammarp->corep->ruleRhsOffsetip,      int,                       earleyGrammarp->corep->ruleAllocl, allocl);
+  EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, earleyGrammarp->corep->ruleRhsLengthip,      int,                       earleyGrammarp->corep->ruleAllocl, allocl);
+  EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, earleyGrammarp->corep->rulePropertyBitSetip, int,                       earleyGrammarp->corep->ruleAllocl, allocl);
+  EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, earleyGrammarp->corep->ruleOptionp,          earleyGrammarRuleOption_t, earleyGrammarp->corep->ruleAllocl, allocl);
+  earleyGrammarp->corep->ruleAllocl = allocl;
 
-  if (! GENERICSTACK_IS_PTR(ruleStackp, rulei)) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such rule %d\n", rulei);
-    errno = ENOENT;
-    goto err;
+ ok:
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_rhsPool_reserveb(earleyGrammar_t *earleyGrammarp, size_t wantedl)
+/****************************************************************************/
+{
+  size_t allocl;
+  short  rcb;
+
+  if (wantedl <= earleyGrammarp->corep->rhsAllocl) {
+    goto ok;
   }
 
-  earleyRulep = GENERICSTACK_GET_PTR(ruleStackp, rulei);
-  if (GENERICSTACK_ERROR(ruleStackp)) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "GENERICSTACK_GET_PTR failure, %s\n", strerror(errno));
+  /* Offsets are int's */
+  if (wantedl > (size_t) INT_MAX) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Too many RHS symbols\n");
+    errno = EINVAL;
     goto err;
   }
 
+  allocl = (earleyGrammarp->corep->rhsAllocl > 0) ? earleyGrammarp->corep->rhsAllocl : EARLEYGRAMMAR_TABLE_START_ALLOCL;
+  while (allocl < wantedl) {
+    allocl *= 2;
+  }
+  if (allocl > (size_t) INT_MAX) {
+    allocl = (size_t) INT_MAX;
+  }
+
+  EARLEYGRAMMAR_TABLE_GROW(earleyGrammarp, earleyGrammarp->corep->rhsSymbolip, int, earleyGrammarp->corep->rhsAllocl, allocl);
+  earleyGrammarp->corep->rhsAllocl = allocl;
+
+ ok:
+  rcb = 1;
   goto done;
 
  err:
-  earleyRulep = NULL;
+  rcb = 0;
 
  done:
-  return earleyRulep;
+  return rcb;
 }
 
 /****************************************************************************/
-static inline void earleySymbol_freev(earleySymbol_t *earleySymbolp)
+static inline short earleyGrammar_rule_checkb(earleyGrammar_t *earleyGrammarp, earleyGrammarRuleOption_t *optionp, int lhsSymboli, int rhsSymboli, int *rhsSymbolip, int nSymboli)
+/****************************************************************************/
+/* Symbol ids are checked against nSymboli, that may be beyond the current  */
+/* number of symbols when creating symbols and rules in bulk.               */
 /****************************************************************************/
 {
-  if (earleySymbolp != NULL) {
-    free(earleySymbolp);
+  int i;
+
+  if ((lhsSymboli < 0) || (lhsSymboli >= nSymboli)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such symbol %d\n", lhsSymboli);
+    errno = ENOENT;
+    return 0;
+  }
+
+  if ((rhsSymboli > 0) && (rhsSymbolip == NULL)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Null RHS\n");
+    errno = EINVAL;
+    return 0;
+  }
+  for (i = 0; i < rhsSymboli; i++) {
+    if ((rhsSymbolip[i] < 0) || (rhsSymbolip[i] >= nSymboli)) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such symbol %d\n", rhsSymbolip[i]);
+      errno = ENOENT;
+      return 0;
+    }
+  }
+
+  if ((optionp != NULL) && optionp->sequenceb) {
+    if (rhsSymboli != 1) {
+      EARLEYGRAMMAR_ERROR(earleyGrammarp, "A sequence must have exactly one RHS symbol\n");
+      errno = EINVAL;
+      return 0;
+    }
+    if ((optionp->minimumi != 0) && (optionp->minimumi != 1)) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Sequence minimum must be 0 or 1, not %d\n", optionp->minimumi);
+      errno = EINVAL;
+      return 0;
+    }
+    if ((optionp->separatorSymboli < -1) || (optionp->separatorSymboli >= nSymboli)) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such separator symbol %d\n", optionp->separatorSymboli);
+      errno = ENOENT;
+      return 0;
+    }
   }
+
+  return 1;
 }
 
 /****************************************************************************/
-static inline void earleyRule_freev(earleyRule_t *earleyRulep)
+static inline void earleyGrammar_rule_storev(earleyGrammar_t *earleyGrammarp, earleyGrammarRuleOption_t *optionp, int lhsSymboli, int rhsOffseti, int rhsSymboli)
+/****************************************************************************/
+/* Rule table must have room for one more rule, and the RHS must already be */
+/* in the pool.                                                             */
 /****************************************************************************/
 {
-  if (earleyRulep != NULL) {
-    if (earleyRulep->rhsStackp != NULL) {
-      GENERICSTACK_RESET(earleyRulep->rhsStackp);
-    }
-    free(earleyRulep);
-  }
+  int rulei = earleyGrammarp->corep->nRulei++;
+
+  earleyGrammarp->corep->ruleLhsSymbolip[rulei]      = lhsSymboli;
+  earleyGrammarp->corep->ruleRhsOffsetip[rulei]      = rhsOffseti;
+  earleyGrammarp->corep->ruleRhsLengthip[rulei]      = rhsSymboli;
+  earleyGrammarp->corep->rulePropertyBitSetip[rulei] = 0;
+  earleyGrammarp->corep->ruleOptionp[rulei]          = (optionp != NULL) ? *optionp : earleyGrammarRuleOptionDefault;
 }
 
 /****************************************************************************/
-/* earleyGrammar_newp                                                       */
+static inline earleyGrammarCore_t *earleyGrammarCore_newp(earleyAllocator_t *allocatorp)
 /****************************************************************************/
-earleyGrammar_t *earleyGrammar_newp(earleyGrammarOption_t *optionp)
 {
-  earleyGrammar_t *earleyGrammarp;
-  genericLogger_t *genericLoggerp;
+  earleyGrammarCore_t *corep;
 
-  if (optionp == NULL) {
-    optionp = &earleyGrammarOptionDefault;
+  corep = (earleyGrammarCore_t *) allocatorp->mallocp(allocatorp->userDatavp, sizeof(earleyGrammarCore_t));
+  if (corep == NULL) {
+    return NULL;
   }
 
-  genericLoggerp = optionp->genericLoggerp;
+  earleyGrammarCore_initv(corep, allocatorp);
 
-  earleyGrammarp = (earleyGrammar_t *) malloc(sizeof(earleyGrammar_t));
-  if (earleyGrammarp == NULL) {
-    GENERICLOGGER_ERRORF(genericLoggerp, "malloc failure: %s", strerror(errno));
-    goto err;
+  return corep;
+}
+
+/****************************************************************************/
+static inline void earleyGrammarCore_initv(earleyGrammarCore_t *corep, earleyAllocator_t *allocatorp)
+/****************************************************************************/
+/* The core gets its own allocator, with the same setup as allocatorp      */
+/****************************************************************************/
+{
+  corep->refcounti              = 1;
+  corep->allocator              = *allocatorp;
+  corep->allocator.chunkp       = NULL;
+  corep->imagei                 = EARLEYGRAMMARCORE_IMAGE_NONE;
+  corep->imagep                 = NULL;
+  corep->imagel                 = 0;
+  corep->storageb               = 0;
+  corep->nSymboli               = 0;
+  corep->symbolAllocl           = 0;
+  corep->symbolPropertyBitSetip = NULL;
+  corep->symbolEventBitSetip    = NULL;
+  corep->symbolOptionp          = NULL;
+  corep->nRulei                 = 0;
+  corep->ruleAllocl             = 0;
+  corep->ruleLhsSymbolip        = NULL;
+  corep->ruleRhsOffsetip        = NULL;
+  corep->ruleRhsLengthip        = NULL;
+  corep->rulePropertyBitSetip   = NULL;
+  corep->ruleOptionp            = NULL;
+  corep->nRhsi                  = 0;
+  corep->rhsAllocl              = 0;
+  corep->rhsSymbolip            = NULL;
+  corep->startSymboli           = -1;
+  corep->nPrecomputedSymboli    = -1;
+  corep->nPrecomputedRulei      = -1;
+  corep->precomputeGenerationl  = 0;
+  corep->symbolLhsRuleOffsetip  = NULL;
+  corep->lhsRuleip              = NULL;
+  corep->symbolRhsRuleOffsetip  = NULL;
+  corep->rhsRuleip              = NULL;
+  corep->nClosureRowi           = 0;
+  corep->symbolClosureRowip     = NULL;
+  corep->closurep               = NULL;
+  corep->nPredictionRowi        = 0;
+  corep->symbolPredictionRowip  = NULL;
+  corep->predictionp            = NULL;
+  corep->nNnfSymboli            = 0;
+  corep->nNnfRulei              = 0;
+  corep->nNnfRhsi               = 0;
+  corep->nnfRuleLhsSymbolip     = NULL;
+  corep->nnfRuleRhsOffsetip     = NULL;
+  corep->nnfRuleRhsLengthip     = NULL;
+  corep->nnfRuleUserip          = NULL;
+  corep->nnfRuleNulledip        = NULL;
+  corep->nnfRhsSymbolip         = NULL;
+  corep->nDfaStatei                 = 0;
+  corep->nDfaItemi                  = 0;
+  corep->nDfaTransitioni            = 0;
+  corep->dfaStateItemOffsetip       = NULL;
+  corep->dfaItemRuleip              = NULL;
+  corep->dfaItemDotip               = NULL;
+  corep->dfaStateNonKernelip        = NULL;
+  corep->dfaStateTransitionOffsetip = NULL;
+  corep->dfaTransitionSymbolip      = NULL;
+  corep->dfaTransitionStateip       = NULL;
+  corep->firstp                     = NULL;
+  corep->nLookaheadRowi             = 0;
+  corep->dottedLookaheadRowip       = NULL;
+  corep->lookaheadp                 = NULL;
+  corep->symbolFollowRowip          = NULL;
+  corep->nLookaheadFullRowi         = 0;
+}
+
+/****************************************************************************/
+static inline void earleyGrammarCore_unrefv(earleyGrammarCore_t *corep)
+/****************************************************************************/
+{
+  earleyAllocator_t allocator;
+
+  if ((corep == NULL) || (EARLEYGRAMMARCORE_UNREF(corep) > 0)) {
+    return;
   }
 
-  earleyGrammarp->symbolStackp = NULL;
-  earleyGrammarp->ruleStackp   = NULL;
-  earleyGrammarp->errori       = 0;
-  earleyGrammarp->option       = *optionp;
-  earleyGrammarp->precomputedb = 0;
+  if (corep->imagei == EARLEYGRAMMARCORE_IMAGE_MMAP) {
+    /* Tables are in the mapping */
+#ifdef EARLEYGRAMMAR_IMAGE_MMAP
+    munmap(corep->imagep, corep->imagel);
+#endif
+  } else if (corep->imagei == EARLEYGRAMMARCORE_IMAGE_HEAP) {
+    /* Tables are in the copy */
+    corep->allocator.freep(corep->allocator.userDatavp, corep->imagep);
+  } else if (corep->imagei == EARLEYGRAMMARCORE_IMAGE_STATIC) {
+    /* Tables belong to the user */
+  } else if (corep->allocator.arenab) {
+    /* Everything at once */
+    earleyAllocator_releasev(&(corep->allocator));
+  } else {
+    /* Free symbol table */
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->symbolPropertyBitSetip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->symbolEventBitSetip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->symbolOptionp);
 
-  earleyGrammarp->symbolStackp = &(earleyGrammarp->_symbolStack);
-  GENERICSTACK_INIT(earleyGrammarp->symbolStackp);
-  if (GENERICSTACK_ERROR(earleyGrammarp->symbolStackp)) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "GENERICSTACK_INIT failure, %s\n", strerror(errno));
-    earleyGrammarp->symbolStackp = NULL;
-    goto err;
+    /* Free rule table */
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->ruleLhsSymbolip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->ruleRhsOffsetip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->ruleRhsLengthip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->rulePropertyBitSetip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->ruleOptionp);
+
+    /* Free RHS pool */
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->rhsSymbolip);
+
+    /* Free indexes */
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->symbolLhsRuleOffsetip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->lhsRuleip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->symbolRhsRuleOffsetip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->rhsRuleip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->symbolClosureRowip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->closurep);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->symbolPredictionRowip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->predictionp);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->nnfRuleLhsSymbolip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->nnfRuleRhsOffsetip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->nnfRuleRhsLengthip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->nnfRuleUserip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->nnfRuleNulledip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->nnfRhsSymbolip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->dfaStateItemOffsetip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->dfaItemRuleip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->dfaItemDotip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->dfaStateNonKernelip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->dfaStateTransitionOffsetip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->dfaTransitionSymbolip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->dfaTransitionStateip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->firstp);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->dottedLookaheadRowip);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->lookaheadp);
+    EARLEYGRAMMAR_TABLE_FREE(&(corep->allocator), corep->symbolFollowRowip);
   }
 
-  earleyGrammarp->ruleStackp = &(earleyGrammarp->_ruleStack);
-  GENERICSTACK_INIT(earleyGrammarp->ruleStackp);
-  if (GENERICSTACK_ERROR(earleyGrammarp->ruleStackp)) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "GENERICSTACK_INIT failure, %s\n", strerror(errno));
-    earleyGrammarp->ruleStackp = NULL;
-    goto err;
+  if (! corep->storageb) {
+    allocator = corep->allocator;
+    allocator.freep(allocator.userDatavp, corep);
   }
+}
 
-  goto done;
+/****************************************************************************/
+static inline earleyGrammar_t *earleyGrammar_allocp(earleyGrammarOption_t *optionp)
+/****************************************************************************/
+/* A grammar without core                                                   */
+/****************************************************************************/
+{
+  earleyGrammar_t   *earleyGrammarp;
+  genericLogger_t   *genericLoggerp = optionp->genericLoggerp;
+  earleyAllocator_t  allocator;
 
- err:
-  earleyGrammar_freev(earleyGrammarp);
-  earleyGrammarp = NULL;
+  if (! earleyAllocator_initb(&allocator, optionp)) {
+    if (genericLoggerp != NULL) {
+      GENERICLOGGER_ERROR(genericLoggerp, "mallocp, reallocp and freep must be all set or all NULL");
+    }
+    return NULL;
+  }
+
+  /* The grammar itself never lives in the arena */
+  earleyGrammarp = (earleyGrammar_t *) allocator.mallocp(allocator.userDatavp, sizeof(earleyGrammar_t));
+  if (earleyGrammarp == NULL) {
+    if (genericLoggerp != NULL) {
+      GENERICLOGGER_ERRORF(genericLoggerp, "malloc failure: %s", strerror(errno));
+    }
+    return NULL;
+  }
+
+  earleyGrammar_initv(earleyGrammarp, &allocator, optionp);
 
- done:
   return earleyGrammarp;
 }
 
 /****************************************************************************/
-/* earleyGrammar_clonep                                                     */
+static inline void earleyGrammar_initv(earleyGrammar_t *earleyGrammarp, earleyAllocator_t *allocatorp, earleyGrammarOption_t *optionp)
 /****************************************************************************/
-earleyGrammar_t *earleyGrammar_clonep(earleyGrammar_t *earleyGrammarOriginp, earleyGrammarCloneOption_t *optionp)
 {
-  earleyGrammar_t *earleyGrammarp = NULL;
-  genericStack_t  *symbolStackp;
-  genericStack_t  *ruleStackp;
-  earleySymbol_t  *earleySymbolp;
-  earleyRule_t    *earleyRulep;
-  genericStack_t  *symbolOriginStackp;
-  genericStack_t  *ruleOriginStackp;
-  earleySymbol_t  *earleySymbolOriginp;
-  earleyRule_t    *earleyRuleOriginp;
-  int              i;
+  earleyGrammarp->corep                      = NULL;
+  earleyGrammarp->symbolOptionOverlayp       = NULL;
+  earleyGrammarp->symbolEventBitSetOverlayip = NULL;
+  earleyGrammarp->ruleOptionOverlayp         = NULL;
+  earleyGrammarp->allocator                  = *allocatorp;
+  earleyGrammarp->storageb                   = 0;
+  earleyGrammarp->errori                     = 0;
+  earleyGrammarp->option                     = *optionp;
+  earleyGrammarp->precomputedb               = 0;
+  earleyGrammarp->eventBitSetp               = NULL;
+  earleyGrammarp->eventBitSetl               = 0;
+  earleyGrammarp->nEventSymboli              = -1;
+  earleyGrammarp->exhaustedb                 = 0;
+  earleyGrammarp->eventReloadb               = 1;
+  earleyGrammarp->eventExhaustionb           = 0;
+  earleyGrammarp->eventp                     = NULL;
+  earleyGrammarp->eventl                     = 0;
+  earleyGrammarp->nEventl                    = 0;
+}
 
-  if (earleyGrammarOriginp == NULL) {
-    errno = EINVAL;
-    goto err;
+/****************************************************************************/
+static inline short earleyGrammar_core_ownb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+/* Makes sure the core is not shared, not read-only and has no overlay,    */
+/* i.e. that it can be modified. This is the copy in copy-on-write.         */
+/* Precomputed tables are not copied: the grammar must be precomputed      */
+/* again anyway, from scratch for a copy, incrementally otherwise.          */
+/****************************************************************************/
+{
+  earleyGrammarCore_t *oldCorep = earleyGrammarp->corep;
+  earleyGrammarCore_t *newCorep;
+  int                  nSymboli;
+  int                  nRulei;
+  int                  nRhsi;
+  short                rcb;
+
+  /* The grammar is about to change */
+  earleyGrammarp->precomputedb = 0;
+
+  if ((oldCorep->refcounti == 1) && (oldCorep->imagei == EARLEYGRAMMARCORE_IMAGE_NONE) && (earleyGrammarp->symbolOptionOverlayp == NULL) && (earleyGrammarp->ruleOptionOverlayp == NULL)) {
+    return 1;
   }
 
-  /* Only precomputed grammars can be cloned */
-  if (! earleyGrammarOriginp->precomputedb) {
-    EARLEYGRAMMAR_ERROR(earleyGrammarOriginp, "Grammar must be precomputed\n");
-    errno = EINVAL;
-    goto err;
+  newCorep = earleyGrammarCore_newp(&(earleyGrammarp->allocator));
+  if (newCorep == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    return 0;
   }
 
-  earleyGrammarp = earleyGrammar_newp(NULL);
-  if (earleyGrammarp == NULL) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarOriginp, "malloc failure, %s\n", strerror(errno));
+  nSymboli = oldCorep->nSymboli;
+  nRulei   = oldCorep->nRulei;
+  nRhsi    = oldCorep->nRhsi;
+
+  /* A recognizer on the old core must not mistake the copy for it */
+  newCorep->precomputeGenerationl = oldCorep->precomputeGenerationl;
+
+  earleyGrammarp->corep = newCorep;
+  if ((! earleyGrammar_symbolTable_reserveb(earleyGrammarp, (size_t) nSymboli)) ||
+      (! earleyGrammar_ruleTable_reserveb(earleyGrammarp, (size_t) nRulei)) ||
+      (! earleyGrammar_rhsPool_reserveb(earleyGrammarp, (size_t) nRhsi))) {
     goto err;
   }
 
-  /* Duplicate symbol stack */
-  symbolStackp = earleyGrammarp->symbolStackp;
-  symbolOriginStackp = earleyGrammarOriginp->symbolStackp;
-  for (i = 0; i < GENERICSTACK_USED(symbolOriginStackp); i++) {
-    earleySymbolOriginp = earleySymbol_getp(earleyGrammarOriginp, i);
-    if (earleySymbolOriginp == NULL) {
-      goto err;
-    }
-    earleySymbolp = (earleySymbol_t *) malloc(sizeof(earleySymbol_t));
-    if (earleySymbolp == NULL) {
-      EARLEYGRAMMAR_ERRORF(earleyGrammarOriginp, "malloc failure, %s\n", strerror(errno));
-      goto err;
-    }
-    *earleySymbolp = *earleySymbolOriginp;
-    GENERICSTACK_PUSH_PTR(symbolStackp, earleySymbolp);
-    if (GENERICSTACK_ERROR(symbolStackp)) {
-      EARLEYGRAMMAR_ERRORF(earleyGrammarOriginp, "GENERICSTACK_PUSH_PTR failure, %s\n", strerror(errno));
-      goto err;
-    }
-    /* Apply clone options */
-    if (optionp != NULL) {
-      if (! optionp->symbolOptionSetterp(optionp->userDatavp, earleySymbolp->idi, &(earleySymbolp->option))) {
-        EARLEYGRAMMAR_ERROR(earleyGrammarOriginp, "symbolOptionSetterp failure\n");
-        goto err;
-      }
-    }
+  /* Overlays, if any, take precedence over the shared tables */
+  if (nSymboli > 0) {
+    memcpy(newCorep->symbolPropertyBitSetip, oldCorep->symbolPropertyBitSetip, nSymboli * sizeof(int));
+    memcpy(newCorep->symbolEventBitSetip,
+           (earleyGrammarp->symbolEventBitSetOverlayip != NULL) ? earleyGrammarp->symbolEventBitSetOverlayip : oldCorep->symbolEventBitSetip,
+           nSymboli * sizeof(int));
+    memcpy(newCorep->symbolOptionp,
+           (earleyGrammarp->symbolOptionOverlayp != NULL) ? earleyGrammarp->symbolOptionOverlayp : oldCorep->symbolOptionp,
+           nSymboli * sizeof(earleyGrammarSymbolOption_t));
+  }
+  if (nRulei > 0) {
+    memcpy(newCorep->ruleLhsSymbolip,      oldCorep->ruleLhsSymbolip,      nRulei * sizeof(int));
+    memcpy(newCorep->ruleRhsOffsetip,      oldCorep->ruleRhsOffsetip,      nRulei * sizeof(int));
+    memcpy(newCorep->ruleRhsLengthip,      oldCorep->ruleRhsLengthip,      nRulei * sizeof(int));
+    memcpy(newCorep->rulePropertyBitSetip, oldCorep->rulePropertyBitSetip, nRulei * sizeof(int));
+    memcpy(newCorep->ruleOptionp,
+           (earleyGrammarp->ruleOptionOverlayp != NULL) ? earleyGrammarp->ruleOptionOverlayp : oldCorep->ruleOptionp,
+           nRulei * sizeof(earleyGrammarRuleOption_t));
+  }
+  if (nRhsi > 0) {
+    memcpy(newCorep->rhsSymbolip, oldCorep->rhsSymbolip, nRhsi * sizeof(int));
   }
+  newCorep->nSymboli = nSymboli;
+  newCorep->nRulei   = nRulei;
+  newCorep->nRhsi    = nRhsi;
 
-  /* Duplicate rule stack */
-  ruleStackp = earleyGrammarp->ruleStackp;
-  ruleOriginStackp = earleyGrammarOriginp->ruleStackp;
-  for (i = 0; i < GENERICSTACK_USED(ruleOriginStackp); i++) {
-    earleyRuleOriginp = earleyRule_getp(earleyGrammarOriginp, i);
-    if (earleyRuleOriginp == NULL) {
+  EARLEYGRAMMAR_TABLE_FREE(&(earleyGrammarp->allocator), earleyGrammarp->symbolOptionOverlayp);
+  EARLEYGRAMMAR_TABLE_FREE(&(earleyGrammarp->allocator), earleyGrammarp->symbolEventBitSetOverlayip);
+  EARLEYGRAMMAR_TABLE_FREE(&(earleyGrammarp->allocator), earleyGrammarp->ruleOptionOverlayp);
+  earleyGrammarp->symbolOptionOverlayp       = NULL;
+  earleyGrammarp->symbolEventBitSetOverlayip = NULL;
+  earleyGrammarp->ruleOptionOverlayp         = NULL;
+
+  earleyGrammarCore_unrefv(oldCorep);
+
+  rcb = 1;
+  goto done;
+
+ err:
+  earleyGrammarCore_unrefv(newCorep);
+  earleyGrammarp->corep = oldCorep;
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_symbolOverlay_ensureb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+{
+  earleyGrammarCore_t *corep = earleyGrammarp->corep;
+  size_t               nSymboll = (size_t) corep->nSymboli;
+
+  if (earleyGrammarp->symbolOptionOverlayp != NULL) {
+    return 1;
+  }
+
+  earleyGrammarp->symbolOptionOverlayp = (earleyGrammarSymbolOption_t *) earleyAllocator_mallocp(&(earleyGrammarp->allocator), nSymboll * sizeof(earleyGrammarSymbolOption_t));
+  if (earleyGrammarp->symbolOptionOverlayp == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+  earleyGrammarp->symbolEventBitSetOverlayip = (int *) earleyAllocator_mallocp(&(earleyGrammarp->allocator), nSymboll * sizeof(int));
+  if (earleyGrammarp->symbolEventBitSetOverlayip == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    EARLEYGRAMMAR_TABLE_FREE(&(earleyGrammarp->allocator), earleyGrammarp->symbolOptionOverlayp);
+    earleyGrammarp->symbolOptionOverlayp = NULL;
+    return 0;
+  }
+
+  memcpy(earleyGrammarp->symbolOptionOverlayp,       corep->symbolOptionp,       nSymboll * sizeof(earleyGrammarSymbolOption_t));
+  memcpy(earleyGrammarp->symbolEventBitSetOverlayip, corep->symbolEventBitSetip, nSymboll * sizeof(int));
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_ruleOverlay_ensureb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+{
+  earleyGrammarCore_t *corep = earleyGrammarp->corep;
+  size_t               nRulel = (size_t) corep->nRulei;
+
+  if (earleyGrammarp->ruleOptionOverlayp != NULL) {
+    return 1;
+  }
+
+  earleyGrammarp->ruleOptionOverlayp = (earleyGrammarRuleOption_t *) earleyAllocator_mallocp(&(earleyGrammarp->allocator), nRulel * sizeof(earleyGrammarRuleOption_t));
+  if (earleyGrammarp->ruleOptionOverlayp == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+
+  memcpy(earleyGrammarp->ruleOptionOverlayp, corep->ruleOptionp, nRulel * sizeof(earleyGrammarRuleOption_t));
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline int earleyGrammar_symbolEvent_computei(earleyGrammarSymbolOption_t *optionp)
+/****************************************************************************/
+{
+  return optionp->eventSeti & (EARLEYGRAMMAR_EVENTTYPE_COMPLETION|EARLEYGRAMMAR_EVENTTYPE_NULLED|EARLEYGRAMMAR_EVENTTYPE_PREDICTION);
+}
+
+/****************************************************************************/
+/* earleyGrammar_newp                                                       */
+/****************************************************************************/
+earleyGrammar_t *earleyGrammar_newp(earleyGrammarOption_t *optionp)
+{
+  earleyGrammar_t *earleyGrammarp;
+
+  if (optionp == NULL) {
+    optionp = &earleyGrammarOptionDefault;
+  }
+
+  earleyGrammarp = earleyGrammar_allocp(optionp);
+  if (earleyGrammarp == NULL) {
+    goto err;
+  }
+
+  earleyGrammarp->corep = earleyGrammarCore_newp(&(earleyGrammarp->allocator));
+  if (earleyGrammarp->corep == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+
+  /* Capacity hints */
+  if (! earleyGrammar_symbolTable_reserveb(earleyGrammarp, optionp->symbolCapacityl)) {
+    goto err;
+  }
+  if (! earleyGrammar_ruleTable_reserveb(earleyGrammarp, optionp->ruleCapacityl)) {
+    goto err;
+  }
+  if (! earleyGrammar_rhsPool_reserveb(earleyGrammarp, optionp->rhsCapacityl)) {
+    goto err;
+  }
+
+  goto done;
+
+ err:
+  earleyGrammar_freev(earleyGrammarp);
+  earleyGrammarp = NULL;
+
+ done:
+  return earleyGrammarp;
+}
+
+/****************************************************************************/
+/* earleyGrammar_clonep                                                     */
+/****************************************************************************/
+/* The clone shares the core of its origin. Only eventSeti of symbols, and  */
+/* ranki and nullRanksHighb of rules, can be changed by the option setters: */
+/* as soon as one of them changes, the clone gets a private overlay for the */
+/* symbol or rule options.                                                  */
+/****************************************************************************/
+earleyGrammar_t *earleyGrammar_clonep(earleyGrammar_t *earleyGrammarOriginp, earleyGrammarCloneOption_t *optionp)
+{
+  earleyGrammar_t             *earleyGrammarp = NULL;
+  earleyGrammarCore_t         *corep;
+  earleyGrammarSymbolOption_t  symbolOption;
+  earleyGrammarSymbolOption_t *symbolOptionp;
+  earleyGrammarRuleOption_t    ruleOption;
+  earleyGrammarRuleOption_t   *ruleOptionp;
+  int                          i;
+
+  if (earleyGrammarOriginp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  /* Only precomputed grammars can be cloned */
+  if (! earleyGrammarOriginp->precomputedb) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarOriginp, "Grammar must be precomputed\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (optionp == NULL) {
+    optionp = &earleyGrammarCloneOptionDefault;
+  }
+
+  earleyGrammarp = earleyGrammar_allocp(&(earleyGrammarOriginp->option));
+  if (earleyGrammarp == NULL) {
+    goto err;
+  }
+
+  /* Share the core */
+  corep = earleyGrammarOriginp->corep;
+  EARLEYGRAMMARCORE_REF(corep);
+  earleyGrammarp->corep = corep;
+
+  /* Inherit the overlays of the origin */
+  if (earleyGrammarOriginp->symbolOptionOverlayp != NULL) {
+    if (! earleyGrammar_symbolOverlay_ensureb(earleyGrammarp)) {
       goto err;
     }
-    earleyRulep = (earleyRule_t *) malloc(sizeof(earleyRule_t));
-    if (earleyRulep == NULL) {
-      EARLEYGRAMMAR_ERRORF(earleyGrammarOriginp, "malloc failure, %s\n", strerror(errno));
+    memcpy(earleyGrammarp->symbolOptionOverlayp,       earleyGrammarOriginp->symbolOptionOverlayp,       corep->nSymboli * sizeof(earleyGrammarSymbolOption_t));
+    memcpy(earleyGrammarp->symbolEventBitSetOverlayip, earleyGrammarOriginp->symbolEventBitSetOverlayip, corep->nSymboli * sizeof(int));
+  }
+  if (earleyGrammarOriginp->ruleOptionOverlayp != NULL) {
+    if (! earleyGrammar_ruleOverlay_ensureb(earleyGrammarp)) {
       goto err;
     }
-    *earleyRulep = *earleyRuleOriginp;
-    GENERICSTACK_PUSH_PTR(ruleStackp, earleyRulep);
-    if (GENERICSTACK_ERROR(ruleStackp)) {
-      EARLEYGRAMMAR_ERRORF(earleyGrammarOriginp, "GENERICSTACK_PUSH_PTR failure, %s\n", strerror(errno));
-      goto err;
+    memcpy(earleyGrammarp->ruleOptionOverlayp, earleyGrammarOriginp->ruleOptionOverlayp, corep->nRulei * sizeof(earleyGrammarRuleOption_t));
+  }
+
+  /* Apply clone options */
+  if (optionp->symbolOptionSetterp != NULL) {
+    for (i = 0; i < corep->nSymboli; i++) {
+      symbolOptionp = EARLEYGRAMMAR_SYMBOLOPTIONP(earleyGrammarp, i);
+      symbolOption  = *symbolOptionp;
+      if (! optionp->symbolOptionSetterp(optionp->userDatavp, i, &symbolOption)) {
+        EARLEYGRAMMAR_ERROR(earleyGrammarOriginp, "symbolOptionSetterp failure\n");
+        goto err;
+      }
+      if ((symbolOption.terminalb != symbolOptionp->terminalb) || (symbolOption.startb != symbolOptionp->startb)) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarOriginp, "Symbol %d: only eventSeti can be changed in a clone\n", i);
+        errno = EINVAL;
+        goto err;
+      }
+      if (symbolOption.eventSeti != symbolOptionp->eventSeti) {
+        if (! earleyGrammar_symbolOverlay_ensureb(earleyGrammarp)) {
+          goto err;
+        }
+        earleyGrammarp->symbolOptionOverlayp[i]       = symbolOption;
+        earleyGrammarp->symbolEventBitSetOverlayip[i] = earleyGrammar_symbolEvent_computei(&symbolOption);
+      }
     }
-    /* Apply clone options */
-    if (optionp != NULL) {
-      if (! optionp->ruleOptionSetterp(optionp->userDatavp, earleyRulep->idi, &(earleyRulep->option))) {
+  }
+
+  if (optionp->ruleOptionSetterp != NULL) {
+    for (i = 0; i < corep->nRulei; i++) {
+      ruleOptionp = EARLEYGRAMMAR_RULEOPTIONP(earleyGrammarp, i);
+      ruleOption  = *ruleOptionp;
+      if (! optionp->ruleOptionSetterp(optionp->userDatavp, i, &ruleOption)) {
         EARLEYGRAMMAR_ERROR(earleyGrammarOriginp, "ruleOptionSetterp failure\n");
         goto err;
       }
+      if ((ruleOption.sequenceb        != ruleOptionp->sequenceb)        ||
+          (ruleOption.separatorSymboli != ruleOptionp->separatorSymboli) ||
+          (ruleOption.properb          != ruleOptionp->properb)          ||
+          (ruleOption.minimumi         != ruleOptionp->minimumi)) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarOriginp, "Rule %d: only ranki and nullRanksHighb can be changed in a clone\n", i);
+        errno = EINVAL;
+        goto err;
+      }
+      if ((ruleOption.ranki != ruleOptionp->ranki) || (ruleOption.nullRanksHighb != ruleOptionp->nullRanksHighb)) {
+        if (! earleyGrammar_ruleOverlay_ensureb(earleyGrammarp)) {
+          goto err;
+        }
+        earleyGrammarp->ruleOptionOverlayp[i] = ruleOption;
+      }
+    }
+  }
+
+  if (optionp->grammarOptionSetterp != NULL) {
+    if (! optionp->grammarOptionSetterp(optionp->userDatavp, &(earleyGrammarp->option))) {
+      EARLEYGRAMMAR_ERROR(earleyGrammarOriginp, "grammarOptionSetterp failure\n");
+      goto err;
+    }
+  }
+
+  earleyGrammarp->precomputedb = earleyGrammarOriginp->precomputedb;
+
+  goto done;
+
+ err:
+  earleyGrammar_freev(earleyGrammarp);
+  earleyGrammarp = NULL;
+
+ done:
+  return earleyGrammarp;
+}
+
+/****************************************************************************/
+/* earleyGrammar_freev                                                      */
+/****************************************************************************/
+void earleyGrammar_freev(earleyGrammar_t *earleyGrammarp)
+{
+  earleyAllocator_t allocator;
+
+  if (earleyGrammarp != NULL) {
+
+    earleyGrammarCore_unrefv(earleyGrammarp->corep);
+
+    if (earleyGrammarp->eventBitSetp != NULL) {
+      earleyGrammarp->allocator.freep(earleyGrammarp->allocator.userDatavp, earleyGrammarp->eventBitSetp);
+    }
+    if (earleyGrammarp->eventp != NULL) {
+      earleyGrammarp->allocator.freep(earleyGrammarp->allocator.userDatavp, earleyGrammarp->eventp);
+    }
+
+    if (earleyGrammarp->allocator.arenab) {
+      earleyAllocator_releasev(&(earleyGrammarp->allocator));
+    } else {
+      EARLEYGRAMMAR_TABLE_FREE(&(earleyGrammarp->allocator), earleyGrammarp->symbolOptionOverlayp);
+      EARLEYGRAMMAR_TABLE_FREE(&(earleyGrammarp->allocator), earleyGrammarp->symbolEventBitSetOverlayip);
+      EARLEYGRAMMAR_TABLE_FREE(&(earleyGrammarp->allocator), earleyGrammarp->ruleOptionOverlayp);
+    }
+
+    if (! earleyGrammarp->storageb) {
+      allocator = earleyGrammarp->allocator;
+      allocator.freep(allocator.userDatavp, earleyGrammarp);
+    }
+  }
+}
+
+/****************************************************************************/
+static inline uint64_t earleyGrammar_image_checksuml(uint64_t checksuml, const void *p, size_t sizel)
+/****************************************************************************/
+/* FNV-1a on 64-bit words. A trailing partial word is zero-padded, exactly */
+/* like the sections are in the image.                                     */
+/****************************************************************************/
+{
+  const unsigned char *bytep = (const unsigned char *) p;
+  uint64_t             wordl;
+
+  while (sizel > 0) {
+    wordl = 0;
+    if (sizel >= sizeof(uint64_t)) {
+      memcpy(&wordl, bytep, sizeof(uint64_t));
+      bytep += sizeof(uint64_t);
+      sizel -= sizeof(uint64_t);
+    } else {
+      memcpy(&wordl, bytep, sizel);
+      sizel = 0;
+    }
+    checksuml ^= wordl;
+    checksuml *= EARLEYGRAMMAR_IMAGE_FNV_PRIME;
+  }
+
+  return checksuml;
+}
+
+/****************************************************************************/
+static inline const void *earleyGrammar_image_sectionp(earleyGrammar_t *earleyGrammarp, int sectioni, size_t *sizelp)
+/****************************************************************************/
+/* Effective content of a section, i.e. with overlays applied              */
+/****************************************************************************/
+{
+  earleyGrammarCore_t *corep    = earleyGrammarp->corep;
+  size_t               nSymboll = (size_t) corep->nSymboli;
+  size_t               nRulel   = (size_t) corep->nRulei;
+  const void          *p;
+
+  switch (sectioni) {
+  case EARLEYGRAMMAR_IMAGE_SECTION_SYMBOLPROPERTY:
+    p = corep->symbolPropertyBitSetip;
+    *sizelp = nSymboll * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_SYMBOLEVENT:
+    p = (earleyGrammarp->symbolEventBitSetOverlayip != NULL) ? earleyGrammarp->symbolEventBitSetOverlayip : corep->symbolEventBitSetip;
+    *sizelp = nSymboll * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_SYMBOLOPTION:
+    p = (earleyGrammarp->symbolOptionOverlayp != NULL) ? earleyGrammarp->symbolOptionOverlayp : corep->symbolOptionp;
+    *sizelp = nSymboll * sizeof(earleyGrammarSymbolOption_t);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_RULELHS:
+    p = corep->ruleLhsSymbolip;
+    *sizelp = nRulel * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_RULERHSOFFSET:
+    p = corep->ruleRhsOffsetip;
+    *sizelp = nRulel * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_RULERHSLENGTH:
+    p = corep->ruleRhsLengthip;
+    *sizelp = nRulel * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_RULEPROPERTY:
+    p = corep->rulePropertyBitSetip;
+    *sizelp = nRulel * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_RULEOPTION:
+    p = (earleyGrammarp->ruleOptionOverlayp != NULL) ? earleyGrammarp->ruleOptionOverlayp : corep->ruleOptionp;
+    *sizelp = nRulel * sizeof(earleyGrammarRuleOption_t);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_RHSSYMBOL:
+    p = corep->rhsSymbolip;
+    *sizelp = (size_t) corep->nRhsi * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_LHSRULEOFFSET:
+    p = corep->symbolLhsRuleOffsetip;
+    *sizelp = (nSymboll + 1) * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_LHSRULE:
+    p = corep->lhsRuleip;
+    *sizelp = nRulel * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_RHSRULEOFFSET:
+    p = corep->symbolRhsRuleOffsetip;
+    *sizelp = (nSymboll + 1) * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_RHSRULE:
+    p = corep->rhsRuleip;
+    *sizelp = (size_t) corep->nRhsi * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_CLOSUREROW:
+    p = corep->symbolClosureRowip;
+    *sizelp = nSymboll * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_CLOSURE:
+    p = corep->closurep;
+    *sizelp = (size_t) corep->nClosureRowi * EARLEYGRAMMAR_BITSET_WORDL(nSymboll) * sizeof(earleyGrammarBitWord_t);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_PREDICTIONROW:
+    p = corep->symbolPredictionRowip;
+    *sizelp = nSymboll * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_PREDICTION:
+    p = corep->predictionp;
+    *sizelp = (size_t) corep->nPredictionRowi * EARLEYGRAMMAR_BITSET_WORDL(nRulel) * sizeof(earleyGrammarBitWord_t);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULELHS:
+    p = corep->nnfRuleLhsSymbolip;
+    *sizelp = (size_t) corep->nNnfRulei * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULERHSOFFSET:
+    p = corep->nnfRuleRhsOffsetip;
+    *sizelp = (size_t) corep->nNnfRulei * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULERHSLENGTH:
+    p = corep->nnfRuleRhsLengthip;
+    *sizelp = (size_t) corep->nNnfRulei * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULEUSER:
+    p = corep->nnfRuleUserip;
+    *sizelp = (size_t) corep->nNnfRulei * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULENULLED:
+    p = corep->nnfRuleNulledip;
+    *sizelp = (size_t) corep->nNnfRulei * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_NNFRHSSYMBOL:
+    p = corep->nnfRhsSymbolip;
+    *sizelp = (size_t) corep->nNnfRhsi * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_DFASTATEITEMOFFSET:
+    p = corep->dfaStateItemOffsetip;
+    *sizelp = (corep->nDfaStatei > 0) ? ((size_t) corep->nDfaStatei + 1) * sizeof(int) : 0;
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_DFAITEMRULE:
+    p = corep->dfaItemRuleip;
+    *sizelp = (size_t) corep->nDfaItemi * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_DFAITEMDOT:
+    p = corep->dfaItemDotip;
+    *sizelp = (size_t) corep->nDfaItemi * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_DFASTATENONKERNEL:
+    p = corep->dfaStateNonKernelip;
+    *sizelp = (size_t) corep->nDfaStatei * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_DFASTATETRANSITIONOFFSET:
+    p = corep->dfaStateTransitionOffsetip;
+    *sizelp = (corep->nDfaStatei > 0) ? ((size_t) corep->nDfaStatei + 1) * sizeof(int) : 0;
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_DFATRANSITIONSYMBOL:
+    p = corep->dfaTransitionSymbolip;
+    *sizelp = (size_t) corep->nDfaTransitioni * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_DFATRANSITIONSTATE:
+    p = corep->dfaTransitionStateip;
+    *sizelp = (size_t) corep->nDfaTransitioni * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_FIRST:
+    p = corep->firstp;
+    *sizelp = (size_t) corep->nClosureRowi * EARLEYGRAMMAR_BITSET_WORDL(nSymboll + 1) * sizeof(earleyGrammarBitWord_t);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_DOTTEDLOOKAHEADROW:
+    p = corep->dottedLookaheadRowip;
+    *sizelp = ((size_t) corep->nRhsi + nRulel) * sizeof(int);
+    break;
+  case EARLEYGRAMMAR_IMAGE_SECTION_LOOKAHEAD:
+    p = corep->lookaheadp;
+    *sizelp = (size_t) corep->nLookaheadRowi * EARLEYGRAMMAR_BITSET_WORDL(nSymboll + 1) * sizeof(earleyGrammarBitWord_t);
+    break;
+  default:
+    p = NULL;
+    *sizelp = 0;
+    break;
+  }
+
+  return p;
+}
+
+/****************************************************************************/
+static inline void *earleyGrammar_image_buildp(earleyGrammar_t *earleyGrammarp, size_t *imagelp)
+/****************************************************************************/
+/* Image layout: a header, a section directory, then the sections. All     */
+/* offsets are relative to the start of the image, so that it can be used  */
+/* wherever it is mapped. The image comes from the allocator hooks.         */
+/****************************************************************************/
+{
+  earleyGrammarImageHeader_t   header;
+  earleyGrammarImageSection_t  section[EARLEYGRAMMAR_IMAGE_SECTION_MAX];
+  const void                  *sectionp[EARLEYGRAMMAR_IMAGE_SECTION_MAX];
+  unsigned char               *imagep;
+  size_t                       offsetl;
+  size_t                       sizel;
+  int                          i;
+
+  if (! earleyGrammarp->precomputedb) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Grammar must be precomputed\n");
+    errno = EINVAL;
+    return NULL;
+  }
+
+  /* Layout */
+  offsetl = sizeof(earleyGrammarImageHeader_t) + sizeof(section);
+  for (i = 0; i < EARLEYGRAMMAR_IMAGE_SECTION_MAX; i++) {
+    sectionp[i] = earleyGrammar_image_sectionp(earleyGrammarp, i + 1, &sizel);
+    section[i].idi       = (uint32_t) (i + 1);
+    section[i].reservedi = 0;
+    section[i].offsetl   = (uint64_t) offsetl;
+    section[i].sizel     = (uint64_t) sizel;
+    offsetl += EARLEYGRAMMAR_IMAGE_ALIGN(sizel);
+  }
+
+  imagep = (unsigned char *) earleyGrammarp->allocator.mallocp(earleyGrammarp->allocator.userDatavp, offsetl);
+  if (imagep == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    return NULL;
+  }
+  /* Padding is part of the checksum */
+  memset(imagep, 0, offsetl);
+
+  memcpy(imagep + sizeof(header), section, sizeof(section));
+  for (i = 0; i < EARLEYGRAMMAR_IMAGE_SECTION_MAX; i++) {
+    if (section[i].sizel > 0) {
+      memcpy(imagep + section[i].offsetl, sectionp[i], (size_t) section[i].sizel);
     }
   }
 
-  /* Apply clone options */
-  if (optionp != NULL) {
-    if (! optionp->grammarOptionSetterp(optionp->userDatavp, &(earleyGrammarp->option))) {
-      EARLEYGRAMMAR_ERROR(earleyGrammarOriginp, "grammarOptionSetterp failure\n");
-      goto err;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magics, EARLEYGRAMMAR_IMAGE_MAGIC, sizeof(header.magics));
+  header.endiani           = EARLEYGRAMMAR_IMAGE_ENDIAN;
+  header.versioni          = EARLEYGRAMMAR_IMAGE_VERSION;
+  header.intSizei          = (uint32_t) sizeof(int);
+  header.symbolOptionSizei = (uint32_t) sizeof(earleyGrammarSymbolOption_t);
+  header.ruleOptionSizei   = (uint32_t) sizeof(earleyGrammarRuleOption_t);
+  header.sectioni          = EARLEYGRAMMAR_IMAGE_SECTION_MAX;
+  header.imagel            = (uint64_t) offsetl;
+  header.checksuml         = earleyGrammar_image_checksuml(EARLEYGRAMMAR_IMAGE_FNV_OFFSET, imagep + sizeof(header), offsetl - sizeof(header));
+  header.nSymboli          = earleyGrammarp->corep->nSymboli;
+  header.nRulei            = earleyGrammarp->corep->nRulei;
+  header.nRhsi             = earleyGrammarp->corep->nRhsi;
+  header.startSymboli      = earleyGrammarp->corep->startSymboli;
+  header.nClosureRowi      = earleyGrammarp->corep->nClosureRowi;
+  header.nPredictionRowi   = earleyGrammarp->corep->nPredictionRowi;
+  header.nNnfSymboli       = earleyGrammarp->corep->nNnfSymboli;
+  header.nNnfRulei         = earleyGrammarp->corep->nNnfRulei;
+  header.nNnfRhsi          = earleyGrammarp->corep->nNnfRhsi;
+  header.nDfaStatei        = earleyGrammarp->corep->nDfaStatei;
+  header.nDfaItemi         = earleyGrammarp->corep->nDfaItemi;
+  header.nDfaTransitioni   = earleyGrammarp->corep->nDfaTransitioni;
+  header.nLookaheadRowi    = earleyGrammarp->corep->nLookaheadRowi;
+  memcpy(imagep, &header, sizeof(header));
+
+  *imagelp = offsetl;
+  return imagep;
+}
+
+/****************************************************************************/
+/* earleyGrammar_saveb                                                      */
+/****************************************************************************/
+short earleyGrammar_saveb(earleyGrammar_t *earleyGrammarp, const char *pathp)
+{
+  void   *imagep = NULL;
+  FILE   *fp     = NULL;
+  size_t  imagel;
+  short   rcb;
+
+  if ((earleyGrammarp == NULL) || (pathp == NULL)) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  imagep = earleyGrammar_image_buildp(earleyGrammarp, &imagel);
+  if (imagep == NULL) {
+    goto err;
+  }
+
+  fp = fopen(pathp, "wb");
+  if (fp == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: %s\n", pathp, strerror(errno));
+    goto err;
+  }
+  if (fwrite(imagep, 1, imagel, fp) != imagel) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: write failure, %s\n", pathp, strerror(errno));
+    goto err;
+  }
+  if (fclose(fp) != 0) {
+    fp = NULL;
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: write failure, %s\n", pathp, strerror(errno));
+    goto err;
+  }
+  fp = NULL;
+
+  rcb = 1;
+  goto done;
+
+ err:
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  rcb = 0;
+
+ done:
+  if (imagep != NULL) {
+    earleyGrammarp->allocator.freep(earleyGrammarp->allocator.userDatavp, imagep);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+/* earleyGrammar_generateb                                                  */
+/****************************************************************************/
+/* Writes every table as a named static const C array, an                  */
+/* earleyGrammarStatic_t pointing at them, and the constructors using it  */
+/* in place: <prefixp>_newp(earleyGrammarOption_t *) and                   */
+/* <prefixp>_initp(earleyGrammarStorage_t *, earleyGrammarOption_t *).     */
+/****************************************************************************/
+short earleyGrammar_generateb(earleyGrammar_t *earleyGrammarp, const char *prefixp, const char *cPathp, const char *hPathp)
+{
+  earleyGrammarCore_t *corep;
+  FILE                *cfp = NULL;
+  FILE                *hfp = NULL;
+  const char          *hNamep;
+  const char          *p;
+  const void          *sectionp;
+  size_t               sizel;
+  int                  sectioni;
+  short                rcb;
+
+  if ((earleyGrammarp == NULL) || (prefixp == NULL) || (cPathp == NULL) || (hPathp == NULL)) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  for (p = prefixp; *p != '\0'; p++) {
+    if (! (((*p >= 'a') && (*p <= 'z')) || ((*p >= 'A') && (*p <= 'Z')) || (*p == '_') || ((p > prefixp) && (*p >= '0') && (*p <= '9')))) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: prefix must be a C identifier\n", prefixp);
+      errno = EINVAL;
+      goto err;
+    }
+  }
+  if (*prefixp == '\0') {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Empty prefix\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  if ((! earleyGrammarp->precomputedb) && (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    goto err;
+  }
+  corep = earleyGrammarp->corep;
+
+  /* The header is included by its file name */
+  hNamep = hPathp;
+  for (p = hPathp; *p != '\0'; p++) {
+    if ((*p == '/') || (*p == '\\')) {
+      hNamep = p + 1;
+    }
+  }
+
+  hfp = fopen(hPathp, "w");
+  if (hfp == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: %s\n", hPathp, strerror(errno));
+    goto err;
+  }
+  fprintf(hfp,
+          "/* Generated by earleyGrammar_generateb - do not edit */\n"
+          "#ifndef %s_EARLEYGRAMMAR_H\n"
+          "#define %s_EARLEYGRAMMAR_H\n"
+          "\n"
+          "#include <earley/grammar.h>\n"
+          "\n"
+          "#ifdef __cplusplus\n"
+          "extern \"C\" {\n"
+          "#endif\n"
+          "  /* Precomputed grammar using static tables. NULL earleyGrammarOptionp means default options. */\n"
+          "  earleyGrammar_t *%s_newp(earleyGrammarOption_t *earleyGrammarOptionp);\n"
+          "  /* Same in earleyGrammarStoragep, without any allocation */\n"
+          "  earleyGrammar_t *%s_initp(earleyGrammarStorage_t *earleyGrammarStoragep, earleyGrammarOption_t *earleyGrammarOptionp);\n"
+          "#ifdef __cplusplus\n"
+          "}\n"
+          "#endif\n"
+          "\n"
+          "#endif /* %s_EARLEYGRAMMAR_H */\n",
+          prefixp, prefixp, prefixp, prefixp, prefixp);
+  if (fclose(hfp) != 0) {
+    hfp = NULL;
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: write failure, %s\n", hPathp, strerror(errno));
+    goto err;
+  }
+  hfp = NULL;
+
+  cfp = fopen(cPathp, "w");
+  if (cfp == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: %s\n", cPathp, strerror(errno));
+    goto err;
+  }
+  fprintf(cfp,
+          "/* Generated by earleyGrammar_generateb - do not edit */\n"
+          "#include <stddef.h>\n"
+          "#include \"%s\"\n",
+          hNamep);
+  for (sectioni = 1; sectioni <= EARLEYGRAMMAR_IMAGE_SECTION_MAX; sectioni++) {
+    sectionp = earleyGrammar_image_sectionp(earleyGrammarp, sectioni, &sizel);
+    earleyGrammar_static_writev(cfp, prefixp, sectioni, sectionp, sizel);
+  }
+  fprintf(cfp,
+          "\n"
+          "static const earleyGrammarStatic_t %s_static = {\n"
+          "  %d,\n"
+          "  %d, %d, %d, %d,\n"
+          "  %d, %d,\n"
+          "  %d, %d, %d,\n"
+          "  %d, %d, %d,\n"
+          "  %d,\n",
+          prefixp,
+          EARLEYGRAMMAR_STATIC_VERSION,
+          corep->nSymboli, corep->nRulei, corep->nRhsi, corep->startSymboli,
+          corep->nClosureRowi, corep->nPredictionRowi,
+          corep->nNnfSymboli, corep->nNnfRulei, corep->nNnfRhsi,
+          corep->nDfaStatei, corep->nDfaItemi, corep->nDfaTransitioni,
+          corep->nLookaheadRowi);
+  for (sectioni = 1; sectioni <= EARLEYGRAMMAR_IMAGE_SECTION_MAX; sectioni++) {
+    earleyGrammar_image_sectionp(earleyGrammarp, sectioni, &sizel);
+    if (sizel > 0) {
+      fprintf(cfp, "  %s_%s", prefixp, earleyGrammarStaticArrayp[sectioni].namep);
+    } else {
+      fprintf(cfp, "  NULL");
+    }
+    fprintf(cfp, "%s\n", (sectioni < EARLEYGRAMMAR_IMAGE_SECTION_MAX) ? "," : "");
+  }
+  fprintf(cfp,
+          "};\n"
+          "\n"
+          "earleyGrammar_t *%s_newp(earleyGrammarOption_t *earleyGrammarOptionp)\n"
+          "{\n"
+          "  return earleyGrammar_staticp(&%s_static, NULL, earleyGrammarOptionp);\n"
+          "}\n"
+          "\n"
+          "earleyGrammar_t *%s_initp(earleyGrammarStorage_t *earleyGrammarStoragep, earleyGrammarOption_t *earleyGrammarOptionp)\n"
+          "{\n"
+          "  return earleyGrammar_staticp(&%s_static, earleyGrammarStoragep, earleyGrammarOptionp);\n"
+          "}\n",
+          prefixp, prefixp, prefixp, prefixp);
+  if (ferror(cfp) || (fclose(cfp) != 0)) {
+    cfp = NULL;
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: write failure, %s\n", cPathp, strerror(errno));
+    goto err;
+  }
+  cfp = NULL;
+
+  rcb = 1;
+  goto done;
+
+ err:
+  if (hfp != NULL) {
+    fclose(hfp);
+  }
+  if (cfp != NULL) {
+    fclose(cfp);
+  }
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_static_writev(FILE *fp, const char *prefixp, int sectioni, const void *p, size_t sizel)
+/****************************************************************************/
+/* One section as "static const <type> <prefixp>_<name>[n]". C has no     */
+/* empty arrays: an empty section is a NULL pointer.                       */
+/****************************************************************************/
+{
+  const earleyGrammarStaticArray_t  *arrayp        = &(earleyGrammarStaticArrayp[sectioni]);
+  const int                         *ip            = (const int *) p;
+  const earleyGrammarBitWord_t      *wordp         = (const earleyGrammarBitWord_t *) p;
+  const earleyGrammarSymbolOption_t *symbolOptionp = (const earleyGrammarSymbolOption_t *) p;
+  const earleyGrammarRuleOption_t   *ruleOptionp   = (const earleyGrammarRuleOption_t *) p;
+  const char                        *typep;
+  size_t                             nl;
+  size_t                             perLinel;
+  size_t                             l;
+
+  switch (arrayp->typei) {
+  case EARLEYGRAMMAR_STATIC_BITWORD:
+    typep    = "earleyGrammarBitWord_t";
+    nl       = sizel / sizeof(earleyGrammarBitWord_t);
+    perLinel = 4;
+    break;
+  case EARLEYGRAMMAR_STATIC_SYMBOLOPTION:
+    typep    = "earleyGrammarSymbolOption_t";
+    nl       = sizel / sizeof(earleyGrammarSymbolOption_t);
+    perLinel = 4;
+    break;
+  case EARLEYGRAMMAR_STATIC_RULEOPTION:
+    typep    = "earleyGrammarRuleOption_t";
+    nl       = sizel / sizeof(earleyGrammarRuleOption_t);
+    perLinel = 2;
+    break;
+  default:
+    typep    = "int";
+    nl       = sizel / sizeof(int);
+    perLinel = 12;
+    break;
+  }
+  if (nl == 0) {
+    return;
+  }
+
+  fprintf(fp, "\nstatic const %s %s_%s[%lu] = {", typep, prefixp, arrayp->namep, (unsigned long) nl);
+  for (l = 0; l < nl; l++) {
+    fputs(((l % perLinel) == 0) ? "\n  " : " ", fp);
+    switch (arrayp->typei) {
+    case EARLEYGRAMMAR_STATIC_BITWORD:
+      fprintf(fp, "0x%016llxULL", (unsigned long long) wordp[l]);
+      break;
+    case EARLEYGRAMMAR_STATIC_SYMBOLOPTION:
+      fprintf(fp, "{%d, %d, %d}", (int) symbolOptionp[l].terminalb, (int) symbolOptionp[l].startb, symbolOptionp[l].eventSeti);
+      break;
+    case EARLEYGRAMMAR_STATIC_RULEOPTION:
+      fprintf(fp, "{%d, %d, %d, %d, %d, %d}", ruleOptionp[l].ranki, (int) ruleOptionp[l].nullRanksHighb, (int) ruleOptionp[l].sequenceb, ruleOptionp[l].separatorSymboli, (int) ruleOptionp[l].properb, ruleOptionp[l].minimumi);
+      break;
+    default:
+      fprintf(fp, "%d", ip[l]);
+      break;
+    }
+    if (l < nl - 1) {
+      fputc(',', fp);
+    }
+  }
+  fputs("\n};\n", fp);
+}
+
+/****************************************************************************/
+static inline void *earleyGrammar_image_readp(earleyGrammar_t *earleyGrammarp, const char *pathp, size_t *sizelp, earleyGrammarCoreImage_t *imageip)
+/****************************************************************************/
+/* Maps the file if possible, else copies it into memory from the hooks    */
+/****************************************************************************/
+{
+  void  *imagep = NULL;
+  FILE  *fp     = NULL;
+  long   sizel;
+#ifdef EARLEYGRAMMAR_IMAGE_MMAP
+  int          fd;
+  struct stat  st;
+
+  fd = open(pathp, O_RDONLY);
+  if (fd >= 0) {
+    if ((fstat(fd, &st) == 0) && (st.st_size > 0) && ((uint64_t) st.st_size <= (uint64_t) SIZE_MAX)) {
+      imagep = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (imagep != MAP_FAILED) {
+        close(fd);
+        *sizelp  = (size_t) st.st_size;
+        *imageip = EARLEYGRAMMARCORE_IMAGE_MMAP;
+        return imagep;
+      }
+      imagep = NULL;
+    }
+    close(fd);
+  }
+#endif
+
+  fp = fopen(pathp, "rb");
+  if (fp == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: %s\n", pathp, strerror(errno));
+    goto err;
+  }
+  if ((fseek(fp, 0, SEEK_END) != 0) || ((sizel = ftell(fp)) < 0) || (fseek(fp, 0, SEEK_SET) != 0)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: %s\n", pathp, strerror(errno));
+    goto err;
+  }
+  if (sizel == 0) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: empty file\n", pathp);
+    errno = EINVAL;
+    goto err;
+  }
+
+  /* Image tables are freed as a whole: never from the arena */
+  imagep = earleyGrammarp->allocator.mallocp(earleyGrammarp->allocator.userDatavp, (size_t) sizel);
+  if (imagep == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  if (fread(imagep, 1, (size_t) sizel, fp) != (size_t) sizel) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "%s: read failure\n", pathp);
+    errno = EIO;
+    goto err;
+  }
+  fclose(fp);
+
+  *sizelp  = (size_t) sizel;
+  *imageip = EARLEYGRAMMARCORE_IMAGE_HEAP;
+  return imagep;
+
+ err:
+  if (imagep != NULL) {
+    earleyGrammarp->allocator.freep(earleyGrammarp->allocator.userDatavp, imagep);
+  }
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  return NULL;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_image_indexb(int *offsetip, int nOffseti, int *entryip, int nEntryi, int maxi)
+/****************************************************************************/
+/* Checks a compressed sparse rows index of nOffseti rows                  */
+/****************************************************************************/
+{
+  int i;
+
+  if (offsetip[0] != 0) {
+    return 0;
+  }
+  for (i = 0; i < nOffseti; i++) {
+    if (offsetip[i + 1] < offsetip[i]) {
+      return 0;
+    }
+  }
+  if (offsetip[nOffseti] != nEntryi) {
+    return 0;
+  }
+  for (i = 0; i < nEntryi; i++) {
+    if ((entryip[i] < 0) || (entryip[i] >= maxi)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_image_rowb(int *rowip, int nRowi, int maxi)
+/****************************************************************************/
+{
+  int i;
+
+  for (i = 0; i < nRowi; i++) {
+    if ((rowip[i] < 0) || (rowip[i] >= maxi)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_image_openb(earleyGrammar_t *earleyGrammarp, earleyGrammarCore_t *corep)
+/****************************************************************************/
+/* Validates corep->imagep and makes the core tables point into it         */
+/****************************************************************************/
+{
+  const unsigned char         *imagep = (const unsigned char *) corep->imagep;
+  size_t                       imagel = corep->imagel;
+  earleyGrammarImageHeader_t   header;
+  earleyGrammarImageSection_t  section;
+  size_t                       directoryl;
+  size_t                       expectedl;
+  void                        *sectionp;
+  uint64_t                     seenl = 0;
+  int                          sectioni;
+  int                          i;
+  int                          j;
+  int                          offseti;
+  int                          lengthi;
+
+  if (imagel < sizeof(header)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image is truncated\n");
+    goto err;
+  }
+  memcpy(&header, imagep, sizeof(header));
+
+  if (memcmp(header.magics, EARLEYGRAMMAR_IMAGE_MAGIC, sizeof(header.magics)) != 0) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Not a grammar image\n");
+    goto err;
+  }
+  if (header.endiani != EARLEYGRAMMAR_IMAGE_ENDIAN) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image has a different endianness\n");
+    goto err;
+  }
+  if (header.versioni != EARLEYGRAMMAR_IMAGE_VERSION) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image version is %u, expected %u\n", (unsigned int) header.versioni, (unsigned int) EARLEYGRAMMAR_IMAGE_VERSION);
+    goto err;
+  }
+  if ((header.intSizei != sizeof(int)) || (header.symbolOptionSizei != sizeof(earleyGrammarSymbolOption_t)) || (header.ruleOptionSizei != sizeof(earleyGrammarRuleOption_t))) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image was saved with a different ABI\n");
+    goto err;
+  }
+  if ((header.imagel != (uint64_t) imagel) || ((imagel % EARLEYGRAMMAR_IMAGE_ALIGNL) != 0)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image size mismatch\n");
+    goto err;
+  }
+  if ((header.nSymboli < 0) || (header.nRulei < 0) || (header.nRhsi < 0) || (header.startSymboli < 0) || (header.startSymboli >= header.nSymboli) || (header.nClosureRowi < 0) || (header.nPredictionRowi < 1) || (header.nNnfSymboli < header.nSymboli) || (header.nNnfRulei < 0) || (header.nNnfRhsi < 0) || (header.nDfaStatei < 0) || (header.nDfaItemi < 0) || (header.nDfaTransitioni < 0) || (header.nLookaheadRowi < 0) || (header.sectioni > (imagel - sizeof(header)) / sizeof(section))) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image header is corrupted\n");
+    goto err;
+  }
+  if (earleyGrammar_image_checksuml(EARLEYGRAMMAR_IMAGE_FNV_OFFSET, imagep + sizeof(header), imagel - sizeof(header)) != header.checksuml) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image checksum mismatch\n");
+    goto err;
+  }
+
+  corep->nSymboli     = header.nSymboli;
+  corep->symbolAllocl = (size_t) header.nSymboli;
+  corep->nRulei       = header.nRulei;
+  corep->ruleAllocl   = (size_t) header.nRulei;
+  corep->nRhsi        = header.nRhsi;
+  corep->rhsAllocl    = (size_t) header.nRhsi;
+  corep->startSymboli = header.startSymboli;
+  corep->nClosureRowi    = header.nClosureRowi;
+  corep->nPredictionRowi = header.nPredictionRowi;
+  corep->nNnfSymboli     = header.nNnfSymboli;
+  corep->nNnfRulei       = header.nNnfRulei;
+  corep->nNnfRhsi        = header.nNnfRhsi;
+  corep->nDfaStatei      = header.nDfaStatei;
+  corep->nDfaItemi       = header.nDfaItemi;
+  corep->nDfaTransitioni = header.nDfaTransitioni;
+  corep->nLookaheadRowi  = header.nLookaheadRowi;
+
+  /* Sections. Unknown ones are skipped. */
+  directoryl = sizeof(header);
+  for (i = 0; i < (int) header.sectioni; i++, directoryl += sizeof(section)) {
+    memcpy(&section, imagep + directoryl, sizeof(section));
+    if ((section.idi < 1) || (section.idi > EARLEYGRAMMAR_IMAGE_SECTION_MAX)) {
+      continue;
+    }
+    sectioni = (int) section.idi;
+    if (((section.offsetl % EARLEYGRAMMAR_IMAGE_ALIGNL) != 0) || (section.offsetl > (uint64_t) imagel) || (section.sizel > (uint64_t) imagel - section.offsetl)) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image section %d is out of bounds\n", sectioni);
+      goto err;
+    }
+    /* The expected size is given by the current layout of the core */
+    earleyGrammar_image_sectionp(earleyGrammarp, sectioni, &expectedl);
+    if (section.sizel != (uint64_t) expectedl) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image section %d has size %lu, expected %lu\n", sectioni, (unsigned long) section.sizel, (unsigned long) expectedl);
+      goto err;
+    }
+    sectionp = (expectedl > 0) ? (void *) (imagep + section.offsetl) : NULL;
+    switch (sectioni) {
+    case EARLEYGRAMMAR_IMAGE_SECTION_SYMBOLPROPERTY:
+      corep->symbolPropertyBitSetip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_SYMBOLEVENT:
+      corep->symbolEventBitSetip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_SYMBOLOPTION:
+      corep->symbolOptionp = (earleyGrammarSymbolOption_t *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_RULELHS:
+      corep->ruleLhsSymbolip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_RULERHSOFFSET:
+      corep->ruleRhsOffsetip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_RULERHSLENGTH:
+      corep->ruleRhsLengthip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_RULEPROPERTY:
+      corep->rulePropertyBitSetip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_RULEOPTION:
+      corep->ruleOptionp = (earleyGrammarRuleOption_t *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_RHSSYMBOL:
+      corep->rhsSymbolip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_LHSRULEOFFSET:
+      corep->symbolLhsRuleOffsetip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_LHSRULE:
+      corep->lhsRuleip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_RHSRULEOFFSET:
+      corep->symbolRhsRuleOffsetip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_RHSRULE:
+      corep->rhsRuleip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_CLOSUREROW:
+      corep->symbolClosureRowip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_CLOSURE:
+      corep->closurep = (earleyGrammarBitWord_t *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_PREDICTIONROW:
+      corep->symbolPredictionRowip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_PREDICTION:
+      corep->predictionp = (earleyGrammarBitWord_t *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULELHS:
+      corep->nnfRuleLhsSymbolip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULERHSOFFSET:
+      corep->nnfRuleRhsOffsetip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULERHSLENGTH:
+      corep->nnfRuleRhsLengthip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULEUSER:
+      corep->nnfRuleUserip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_NNFRULENULLED:
+      corep->nnfRuleNulledip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_NNFRHSSYMBOL:
+      corep->nnfRhsSymbolip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_DFASTATEITEMOFFSET:
+      corep->dfaStateItemOffsetip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_DFAITEMRULE:
+      corep->dfaItemRuleip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_DFAITEMDOT:
+      corep->dfaItemDotip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_DFASTATENONKERNEL:
+      corep->dfaStateNonKernelip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_DFASTATETRANSITIONOFFSET:
+      corep->dfaStateTransitionOffsetip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_DFATRANSITIONSYMBOL:
+      corep->dfaTransitionSymbolip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_DFATRANSITIONSTATE:
+      corep->dfaTransitionStateip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_FIRST:
+      corep->firstp = (earleyGrammarBitWord_t *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_DOTTEDLOOKAHEADROW:
+      corep->dottedLookaheadRowip = (int *) sectionp;
+      break;
+    case EARLEYGRAMMAR_IMAGE_SECTION_LOOKAHEAD:
+      corep->lookaheadp = (earleyGrammarBitWord_t *) sectionp;
+      break;
+    default:
+      break;
+    }
+    seenl |= ((uint64_t) 1) << sectioni;
+  }
+  for (sectioni = 1; sectioni <= EARLEYGRAMMAR_IMAGE_SECTION_MAX; sectioni++) {
+    if ((seenl & (((uint64_t) 1) << sectioni)) == 0) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image section %d is missing\n", sectioni);
+      goto err;
+    }
+  }
+
+  /* Symbol ids must be usable without further checks */
+  for (i = 0; i < corep->nRulei; i++) {
+    offseti = corep->ruleRhsOffsetip[i];
+    lengthi = corep->ruleRhsLengthip[i];
+    if ((corep->ruleLhsSymbolip[i] < 0) || (corep->ruleLhsSymbolip[i] >= corep->nSymboli) ||
+        (offseti < 0) || (lengthi < 0) || (offseti > corep->nRhsi - lengthi)) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image rule %d is corrupted\n", i);
+      goto err;
+    }
+  }
+  for (j = 0; j < corep->nRhsi; j++) {
+    if ((corep->rhsSymbolip[j] < 0) || (corep->rhsSymbolip[j] >= corep->nSymboli)) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image RHS symbol at offset %d is corrupted\n", j);
+      goto err;
+    }
+  }
+  if ((! earleyGrammar_image_indexb(corep->symbolLhsRuleOffsetip, corep->nSymboli, corep->lhsRuleip, corep->nRulei, corep->nRulei)) ||
+      (! earleyGrammar_image_indexb(corep->symbolRhsRuleOffsetip, corep->nSymboli, corep->rhsRuleip, corep->nRhsi, corep->nRulei))) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image index is corrupted\n");
+    goto err;
+  }
+  if ((! earleyGrammar_image_rowb(corep->symbolClosureRowip, corep->nSymboli, corep->nClosureRowi)) ||
+      (! earleyGrammar_image_rowb(corep->symbolPredictionRowip, corep->nSymboli, corep->nPredictionRowi)) ||
+      (! earleyGrammar_image_rowb(corep->dottedLookaheadRowip, corep->nRhsi + corep->nRulei, corep->nLookaheadRowi))) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image prediction rows are corrupted\n");
+    goto err;
+  }
+  for (i = 0; i < corep->nNnfRulei; i++) {
+    offseti = corep->nnfRuleRhsOffsetip[i];
+    lengthi = corep->nnfRuleRhsLengthip[i];
+    if ((corep->nnfRuleLhsSymbolip[i] < 0) || (corep->nnfRuleLhsSymbolip[i] >= corep->nNnfSymboli) ||
+        (corep->nnfRuleUserip[i] < 0) || (corep->nnfRuleUserip[i] >= corep->nRulei) ||
+        (offseti < 0) || (lengthi < 1) || (offseti > corep->nNnfRhsi - lengthi)) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image internal rule %d is corrupted\n", i);
+      goto err;
+    }
+  }
+  for (j = 0; j < corep->nNnfRhsi; j++) {
+    if ((corep->nnfRhsSymbolip[j] < 0) || (corep->nnfRhsSymbolip[j] >= corep->nNnfSymboli)) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image internal RHS symbol at offset %d is corrupted\n", j);
+      goto err;
+    }
+  }
+  if (corep->nDfaStatei > 0) {
+    if ((! earleyGrammar_image_indexb(corep->dfaStateItemOffsetip, corep->nDfaStatei, corep->dfaItemRuleip, corep->nDfaItemi, corep->nNnfRulei)) ||
+        (! earleyGrammar_image_indexb(corep->dfaStateTransitionOffsetip, corep->nDfaStatei, corep->dfaTransitionStateip, corep->nDfaTransitioni, corep->nDfaStatei))) {
+      EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image DFA is corrupted\n");
+      goto err;
+    }
+    for (j = 0; j < corep->nDfaItemi; j++) {
+      if ((corep->dfaItemDotip[j] < 0) || (corep->dfaItemDotip[j] > corep->nnfRuleRhsLengthip[corep->dfaItemRuleip[j]])) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image DFA item %d is corrupted\n", j);
+        goto err;
+      }
+    }
+    for (j = 0; j < corep->nDfaTransitioni; j++) {
+      if ((corep->dfaTransitionSymbolip[j] < 0) || (corep->dfaTransitionSymbolip[j] >= corep->nNnfSymboli)) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image DFA transition %d is corrupted\n", j);
+        goto err;
+      }
+    }
+    for (i = 0; i < corep->nDfaStatei; i++) {
+      if ((corep->dfaStateNonKernelip[i] < -1) || (corep->dfaStateNonKernelip[i] >= corep->nDfaStatei)) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Image DFA state %d is corrupted\n", i);
+        goto err;
+      }
+    }
+  } else if ((corep->nDfaItemi != 0) || (corep->nDfaTransitioni != 0)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Image DFA is corrupted\n");
+    goto err;
+  }
+
+  return 1;
+
+ err:
+  errno = EINVAL;
+  return 0;
+}
+
+/****************************************************************************/
+/* earleyGrammar_loadp                                                      */
+/****************************************************************************/
+earleyGrammar_t *earleyGrammar_loadp(const char *pathp, earleyGrammarOption_t *optionp)
+{
+  earleyGrammar_t          *earleyGrammarp = NULL;
+  earleyGrammarCore_t      *corep;
+  earleyGrammarCoreImage_t  imagei;
+  size_t                    imagel;
+  void                     *imagep;
+
+  if (pathp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (optionp == NULL) {
+    optionp = &earleyGrammarOptionDefault;
+  }
+
+  earleyGrammarp = earleyGrammar_allocp(optionp);
+  if (earleyGrammarp == NULL) {
+    goto err;
+  }
+
+  corep = earleyGrammarCore_newp(&(earleyGrammarp->allocator));
+  if (corep == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  earleyGrammarp->corep = corep;
+
+  imagep = earleyGrammar_image_readp(earleyGrammarp, pathp, &imagel, &imagei);
+  if (imagep == NULL) {
+    goto err;
+  }
+  corep->imagei = imagei;
+  corep->imagep = imagep;
+  corep->imagel = imagel;
+
+  if (! earleyGrammar_image_openb(earleyGrammarp, corep)) {
+    goto err;
+  }
+
+  earleyGrammarp->precomputedb = 1;
+
+  goto done;
+
+ err:
+  earleyGrammar_freev(earleyGrammarp);
+  earleyGrammarp = NULL;
+
+ done:
+  return earleyGrammarp;
+}
+
+/****************************************************************************/
+/* earleyGrammar_load_imagep                                                */
+/****************************************************************************/
+/* Same as earleyGrammar_loadp, for an image that is already in memory and */
+/* that outlives the grammar.                                              */
+/****************************************************************************/
+earleyGrammar_t *earleyGrammar_load_imagep(const void *imagep, size_t imagel, earleyGrammarOption_t *optionp)
+{
+  earleyGrammar_t     *earleyGrammarp = NULL;
+  earleyGrammarCore_t *corep;
+
+  if ((imagep == NULL) || ((((uintptr_t) imagep) % EARLEYGRAMMAR_IMAGE_ALIGNL) != 0)) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (optionp == NULL) {
+    optionp = &earleyGrammarOptionDefault;
+  }
+
+  earleyGrammarp = earleyGrammar_allocp(optionp);
+  if (earleyGrammarp == NULL) {
+    goto err;
+  }
+
+  corep = earleyGrammarCore_newp(&(earleyGrammarp->allocator));
+  if (corep == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  earleyGrammarp->corep = corep;
+
+  /* The image is never written to: any mutation gets a private core */
+  corep->imagei = EARLEYGRAMMARCORE_IMAGE_STATIC;
+  corep->imagep = (void *) imagep;
+  corep->imagel = imagel;
+
+  if (! earleyGrammar_image_openb(earleyGrammarp, corep)) {
+    goto err;
+  }
+
+  earleyGrammarp->precomputedb = 1;
+
+  goto done;
+
+ err:
+  earleyGrammar_freev(earleyGrammarp);
+  earleyGrammarp = NULL;
+
+ done:
+  return earleyGrammarp;
+}
+
+/****************************************************************************/
+/* earleyGrammar_staticp                                                    */
+/****************************************************************************/
+/* Same with the tables of earleyGrammar_generateb, that are used in place */
+/* as they are: they were validated when generated. In storagep, the      */
+/* grammar and the core are never freed, and nothing is allocated until a */
+/* mutation or an event.                                                   */
+/****************************************************************************/
+earleyGrammar_t *earleyGrammar_staticp(const earleyGrammarStatic_t *staticp, earleyGrammarStorage_t *storagep, earleyGrammarOption_t *optionp)
+{
+  earleyGrammar_t              *earleyGrammarp = NULL;
+  earleyGrammarCore_t          *corep;
+  earleyGrammarStorageLayout_t *layoutp;
+  earleyAllocator_t             allocator;
+
+  if (staticp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (optionp == NULL) {
+    optionp = &earleyGrammarOptionDefault;
+  }
+
+  if (storagep == NULL) {
+    earleyGrammarp = earleyGrammar_allocp(optionp);
+    if (earleyGrammarp == NULL) {
+      goto err;
+    }
+    corep = earleyGrammarCore_newp(&(earleyGrammarp->allocator));
+    if (corep == NULL) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+      goto err;
+    }
+  } else {
+    if (! earleyAllocator_initb(&allocator, optionp)) {
+      if (optionp->genericLoggerp != NULL) {
+        GENERICLOGGER_ERROR(optionp->genericLoggerp, "mallocp, reallocp and freep must be all set or all NULL");
+      }
+      goto err;
+    }
+    layoutp        = (earleyGrammarStorageLayout_t *) storagep;
+    earleyGrammarp = &(layoutp->grammar);
+    corep          = &(layoutp->core);
+    earleyGrammar_initv(earleyGrammarp, &allocator, optionp);
+    earleyGrammarCore_initv(corep, &allocator);
+    earleyGrammarp->storageb = 1;
+    corep->storageb          = 1;
+  }
+  earleyGrammarp->corep = corep;
+
+  /* The tables are never written to: any mutation gets a private core */
+  corep->imagei = EARLEYGRAMMARCORE_IMAGE_STATIC;
+  corep->imagep = (void *) staticp;
+  corep->imagel = sizeof(earleyGrammarStatic_t);
+
+  if (! earleyGrammar_static_openb(earleyGrammarp, corep, staticp)) {
+    goto err;
+  }
+
+  earleyGrammarp->precomputedb = 1;
+
+  goto done;
+
+ err:
+  earleyGrammar_freev(earleyGrammarp);
+  earleyGrammarp = NULL;
+
+ done:
+  return earleyGrammarp;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_static_openb(earleyGrammar_t *earleyGrammarp, earleyGrammarCore_t *corep, const earleyGrammarStatic_t *staticp)
+/****************************************************************************/
+/* Makes the core tables point at the static ones. Only the sizes are     */
+/* checked, as in an image header.                                         */
+/****************************************************************************/
+{
+  if (staticp->versioni != EARLEYGRAMMAR_STATIC_VERSION) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Static tables version is %d, expected %d\n", staticp->versioni, EARLEYGRAMMAR_STATIC_VERSION);
+    errno = EINVAL;
+    return 0;
+  }
+  if ((staticp->nSymboli < 0) || (staticp->nRulei < 0) || (staticp->nRhsi < 0) || (staticp->startSymboli < 0) || (staticp->startSymboli >= staticp->nSymboli) || (staticp->nClosureRowi < 0) || (staticp->nPredictionRowi < 1) || (staticp->nNnfSymboli < staticp->nSymboli) || (staticp->nNnfRulei < 0) || (staticp->nNnfRhsi < 0) || (staticp->nDfaStatei < 0) || (staticp->nDfaItemi < 0) || (staticp->nDfaTransitioni < 0) || (staticp->nLookaheadRowi < 0)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Static tables are corrupted\n");
+    errno = EINVAL;
+    return 0;
+  }
+
+  corep->nSymboli        = staticp->nSymboli;
+  corep->symbolAllocl    = (size_t) staticp->nSymboli;
+  corep->nRulei          = staticp->nRulei;
+  corep->ruleAllocl      = (size_t) staticp->nRulei;
+  corep->nRhsi           = staticp->nRhsi;
+  corep->rhsAllocl       = (size_t) staticp->nRhsi;
+  corep->startSymboli    = staticp->startSymboli;
+  corep->nClosureRowi    = staticp->nClosureRowi;
+  corep->nPredictionRowi = staticp->nPredictionRowi;
+  corep->nNnfSymboli     = staticp->nNnfSymboli;
+  corep->nNnfRulei       = staticp->nNnfRulei;
+  corep->nNnfRhsi        = staticp->nNnfRhsi;
+  corep->nDfaStatei      = staticp->nDfaStatei;
+  corep->nDfaItemi       = staticp->nDfaItemi;
+  corep->nDfaTransitioni = staticp->nDfaTransitioni;
+  corep->nLookaheadRowi  = staticp->nLookaheadRowi;
+
+  /* Read-only: see EARLEYGRAMMARCORE_IMAGE_STATIC */
+  corep->symbolPropertyBitSetip     = (int *) staticp->symbolPropertyBitSetip;
+  corep->symbolEventBitSetip        = (int *) staticp->symbolEventBitSetip;
+  corep->symbolOptionp              = (earleyGrammarSymbolOption_t *) staticp->symbolOptionp;
+  corep->ruleLhsSymbolip            = (int *) staticp->ruleLhsSymbolip;
+  corep->ruleRhsOffsetip            = (int *) staticp->ruleRhsOffsetip;
+  corep->ruleRhsLengthip            = (int *) staticp->ruleRhsLengthip;
+  corep->rulePropertyBitSetip       = (int *) staticp->rulePropertyBitSetip;
+  corep->ruleOptionp                = (earleyGrammarRuleOption_t *) staticp->ruleOptionp;
+  corep->rhsSymbolip                = (int *) staticp->rhsSymbolip;
+  corep->symbolLhsRuleOffsetip      = (int *) staticp->symbolLhsRuleOffsetip;
+  corep->lhsRuleip                  = (int *) staticp->lhsRuleip;
+  corep->symbolRhsRuleOffsetip      = (int *) staticp->symbolRhsRuleOffsetip;
+  corep->rhsRuleip                  = (int *) staticp->rhsRuleip;
+  corep->symbolClosureRowip         = (int *) staticp->symbolClosureRowip;
+  corep->closurep                   = (earleyGrammarBitWord_t *) staticp->closurep;
+  corep->symbolPredictionRowip      = (int *) staticp->symbolPredictionRowip;
+  corep->predictionp                = (earleyGrammarBitWord_t *) staticp->predictionp;
+  corep->nnfRuleLhsSymbolip         = (int *) staticp->nnfRuleLhsSymbolip;
+  corep->nnfRuleRhsOffsetip         = (int *) staticp->nnfRuleRhsOffsetip;
+  corep->nnfRuleRhsLengthip         = (int *) staticp->nnfRuleRhsLengthip;
+  corep->nnfRuleUserip              = (int *) staticp->nnfRuleUserip;
+  corep->nnfRuleNulledip            = (int *) staticp->nnfRuleNulledip;
+  corep->nnfRhsSymbolip             = (int *) staticp->nnfRhsSymbolip;
+  corep->dfaStateItemOffsetip       = (int *) staticp->dfaStateItemOffsetip;
+  corep->dfaItemRuleip              = (int *) staticp->dfaItemRuleip;
+  corep->dfaItemDotip               = (int *) staticp->dfaItemDotip;
+  corep->dfaStateNonKernelip        = (int *) staticp->dfaStateNonKernelip;
+  corep->dfaStateTransitionOffsetip = (int *) staticp->dfaStateTransitionOffsetip;
+  corep->dfaTransitionSymbolip      = (int *) staticp->dfaTransitionSymbolip;
+  corep->dfaTransitionStateip       = (int *) staticp->dfaTransitionStateip;
+  corep->firstp                     = (earleyGrammarBitWord_t *) staticp->firstp;
+  corep->dottedLookaheadRowip       = (int *) staticp->dottedLookaheadRowip;
+  corep->lookaheadp                 = (earleyGrammarBitWord_t *) staticp->lookaheadp;
+
+  return 1;
+}
+
+/****************************************************************************/
+int earleyGrammar_newSymboli(earleyGrammar_t *earleyGrammarp, earleyGrammarSymbolOption_t *optionp)
+/****************************************************************************/
+{
+  int symboli;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyGrammar_core_ownb(earleyGrammarp)) {
+    goto err;
+  }
+
+  if (! earleyGrammar_symbolTable_reserveb(earleyGrammarp, (size_t) earleyGrammarp->corep->nSymboli + 1)) {
+    goto err;
+  }
+
+  symboli = earleyGrammarp->corep->nSymboli;
+
+  earleyGrammarp->corep->symbolPropertyBitSetip[symboli] = 0;
+  earleyGrammarp->corep->symbolOptionp[symboli]          = (optionp != NULL) ? *optionp : earleyGrammarSymbolOptionDefault;
+  earleyGrammarp->corep->symbolEventBitSetip[symboli]    = earleyGrammar_symbolEvent_computei(&(earleyGrammarp->corep->symbolOptionp[symboli]));
+
+  earleyGrammarp->corep->nSymboli++;
+  goto done;
+
+ err:
+  symboli = -1;
+
+ done:
+  return symboli;
+}
+
+/****************************************************************************/
+short earleyGrammar_symbolPropertyb(earleyGrammar_t *earleyGrammarp, int symboli, int *earleySymbolPropertyBitSetp)
+/****************************************************************************/
+{
+  short rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleySymbol_existb(earleyGrammarp, symboli)) {
+    goto err;
+  }
+
+  if (earleySymbolPropertyBitSetp != NULL) {
+    *earleySymbolPropertyBitSetp = earleyGrammarp->corep->symbolPropertyBitSetip[symboli];
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyGrammar_symbolEventb(earleyGrammar_t *earleyGrammarp, int symboli, int *earleySymbolEventBitSetp)
+/****************************************************************************/
+{
+  short rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleySymbol_existb(earleyGrammarp, symboli)) {
+    goto err;
+  }
+
+  if (earleySymbolEventBitSetp != NULL) {
+    *earleySymbolEventBitSetp = EARLEYGRAMMAR_SYMBOLEVENTI(earleyGrammarp, symboli);
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyGrammar_symbolEvent_activateb(earleyGrammar_t *earleyGrammarp, int symboli, int eventSeti, short activeb)
+/****************************************************************************/
+/* A flip of the event masks: neither the event sets of the symbol nor the */
+/* precomputed tables change.                                               */
+/****************************************************************************/
+{
+  earleyGrammarBitWord_t *wordp;
+  earleyGrammarBitWord_t  bitl;
+  size_t                  wordl;
+  int                     eventi;
+  short                   rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleySymbol_existb(earleyGrammarp, symboli)) {
+    goto err;
+  }
+
+  if ((eventSeti & ~(EARLEYGRAMMAR_EVENTTYPE_COMPLETION|EARLEYGRAMMAR_EVENTTYPE_NULLED|EARLEYGRAMMAR_EVENTTYPE_PREDICTION)) != 0) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Invalid event set 0x%x\n", eventSeti);
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyGrammar_event_maskb(earleyGrammarp)) {
+    goto err;
+  }
+
+  wordl = EARLEYGRAMMAR_BITSET_WORDL(earleyGrammarp->nEventSymboli);
+  bitl  = ((earleyGrammarBitWord_t) 1) << (symboli % EARLEYGRAMMAR_BITWORD_BITS);
+  for (eventi = 0; eventi < EARLEYGRAMMAR_EVENT_ROWI; eventi++) {
+    if ((eventSeti & (1 << eventi)) == 0) {
+      continue;
+    }
+    wordp = earleyGrammarp->eventBitSetp + (size_t) eventi * wordl + symboli / EARLEYGRAMMAR_BITWORD_BITS;
+    if (activeb) {
+      *wordp |= bitl;
+    } else {
+      *wordp &= ~bitl;
+    }
+  }
+  earleyGrammarp->eventReloadb = 1;
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyGrammar_symbolEvent_activeb(earleyGrammar_t *earleyGrammarp, int symboli, int *eventSetip)
+/****************************************************************************/
+{
+  size_t wordl;
+  int    eventSeti;
+  int    eventi;
+  short  rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleySymbol_existb(earleyGrammarp, symboli)) {
+    goto err;
+  }
+
+  if (! earleyGrammar_event_maskb(earleyGrammarp)) {
+    goto err;
+  }
+
+  wordl     = EARLEYGRAMMAR_BITSET_WORDL(earleyGrammarp->nEventSymboli);
+  eventSeti = EARLEYGRAMMAR_EVENTTYPE_NONE;
+  for (eventi = 0; eventi < EARLEYGRAMMAR_EVENT_ROWI; eventi++) {
+    if (EARLEYGRAMMAR_BITSET_GETB(earleyGrammarp->eventBitSetp + (size_t) eventi * wordl, symboli)) {
+      eventSeti |= 1 << eventi;
+    }
+  }
+  if (eventSetip != NULL) {
+    *eventSetip = eventSeti;
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+int earleyGrammar_newRulei(earleyGrammar_t *earleyGrammarp, earleyGrammarRuleOption_t *optionp,
+                           int lhsSymboli,
+                           size_t rhsSymboll, int *rhsSymbolip
+                           )
+/****************************************************************************/
+{
+  int rulei;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyGrammar_core_ownb(earleyGrammarp)) {
+    goto err;
+  }
+
+  if (rhsSymboll > (size_t) (INT_MAX - earleyGrammarp->corep->nRhsi)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Too many RHS symbols\n");
+    errno = EINVAL;
+    goto err;
+  }
+  if (! earleyGrammar_rule_checkb(earleyGrammarp, optionp, lhsSymboli, (int) rhsSymboll, rhsSymbolip, earleyGrammarp->corep->nSymboli)) {
+    goto err;
+  }
+  if (! earleyGrammar_ruleTable_reserveb(earleyGrammarp, (size_t) earleyGrammarp->corep->nRulei + 1)) {
+    goto err;
+  }
+  if (! earleyGrammar_rhsPool_reserveb(earleyGrammarp, (size_t) earleyGrammarp->corep->nRhsi + rhsSymboll)) {
+    goto err;
+  }
+
+  if (rhsSymboll > 0) {
+    memcpy(earleyGrammarp->corep->rhsSymbolip + earleyGrammarp->corep->nRhsi, rhsSymbolip, rhsSymboll * sizeof(int));
+  }
+  rulei = earleyGrammarp->corep->nRulei;
+  earleyGrammar_rule_storev(earleyGrammarp, optionp, lhsSymboli, earleyGrammarp->corep->nRhsi, (int) rhsSymboll);
+  earleyGrammarp->corep->nRhsi += (int) rhsSymboll;
+
+  goto done;
+
+ err:
+  rulei = -1;
+
+ done:
+  return rulei;
+}
+
+/****************************************************************************/
+short earleyGrammar_rulePropertyb(earleyGrammar_t *earleyGrammarp, int rulei, int *earleyRulePropertyBitSetp)
+/****************************************************************************/
+{
+  short rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyRule_existb(earleyGrammarp, rulei)) {
+    goto err;
+  }
+
+  if (earleyRulePropertyBitSetp != NULL) {
+    *earleyRulePropertyBitSetp = earleyGrammarp->corep->rulePropertyBitSetip[rulei];
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyGrammar_ruleRhsb(earleyGrammar_t *earleyGrammarp, int rulei, size_t *rhsSymbollp, const int **rhsSymbolipp)
+/****************************************************************************/
+{
+  short rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyRule_existb(earleyGrammarp, rulei)) {
+    goto err;
+  }
+
+  if (rhsSymbollp != NULL) {
+    *rhsSymbollp = (size_t) earleyGrammarp->corep->ruleRhsLengthip[rulei];
+  }
+  if (rhsSymbolipp != NULL) {
+    /* Never NULL when the RHS is not empty, and valid until the next rule creation */
+    *rhsSymbolipp = (earleyGrammarp->corep->rhsSymbolip != NULL) ? earleyGrammarp->corep->rhsSymbolip + earleyGrammarp->corep->ruleRhsOffsetip[rulei] : NULL;
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+int earleyGrammar_newSymbolExti(earleyGrammar_t *earleyGrammarp, short terminalb, short startb, int eventSeti)
+/****************************************************************************/
+{
+  earleyGrammarSymbolOption_t option = earleyGrammarSymbolOptionDefault;
+
+  option.terminalb = terminalb;
+  option.startb    = startb;
+  option.eventSeti = eventSeti;
+
+  return earleyGrammar_newSymboli(earleyGrammarp, &option);
+}
+
+/****************************************************************************/
+int earleyGrammar_newRuleExti(earleyGrammar_t *earleyGrammarp, int ranki, short nullRanksHighb, int lhsSymboli, ...)
+/****************************************************************************/
+{
+  earleyGrammarRuleOption_t option     = earleyGrammarRuleOptionDefault;
+  int                       rhsSymboli = 0;
+  int                       symboli;
+  va_list                   ap;
+  int                       rulei;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyGrammar_core_ownb(earleyGrammarp)) {
+    goto err;
+  }
+
+  option.ranki          = ranki;
+  option.nullRanksHighb = nullRanksHighb;
+
+  if (! earleyGrammar_ruleTable_reserveb(earleyGrammarp, (size_t) earleyGrammarp->corep->nRulei + 1)) {
+    goto err;
+  }
+
+  /* The RHS is collected directly at the end of the pool: it becomes */
+  /* part of it only when the rule is stored.                         */
+  va_start(ap, lhsSymboli);
+  while ((symboli = va_arg(ap, int)) >= 0) {
+    if (! earleyGrammar_rhsPool_reserveb(earleyGrammarp, (size_t) earleyGrammarp->corep->nRhsi + (size_t) rhsSymboli + 1)) {
+      va_end(ap);
+      goto err;
+    }
+    earleyGrammarp->corep->rhsSymbolip[earleyGrammarp->corep->nRhsi + rhsSymboli++] = symboli;
+  }
+  va_end(ap);
+
+  if (! earleyGrammar_rule_checkb(earleyGrammarp, &option, lhsSymboli, rhsSymboli, (rhsSymboli > 0) ? earleyGrammarp->corep->rhsSymbolip + earleyGrammarp->corep->nRhsi : NULL, earleyGrammarp->corep->nSymboli)) {
+    goto err;
+  }
+  rulei = earleyGrammarp->corep->nRulei;
+  earleyGrammar_rule_storev(earleyGrammarp, &option, lhsSymboli, earleyGrammarp->corep->nRhsi, rhsSymboli);
+  earleyGrammarp->corep->nRhsi += rhsSymboli;
+
+  goto done;
+
+ err:
+  rulei = -1;
+
+ done:
+  return rulei;
+}
+
+/****************************************************************************/
+int earleyGrammar_newSequenceExti(earleyGrammar_t *earleyGrammarp, int ranki, short nullRanksHighb,
+                                  int lhsSymboli,
+                                  int rhsSymboli, int minimumi, int separatorSymboli, short properb)
+/****************************************************************************/
+{
+  earleyGrammarRuleOption_t option;
+  int                       rhsSymbolip[1] = { rhsSymboli };
+
+  switch (minimumi) {
+  case '*':
+    minimumi = 0;
+    break;
+  case '+':
+    minimumi = 1;
+    break;
+  default:
+    break;
+  }
+  
+  option.ranki            = ranki;
+  option.nullRanksHighb   = nullRanksHighb;
+  option.sequenceb        = 1;
+  option.separatorSymboli = separatorSymboli;
+  option.properb          = properb;
+  option.minimumi         = minimumi;
+
+  return earleyGrammar_newRulei(earleyGrammarp, &option, lhsSymboli, 1, rhsSymbolip);
+}
+
+/****************************************************************************/
+short earleyGrammar_newBulkb(earleyGrammar_t *earleyGrammarp,
+                             size_t symboll, earleyGrammarSymbolOption_t *symbolOptionp,
+                             size_t rulel, int *lhsSymbolip, int *rhsOffsetip, int *rhsSymbolip, earleyGrammarRuleOption_t *ruleOptionp,
+                             int *firstSymbolip, int *firstRuleip)
+/****************************************************************************/
+{
+  int    nSymboli;
+  int    rhsFirsti;
+  int    rhsSymboli;
+  int    deltai;
+  int    i;
+  size_t l;
+  short  rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyGrammar_core_ownb(earleyGrammarp)) {
+    goto err;
+  }
+
+  if ((symboll > (size_t) (INT_MAX - earleyGrammarp->corep->nSymboli)) || (rulel > (size_t) (INT_MAX - earleyGrammarp->corep->nRulei))) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Too many symbols or rules\n");
+    errno = EINVAL;
+    goto err;
+  }
+  if ((rulel > 0) && ((lhsSymbolip == NULL) || (rhsOffsetip == NULL))) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Null LHS or RHS offsets\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  /* Validation is done once for all, against the final number of symbols */
+  nSymboli   = earleyGrammarp->corep->nSymboli + (int) symboll;
+  rhsFirsti  = (rulel > 0) ? rhsOffsetip[0] : 0;
+  rhsSymboli = (rulel > 0) ? rhsOffsetip[rulel] - rhsFirsti : 0;
+  if ((rhsFirsti < 0) || (rhsSymboli < 0) || (rhsSymboli > (INT_MAX - earleyGrammarp->corep->nRhsi))) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Invalid RHS offsets\n");
+    errno = EINVAL;
+    goto err;
+  }
+  for (l = 0; l < rulel; l++) {
+    if (rhsOffsetip[l + 1] < rhsOffsetip[l]) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Invalid RHS offsets for rule at index %ld\n", (long) l);
+      errno = EINVAL;
+      goto err;
+    }
+    if (! earleyGrammar_rule_checkb(earleyGrammarp,
+                                    (ruleOptionp != NULL) ? &(ruleOptionp[l]) : NULL,
+                                    lhsSymbolip[l],
+                                    rhsOffsetip[l + 1] - rhsOffsetip[l],
+                                    (rhsSymbolip != NULL) ? rhsSymbolip + rhsOffsetip[l] : NULL,
+                                    nSymboli)) {
+      goto err;
+    }
+  }
+
+  /* Tables are sized once. Nothing is visible until everything succeeded. */
+  if (! earleyGrammar_symbolTable_reserveb(earleyGrammarp, (size_t) nSymboli)) {
+    goto err;
+  }
+  if (! earleyGrammar_ruleTable_reserveb(earleyGrammarp, (size_t) earleyGrammarp->corep->nRulei + rulel)) {
+    goto err;
+  }
+  if (! earleyGrammar_rhsPool_reserveb(earleyGrammarp, (size_t) earleyGrammarp->corep->nRhsi + (size_t) rhsSymboli)) {
+    goto err;
+  }
+
+  if (firstSymbolip != NULL) {
+    *firstSymbolip = earleyGrammarp->corep->nSymboli;
+  }
+  if (firstRuleip != NULL) {
+    *firstRuleip = earleyGrammarp->corep->nRulei;
+  }
+
+  for (i = earleyGrammarp->corep->nSymboli, l = 0; l < symboll; i++, l++) {
+    earleyGrammarp->corep->symbolPropertyBitSetip[i] = 0;
+    earleyGrammarp->corep->symbolOptionp[i]          = (symbolOptionp != NULL) ? symbolOptionp[l] : earleyGrammarSymbolOptionDefault;
+    earleyGrammarp->corep->symbolEventBitSetip[i]    = earleyGrammar_symbolEvent_computei(&(earleyGrammarp->corep->symbolOptionp[i]));
+  }
+  earleyGrammarp->corep->nSymboli = nSymboli;
+
+  if (rhsSymboli > 0) {
+    memcpy(earleyGrammarp->corep->rhsSymbolip + earleyGrammarp->corep->nRhsi, rhsSymbolip + rhsFirsti, rhsSymboli * sizeof(int));
+  }
+  deltai = earleyGrammarp->corep->nRhsi - rhsFirsti;
+  for (l = 0; l < rulel; l++) {
+    earleyGrammar_rule_storev(earleyGrammarp,
+                              (ruleOptionp != NULL) ? &(ruleOptionp[l]) : NULL,
+                              lhsSymbolip[l],
+                              rhsOffsetip[l] + deltai,
+                              rhsOffsetip[l + 1] - rhsOffsetip[l]);
+  }
+  earleyGrammarp->corep->nRhsi += rhsSymboli;
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyGrammar_errorb(earleyGrammar_t *earleyGrammarp, int *errorip)
+/****************************************************************************/
+{
+  short rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (errorip != NULL) {
+    *errorip = earleyGrammarp->errori;
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyGrammar_error_clearb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+{
+  short rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  earleyGrammarp->errori = 0;
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyGrammar_precomputeb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+/* The start symbol is the one with the startb option, else symbol 0       */
+/****************************************************************************/
+{
+  int starti = -1;
+  int i;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  for (i = 0; i < earleyGrammarp->corep->nSymboli; i++) {
+    if (EARLEYGRAMMAR_SYMBOLOPTIONP(earleyGrammarp, i)->startb) {
+      if (starti >= 0) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Symbols %d and %d are both marked as start symbol\n", starti, i);
+        errno = EINVAL;
+        return 0;
+      }
+      starti = i;
+    }
+  }
+
+  return earleyGrammar_precompute_startb(earleyGrammarp, (starti >= 0) ? starti : 0);
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_precompute_indexb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+/* Rules by LHS and by RHS occurrence, with a counting sort: rules are     */
+/* listed in increasing id order for every symbol.                          */
+/****************************************************************************/
+{
+  earleyGrammarCore_t *corep    = earleyGrammarp->corep;
+  earleyAllocator_t   *allocatorp = &(corep->allocator);
+  int                  nSymboli = corep->nSymboli;
+  int                  nRulei   = corep->nRulei;
+  int                  rulei;
+  int                  symboli;
+  int                  offseti;
+  int                  endi;
+  int                  i;
+
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->symbolLhsRuleOffsetip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->lhsRuleip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->symbolRhsRuleOffsetip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->rhsRuleip);
+
+  corep->symbolLhsRuleOffsetip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) nSymboli + 1) * sizeof(int));
+  corep->lhsRuleip             = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) nRulei + 1) * sizeof(int));
+  corep->symbolRhsRuleOffsetip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) nSymboli + 1) * sizeof(int));
+  corep->rhsRuleip             = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) corep->nRhsi + 1) * sizeof(int));
+  if ((corep->symbolLhsRuleOffsetip == NULL) || (corep->lhsRuleip == NULL) || (corep->symbolRhsRuleOffsetip == NULL) || (corep->rhsRuleip == NULL)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+
+  /* Counts, shifted by one */
+  memset(corep->symbolLhsRuleOffsetip, 0, ((size_t) nSymboli + 1) * sizeof(int));
+  memset(corep->symbolRhsRuleOffsetip, 0, ((size_t) nSymboli + 1) * sizeof(int));
+  for (rulei = 0; rulei < nRulei; rulei++) {
+    corep->symbolLhsRuleOffsetip[corep->ruleLhsSymbolip[rulei] + 1]++;
+    offseti = corep->ruleRhsOffsetip[rulei];
+    endi    = offseti + corep->ruleRhsLengthip[rulei];
+    for (i = offseti; i < endi; i++) {
+      corep->symbolRhsRuleOffsetip[corep->rhsSymbolip[i] + 1]++;
+    }
+  }
+
+  /* Prefix sums give the start of every row, the next slot of row s is  */
+  /* then kept in offset[s+1] while filling, which ends up as the end of  */
+  /* row s, i.e. the start of row s+1.                                    */
+  for (symboli = 1; symboli <= nSymboli; symboli++) {
+    corep->symbolLhsRuleOffsetip[symboli] += corep->symbolLhsRuleOffsetip[symboli - 1];
+    corep->symbolRhsRuleOffsetip[symboli] += corep->symbolRhsRuleOffsetip[symboli - 1];
+  }
+  for (symboli = nSymboli; symboli > 0; symboli--) {
+    corep->symbolLhsRuleOffsetip[symboli] = corep->symbolLhsRuleOffsetip[symboli - 1];
+    corep->symbolRhsRuleOffsetip[symboli] = corep->symbolRhsRuleOffsetip[symboli - 1];
+  }
+  for (rulei = 0; rulei < nRulei; rulei++) {
+    corep->lhsRuleip[corep->symbolLhsRuleOffsetip[corep->ruleLhsSymbolip[rulei] + 1]++] = rulei;
+    offseti = corep->ruleRhsOffsetip[rulei];
+    endi    = offseti + corep->ruleRhsLengthip[rulei];
+    for (i = offseti; i < endi; i++) {
+      corep->rhsRuleip[corep->symbolRhsRuleOffsetip[corep->rhsSymbolip[i] + 1]++] = rulei;
+    }
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_precompute_propagatev(earleyGrammarCore_t *corep, int *counterip, int *worklistip, int nWorklisti, int symbolPropertyi, int rulePropertyi)
+/****************************************************************************/
+/* Generic "all RHS symbols have the property" propagation. counterip has  */
+/* the number of RHS positions still lacking the property for every rule,  */
+/* worklistip the nWorklisti symbols that have it and are not processed.   */
+/* Every RHS occurrence is visited at most once: O(total RHS length).      */
+/****************************************************************************/
+{
+  int symboli;
+  int lhsSymboli;
+  int rulei;
+  int i;
+
+  /* Rules that have the property from the start */
+  for (rulei = 0; rulei < corep->nRulei; rulei++) {
+    if (counterip[rulei] == 0) {
+      corep->rulePropertyBitSetip[rulei] |= rulePropertyi;
+      lhsSymboli = corep->ruleLhsSymbolip[rulei];
+      if ((corep->symbolPropertyBitSetip[lhsSymboli] & symbolPropertyi) == 0) {
+        corep->symbolPropertyBitSetip[lhsSymboli] |= symbolPropertyi;
+        worklistip[nWorklisti++] = lhsSymboli;
+      }
+    }
+  }
+
+  while (nWorklisti > 0) {
+    symboli = worklistip[--nWorklisti];
+    for (i = corep->symbolRhsRuleOffsetip[symboli]; i < corep->symbolRhsRuleOffsetip[symboli + 1]; i++) {
+      rulei = corep->rhsRuleip[i];
+      /* Counters of rules that had the property from the start go negative and are never 0 again */
+      if (--counterip[rulei] != 0) {
+        continue;
+      }
+      corep->rulePropertyBitSetip[rulei] |= rulePropertyi;
+      lhsSymboli = corep->ruleLhsSymbolip[rulei];
+      if ((corep->symbolPropertyBitSetip[lhsSymboli] & symbolPropertyi) == 0) {
+        corep->symbolPropertyBitSetip[lhsSymboli] |= symbolPropertyi;
+        worklistip[nWorklisti++] = lhsSymboli;
+      }
+    }
+  }
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_sccb(earleyAllocator_t *allocatorp, int nNodei, int *offsetip, int *targetip, int *componentip, int *nComponentip)
+/****************************************************************************/
+/* Strongly connected components of a graph in compressed sparse rows,     */
+/* Tarjan's algorithm without recursion: O(nodes + edges). Components are  */
+/* numbered in reverse topological order, i.e. a component only has edges  */
+/* to components with a lower or equal number.                              */
+/****************************************************************************/
+{
+  int   *indexip;     /* Visit order, -1 when not visited */
+  int   *lowlinkip;
+  int   *stackip;     /* Tarjan stack */
+  int   *frameip;     /* Call stack: nodes... */
+  int   *edgeip;      /* ...and their next edge */
+  int    nStacki  = 0;
+  int    nFramei  = 0;
+  int    indexi   = 0;
+  int    componenti = 0;
+  int    rooti;
+  int    nodei;
+  int    targeti;
+  int    i;
+  short  rcb;
+
+  indexip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nNodei + 1) * sizeof(int));
+  lowlinkip = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nNodei + 1) * sizeof(int));
+  stackip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nNodei + 1) * sizeof(int));
+  frameip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nNodei + 1) * sizeof(int));
+  edgeip    = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nNodei + 1) * sizeof(int));
+  if ((indexip == NULL) || (lowlinkip == NULL) || (stackip == NULL) || (frameip == NULL) || (edgeip == NULL)) {
+    goto err;
+  }
+
+  for (i = 0; i < nNodei; i++) {
+    indexip[i]     = -1;
+    componentip[i] = -1;
+  }
+
+  for (rooti = 0; rooti < nNodei; rooti++) {
+    if (indexip[rooti] >= 0) {
+      continue;
+    }
+    indexip[rooti] = lowlinkip[rooti] = indexi++;
+    stackip[nStacki++] = rooti;
+    frameip[nFramei]   = rooti;
+    edgeip[nFramei++]  = offsetip[rooti];
+
+    while (nFramei > 0) {
+      nodei = frameip[nFramei - 1];
+      if (edgeip[nFramei - 1] < offsetip[nodei + 1]) {
+        targeti = targetip[edgeip[nFramei - 1]++];
+        if (indexip[targeti] < 0) {
+          /* Recurse */
+          indexip[targeti] = lowlinkip[targeti] = indexi++;
+          stackip[nStacki++] = targeti;
+          frameip[nFramei]   = targeti;
+          edgeip[nFramei++]  = offsetip[targeti];
+        } else if ((componentip[targeti] < 0) && (indexip[targeti] < lowlinkip[nodei])) {
+          /* Still on the Tarjan stack */
+          lowlinkip[nodei] = indexip[targeti];
+        }
+        continue;
+      }
+
+      /* All edges of nodei are done */
+      if (lowlinkip[nodei] == indexip[nodei]) {
+        do {
+          targeti = stackip[--nStacki];
+          componentip[targeti] = componenti;
+        } while (targeti != nodei);
+        componenti++;
+      }
+      if (--nFramei > 0) {
+        targeti = frameip[nFramei - 1];
+        if (lowlinkip[nodei] < lowlinkip[targeti]) {
+          lowlinkip[targeti] = lowlinkip[nodei];
+        }
+      }
+    }
+  }
+
+  *nComponentip = componenti;
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  if (indexip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, indexip);
+  }
+  if (lowlinkip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, lowlinkip);
+  }
+  if (stackip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, stackip);
+  }
+  if (frameip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, frameip);
+  }
+  if (edgeip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, edgeip);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_precompute_loopb(earleyGrammar_t *earleyGrammarp, short *warningbp)
+/****************************************************************************/
+/* Loop rules, i.e. rules that can be used in a derivation A =>+ A.        */
+/* In the unit-derivation graph there is an edge A -> B for every productive*/
+/* rule A ::= x B y where x and y are nullable. Loop rules are the rules of */
+/* edges inside a strongly connected component that is a cycle. Nullable   */
+/* properties must be known.                                                */
+/****************************************************************************/
+{
+  earleyGrammarCore_t *corep      = earleyGrammarp->corep;
+  earleyAllocator_t   *allocatorp = &(corep->allocator);
+  int                  nSymboli   = corep->nSymboli;
+  int                  nRulei     = corep->nRulei;
+  int                 *edgeOffsetip = NULL;
+  int                 *edgeTargetip = NULL;
+  int                 *edgeRuleip   = NULL;
+  int                 *componentip  = NULL;
+  int                 *componentSizeip = NULL;
+  int                  nComponenti;
+  int                  pass;
+  int                  rulei;
+  int                  lhsSymboli;
+  int                  rhsSymboli;
+  int                  nonNullableSymboli;
+  int                  nNonNullablei;
+  int                  symboli;
+  int                  i;
+  int                  endi;
+  short                rcb;
+
+  edgeOffsetip    = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  edgeTargetip    = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nRhsi + 1) * sizeof(int));
+  edgeRuleip      = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nRhsi + 1) * sizeof(int));
+  componentip     = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  componentSizeip = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  if ((edgeOffsetip == NULL) || (edgeTargetip == NULL) || (edgeRuleip == NULL) || (componentip == NULL) || (componentSizeip == NULL)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+
+  /* Edges, by LHS: first pass counts, second pass fills */
+  memset(edgeOffsetip, 0, ((size_t) nSymboli + 1) * sizeof(int));
+  for (pass = 0; pass < 2; pass++) {
+    for (rulei = 0; rulei < nRulei; rulei++) {
+      if ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) == 0) {
+        continue;
+      }
+      lhsSymboli = corep->ruleLhsSymbolip[rulei];
+      i          = corep->ruleRhsOffsetip[rulei];
+      endi       = i + corep->ruleRhsLengthip[rulei];
+      /* A sequence has one RHS symbol: a single item is a unit derivation */
+      nNonNullablei      = 0;
+      nonNullableSymboli = -1;
+      for (; i < endi; i++) {
+        if ((corep->symbolPropertyBitSetip[corep->rhsSymbolip[i]] & EARLEY_SYMBOL_IS_NULLABLE) == 0) {
+          nonNullableSymboli = corep->rhsSymbolip[i];
+          if (++nNonNullablei > 1) {
+            break;
+          }
+        }
+      }
+      if (nNonNullablei > 1) {
+        continue;
+      }
+      for (i = corep->ruleRhsOffsetip[rulei]; i < endi; i++) {
+        rhsSymboli = corep->rhsSymbolip[i];
+        if ((nNonNullablei == 1) && (rhsSymboli != nonNullableSymboli)) {
+          continue;
+        }
+        if (pass == 0) {
+          edgeOffsetip[lhsSymboli + 1]++;
+        } else {
+          edgeTargetip[edgeOffsetip[lhsSymboli + 1]]  = rhsSymboli;
+          edgeRuleip[edgeOffsetip[lhsSymboli + 1]++] = rulei;
+        }
+      }
+    }
+    if (pass == 0) {
+      for (symboli = 1; symboli <= nSymboli; symboli++) {
+        edgeOffsetip[symboli] += edgeOffsetip[symboli - 1];
+      }
+      for (symboli = nSymboli; symboli > 0; symboli--) {
+        edgeOffsetip[symboli] = edgeOffsetip[symboli - 1];
+      }
+    }
+  }
+  if (! earleyGrammar_sccb(allocatorp, nSymboli, edgeOffsetip, edgeTargetip, componentip, &nComponenti)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+
+  memset(componentSizeip, 0, (size_t) nComponenti * sizeof(int));
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    componentSizeip[componentip[symboli]]++;
+  }
+
+  /* An edge is in a cycle when both ends are in the same component, and */
+  /* the component is not a single symbol, unless the edge is a self-loop. */
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    for (i = edgeOffsetip[symboli]; i < edgeOffsetip[symboli + 1]; i++) {
+      rhsSymboli = edgeTargetip[i];
+      if ((componentip[rhsSymboli] != componentip[symboli]) || ((componentSizeip[componentip[symboli]] == 1) && (rhsSymboli != symboli))) {
+        continue;
+      }
+      rulei = edgeRuleip[i];
+      if ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_LOOP) == 0) {
+        corep->rulePropertyBitSetip[rulei] |= EARLEY_RULE_IS_LOOP;
+        EARLEYGRAMMAR_WARNF(earleyGrammarp, "Rule %d is a loop: symbol %d derives %d in a cycle of %d symbol(s)\n", rulei, symboli, rhsSymboli, componentSizeip[componentip[symboli]]);
+        *warningbp = 1;
+      }
+    }
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  if (edgeOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, edgeOffsetip);
+  }
+  if (edgeTargetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, edgeTargetip);
+  }
+  if (edgeRuleip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, edgeRuleip);
+  }
+  if (componentip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, componentip);
+  }
+  if (componentSizeip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, componentSizeip);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_bitset_orv(earleyGrammarBitWord_t *restrict dstp, const earleyGrammarBitWord_t *restrict srcp, size_t wordl)
+/****************************************************************************/
+/* Plain loop on non-aliased words: compilers vectorize it                 */
+/****************************************************************************/
+{
+  size_t l;
+
+  for (l = 0; l < wordl; l++) {
+    dstp[l] |= srcp[l];
+  }
+}
+
+/****************************************************************************/
+static inline int earleyGrammar_thread_counti(earleyGrammar_t *earleyGrammarp, size_t workl, size_t minWorkl)
+/****************************************************************************/
+/* Threads of a job, so that every slice has at least minWorkl units      */
+/****************************************************************************/
+{
+#ifdef EARLEYGRAMMAR_THREAD
+  int nThreadi = earleyGrammarp->option.nThreadi;
+
+  if (nThreadi > EARLEYGRAMMAR_THREAD_MAX) {
+    nThreadi = EARLEYGRAMMAR_THREAD_MAX;
+  }
+  if ((nThreadi > 1) && ((size_t) nThreadi > workl / minWorkl)) {
+    nThreadi = (int) (workl / minWorkl);
+  }
+  return (nThreadi > 1) ? nThreadi : 1;
+#else
+  return 1;
+#endif
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_thread_slicev(size_t workl, int threadi, int nThreadi, size_t *firstlp, size_t *endlp)
+/****************************************************************************/
+{
+  *firstlp = (workl / (size_t) nThreadi) * (size_t) threadi       + (workl % (size_t) nThreadi) * (size_t) threadi       / (size_t) nThreadi;
+  *endlp   = (workl / (size_t) nThreadi) * (size_t) (threadi + 1) + (workl % (size_t) nThreadi) * (size_t) (threadi + 1) / (size_t) nThreadi;
+}
+
+#ifdef EARLEYGRAMMAR_THREAD
+/****************************************************************************/
+static void *earleyGrammar_thread_startp(void *argp)
+/****************************************************************************/
+{
+  earleyGrammarThread_t *threadp = (earleyGrammarThread_t *) argp;
+
+  threadp->jobp(threadp->contextp, threadp->threadi, threadp->nThreadi);
+  return NULL;
+}
+#endif
+
+/****************************************************************************/
+static inline void earleyGrammar_thread_runv(earleyGrammar_job_t jobp, void *contextp, int nThreadi)
+/****************************************************************************/
+/* The calling thread takes the first slice. A slice whose thread could   */
+/* not be created is run by the calling thread after the others: slices  */
+/* are independent, so the result does not change.                       */
+/****************************************************************************/
+{
+#ifdef EARLEYGRAMMAR_THREAD
+  pthread_t             threadp[EARLEYGRAMMAR_THREAD_MAX];
+  earleyGrammarThread_t argp[EARLEYGRAMMAR_THREAD_MAX];
+  short                 startedbp[EARLEYGRAMMAR_THREAD_MAX];
+#endif
+  int                   threadi;
+
+#ifdef EARLEYGRAMMAR_THREAD
+  for (threadi = 1; threadi < nThreadi; threadi++) {
+    argp[threadi].jobp     = jobp;
+    argp[threadi].contextp = contextp;
+    argp[threadi].threadi  = threadi;
+    argp[threadi].nThreadi = nThreadi;
+    startedbp[threadi]     = (pthread_create(&(threadp[threadi]), NULL, earleyGrammar_thread_startp, &(argp[threadi])) == 0) ? 1 : 0;
+  }
+#endif
+  jobp(contextp, 0, nThreadi);
+  for (threadi = 1; threadi < nThreadi; threadi++) {
+#ifdef EARLEYGRAMMAR_THREAD
+    if (startedbp[threadi]) {
+      pthread_join(threadp[threadi], NULL);
+      continue;
+    }
+#endif
+    jobp(contextp, threadi, nThreadi);
+  }
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_precompute_predictionb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+/* Expecting A predicts the rules of A, hence expecting the first symbol   */
+/* of their RHS, or the next one as long as the previous ones are nullable.*/
+/* This is an edge A -> B of the prediction graph, and the closure of A is */
+/* everything reachable from A. Its strongly connected components all have */
+/* the same closure, and they are numbered in reverse topological order:   */
+/* processing them in increasing order, the closure of a component is its  */
+/* own symbols and rules, OR-ed with the closures of its successors, a row */
+/* at a time. Only productive rules are predicted.                          */
+/* Columns are independent: with several threads, each one fills a slice  */
+/* of the columns of every row.                                            */
+/****************************************************************************/
+{
+  earleyGrammarCore_t       *corep      = earleyGrammarp->corep;
+  earleyAllocator_t         *allocatorp = &(corep->allocator);
+  earleyGrammarRuleOption_t *ruleOptionp;
+  int                        nSymboli   = corep->nSymboli;
+  int                        nRulei     = corep->nRulei;
+  size_t                     symbolWordl = EARLEYGRAMMAR_BITSET_WORDL(nSymboli);
+  size_t                     ruleWordl   = EARLEYGRAMMAR_BITSET_WORDL(nRulei);
+  int                       *edgeOffsetip = NULL;
+  int                       *edgeTargetip = NULL;
+  int                       *componentip  = NULL;
+  int                       *memberOffsetip = NULL;   /* Symbols by component */
+  int                       *memberip     = NULL;
+  int                       *seenip       = NULL;     /* Last component that OR-ed a successor, by thread */
+  int                        nThreadi     = earleyGrammar_thread_counti(earleyGrammarp, (symbolWordl > ruleWordl) ? symbolWordl : ruleWordl, EARLEYGRAMMAR_THREAD_WORDL);
+  earleyGrammarClosureJob_t  job;
+  int                        nComponenti;
+  int                        nPredictionRowi;
+  int                        componenti;
+  int                        pass;
+  int                        symboli;
+  int                        rulei;
+  int                        lhsSymboli;
+  int                        rhsSymboli;
+  int                        i;
+  int                        j;
+  int                        endi;
+  short                      rcb;
+
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->symbolClosureRowip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->closurep);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->symbolPredictionRowip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->predictionp);
+  corep->symbolClosureRowip    = NULL;
+  corep->closurep              = NULL;
+  corep->symbolPredictionRowip = NULL;
+  corep->predictionp           = NULL;
+  corep->nClosureRowi          = 0;
+  corep->nPredictionRowi       = 0;
+
+  /* At most one edge per RHS position, plus one per separator */
+  edgeOffsetip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  edgeTargetip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nRhsi + (size_t) nRulei + 1) * sizeof(int));
+  componentip    = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  memberOffsetip = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  memberip       = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  seenip         = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * (size_t) nThreadi * sizeof(int));
+  if ((edgeOffsetip == NULL) || (edgeTargetip == NULL) || (componentip == NULL) || (memberOffsetip == NULL) || (memberip == NULL) || (seenip == NULL)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+
+  /* Edges, by LHS: first pass counts, second pass fills */
+  memset(edgeOffsetip, 0, ((size_t) nSymboli + 1) * sizeof(int));
+  for (pass = 0; pass < 2; pass++) {
+    for (rulei = 0; rulei < nRulei; rulei++) {
+      if ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) == 0) {
+        continue;
+      }
+      lhsSymboli  = corep->ruleLhsSymbolip[rulei];
+      ruleOptionp = &(corep->ruleOptionp[rulei]);
+      i           = corep->ruleRhsOffsetip[rulei];
+      endi        = i + corep->ruleRhsLengthip[rulei];
+      for (; i <= endi; i++) {
+        if (i < endi) {
+          rhsSymboli = corep->rhsSymbolip[i];
+        } else if (ruleOptionp->sequenceb && (ruleOptionp->separatorSymboli >= 0)) {
+          /* After a nullable item of a sequence comes the separator */
+          rhsSymboli = ruleOptionp->separatorSymboli;
+        } else {
+          break;
+        }
+        if (pass == 0) {
+          edgeOffsetip[lhsSymboli + 1]++;
+        } else {
+          edgeTargetip[edgeOffsetip[lhsSymboli + 1]++] = rhsSymboli;
+        }
+        if ((corep->symbolPropertyBitSetip[rhsSymboli] & EARLEY_SYMBOL_IS_NULLABLE) == 0) {
+          break;
+        }
+      }
+    }
+    if (pass == 0) {
+      for (symboli = 1; symboli <= nSymboli; symboli++) {
+        edgeOffsetip[symboli] += edgeOffsetip[symboli - 1];
+      }
+      for (symboli = nSymboli; symboli > 0; symboli--) {
+        edgeOffsetip[symboli] = edgeOffsetip[symboli - 1];
+      }
+    }
+  }
+
+  if (! earleyGrammar_sccb(allocatorp, nSymboli, edgeOffsetip, edgeTargetip, componentip, &nComponenti)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+
+  /* Members of every component */
+  memset(memberOffsetip, 0, ((size_t) nComponenti + 1) * sizeof(int));
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    memberOffsetip[componentip[symboli] + 1]++;
+  }
+  for (componenti = 1; componenti <= nComponenti; componenti++) {
+    memberOffsetip[componenti] += memberOffsetip[componenti - 1];
+  }
+  for (componenti = nComponenti; componenti > 0; componenti--) {
+    memberOffsetip[componenti] = memberOffsetip[componenti - 1];
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    memberip[memberOffsetip[componentip[symboli] + 1]++] = symboli;
+  }
+
+  /* Rows: one closure row per component, one prediction row per component */
+  /* having rules, plus an empty prediction row shared by the others.     */
+  corep->symbolClosureRowip    = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) nSymboli + 1) * sizeof(int));
+  corep->symbolPredictionRowip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) nSymboli + 1) * sizeof(int));
+  if ((corep->symbolClosureRowip == NULL) || (corep->symbolPredictionRowip == NULL)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  /* seenip is first the prediction row of every component */
+  nPredictionRowi = 0;
+  for (componenti = 0; componenti < nComponenti; componenti++) {
+    seenip[componenti] = -1;
+    for (j = memberOffsetip[componenti]; j < memberOffsetip[componenti + 1]; j++) {
+      if ((corep->symbolPropertyBitSetip[memberip[j]] & EARLEY_SYMBOL_IS_TERMINAL) == 0) {
+        seenip[componenti] = nPredictionRowi++;
+        break;
+      }
+    }
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    corep->symbolClosureRowip[symboli]    = componentip[symboli];
+    corep->symbolPredictionRowip[symboli] = (seenip[componentip[symboli]] >= 0) ? seenip[componentip[symboli]] : nPredictionRowi;
+  }
+  nPredictionRowi++;
+
+  if ((nComponenti > 0) && (symbolWordl > SIZE_MAX / sizeof(earleyGrammarBitWord_t) / (size_t) nComponenti)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Prediction closure is too large\n");
+    errno = EINVAL;
+    goto err;
+  }
+  if ((ruleWordl > 0) && (ruleWordl > SIZE_MAX / sizeof(earleyGrammarBitWord_t) / (size_t) nPredictionRowi)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Prediction closure is too large\n");
+    errno = EINVAL;
+    goto err;
+  }
+  corep->closurep    = (earleyGrammarBitWord_t *) earleyAllocator_mallocp(allocatorp, ((size_t) nComponenti * symbolWordl + 1) * sizeof(earleyGrammarBitWord_t));
+  corep->predictionp = (earleyGrammarBitWord_t *) earleyAllocator_mallocp(allocatorp, ((size_t) nPredictionRowi * ruleWordl + 1) * sizeof(earleyGrammarBitWord_t));
+  if ((corep->closurep == NULL) || (corep->predictionp == NULL)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  memset(corep->closurep,    0, (size_t) nComponenti * symbolWordl * sizeof(earleyGrammarBitWord_t));
+  memset(corep->predictionp, 0, (size_t) nPredictionRowi * ruleWordl * sizeof(earleyGrammarBitWord_t));
+  corep->nClosureRowi    = nComponenti;
+  corep->nPredictionRowi = nPredictionRowi;
+
+  /* Slices of columns, processed by as many threads */
+  job.corep           = corep;
+  job.nComponenti     = nComponenti;
+  job.nPredictionRowi = nPredictionRowi;
+  job.edgeOffsetip    = edgeOffsetip;
+  job.edgeTargetip    = edgeTargetip;
+  job.componentip     = componentip;
+  job.memberOffsetip  = memberOffsetip;
+  job.memberip        = memberip;
+  job.seenip          = seenip;
+  earleyGrammar_thread_runv(earleyGrammar_closure_jobv, &job, nThreadi);
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  if (edgeOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, edgeOffsetip);
+  }
+  if (edgeTargetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, edgeTargetip);
+  }
+  if (componentip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, componentip);
+  }
+  if (memberOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, memberOffsetip);
+  }
+  if (memberip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, memberip);
+  }
+  if (seenip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, seenip);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_closure_jobv(void *contextp, int threadi, int nThreadi)
+/****************************************************************************/
+/* Components in increasing order, restricted to the symbol words and the  */
+/* rule words of the slice of that thread.                                 */
+/****************************************************************************/
+{
+  earleyGrammarClosureJob_t *jobp        = (earleyGrammarClosureJob_t *) contextp;
+  earleyGrammarCore_t       *corep       = jobp->corep;
+  size_t                     symbolWordl = EARLEYGRAMMAR_BITSET_WORDL(corep->nSymboli);
+  size_t                     ruleWordl   = EARLEYGRAMMAR_BITSET_WORDL(corep->nRulei);
+  int                       *seenip      = jobp->seenip + ((size_t) corep->nSymboli + 1) * (size_t) threadi;
+  int                       *componentip = jobp->componentip;
+  int                        lastRowi    = jobp->nPredictionRowi - 1;
+  earleyGrammarBitWord_t    *rowp;
+  earleyGrammarBitWord_t    *predictionRowp;
+  size_t                     firstSymboll;
+  size_t                     endSymboll;
+  size_t                     firstRulel;
+  size_t                     endRulel;
+  size_t                     wordl;
+  int                        componenti;
+  int                        successori;
+  int                        symboli;
+  int                        targeti;
+  int                        rulei;
+  int                        i;
+  int                        j;
+
+  earleyGrammar_thread_slicev(symbolWordl, threadi, nThreadi, &firstSymboll, &endSymboll);
+  earleyGrammar_thread_slicev(ruleWordl,   threadi, nThreadi, &firstRulel,   &endRulel);
+
+  /* Successors always have a lower number */
+  for (componenti = 0; componenti < jobp->nComponenti; componenti++) {
+    seenip[componenti] = -1;
+  }
+  for (componenti = 0; componenti < jobp->nComponenti; componenti++) {
+    rowp = corep->closurep + (size_t) componenti * symbolWordl;
+    for (j = jobp->memberOffsetip[componenti]; j < jobp->memberOffsetip[componenti + 1]; j++) {
+      symboli = jobp->memberip[j];
+      wordl   = (size_t) (symboli / EARLEYGRAMMAR_BITWORD_BITS);
+      if ((wordl >= firstSymboll) && (wordl < endSymboll)) {
+        rowp[wordl] |= ((earleyGrammarBitWord_t) 1) << (symboli % EARLEYGRAMMAR_BITWORD_BITS);
+      }
+      predictionRowp = corep->predictionp + (size_t) corep->symbolPredictionRowip[symboli] * ruleWordl;
+      for (i = corep->symbolLhsRuleOffsetip[symboli]; i < corep->symbolLhsRuleOffsetip[symboli + 1]; i++) {
+        rulei = corep->lhsRuleip[i];
+        wordl = (size_t) (rulei / EARLEYGRAMMAR_BITWORD_BITS);
+        if ((wordl >= firstRulel) && (wordl < endRulel) && ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) != 0)) {
+          predictionRowp[wordl] |= ((earleyGrammarBitWord_t) 1) << (rulei % EARLEYGRAMMAR_BITWORD_BITS);
+        }
+      }
+    }
+    for (j = jobp->memberOffsetip[componenti]; j < jobp->memberOffsetip[componenti + 1]; j++) {
+      symboli = jobp->memberip[j];
+      for (i = jobp->edgeOffsetip[symboli]; i < jobp->edgeOffsetip[symboli + 1]; i++) {
+        targeti    = jobp->edgeTargetip[i];
+        successori = componentip[targeti];
+        if ((successori == componenti) || (seenip[successori] == componenti)) {
+          continue;
+        }
+        seenip[successori] = componenti;
+        earleyGrammar_bitset_orv(rowp + firstSymboll, corep->closurep + (size_t) successori * symbolWordl + firstSymboll, endSymboll - firstSymboll);
+        if (corep->symbolPredictionRowip[targeti] != lastRowi) {
+          earleyGrammar_bitset_orv(corep->predictionp + (size_t) corep->symbolPredictionRowip[symboli] * ruleWordl + firstRulel,
+                                   corep->predictionp + (size_t) corep->symbolPredictionRowip[targeti] * ruleWordl + firstRulel,
+                                   endRulel - firstRulel);
+        }
+      }
+    }
+  }
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_nnf_rulev(earleyGrammarCore_t *corep, int passi, int lhsSymboli, int *rhsSymbolip, int rhsSymboli, int userRulei, int nulledi)
+/****************************************************************************/
+/* Pass 0 only counts, pass 1 stores                                        */
+/****************************************************************************/
+{
+  if (passi > 0) {
+    corep->nnfRuleLhsSymbolip[corep->nNnfRulei] = lhsSymboli;
+    corep->nnfRuleRhsOffsetip[corep->nNnfRulei] = corep->nNnfRhsi;
+    corep->nnfRuleRhsLengthip[corep->nNnfRulei] = rhsSymboli;
+    corep->nnfRuleUserip[corep->nNnfRulei]      = userRulei;
+    corep->nnfRuleNulledip[corep->nNnfRulei]    = nulledi;
+    memcpy(corep->nnfRhsSymbolip + corep->nNnfRhsi, rhsSymbolip, (size_t) rhsSymboli * sizeof(int));
+  }
+  corep->nNnfRulei++;
+  corep->nNnfRhsi += rhsSymboli;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_precompute_nnfb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+/* Nihilist normal form, with the CHAF factoring of Aycock and Horspool:   */
+/* - nulling RHS symbols are dropped, so nulling rules disappear,          */
+/* - a proper nullable RHS symbol is kept in a variant and dropped in      */
+/*   another one, and variants that would be empty are not generated,      */
+/* - to stay linear, a RHS is cut after its second proper nullable when    */
+/*   there are more of them: the rest becomes a new factor symbol, with    */
+/*   its own variants, and is itself dropped when all its symbols are      */
+/*   nullable. A piece has then at most 2 nullables and 8 variants.        */
+/* Unproductive rules are skipped. Sequence rules are kept as they are.    */
+/****************************************************************************/
+{
+  earleyGrammarCore_t       *corep      = earleyGrammarp->corep;
+  earleyAllocator_t         *allocatorp = &(corep->allocator);
+  earleyGrammarRuleOption_t *ruleOptionp;
+  int                       *symbolip   = NULL;   /* RHS without its nulling symbols */
+  int                       *variantip  = NULL;
+  int                        nulledpositionip[2];
+  int                        nNullablei;
+  int                        nNullingi;
+  int                        nSymboli;
+  int                        passi;
+  int                        rulei;
+  int                        lhsSymboli;
+  int                        restSymboli;
+  int                        restNullableb;
+  int                        restDeletedi;
+  int                        rhsSymboli;
+  int                        variantSymboli;
+  int                        nulledi;
+  int                        maski;
+  int                        starti;
+  int                        endi;
+  int                        i;
+  short                      rcb;
+
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->nnfRuleLhsSymbolip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->nnfRuleRhsOffsetip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->nnfRuleRhsLengthip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->nnfRuleUserip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->nnfRuleNulledip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->nnfRhsSymbolip);
+  corep->nnfRuleLhsSymbolip = NULL;
+  corep->nnfRuleRhsOffsetip = NULL;
+  corep->nnfRuleRhsLengthip = NULL;
+  corep->nnfRuleUserip      = NULL;
+  corep->nnfRuleNulledip    = NULL;
+  corep->nnfRhsSymbolip     = NULL;
+
+  /* Every RHS symbol is in at most 8 variants, that have at most one more symbol each */
+  if (corep->nRhsi > (INT_MAX - 16) / 16 - corep->nRulei) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Grammar is too large for its normal form\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  symbolip  = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nRhsi + 1) * sizeof(int));
+  variantip = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nRhsi + 1) * sizeof(int));
+  if ((symbolip == NULL) || (variantip == NULL)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+
+  for (passi = 0; passi < 2; passi++) {
+    corep->nNnfSymboli = corep->nSymboli;
+    corep->nNnfRulei   = 0;
+    corep->nNnfRhsi    = 0;
+    for (rulei = 0; rulei < corep->nRulei; rulei++) {
+      if (((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) == 0) ||
+          ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_NULLING) != 0)) {
+        continue;
+      }
+      ruleOptionp = &(corep->ruleOptionp[rulei]);
+      lhsSymboli  = corep->ruleLhsSymbolip[rulei];
+      if (ruleOptionp->sequenceb) {
+        earleyGrammar_nnf_rulev(corep, passi, lhsSymboli, corep->rhsSymbolip + corep->ruleRhsOffsetip[rulei], corep->ruleRhsLengthip[rulei], rulei, 0);
+        continue;
+      }
+
+      nSymboli  = 0;
+      nNullingi = 0;
+      i         = corep->ruleRhsOffsetip[rulei];
+      endi      = i + corep->ruleRhsLengthip[rulei];
+      for (; i < endi; i++) {
+        rhsSymboli = corep->rhsSymbolip[i];
+        if ((corep->symbolPropertyBitSetip[rhsSymboli] & EARLEY_SYMBOL_IS_NULLING) != 0) {
+          nNullingi++;
+        } else {
+          symbolip[nSymboli++] = rhsSymboli;
+        }
+      }
+
+      for (starti = 0; starti < nSymboli; starti = endi, lhsSymboli = restSymboli) {
+        /* Piece [starti, endi[, followed by restSymboli if any */
+        nNullablei = 0;
+        endi       = nSymboli;
+        for (i = starti; i < nSymboli; i++) {
+          if ((corep->symbolPropertyBitSetip[symbolip[i]] & EARLEY_SYMBOL_IS_NULLABLE) != 0) {
+            if (nNullablei == 2) {
+              endi = nulledpositionip[1] + 1;
+              break;
+            }
+            nulledpositionip[nNullablei++] = i;
+          }
+        }
+        restSymboli   = -1;
+        restNullableb = 0;
+        if (endi < nSymboli) {
+          restSymboli   = corep->nNnfSymboli++;
+          restNullableb = 1;
+          for (i = endi; i < nSymboli; i++) {
+            if ((corep->symbolPropertyBitSetip[symbolip[i]] & EARLEY_SYMBOL_IS_NULLABLE) == 0) {
+              restNullableb = 0;
+              break;
+            }
+          }
+        }
+
+        /* Bit k of maski drops the k-th nullable of the piece */
+        for (maski = 0; maski < (1 << nNullablei); maski++) {
+          for (restDeletedi = 0; restDeletedi <= restNullableb; restDeletedi++) {
+            variantSymboli = 0;
+            nulledi        = (starti == 0) ? nNullingi : 0;
+            for (i = starti; i < endi; i++) {
+              if (((nNullablei > 0) && (i == nulledpositionip[0]) && ((maski & 1) != 0)) ||
+                  ((nNullablei > 1) && (i == nulledpositionip[1]) && ((maski & 2) != 0))) {
+                nulledi++;
+              } else {
+                variantip[variantSymboli++] = symbolip[i];
+              }
+            }
+            if (restSymboli >= 0) {
+              if (restDeletedi) {
+                nulledi += nSymboli - endi;
+              } else {
+                variantip[variantSymboli++] = restSymboli;
+              }
+            }
+            if (variantSymboli > 0) {
+              earleyGrammar_nnf_rulev(corep, passi, lhsSymboli, variantip, variantSymboli, rulei, nulledi);
+            }
+          }
+        }
+      }
+    }
+
+    if (passi == 0) {
+      corep->nnfRuleLhsSymbolip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) corep->nNnfRulei + 1) * sizeof(int));
+      corep->nnfRuleRhsOffsetip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) corep->nNnfRulei + 1) * sizeof(int));
+      corep->nnfRuleRhsLengthip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) corep->nNnfRulei + 1) * sizeof(int));
+      corep->nnfRuleUserip      = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) corep->nNnfRulei + 1) * sizeof(int));
+      corep->nnfRuleNulledip    = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) corep->nNnfRulei + 1) * sizeof(int));
+      corep->nnfRhsSymbolip     = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) corep->nNnfRhsi + 1) * sizeof(int));
+      if ((corep->nnfRuleLhsSymbolip == NULL) || (corep->nnfRuleRhsOffsetip == NULL) || (corep->nnfRuleRhsLengthip == NULL) ||
+          (corep->nnfRuleUserip == NULL) || (corep->nnfRuleNulledip == NULL) || (corep->nnfRhsSymbolip == NULL)) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+        goto err;
+      }
+    }
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  corep->nNnfSymboli = corep->nSymboli;
+  corep->nNnfRulei   = 0;
+  corep->nNnfRhsi    = 0;
+  rcb = 0;
+
+ done:
+  if (symbolip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, symbolip);
+  }
+  if (variantip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, variantip);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static inline int earleyGrammar_dfa_item_cmpi(const void *p1, const void *p2)
+/****************************************************************************/
+{
+  int item1i = *((const int *) p1);
+  int item2i = *((const int *) p2);
+
+  return (item1i < item2i) ? -1 : ((item1i > item2i) ? 1 : 0);
+}
+
+/****************************************************************************/
+static inline int earleyGrammar_dfa_pair_cmpi(const void *p1, const void *p2)
+/****************************************************************************/
+{
+  const int *pair1ip = (const int *) p1;
+  const int *pair2ip = (const int *) p2;
+
+  if (pair1ip[0] != pair2ip[0]) {
+    return (pair1ip[0] < pair2ip[0]) ? -1 : 1;
+  }
+  return earleyGrammar_dfa_item_cmpi(pair1ip + 1, pair2ip + 1);
+}
+
+/****************************************************************************/
+static inline uint64_t earleyGrammar_dfa_hashl(const int *itemip, int nItemi)
+/****************************************************************************/
+{
+  uint64_t hashl = EARLEYGRAMMAR_IMAGE_FNV_OFFSET;
+  int      i;
+
+  for (i = 0; i < nItemi; i++) {
+    hashl ^= (uint64_t) (unsigned int) itemip[i];
+    hashl *= EARLEYGRAMMAR_IMAGE_FNV_PRIME;
+  }
+
+  return hashl;
+}
+
+/****************************************************************************/
+static inline int earleyGrammar_dfa_statei(earleyGrammarDfaBuild_t *buildp, int nNewItemi)
+/****************************************************************************/
+/* The candidate state is the nNewItemi sorted items after the last state. */
+/* Returns the state with the same items, that is created if needed, or -1 */
+/* on failure.                                                              */
+/****************************************************************************/
+{
+  earleyAllocator_t *allocatorp = buildp->allocatorp;
+  int               *itemip     = buildp->stateItemip + buildp->nStateItemi;
+  int               *haship;
+  size_t             hashl;
+  size_t             slotl;
+  int                statei;
+  int                firsti;
+  int                nItemi;
+
+  /* Keep the load factor under 1/2 */
+  if ((size_t) buildp->nStatei >= buildp->hashl / 2) {
+    hashl  = (buildp->hashl > 0) ? buildp->hashl * 2 : 64;
+    haship = (int *) allocatorp->mallocp(allocatorp->userDatavp, hashl * sizeof(int));
+    if (haship == NULL) {
+      return -1;
+    }
+    for (slotl = 0; slotl < hashl; slotl++) {
+      haship[slotl] = -1;
+    }
+    for (statei = 0; statei < buildp->nStatei; statei++) {
+      firsti = buildp->stateItemOffsetip[statei];
+      nItemi = buildp->stateItemOffsetip[statei + 1] - firsti;
+      slotl  = (size_t) earleyGrammar_hash_mixl(earleyGrammar_dfa_hashl(buildp->stateItemip + firsti, nItemi)) & (hashl - 1);
+      while (haship[slotl] >= 0) {
+        slotl = (slotl + 1) & (hashl - 1);
+      }
+      haship[slotl] = statei;
+    }
+    if (buildp->haship != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, buildp->haship);
+    }
+    buildp->haship = haship;
+    buildp->hashl  = hashl;
+  }
+
+  slotl = (size_t) earleyGrammar_hash_mixl(earleyGrammar_dfa_hashl(itemip, nNewItemi)) & (buildp->hashl - 1);
+  while ((statei = buildp->haship[slotl]) >= 0) {
+    firsti = buildp->stateItemOffsetip[statei];
+    nItemi = buildp->stateItemOffsetip[statei + 1] - firsti;
+    if ((nItemi == nNewItemi) && (memcmp(buildp->stateItemip + firsti, itemip, (size_t) nItemi * sizeof(int)) == 0)) {
+      return statei;
+    }
+    slotl = (slotl + 1) & (buildp->hashl - 1);
+  }
+
+  if (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(buildp->stateItemOffsetip), &(buildp->stateItemOffsetl), (size_t) buildp->nStatei + 2, sizeof(int))) {
+    return -1;
+  }
+  statei = buildp->nStatei++;
+  buildp->nStateItemi += nNewItemi;
+  buildp->stateItemOffsetip[buildp->nStatei] = buildp->nStateItemi;
+  buildp->haship[slotl] = statei;
+
+  return statei;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_precompute_dfab(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+/* Split LR(0) epsilon-DFA of Aycock and Horspool, on the normal form: no  */
+/* internal symbol derives the empty string, so the only epsilon moves are */
+/* predictions. A kernel state, reached by a goto, has its predictions in  */
+/* a separate non-kernel state, and states with the same items are merged. */
+/* The start state is the non-kernel state predicted by the start symbol.  */
+/*                                                                          */
+/* While building, an item is the integer offset+rule+dot, i.e. there is   */
+/* one per position of every internal RHS, end included: sorting items     */
+/* sorts them by rule then dot.                                             */
+/****************************************************************************/
+{
+  earleyGrammarCore_t     *corep      = earleyGrammarp->corep;
+  earleyAllocator_t       *allocatorp = &(corep->allocator);
+  earleyGrammarDfaBuild_t  build;
+  int                     *itemRuleip  = NULL;   /* Rule of every item */
+  int                     *lhsOffsetip = NULL;   /* Internal rules by LHS */
+  int                     *lhsRuleip   = NULL;
+  int                     *stampip     = NULL;   /* Last closure that visited a symbol */
+  int                     *stackip     = NULL;
+  int                     *pairip      = NULL;   /* (postdot symbol, advanced item) pairs */
+  size_t                   pairl       = 0;
+  int                      nItemi;
+  int                      nPairi;
+  int                      nStacki;
+  int                      nNewItemi;
+  int                      stampi;
+  int                      statei;
+  int                      targetStatei;
+  int                      rulei;
+  int                      doti;
+  int                      itemi;
+  int                      symboli;
+  int                      rhsSymboli;
+  int                      kernelb;
+  int                      i;
+  int                      j;
+  short                    rcb;
+
+  build.allocatorp              = allocatorp;
+  build.stateItemOffsetip       = NULL;
+  build.stateItemOffsetl        = 0;
+  build.stateItemip             = NULL;
+  build.stateIteml              = 0;
+  build.stateNonKernelip        = NULL;
+  build.stateNonKernell         = 0;
+  build.stateTransitionOffsetip = NULL;
+  build.stateTransitionOffsetl  = 0;
+  build.transitionSymbolip      = NULL;
+  build.transitionSymboll       = 0;
+  build.transitionStateip       = NULL;
+  build.transitionStatel        = 0;
+  build.haship                  = NULL;
+  build.hashl                   = 0;
+  build.nStatei                 = 0;
+  build.nStateItemi             = 0;
+  build.nTransitioni            = 0;
+
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->dfaStateItemOffsetip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->dfaItemRuleip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->dfaItemDotip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->dfaStateNonKernelip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->dfaStateTransitionOffsetip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->dfaTransitionSymbolip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->dfaTransitionStateip);
+  corep->dfaStateItemOffsetip       = NULL;
+  corep->dfaItemRuleip              = NULL;
+  corep->dfaItemDotip               = NULL;
+  corep->dfaStateNonKernelip        = NULL;
+  corep->dfaStateTransitionOffsetip = NULL;
+  corep->dfaTransitionSymbolip      = NULL;
+  corep->dfaTransitionStateip       = NULL;
+  corep->nDfaStatei                 = 0;
+  corep->nDfaItemi                  = 0;
+  corep->nDfaTransitioni            = 0;
+
+  if (! earleyGrammarp->option.dfab) {
+    rcb = 1;
+    goto done;
+  }
+
+  nItemi      = corep->nNnfRhsi + corep->nNnfRulei;
+  itemRuleip  = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nItemi + 1) * sizeof(int));
+  lhsOffsetip = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nNnfSymboli + 1) * sizeof(int));
+  lhsRuleip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nNnfRulei + 1) * sizeof(int));
+  stampip     = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nNnfSymboli + 1) * sizeof(int));
+  stackip     = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nNnfSymboli + 1) * sizeof(int));
+  if ((itemRuleip == NULL) || (lhsOffsetip == NULL) || (lhsRuleip == NULL) || (stampip == NULL) || (stackip == NULL)) {
+    goto err;
+  }
+
+  /* Rule of every item, and internal rules by LHS */
+  memset(lhsOffsetip, 0, ((size_t) corep->nNnfSymboli + 1) * sizeof(int));
+  for (rulei = 0; rulei < corep->nNnfRulei; rulei++) {
+    for (doti = 0; doti <= corep->nnfRuleRhsLengthip[rulei]; doti++) {
+      itemRuleip[corep->nnfRuleRhsOffsetip[rulei] + rulei + doti] = rulei;
+    }
+    lhsOffsetip[corep->nnfRuleLhsSymbolip[rulei] + 1]++;
+  }
+  for (symboli = 1; symboli <= corep->nNnfSymboli; symboli++) {
+    lhsOffsetip[symboli] += lhsOffsetip[symboli - 1];
+  }
+  for (symboli = corep->nNnfSymboli; symboli > 0; symboli--) {
+    lhsOffsetip[symboli] = lhsOffsetip[symboli - 1];
+  }
+  for (rulei = 0; rulei < corep->nNnfRulei; rulei++) {
+    lhsRuleip[lhsOffsetip[corep->nnfRuleLhsSymbolip[rulei] + 1]++] = rulei;
+  }
+  for (symboli = 0; symboli < corep->nNnfSymboli; symboli++) {
+    stampip[symboli] = -1;
+  }
+  stampi = 0;
+
+  if (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(build.stateItemOffsetip), &(build.stateItemOffsetl), 1, sizeof(int))) {
+    goto err;
+  }
+  if (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(build.stateItemip), &(build.stateIteml), 1, sizeof(int))) {
+    goto err;
+  }
+  build.stateItemOffsetip[0] = 0;
+
+  /* statei -1 stands for the start: it predicts the start symbol */
+  for (statei = -1; statei < build.nStatei; statei++) {
+    nStacki = 0;
+    nPairi  = 0;
+    kernelb = 0;
+    if (statei < 0) {
+      stampip[corep->startSymboli] = stampi;
+      stackip[nStacki++] = corep->startSymboli;
+    } else {
+      if (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(build.stateTransitionOffsetip), &(build.stateTransitionOffsetl), (size_t) statei + 2, sizeof(int))) {
+        goto err;
+      }
+      if (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(build.stateNonKernelip), &(build.stateNonKernell), (size_t) statei + 1, sizeof(int))) {
+        goto err;
+      }
+      build.stateTransitionOffsetip[statei] = build.nTransitioni;
+      build.stateNonKernelip[statei]        = -1;
+
+      /* Items advanced over their postdot symbol, grouped by symbol */
+      for (i = build.stateItemOffsetip[statei]; i < build.stateItemOffsetip[statei + 1]; i++) {
+        itemi = build.stateItemip[i];
+        rulei = itemRuleip[itemi];
+        doti  = itemi - corep->nnfRuleRhsOffsetip[rulei] - rulei;
+        if (doti > 0) {
+          kernelb = 1;
+        }
+        if (doti < corep->nnfRuleRhsLengthip[rulei]) {
+          if (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &pairip, &pairl, 2 * ((size_t) nPairi + 1), sizeof(int))) {
+            goto err;
+          }
+          pairip[2 * nPairi]     = corep->nnfRhsSymbolip[corep->nnfRuleRhsOffsetip[rulei] + doti];
+          pairip[2 * nPairi + 1] = itemi + 1;
+          nPairi++;
+        }
+      }
+      if (nPairi > 1) {
+        qsort(pairip, (size_t) nPairi, 2 * sizeof(int), earleyGrammar_dfa_pair_cmpi);
+      }
+
+      for (i = 0; i < nPairi; i = j) {
+        symboli = pairip[2 * i];
+        if (kernelb && (stampip[symboli] != stampi)) {
+          stampip[symboli] = stampi;
+          stackip[nStacki++] = symboli;
+        }
+        for (j = i; (j < nPairi) && (pairip[2 * j] == symboli); j++) {
+          if (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(build.stateItemip), &(build.stateIteml), (size_t) build.nStateItemi + (size_t) (j - i) + 1, sizeof(int))) {
+            goto err;
+          }
+          build.stateItemip[build.nStateItemi + (j - i)] = pairip[2 * j + 1];
+        }
+        targetStatei = earleyGrammar_dfa_statei(&build, j - i);
+        if (targetStatei < 0) {
+          goto err;
+        }
+        if ((! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(build.transitionSymbolip), &(build.transitionSymboll), (size_t) build.nTransitioni + 1, sizeof(int))) ||
+            (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(build.transitionStateip), &(build.transitionStatel), (size_t) build.nTransitioni + 1, sizeof(int)))) {
+          goto err;
+        }
+        build.transitionSymbolip[build.nTransitioni] = symboli;
+        build.transitionStateip[build.nTransitioni]  = targetStatei;
+        build.nTransitioni++;
+      }
+    }
+
+    /* Predictions of the start, or of a kernel state: the closure of */
+    /* the postdot symbols through the first symbol of their rules.   */
+    if ((statei >= 0) && (! kernelb)) {
+      continue;
+    }
+    nNewItemi = 0;
+    while (nStacki > 0) {
+      symboli = stackip[--nStacki];
+      for (j = lhsOffsetip[symboli]; j < lhsOffsetip[symboli + 1]; j++) {
+        rulei = lhsRuleip[j];
+        if (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(build.stateItemip), &(build.stateIteml), (size_t) build.nStateItemi + (size_t) nNewItemi + 1, sizeof(int))) {
+          goto err;
+        }
+        build.stateItemip[build.nStateItemi + nNewItemi++] = corep->nnfRuleRhsOffsetip[rulei] + rulei;
+        rhsSymboli = corep->nnfRhsSymbolip[corep->nnfRuleRhsOffsetip[rulei]];
+        if (stampip[rhsSymboli] != stampi) {
+          stampip[rhsSymboli] = stampi;
+          stackip[nStacki++] = rhsSymboli;
+        }
+      }
+    }
+    stampi++;
+    /* The start state always exists, even without items */
+    if ((nNewItemi > 0) || (statei < 0)) {
+      qsort(build.stateItemip + build.nStateItemi, (size_t) nNewItemi, sizeof(int), earleyGrammar_dfa_item_cmpi);
+      targetStatei = earleyGrammar_dfa_statei(&build, nNewItemi);
+      if (targetStatei < 0) {
+        goto err;
+      }
+      if (statei >= 0) {
+        build.stateNonKernelip[statei] = targetStatei;
+      }
+    }
+  }
+  build.stateTransitionOffsetip[build.nStatei] = build.nTransitioni;
+
+  /* Final tables, in the core */
+  corep->dfaStateItemOffsetip       = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) build.nStatei + 1) * sizeof(int));
+  corep->dfaItemRuleip              = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) build.nStateItemi + 1) * sizeof(int));
+  corep->dfaItemDotip               = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) build.nStateItemi + 1) * sizeof(int));
+  corep->dfaStateNonKernelip        = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) build.nStatei + 1) * sizeof(int));
+  corep->dfaStateTransitionOffsetip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) build.nStatei + 1) * sizeof(int));
+  corep->dfaTransitionSymbolip      = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) build.nTransitioni + 1) * sizeof(int));
+  corep->dfaTransitionStateip       = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) build.nTransitioni + 1) * sizeof(int));
+  if ((corep->dfaStateItemOffsetip == NULL) || (corep->dfaItemRuleip == NULL) || (corep->dfaItemDotip == NULL) || (corep->dfaStateNonKernelip == NULL) ||
+      (corep->dfaStateTransitionOffsetip == NULL) || (corep->dfaTransitionSymbolip == NULL) || (corep->dfaTransitionStateip == NULL)) {
+    goto err;
+  }
+  memcpy(corep->dfaStateItemOffsetip,       build.stateItemOffsetip,       ((size_t) build.nStatei + 1) * sizeof(int));
+  memcpy(corep->dfaStateNonKernelip,        build.stateNonKernelip,        (size_t) build.nStatei * sizeof(int));
+  memcpy(corep->dfaStateTransitionOffsetip, build.stateTransitionOffsetip, ((size_t) build.nStatei + 1) * sizeof(int));
+  if (build.nTransitioni > 0) {
+    memcpy(corep->dfaTransitionSymbolip, build.transitionSymbolip, (size_t) build.nTransitioni * sizeof(int));
+    memcpy(corep->dfaTransitionStateip,  build.transitionStateip,  (size_t) build.nTransitioni * sizeof(int));
+  }
+  for (i = 0; i < build.nStateItemi; i++) {
+    itemi = build.stateItemip[i];
+    rulei = itemRuleip[itemi];
+    corep->dfaItemRuleip[i] = rulei;
+    corep->dfaItemDotip[i]  = itemi - corep->nnfRuleRhsOffsetip[rulei] - rulei;
+  }
+  corep->nDfaStatei      = build.nStatei;
+  corep->nDfaItemi       = build.nStateItemi;
+  corep->nDfaTransitioni = build.nTransitioni;
+
+  rcb = 1;
+  goto done;
+
+ err:
+  /* Everything that can fail is an allocation */
+  EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+  rcb = 0;
+
+ done:
+  if (itemRuleip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, itemRuleip);
+  }
+  if (lhsOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, lhsOffsetip);
+  }
+  if (lhsRuleip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, lhsRuleip);
+  }
+  if (stampip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, stampip);
+  }
+  if (stackip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, stackip);
+  }
+  if (pairip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, pairip);
+  }
+  if (build.stateItemOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, build.stateItemOffsetip);
+  }
+  if (build.stateItemip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, build.stateItemip);
+  }
+  if (build.stateNonKernelip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, build.stateNonKernelip);
+  }
+  if (build.stateTransitionOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, build.stateTransitionOffsetip);
+  }
+  if (build.transitionSymbolip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, build.transitionSymbolip);
+  }
+  if (build.transitionStateip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, build.transitionStateip);
+  }
+  if (build.haship != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, build.haship);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static inline int earleyGrammar_rowSet_addi(earleyGrammarRowSet_t *rowSetp, const earleyGrammarBitWord_t *rowp)
+/****************************************************************************/
+/* Index of the row with the same bits, that is appended if needed, or -1  */
+/* on failure.                                                              */
+/****************************************************************************/
+{
+  return earleyGrammar_rowSet_add_hashi(rowSetp, rowp, earleyGrammar_hash_mixl(earleyGrammar_image_checksuml(EARLEYGRAMMAR_IMAGE_FNV_OFFSET, rowp, rowSetp->wordl * sizeof(earleyGrammarBitWord_t))));
+}
+
+/****************************************************************************/
+static inline int earleyGrammar_rowSet_add_hashi(earleyGrammarRowSet_t *rowSetp, const earleyGrammarBitWord_t *rowp, uint64_t rowHashl)
+/****************************************************************************/
+/* Same with the hash of the row already known. Hashes are kept with the   */
+/* rows, for growing the table and for merging sets.                       */
+/****************************************************************************/
+{
+  earleyAllocator_t *allocatorp = rowSetp->allocatorp;
+  size_t             wordl      = rowSetp->wordl;
+  int               *haship;
+  size_t             hashl;
+  size_t             slotl;
+  int                rowi;
+
+  /* Keep the load factor under 1/2 */
+  if ((size_t) rowSetp->nRowi >= rowSetp->hashl / 2) {
+    hashl  = (rowSetp->hashl > 0) ? rowSetp->hashl * 2 : 64;
+    haship = (int *) allocatorp->mallocp(allocatorp->userDatavp, hashl * sizeof(int));
+    if (haship == NULL) {
+      return -1;
+    }
+    for (slotl = 0; slotl < hashl; slotl++) {
+      haship[slotl] = -1;
+    }
+    for (rowi = 0; rowi < rowSetp->nRowi; rowi++) {
+      slotl = (size_t) rowSetp->rowHashlp[rowi] & (hashl - 1);
+      while (haship[slotl] >= 0) {
+        slotl = (slotl + 1) & (hashl - 1);
+      }
+      haship[slotl] = rowi;
+    }
+    if (rowSetp->haship != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, rowSetp->haship);
+    }
+    rowSetp->haship = haship;
+    rowSetp->hashl  = hashl;
+  }
+
+  slotl = (size_t) rowHashl & (rowSetp->hashl - 1);
+  while ((rowi = rowSetp->haship[slotl]) >= 0) {
+    if ((rowSetp->rowHashlp[rowi] == rowHashl) && (memcmp(rowSetp->rowp + (size_t) rowi * wordl, rowp, wordl * sizeof(earleyGrammarBitWord_t)) == 0)) {
+      return rowi;
+    }
+    slotl = (slotl + 1) & (rowSetp->hashl - 1);
+  }
+
+  if ((! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(rowSetp->rowp), &(rowSetp->rowl), ((size_t) rowSetp->nRowi + 1) * wordl, sizeof(earleyGrammarBitWord_t))) ||
+      (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &(rowSetp->rowHashlp), &(rowSetp->rowHashl), (size_t) rowSetp->nRowi + 1, sizeof(uint64_t)))) {
+    return -1;
+  }
+  rowi = rowSetp->nRowi++;
+  memcpy(rowSetp->rowp + (size_t) rowi * wordl, rowp, wordl * sizeof(earleyGrammarBitWord_t));
+  rowSetp->rowHashlp[rowi] = rowHashl;
+  rowSetp->haship[slotl]   = rowi;
+
+  return rowi;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_precompute_lookaheadb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+/* One-token lookahead over the terminals, in rows of nSymboli+1 bits: bit */
+/* nSymboli stands for the end of input.                                   */
+/* - FIRST(X) is the prediction closure of X restricted to terminals, so   */
+/*   it shares the rows of the closure.                                    */
+/* - FOLLOW(A) gets FIRST(beta) for every occurrence X ::= alpha A beta,   */
+/*   and includes FOLLOW(X) when beta is nullable. These inclusions are a  */
+/*   graph, condensed like the prediction one, and FOLLOW rows are OR-ed   */
+/*   in reverse topological order.                                         */
+/* - The lookahead of a dotted rule X ::= alpha . beta is FIRST(beta), and */
+/*   FOLLOW(X) when beta is nullable. Identical rows are stored once.      */
+/* Sets of sequence rules are supersets: they do not depend on how many    */
+/* items were already seen.                                                */
+/* With several threads, FIRST and FOLLOW are filled by slices of columns, */
+/* and dotted rules by slices of rules. Merging the row sets of the slices */
+/* in order gives the same row numbers as a single thread.                 */
+/****************************************************************************/
+{
+  earleyGrammarCore_t         *corep      = earleyGrammarp->corep;
+  earleyAllocator_t           *allocatorp = &(corep->allocator);
+  earleyGrammarRuleOption_t   *ruleOptionp;
+  earleyGrammarRowSet_t        rowSetp[EARLEYGRAMMAR_THREAD_MAX];
+  short                        okbp[EARLEYGRAMMAR_THREAD_MAX];
+  earleyGrammarLookaheadJob_t  job;
+  int                          nSymboli   = corep->nSymboli;
+  int                          nRulei     = corep->nRulei;
+  int                          nDottedi   = corep->nRhsi + corep->nRulei;
+  size_t                       closureWordl = EARLEYGRAMMAR_BITSET_WORDL(nSymboli);
+  size_t                       wordl        = EARLEYGRAMMAR_BITSET_WORDL((size_t) nSymboli + 1);
+  int                          nFollowThreadi = earleyGrammar_thread_counti(earleyGrammarp, wordl, EARLEYGRAMMAR_THREAD_WORDL);
+  int                          nDottedThreadi = earleyGrammar_thread_counti(earleyGrammarp, (size_t) nRulei, EARLEYGRAMMAR_THREAD_RULEL);
+  int                          nThreadi       = (nFollowThreadi > nDottedThreadi) ? nFollowThreadi : nDottedThreadi;
+  earleyGrammarBitWord_t      *terminalp  = NULL;   /* Terminal symbols */
+  earleyGrammarBitWord_t      *followp    = NULL;   /* By component */
+  earleyGrammarBitWord_t      *suffixp    = NULL;
+  int                         *edgeOffsetip   = NULL;
+  int                         *edgeTargetip   = NULL;
+  int                         *componentip    = NULL;
+  int                         *memberOffsetip = NULL;
+  int                         *memberip       = NULL;
+  int                         *seenip         = NULL;
+  int                         *mapip          = NULL;   /* Rows of a slice, in the merged set */
+  size_t                       mapl           = 0;
+  size_t                       firstRulel;
+  size_t                       endRulel;
+  int                          nComponenti;
+  int                          componenti;
+  int                          passi;
+  int                          symboli;
+  int                          lhsSymboli;
+  int                          rhsSymboli;
+  int                          rulei;
+  int                          firsti;
+  int                          rowi;
+  int                          threadi;
+  int                          i;
+  short                        rcb;
+
+  for (threadi = 0; threadi < nDottedThreadi; threadi++) {
+    rowSetp[threadi].allocatorp = allocatorp;
+    rowSetp[threadi].wordl      = wordl;
+    rowSetp[threadi].rowp       = NULL;
+    rowSetp[threadi].rowl       = 0;
+    rowSetp[threadi].nRowi      = 0;
+    rowSetp[threadi].rowHashlp  = NULL;
+    rowSetp[threadi].rowHashl   = 0;
+    rowSetp[threadi].haship     = NULL;
+    rowSetp[threadi].hashl      = 0;
+    okbp[threadi]               = 1;
+  }
+
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->firstp);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->dottedLookaheadRowip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->lookaheadp);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->symbolFollowRowip);
+  corep->firstp               = NULL;
+  corep->dottedLookaheadRowip = NULL;
+  corep->lookaheadp           = NULL;
+  corep->symbolFollowRowip    = NULL;
+  corep->nLookaheadRowi       = 0;
+  corep->nLookaheadFullRowi   = 0;
+
+  if ((corep->nClosureRowi > 0) && (wordl > SIZE_MAX / sizeof(earleyGrammarBitWord_t) / (size_t) (corep->nClosureRowi + 1))) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Lookahead sets are too large\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  terminalp      = (earleyGrammarBitWord_t *) allocatorp->mallocp(allocatorp->userDatavp, wordl * sizeof(earleyGrammarBitWord_t));
+  suffixp        = (earleyGrammarBitWord_t *) allocatorp->mallocp(allocatorp->userDatavp, wordl * (size_t) nThreadi * sizeof(earleyGrammarBitWord_t));
+  edgeOffsetip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  edgeTargetip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nRhsi + (size_t) nRulei + 1) * sizeof(int));
+  componentip    = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  memberOffsetip = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  memberip       = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  seenip         = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * (size_t) nFollowThreadi * sizeof(int));
+  corep->firstp  = (earleyGrammarBitWord_t *) earleyAllocator_mallocp(allocatorp, ((size_t) corep->nClosureRowi * wordl + 1) * sizeof(earleyGrammarBitWord_t));
+  if ((terminalp == NULL) || (suffixp == NULL) || (edgeOffsetip == NULL) || (edgeTargetip == NULL) || (componentip == NULL) ||
+      (memberOffsetip == NULL) || (memberip == NULL) || (seenip == NULL) || (corep->firstp == NULL)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+
+  memset(terminalp, 0, wordl * sizeof(earleyGrammarBitWord_t));
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) != 0) {
+      terminalp[symboli / EARLEYGRAMMAR_BITWORD_BITS] |= ((earleyGrammarBitWord_t) 1) << (symboli % EARLEYGRAMMAR_BITWORD_BITS);
+    }
+  }
+#define EARLEYGRAMMAR_NULLABLEB(symboli) ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_NULLABLE) != 0)
+
+  /* FOLLOW inclusions: an edge A -> X when FOLLOW(A) includes FOLLOW(X) */
+  memset(edgeOffsetip, 0, ((size_t) nSymboli + 1) * sizeof(int));
+  for (passi = 0; passi < 2; passi++) {
+    for (rulei = 0; rulei < nRulei; rulei++) {
+      if ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) == 0) {
+        continue;
+      }
+      lhsSymboli  = corep->ruleLhsSymbolip[rulei];
+      ruleOptionp = &(corep->ruleOptionp[rulei]);
+      firsti      = corep->ruleRhsOffsetip[rulei];
+      for (i = firsti + corep->ruleRhsLengthip[rulei] - 1; i >= firsti - 1; i--) {
+        if (i >= firsti) {
+          rhsSymboli = corep->rhsSymbolip[i];
+        } else if (ruleOptionp->sequenceb && (ruleOptionp->separatorSymboli >= 0) && ((! ruleOptionp->properb) || EARLEYGRAMMAR_NULLABLEB(corep->rhsSymbolip[firsti]))) {
+          /* A separator can be last when not proper, or when items are nullable */
+          rhsSymboli = ruleOptionp->separatorSymboli;
+        } else {
+          break;
+        }
+        if (passi == 0) {
+          edgeOffsetip[rhsSymboli + 1]++;
+        } else {
+          edgeTargetip[edgeOffsetip[rhsSymboli + 1]++] = lhsSymboli;
+        }
+        if ((i >= firsti) && (! ruleOptionp->sequenceb) && (! EARLEYGRAMMAR_NULLABLEB(rhsSymboli))) {
+          break;
+        }
+      }
+    }
+    if (passi == 0) {
+      for (symboli = 1; symboli <= nSymboli; symboli++) {
+        edgeOffsetip[symboli] += edgeOffsetip[symboli - 1];
+      }
+      for (symboli = nSymboli; symboli > 0; symboli--) {
+        edgeOffsetip[symboli] = edgeOffsetip[symboli - 1];
+      }
+    }
+  }
+#undef EARLEYGRAMMAR_NULLABLEB
+
+  if (! earleyGrammar_sccb(allocatorp, nSymboli, edgeOffsetip, edgeTargetip, componentip, &nComponenti)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+
+  if ((nComponenti > 0) && (wordl > SIZE_MAX / sizeof(earleyGrammarBitWord_t) / (size_t) nComponenti)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Lookahead sets are too large\n");
+    errno = EINVAL;
+    goto err;
+  }
+  followp = (earleyGrammarBitWord_t *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nComponenti * wordl + 1) * sizeof(earleyGrammarBitWord_t));
+  if (followp == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  memset(followp, 0, (size_t) nComponenti * wordl * sizeof(earleyGrammarBitWord_t));
+
+  /* Members of every component */
+  memset(memberOffsetip, 0, ((size_t) nComponenti + 1) * sizeof(int));
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    memberOffsetip[componentip[symboli] + 1]++;
+  }
+  for (componenti = 1; componenti <= nComponenti; componenti++) {
+    memberOffsetip[componenti] += memberOffsetip[componenti - 1];
+  }
+  for (componenti = nComponenti; componenti > 0; componenti--) {
+    memberOffsetip[componenti] = memberOffsetip[componenti - 1];
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    memberip[memberOffsetip[componentip[symboli] + 1]++] = symboli;
+  }
+
+  job.corep          = corep;
+  job.wordl          = wordl;
+  job.closureWordl   = closureWordl;
+  job.terminalp      = terminalp;
+  job.followp        = followp;
+  job.suffixp        = suffixp;
+  job.nComponenti    = nComponenti;
+  job.edgeOffsetip   = edgeOffsetip;
+  job.edgeTargetip   = edgeTargetip;
+  job.componentip    = componentip;
+  job.memberOffsetip = memberOffsetip;
+  job.memberip       = memberip;
+  job.seenip         = seenip;
+  job.rowSetp        = rowSetp;
+  job.okbp           = okbp;
+  earleyGrammar_thread_runv(earleyGrammar_follow_jobv, &job, nFollowThreadi);
+
+  corep->dottedLookaheadRowip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) nDottedi + 1) * sizeof(int));
+  if (corep->dottedLookaheadRowip == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  earleyGrammar_thread_runv(earleyGrammar_dotted_jobv, &job, nDottedThreadi);
+  for (threadi = 0; threadi < nDottedThreadi; threadi++) {
+    if (! okbp[threadi]) {
+      goto malloc_err;
+    }
+  }
+
+  /* Rows of the next slices go to the set of the first one */
+  for (threadi = 1; threadi < nDottedThreadi; threadi++) {
+    if (! earleyGrammar_scratch_reserveb(allocatorp, (void **) &mapip, &mapl, (size_t) rowSetp[threadi].nRowi + 1, sizeof(int))) {
+      goto malloc_err;
+    }
+    for (rowi = 0; rowi < rowSetp[threadi].nRowi; rowi++) {
+      if ((mapip[rowi] = earleyGrammar_rowSet_add_hashi(&(rowSetp[0]), rowSetp[threadi].rowp + (size_t) rowi * wordl, rowSetp[threadi].rowHashlp[rowi])) < 0) {
+        goto malloc_err;
+      }
+    }
+    earleyGrammar_thread_slicev((size_t) nRulei, threadi, nDottedThreadi, &firstRulel, &endRulel);
+    for (rulei = (int) firstRulel; rulei < (int) endRulel; rulei++) {
+      firsti = corep->ruleRhsOffsetip[rulei] + rulei;
+      for (i = 0; i <= corep->ruleRhsLengthip[rulei]; i++) {
+        corep->dottedLookaheadRowip[firsti + i] = mapip[corep->dottedLookaheadRowip[firsti + i]];
+      }
+    }
+  }
+
+  /* FOLLOW rows of the nonterminals are kept for incremental updates. */
+  /* They usually are the rows of the rules ends already.               */
+  corep->symbolFollowRowip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) nSymboli + 1) * sizeof(int));
+  if (corep->symbolFollowRowip == NULL) {
+    goto malloc_err;
+  }
+  for (componenti = 0; componenti < nComponenti; componenti++) {
+    seenip[componenti] = -1;
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    corep->symbolFollowRowip[symboli] = -1;
+    if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) != 0) {
+      continue;
+    }
+    componenti = componentip[symboli];
+    if ((seenip[componenti] < 0) && ((seenip[componenti] = earleyGrammar_rowSet_addi(&(rowSetp[0]), followp + (size_t) componenti * wordl)) < 0)) {
+      goto malloc_err;
+    }
+    corep->symbolFollowRowip[symboli] = seenip[componenti];
+  }
+
+  corep->lookaheadp = (earleyGrammarBitWord_t *) earleyAllocator_mallocp(allocatorp, ((size_t) rowSetp[0].nRowi * wordl + 1) * sizeof(earleyGrammarBitWord_t));
+  if (corep->lookaheadp == NULL) {
+    goto malloc_err;
+  }
+  if (rowSetp[0].nRowi > 0) {
+    memcpy(corep->lookaheadp, rowSetp[0].rowp, (size_t) rowSetp[0].nRowi * wordl * sizeof(earleyGrammarBitWord_t));
+  }
+  corep->nLookaheadRowi     = rowSetp[0].nRowi;
+  corep->nLookaheadFullRowi = rowSetp[0].nRowi;
+
+  rcb = 1;
+  goto done;
+
+ malloc_err:
+  EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+
+ err:
+  rcb = 0;
+
+ done:
+  if (terminalp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, terminalp);
+  }
+  if (suffixp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, suffixp);
+  }
+  if (followp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, followp);
+  }
+  if (edgeOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, edgeOffsetip);
+  }
+  if (edgeTargetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, edgeTargetip);
+  }
+  if (componentip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, componentip);
+  }
+  if (memberOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, memberOffsetip);
+  }
+  if (memberip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, memberip);
+  }
+  if (seenip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, seenip);
+  }
+  if (mapip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, mapip);
+  }
+  for (threadi = 0; threadi < nDottedThreadi; threadi++) {
+    if (rowSetp[threadi].rowp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, rowSetp[threadi].rowp);
+    }
+    if (rowSetp[threadi].rowHashlp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, rowSetp[threadi].rowHashlp);
+    }
+    if (rowSetp[threadi].haship != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, rowSetp[threadi].haship);
+    }
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_follow_jobv(void *contextp, int threadi, int nThreadi)
+/****************************************************************************/
+/* FIRST, then FOLLOW own and inherited parts, on the columns of a slice   */
+/****************************************************************************/
+{
+  earleyGrammarLookaheadJob_t *jobp        = (earleyGrammarLookaheadJob_t *) contextp;
+  earleyGrammarCore_t         *corep       = jobp->corep;
+  earleyGrammarRuleOption_t   *ruleOptionp;
+  int                          nSymboli    = corep->nSymboli;
+  size_t                       wordl       = jobp->wordl;
+  earleyGrammarBitWord_t      *followp     = jobp->followp;
+  earleyGrammarBitWord_t      *suffixp     = jobp->suffixp + wordl * (size_t) threadi;
+  int                         *componentip = jobp->componentip;
+  int                         *seenip      = jobp->seenip + ((size_t) nSymboli + 1) * (size_t) threadi;
+  earleyGrammarBitWord_t      *rowp;
+  size_t                       firstl;
+  size_t                       endl;
+  size_t                       slicel;
+  size_t                       l;
+  int                          componenti;
+  int                          successori;
+  int                          symboli;
+  int                          rhsSymboli;
+  int                          itemSymboli;
+  int                          separatorSymboli;
+  int                          rulei;
+  int                          firsti;
+  int                          rowi;
+  int                          i;
+  int                          j;
+
+  earleyGrammar_thread_slicev(wordl, threadi, nThreadi, &firstl, &endl);
+  slicel = endl - firstl;
+  if (slicel == 0) {
+    return;
+  }
+
+  /* FIRST */
+  for (rowi = 0; rowi < corep->nClosureRowi; rowi++) {
+    rowp = corep->firstp + (size_t) rowi * wordl;
+    for (l = firstl; l < endl; l++) {
+      rowp[l] = (l < jobp->closureWordl) ? (corep->closurep[(size_t) rowi * jobp->closureWordl + l] & jobp->terminalp[l]) : 0;
+    }
+  }
+#define EARLEYGRAMMAR_FIRSTP(symboli) (corep->firstp + (size_t) corep->symbolClosureRowip[symboli] * wordl + firstl)
+#define EARLEYGRAMMAR_NULLABLEB(symboli) ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_NULLABLE) != 0)
+#define EARLEYGRAMMAR_FOLLOWP(symboli) (followp + (size_t) componentip[symboli] * wordl + firstl)
+
+  /* FOLLOW, own part: what comes next in the RHS */
+  l = (size_t) (nSymboli / EARLEYGRAMMAR_BITWORD_BITS);
+  if ((corep->startSymboli >= 0) && (l >= firstl) && (l < endl)) {
+    followp[(size_t) componentip[corep->startSymboli] * wordl + l] |= ((earleyGrammarBitWord_t) 1) << (nSymboli % EARLEYGRAMMAR_BITWORD_BITS);
+  }
+  for (rulei = 0; rulei < corep->nRulei; rulei++) {
+    if ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) == 0) {
+      continue;
+    }
+    ruleOptionp = &(corep->ruleOptionp[rulei]);
+    firsti      = corep->ruleRhsOffsetip[rulei];
+    if (ruleOptionp->sequenceb) {
+      itemSymboli      = corep->rhsSymbolip[firsti];
+      separatorSymboli = ruleOptionp->separatorSymboli;
+      if (separatorSymboli >= 0) {
+        earleyGrammar_bitset_orv(EARLEYGRAMMAR_FOLLOWP(itemSymboli), EARLEYGRAMMAR_FIRSTP(separatorSymboli), slicel);
+        earleyGrammar_bitset_orv(EARLEYGRAMMAR_FOLLOWP(separatorSymboli), EARLEYGRAMMAR_FIRSTP(itemSymboli), slicel);
+        if (EARLEYGRAMMAR_NULLABLEB(itemSymboli)) {
+          earleyGrammar_bitset_orv(EARLEYGRAMMAR_FOLLOWP(separatorSymboli), EARLEYGRAMMAR_FIRSTP(separatorSymboli), slicel);
+        }
+      }
+      if ((separatorSymboli < 0) || EARLEYGRAMMAR_NULLABLEB(separatorSymboli)) {
+        earleyGrammar_bitset_orv(EARLEYGRAMMAR_FOLLOWP(itemSymboli), EARLEYGRAMMAR_FIRSTP(itemSymboli), slicel);
+      }
+      continue;
+    }
+    memset(suffixp, 0, slicel * sizeof(earleyGrammarBitWord_t));
+    for (i = firsti + corep->ruleRhsLengthip[rulei] - 1; i >= firsti; i--) {
+      rhsSymboli = corep->rhsSymbolip[i];
+      earleyGrammar_bitset_orv(EARLEYGRAMMAR_FOLLOWP(rhsSymboli), suffixp, slicel);
+      if (! EARLEYGRAMMAR_NULLABLEB(rhsSymboli)) {
+        memset(suffixp, 0, slicel * sizeof(earleyGrammarBitWord_t));
+      }
+      earleyGrammar_bitset_orv(suffixp, EARLEYGRAMMAR_FIRSTP(rhsSymboli), slicel);
+    }
+  }
+#undef EARLEYGRAMMAR_FIRSTP
+#undef EARLEYGRAMMAR_NULLABLEB
+#undef EARLEYGRAMMAR_FOLLOWP
+
+  /* FOLLOW, inherited part. Successors always have a lower number. */
+  for (componenti = 0; componenti < jobp->nComponenti; componenti++) {
+    seenip[componenti] = -1;
+  }
+  for (componenti = 0; componenti < jobp->nComponenti; componenti++) {
+    rowp = followp + (size_t) componenti * wordl;
+    for (j = jobp->memberOffsetip[componenti]; j < jobp->memberOffsetip[componenti + 1]; j++) {
+      symboli = jobp->memberip[j];
+      for (i = jobp->edgeOffsetip[symboli]; i < jobp->edgeOffsetip[symboli + 1]; i++) {
+        successori = componentip[jobp->edgeTargetip[i]];
+        if ((successori == componenti) || (seenip[successori] == componenti)) {
+          continue;
+        }
+        seenip[successori] = componenti;
+        earleyGrammar_bitset_orv(rowp + firstl, followp + (size_t) successori * wordl + firstl, slicel);
+      }
+    }
+  }
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_dotted_jobv(void *contextp, int threadi, int nThreadi)
+/****************************************************************************/
+/* Dotted rules of a slice of rules, numbered in the row set of the slice  */
+/****************************************************************************/
+{
+  earleyGrammarLookaheadJob_t *jobp        = (earleyGrammarLookaheadJob_t *) contextp;
+  earleyGrammarCore_t         *corep       = jobp->corep;
+  size_t                       wordl       = jobp->wordl;
+  earleyGrammarBitWord_t      *suffixp     = jobp->suffixp + wordl * (size_t) threadi;
+  size_t                       firstRulel;
+  size_t                       endRulel;
+  int                          rulei;
+
+  earleyGrammar_thread_slicev((size_t) corep->nRulei, threadi, nThreadi, &firstRulel, &endRulel);
+  for (rulei = (int) firstRulel; rulei < (int) endRulel; rulei++) {
+    if (! earleyGrammar_lookahead_ruleb(corep, &(jobp->rowSetp[threadi]), 0, 0, suffixp, wordl, jobp->followp + (size_t) jobp->componentip[corep->ruleLhsSymbolip[rulei]] * wordl, rulei)) {
+      jobp->okbp[threadi] = 0;
+      return;
+    }
+  }
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_lookahead_ruleb(earleyGrammarCore_t *corep, earleyGrammarRowSet_t *rowSetp, int firstRowi, short updateb, earleyGrammarBitWord_t *suffixp, size_t wordl, const earleyGrammarBitWord_t *lhsFollowp, int rulei)
+/****************************************************************************/
+/* Dotted rules of one rule, from the end of the RHS, given the FOLLOW row */
+/* of its LHS. suffixp is wordl words of scratch.                          */
+/* See lookahead_rowb for firstRowi and updateb: both 0 in a build.        */
+/****************************************************************************/
+{
+  earleyGrammarRuleOption_t   *ruleOptionp = &(corep->ruleOptionp[rulei]);
+  int                          firsti      = corep->ruleRhsOffsetip[rulei];
+  int                          rhsSymboli;
+  int                          itemSymboli;
+  int                          separatorSymboli;
+  int                          i;
+  short                        nullableb;
+
+#define EARLEYGRAMMAR_FIRSTP(symboli) (corep->firstp + (size_t) corep->symbolClosureRowip[symboli] * wordl)
+#define EARLEYGRAMMAR_NULLABLEB(symboli) ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_NULLABLE) != 0)
+  if ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) == 0) {
+    memset(suffixp, 0, wordl * sizeof(earleyGrammarBitWord_t));
+    for (i = 0; i <= corep->ruleRhsLengthip[rulei]; i++) {
+      if (! earleyGrammar_lookahead_rowb(corep, rowSetp, firstRowi, updateb, suffixp, wordl, &(corep->dottedLookaheadRowip[firsti + rulei + i]))) {
+        return 0;
+      }
+    }
+    return 1;
+  }
+  memcpy(suffixp, lhsFollowp, wordl * sizeof(earleyGrammarBitWord_t));
+  if (ruleOptionp->sequenceb) {
+    /* After an item: the end, a separator or another item */
+    itemSymboli      = corep->rhsSymbolip[firsti];
+    separatorSymboli = ruleOptionp->separatorSymboli;
+    if (separatorSymboli >= 0) {
+      earleyGrammar_bitset_orv(suffixp, EARLEYGRAMMAR_FIRSTP(separatorSymboli), wordl);
+    }
+    if ((separatorSymboli < 0) || EARLEYGRAMMAR_NULLABLEB(separatorSymboli)) {
+      earleyGrammar_bitset_orv(suffixp, EARLEYGRAMMAR_FIRSTP(itemSymboli), wordl);
+    }
+    if (! earleyGrammar_lookahead_rowb(corep, rowSetp, firstRowi, updateb, suffixp, wordl, &(corep->dottedLookaheadRowip[firsti + rulei + 1]))) {
+      return 0;
+    }
+    /* Before the first item: the end only if the sequence can be empty */
+    nullableb = (ruleOptionp->minimumi == 0) || EARLEYGRAMMAR_NULLABLEB(itemSymboli);
+    if (! nullableb) {
+      memset(suffixp, 0, wordl * sizeof(earleyGrammarBitWord_t));
+    } else {
+      memcpy(suffixp, lhsFollowp, wordl * sizeof(earleyGrammarBitWord_t));
+    }
+    earleyGrammar_bitset_orv(suffixp, EARLEYGRAMMAR_FIRSTP(itemSymboli), wordl);
+    if (! earleyGrammar_lookahead_rowb(corep, rowSetp, firstRowi, updateb, suffixp, wordl, &(corep->dottedLookaheadRowip[firsti + rulei]))) {
+      return 0;
+    }
+    return 1;
+  }
+  for (i = corep->ruleRhsLengthip[rulei]; i >= 0; i--) {
+    if (i < corep->ruleRhsLengthip[rulei]) {
+      rhsSymboli = corep->rhsSymbolip[firsti + i];
+      if (! EARLEYGRAMMAR_NULLABLEB(rhsSymboli)) {
+        memset(suffixp, 0, wordl * sizeof(earleyGrammarBitWord_t));
+      }
+      earleyGrammar_bitset_orv(suffixp, EARLEYGRAMMAR_FIRSTP(rhsSymboli), wordl);
+    }
+    if (! earleyGrammar_lookahead_rowb(corep, rowSetp, firstRowi, updateb, suffixp, wordl, &(corep->dottedLookaheadRowip[firsti + rulei + i]))) {
+      return 0;
+    }
+  }
+#undef EARLEYGRAMMAR_FIRSTP
+#undef EARLEYGRAMMAR_NULLABLEB
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_lookahead_rowb(earleyGrammarCore_t *corep, earleyGrammarRowSet_t *rowSetp, int firstRowi, short updateb, const earleyGrammarBitWord_t *rowp, size_t wordl, int *rowip)
+/****************************************************************************/
+/* Row number of rowp in *rowip. An update stores its rows after the       */
+/* firstRowi ones of lookaheadp, and keeps *rowip when it is not -1 and    */
+/* its row did not change.                                                  */
+/****************************************************************************/
+{
+  int rowi;
+
+  if (updateb && (*rowip >= 0) && (memcmp(corep->lookaheadp + (size_t) *rowip * wordl, rowp, wordl * sizeof(earleyGrammarBitWord_t)) == 0)) {
+    return 1;
+  }
+  if ((rowi = earleyGrammar_rowSet_addi(rowSetp, rowp)) < 0) {
+    return 0;
+  }
+  *rowip = firstRowi + rowi;
+  return 1;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_precompute_separatorv(earleyGrammarCore_t *corep, int *separatorOffsetip, int *separatorip)
+/****************************************************************************/
+/* Sequence rules with a separator, by separator symbol: they count for    */
+/* non-empty derivations as soon as the sequence can have two items.       */
+/****************************************************************************/
+{
+  earleyGrammarRuleOption_t *ruleOptionp;
+  int                        nSymboli = corep->nSymboli;
+  int                        symboli;
+  int                        rulei;
+
+  memset(separatorOffsetip, 0, ((size_t) nSymboli + 1) * sizeof(int));
+  for (rulei = 0; rulei < corep->nRulei; rulei++) {
+    ruleOptionp = &(corep->ruleOptionp[rulei]);
+    if (ruleOptionp->sequenceb && (ruleOptionp->separatorSymboli >= 0)) {
+      separatorOffsetip[ruleOptionp->separatorSymboli + 1]++;
+    }
+  }
+  for (symboli = 1; symboli <= nSymboli; symboli++) {
+    separatorOffsetip[symboli] += separatorOffsetip[symboli - 1];
+  }
+  for (symboli = nSymboli; symboli > 0; symboli--) {
+    separatorOffsetip[symboli] = separatorOffsetip[symboli - 1];
+  }
+  for (rulei = 0; rulei < corep->nRulei; rulei++) {
+    ruleOptionp = &(corep->ruleOptionp[rulei]);
+    if (ruleOptionp->sequenceb && (ruleOptionp->separatorSymboli >= 0)) {
+      separatorip[separatorOffsetip[ruleOptionp->separatorSymboli + 1]++] = rulei;
+    }
+  }
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_precompute_nonEmptyv(earleyGrammarCore_t *corep, char *nonEmptybp, int *worklistip, int nWorklisti, int *separatorOffsetip, int *separatorip, char *symbolFlagbp)
+/****************************************************************************/
+/* Non-empty: a productive rule with one non-empty RHS symbol, from the    */
+/* nWorklisti non-empty symbols in worklistip. Any occurrence suffices, so */
+/* no counter. Symbols that become non-empty are flagged in symbolFlagbp,  */
+/* if not NULL.                                                             */
+/****************************************************************************/
+{
+  int symboli;
+  int lhsSymboli;
+  int itemSymboli;
+  int rulei;
+  int i;
+
+  while (nWorklisti > 0) {
+    symboli = worklistip[--nWorklisti];
+    for (i = corep->symbolRhsRuleOffsetip[symboli]; i < corep->symbolRhsRuleOffsetip[symboli + 1]; i++) {
+      rulei = corep->rhsRuleip[i];
+      lhsSymboli = corep->ruleLhsSymbolip[rulei];
+      if (((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) != 0) && (! nonEmptybp[lhsSymboli])) {
+        nonEmptybp[lhsSymboli] = 1;
+        worklistip[nWorklisti++] = lhsSymboli;
+        if (symbolFlagbp != NULL) {
+          symbolFlagbp[lhsSymboli] |= EARLEYGRAMMAR_INCREMENTAL_NONEMPTY;
+        }
+      }
+    }
+    for (i = separatorOffsetip[symboli]; i < separatorOffsetip[symboli + 1]; i++) {
+      rulei       = separatorip[i];
+      lhsSymboli  = corep->ruleLhsSymbolip[rulei];
+      itemSymboli = corep->rhsSymbolip[corep->ruleRhsOffsetip[rulei]];
+      if (((corep->symbolPropertyBitSetip[itemSymboli] & EARLEY_SYMBOL_IS_PRODUCTIVE) != 0) && (! nonEmptybp[lhsSymboli])) {
+        nonEmptybp[lhsSymboli] = 1;
+        worklistip[nWorklisti++] = lhsSymboli;
+        if (symbolFlagbp != NULL) {
+          symbolFlagbp[lhsSymboli] |= EARLEYGRAMMAR_INCREMENTAL_NONEMPTY;
+        }
+      }
+    }
+  }
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_precompute_rule_nonEmptyb(earleyGrammarCore_t *corep, int rulei, char *nonEmptybp)
+/****************************************************************************/
+/* Whether one of the RHS symbols of rulei derives a non-empty string: a   */
+/* nullable rule without one is nulling.                                    */
+/****************************************************************************/
+{
+  earleyGrammarRuleOption_t *ruleOptionp = &(corep->ruleOptionp[rulei]);
+  int                        i           = corep->ruleRhsOffsetip[rulei];
+  int                        endi        = i + corep->ruleRhsLengthip[rulei];
+
+  for (; i < endi; i++) {
+    if (nonEmptybp[corep->rhsSymbolip[i]]) {
+      return 1;
+    }
+  }
+  if (ruleOptionp->sequenceb && (ruleOptionp->separatorSymboli >= 0) && nonEmptybp[ruleOptionp->separatorSymboli] &&
+      ((corep->symbolPropertyBitSetip[corep->rhsSymbolip[corep->ruleRhsOffsetip[rulei]]] & EARLEY_SYMBOL_IS_PRODUCTIVE) != 0)) {
+    return 1;
+  }
+  return 0;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_precompute_accessiblev(earleyGrammarCore_t *corep, int *worklistip, int nWorklisti)
+/****************************************************************************/
+/* Accessible, through the rules by LHS, from the nWorklisti accessible    */
+/* symbols in worklistip.                                                   */
+/****************************************************************************/
+{
+  earleyGrammarRuleOption_t *ruleOptionp;
+  int                        symboli;
+  int                        rhsSymboli;
+  int                        rulei;
+  int                        i;
+  int                        j;
+  int                        endi;
+
+  while (nWorklisti > 0) {
+    symboli = worklistip[--nWorklisti];
+    for (i = corep->symbolLhsRuleOffsetip[symboli]; i < corep->symbolLhsRuleOffsetip[symboli + 1]; i++) {
+      rulei = corep->lhsRuleip[i];
+      corep->rulePropertyBitSetip[rulei] |= EARLEY_RULE_IS_ACCESSIBLE;
+      j    = corep->ruleRhsOffsetip[rulei];
+      endi = j + corep->ruleRhsLengthip[rulei];
+      for (; j < endi; j++) {
+        rhsSymboli = corep->rhsSymbolip[j];
+        if ((corep->symbolPropertyBitSetip[rhsSymboli] & EARLEY_SYMBOL_IS_ACCESSIBLE) == 0) {
+          corep->symbolPropertyBitSetip[rhsSymboli] |= EARLEY_SYMBOL_IS_ACCESSIBLE;
+          worklistip[nWorklisti++] = rhsSymboli;
+        }
+      }
+      ruleOptionp = &(corep->ruleOptionp[rulei]);
+      if (ruleOptionp->sequenceb && (ruleOptionp->separatorSymboli >= 0)) {
+        rhsSymboli = ruleOptionp->separatorSymboli;
+        if ((corep->symbolPropertyBitSetip[rhsSymboli] & EARLEY_SYMBOL_IS_ACCESSIBLE) == 0) {
+          corep->symbolPropertyBitSetip[rhsSymboli] |= EARLEY_SYMBOL_IS_ACCESSIBLE;
+          worklistip[nWorklisti++] = rhsSymboli;
+        }
+      }
+    }
+  }
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_precompute_propertyb(earleyGrammar_t *earleyGrammarp, int starti)
+/****************************************************************************/
+/* Symbol and rule properties from scratch, by worklist propagation over   */
+/* the indexes:                                                             */
+/* - terminal:   terminalb option, or not the LHS of any rule              */
+/* - productive: derives a terminal string                                  */
+/* - nullable:   derives the empty string                                   */
+/* - nulling:    derives only the empty string                              */
+/* - accessible: reachable from the start symbol                            */
+/* A sequence rule counts as a rule with its single RHS symbol, that is    */
+/* nullable and productive when minimumi is 0.                              */
+/****************************************************************************/
+{
+  earleyGrammarCore_t         *corep        = earleyGrammarp->corep;
+  earleyAllocator_t           *allocatorp   = &(corep->allocator);
+  earleyGrammarSymbolOption_t *symbolOptionp;
+  earleyGrammarRuleOption_t   *ruleOptionp;
+  int                          nSymboli     = corep->nSymboli;
+  int                          nRulei       = corep->nRulei;
+  int                         *counterip    = NULL;
+  int                         *worklistip   = NULL;
+  char                        *nonEmptybp   = NULL;   /* Derives a non-empty terminal string */
+  int                         *separatorip  = NULL;   /* Sequence rules with a separator, by separator */
+  int                         *separatorOffsetip = NULL;
+  int                          nWorklisti;
+  int                          symboli;
+  int                          rulei;
+  short                        rcb;
+
+  /* Scratch memory never comes from the arena */
+  counterip         = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nRulei + 1) * sizeof(int));
+  worklistip        = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  nonEmptybp        = (char *) allocatorp->mallocp(allocatorp->userDatavp, (size_t) nSymboli + 1);
+  separatorOffsetip = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  separatorip       = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nRulei + 1) * sizeof(int));
+  if ((counterip == NULL) || (worklistip == NULL) || (nonEmptybp == NULL) || (separatorOffsetip == NULL) || (separatorip == NULL)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+
+  /* Terminals */
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    symbolOptionp = &(corep->symbolOptionp[symboli]);
+    corep->symbolPropertyBitSetip[symboli] = 0;
+    if (corep->symbolLhsRuleOffsetip[symboli + 1] > corep->symbolLhsRuleOffsetip[symboli]) {
+      if (symbolOptionp->terminalb) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Terminal symbol %d is the LHS of rule %d\n", symboli, corep->lhsRuleip[corep->symbolLhsRuleOffsetip[symboli]]);
+        errno = EINVAL;
+        goto err;
+      }
+    } else {
+      corep->symbolPropertyBitSetip[symboli] |= EARLEY_SYMBOL_IS_TERMINAL;
+    }
+  }
+  corep->symbolPropertyBitSetip[starti] |= EARLEY_SYMBOL_IS_START;
+  for (rulei = 0; rulei < nRulei; rulei++) {
+    corep->rulePropertyBitSetip[rulei] = 0;
+  }
+
+  /* Nullable */
+  for (rulei = 0; rulei < nRulei; rulei++) {
+    ruleOptionp = &(corep->ruleOptionp[rulei]);
+    counterip[rulei] = (ruleOptionp->sequenceb && (ruleOptionp->minimumi == 0)) ? 0 : corep->ruleRhsLengthip[rulei];
+  }
+  earleyGrammar_precompute_propagatev(corep, counterip, worklistip, 0, EARLEY_SYMBOL_IS_NULLABLE, EARLEY_RULE_IS_NULLABLE);
+
+  /* Productive: terminals are the seeds */
+  nWorklisti = 0;
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) != 0) {
+      corep->symbolPropertyBitSetip[symboli] |= EARLEY_SYMBOL_IS_PRODUCTIVE;
+      worklistip[nWorklisti++] = symboli;
+    }
+  }
+  for (rulei = 0; rulei < nRulei; rulei++) {
+    ruleOptionp = &(corep->ruleOptionp[rulei]);
+    counterip[rulei] = (ruleOptionp->sequenceb && (ruleOptionp->minimumi == 0)) ? 0 : corep->ruleRhsLengthip[rulei];
+  }
+  earleyGrammar_precompute_propagatev(corep, counterip, worklistip, nWorklisti, EARLEY_SYMBOL_IS_PRODUCTIVE, EARLEY_RULE_IS_PRODUCTIVE);
+
+  if ((corep->symbolPropertyBitSetip[starti] & EARLEY_SYMBOL_IS_PRODUCTIVE) == 0) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "Start symbol %d is not productive\n", starti);
+    errno = EINVAL;
+    goto err;
+  }
+
+  /* Non-empty, starting from the terminals */
+  earleyGrammar_precompute_separatorv(corep, separatorOffsetip, separatorip);
+  nWorklisti = 0;
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    nonEmptybp[symboli] = ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) != 0) ? 1 : 0;
+    if (nonEmptybp[symboli]) {
+      worklistip[nWorklisti++] = symboli;
+    }
+  }
+  earleyGrammar_precompute_nonEmptyv(corep, nonEmptybp, worklistip, nWorklisti, separatorOffsetip, separatorip, NULL);
+
+  /* Nulling */
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if (((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_NULLABLE) != 0) && (! nonEmptybp[symboli])) {
+      corep->symbolPropertyBitSetip[symboli] |= EARLEY_SYMBOL_IS_NULLING;
+    }
+  }
+  for (rulei = 0; rulei < nRulei; rulei++) {
+    if (((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_NULLABLE) != 0) && (! earleyGrammar_precompute_rule_nonEmptyb(corep, rulei, nonEmptybp))) {
+      corep->rulePropertyBitSetip[rulei] |= EARLEY_RULE_IS_NULLING;
+    }
+  }
+
+  /* Accessible, from the start symbol */
+  corep->symbolPropertyBitSetip[starti] |= EARLEY_SYMBOL_IS_ACCESSIBLE;
+  worklistip[0] = starti;
+  earleyGrammar_precompute_accessiblev(corep, worklistip, 1);
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  if (counterip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, counterip);
+  }
+  if (worklistip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, worklistip);
+  }
+  if (nonEmptybp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, nonEmptybp);
+  }
+  if (separatorOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, separatorOffsetip);
+  }
+  if (separatorip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, separatorip);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_incremental_ruleb(earleyGrammarCore_t *corep, int rulei, int symbolPropertyi)
+/****************************************************************************/
+/* Whether all RHS symbols of rulei have the property: the counter-free    */
+/* version of propagatev, for a few rules at a time.                        */
+/****************************************************************************/
+{
+  earleyGrammarRuleOption_t *ruleOptionp = &(corep->ruleOptionp[rulei]);
+  int                        i           = corep->ruleRhsOffsetip[rulei];
+  int                        endi        = i + corep->ruleRhsLengthip[rulei];
+
+  if (ruleOptionp->sequenceb && (ruleOptionp->minimumi == 0)) {
+    return 1;
+  }
+  for (; i < endi; i++) {
+    if ((corep->symbolPropertyBitSetip[corep->rhsSymbolip[i]] & symbolPropertyi) == 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_incremental_propagatev(earleyGrammarCore_t *corep, int *worklistip, int nWorklisti, int firstRulei, int symbolPropertyi, int rulePropertyi,
+                                                        int *ruleip, int *nRuleip, char *symbolFlagbp, char flagb)
+/****************************************************************************/
+/* propagatev from the rules firstRulei and above, and from the nWorklisti */
+/* symbols in worklistip, that just got the property: only the rules where */
+/* they appear are looked at again. Rules that get the property are added  */
+/* to ruleip, symbols are flagged with flagb.                               */
+/****************************************************************************/
+{
+  int symboli;
+  int lhsSymboli;
+  int rulei;
+  int i;
+
+  /* New rules */
+  for (rulei = firstRulei; rulei < corep->nRulei; rulei++) {
+    if (((corep->rulePropertyBitSetip[rulei] & rulePropertyi) == 0) && earleyGrammar_incremental_ruleb(corep, rulei, symbolPropertyi)) {
+      corep->rulePropertyBitSetip[rulei] |= rulePropertyi;
+      ruleip[(*nRuleip)++] = rulei;
+      lhsSymboli = corep->ruleLhsSymbolip[rulei];
+      if ((corep->symbolPropertyBitSetip[lhsSymboli] & symbolPropertyi) == 0) {
+        corep->symbolPropertyBitSetip[lhsSymboli] |= symbolPropertyi;
+        symbolFlagbp[lhsSymboli] |= flagb;
+        worklistip[nWorklisti++] = lhsSymboli;
+      }
+    }
+  }
+
+  while (nWorklisti > 0) {
+    symboli = worklistip[--nWorklisti];
+    for (i = corep->symbolRhsRuleOffsetip[symboli]; i < corep->symbolRhsRuleOffsetip[symboli + 1]; i++) {
+      rulei = corep->rhsRuleip[i];
+      if (((corep->rulePropertyBitSetip[rulei] & rulePropertyi) != 0) || (! earleyGrammar_incremental_ruleb(corep, rulei, symbolPropertyi))) {
+        continue;
+      }
+      corep->rulePropertyBitSetip[rulei] |= rulePropertyi;
+      ruleip[(*nRuleip)++] = rulei;
+      lhsSymboli = corep->ruleLhsSymbolip[rulei];
+      if ((corep->symbolPropertyBitSetip[lhsSymboli] & symbolPropertyi) == 0) {
+        corep->symbolPropertyBitSetip[lhsSymboli] |= symbolPropertyi;
+        symbolFlagbp[lhsSymboli] |= flagb;
+        worklistip[nWorklisti++] = lhsSymboli;
+      }
+    }
+  }
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_precompute_incrementalb(earleyGrammar_t *earleyGrammarp, int starti, short *incrementalbp)
+/****************************************************************************/
+/* When symbols and rules were only added since the last precompute, with  */
+/* the same start symbol, properties can only be gained: they are          */
+/* propagated from the new rules and the new terminals, and the prediction */
+/* tables are updated with what changed. An old terminal that is now a LHS */
+/* changes too much: *incrementalbp is then 0, and nothing was done.       */
+/****************************************************************************/
+{
+  earleyGrammarCore_t       *corep            = earleyGrammarp->corep;
+  earleyAllocator_t         *allocatorp       = &(corep->allocator);
+  int                        nSymboli         = corep->nSymboli;
+  int                        nRulei           = corep->nRulei;
+  int                        firstSymboli     = corep->nPrecomputedSymboli;   /* First new symbol */
+  int                        firstRulei       = corep->nPrecomputedRulei;     /* First new rule   */
+  int                       *worklistip       = NULL;
+  int                       *nullableRuleip   = NULL;   /* Rules that became nullable   */
+  int                       *productiveRuleip = NULL;   /* Rules that became productive */
+  int                       *ruleip           = NULL;   /* Rules to look at again       */
+  int                       *separatorip      = NULL;
+  int                       *separatorOffsetip = NULL;
+  char                      *nonEmptybp       = NULL;
+  char                      *symbolFlagbp     = NULL;
+  char                      *ruleFlagbp       = NULL;
+  int                        nWorklisti;
+  int                        nNullableRulei;
+  int                        nProductiveRulei;
+  int                        nRuleListi;
+  int                        symboli;
+  int                        lhsSymboli;
+  int                        rulei;
+  int                        i;
+  int                        k;
+  short                      rcb;
+
+  /* Whatever happens next, the tables are only valid again after success */
+  *incrementalbp             = 0;
+  corep->nPrecomputedSymboli = -1;
+  corep->nPrecomputedRulei   = -1;
+
+  if ((firstSymboli < 0) || (firstRulei < 0) || (corep->startSymboli != starti) || (firstSymboli > nSymboli) || (firstRulei > nRulei)) {
+    rcb = 1;
+    goto done;
+  }
+  for (rulei = firstRulei; rulei < nRulei; rulei++) {
+    lhsSymboli = corep->ruleLhsSymbolip[rulei];
+    /* A terminalb LHS is reported by the full precompute */
+    if (corep->symbolOptionp[lhsSymboli].terminalb ||
+        ((lhsSymboli < firstSymboli) && ((corep->symbolPropertyBitSetip[lhsSymboli] & EARLEY_SYMBOL_IS_TERMINAL) != 0))) {
+      rcb = 1;
+      goto done;
+    }
+  }
+
+  /* Scratch memory never comes from the arena */
+  worklistip        = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  nullableRuleip    = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nRulei + 1) * sizeof(int));
+  productiveRuleip  = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nRulei + 1) * sizeof(int));
+  ruleip            = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nRulei + 1) * sizeof(int));
+  separatorOffsetip = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  separatorip       = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nRulei + 1) * sizeof(int));
+  nonEmptybp        = (char *) allocatorp->mallocp(allocatorp->userDatavp, (size_t) nSymboli + 1);
+  symbolFlagbp      = (char *) allocatorp->mallocp(allocatorp->userDatavp, (size_t) nSymboli + 1);
+  ruleFlagbp        = (char *) allocatorp->mallocp(allocatorp->userDatavp, (size_t) nRulei + 1);
+  if ((worklistip == NULL) || (nullableRuleip == NULL) || (productiveRuleip == NULL) || (ruleip == NULL) || (separatorOffsetip == NULL) || (separatorip == NULL) ||
+      (nonEmptybp == NULL) || (symbolFlagbp == NULL) || (ruleFlagbp == NULL)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  memset(symbolFlagbp, 0, (size_t) nSymboli + 1);
+  memset(ruleFlagbp,   0, (size_t) nRulei + 1);
+
+  /* New symbols are terminals when they are not a LHS. Non-empty is       */
+  /* productive and not nulling, as long as the new symbols are not done.  */
+  nWorklisti = 0;
+  for (symboli = firstSymboli; symboli < nSymboli; symboli++) {
+    corep->symbolPropertyBitSetip[symboli] = 0;
+    if (corep->symbolLhsRuleOffsetip[symboli + 1] == corep->symbolLhsRuleOffsetip[symboli]) {
+      corep->symbolPropertyBitSetip[symboli] = EARLEY_SYMBOL_IS_TERMINAL | EARLEY_SYMBOL_IS_PRODUCTIVE;
+      symbolFlagbp[symboli] |= EARLEYGRAMMAR_INCREMENTAL_PRODUCTIVE;
+      worklistip[nWorklisti++] = symboli;
+    }
+  }
+  for (rulei = firstRulei; rulei < nRulei; rulei++) {
+    corep->rulePropertyBitSetip[rulei] = 0;
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    nonEmptybp[symboli] = ((corep->symbolPropertyBitSetip[symboli] & (EARLEY_SYMBOL_IS_PRODUCTIVE | EARLEY_SYMBOL_IS_NULLING)) == EARLEY_SYMBOL_IS_PRODUCTIVE) ? 1 : 0;
+  }
+
+  /* Productive and nullable */
+  nProductiveRulei = 0;
+  earleyGrammar_incremental_propagatev(corep, worklistip, nWorklisti, firstRulei, EARLEY_SYMBOL_IS_PRODUCTIVE, EARLEY_RULE_IS_PRODUCTIVE,
+                                       productiveRuleip, &nProductiveRulei, symbolFlagbp, EARLEYGRAMMAR_INCREMENTAL_PRODUCTIVE);
+  nNullableRulei = 0;
+  earleyGrammar_incremental_propagatev(corep, worklistip, 0, firstRulei, EARLEY_SYMBOL_IS_NULLABLE, EARLEY_RULE_IS_NULLABLE,
+                                       nullableRuleip, &nNullableRulei, symbolFlagbp, EARLEYGRAMMAR_INCREMENTAL_NULLABLE);
+
+  /* Non-empty, from the rules that became productive, and from the        */
+  /* sequences whose item became productive.                               */
+  earleyGrammar_precompute_separatorv(corep, separatorOffsetip, separatorip);
+  nWorklisti = 0;
+  for (k = 0; k < nProductiveRulei; k++) {
+    rulei      = productiveRuleip[k];
+    lhsSymboli = corep->ruleLhsSymbolip[rulei];
+    if ((! nonEmptybp[lhsSymboli]) && earleyGrammar_precompute_rule_nonEmptyb(corep, rulei, nonEmptybp)) {
+      nonEmptybp[lhsSymboli]    = 1;
+      symbolFlagbp[lhsSymboli] |= EARLEYGRAMMAR_INCREMENTAL_NONEMPTY;
+      worklistip[nWorklisti++]  = lhsSymboli;
+    }
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((symbolFlagbp[symboli] & EARLEYGRAMMAR_INCREMENTAL_PRODUCTIVE) == 0) {
+      continue;
+    }
+    for (i = corep->symbolRhsRuleOffsetip[symboli]; i < corep->symbolRhsRuleOffsetip[symboli + 1]; i++) {
+      rulei      = corep->rhsRuleip[i];
+      lhsSymboli = corep->ruleLhsSymbolip[rulei];
+      if ((! nonEmptybp[lhsSymboli]) && corep->ruleOptionp[rulei].sequenceb && earleyGrammar_precompute_rule_nonEmptyb(corep, rulei, nonEmptybp)) {
+        nonEmptybp[lhsSymboli]    = 1;
+        symbolFlagbp[lhsSymboli] |= EARLEYGRAMMAR_INCREMENTAL_NONEMPTY;
+        worklistip[nWorklisti++]  = lhsSymboli;
+      }
+    }
+  }
+  earleyGrammar_precompute_nonEmptyv(corep, nonEmptybp, worklistip, nWorklisti, separatorOffsetip, separatorip, symbolFlagbp);
+
+  /* Nulling symbols, and the rules that may have changed: new, nullable   */
+  /* or with a RHS symbol or separator that changed.                       */
+  nRuleListi = 0;
+  for (rulei = firstRulei; rulei < nRulei; rulei++) {
+    ruleFlagbp[rulei]      |= EARLEYGRAMMAR_INCREMENTAL_NULLING;
+    ruleip[nRuleListi++]    = rulei;
+  }
+  for (k = 0; k < nNullableRulei; k++) {
+    rulei = nullableRuleip[k];
+    if ((ruleFlagbp[rulei] & EARLEYGRAMMAR_INCREMENTAL_NULLING) == 0) {
+      ruleFlagbp[rulei]   |= EARLEYGRAMMAR_INCREMENTAL_NULLING;
+      ruleip[nRuleListi++] = rulei;
+    }
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((symbolFlagbp[symboli] & EARLEYGRAMMAR_INCREMENTAL_NONEMPTY) != 0) {
+      corep->symbolPropertyBitSetip[symboli] &= ~EARLEY_SYMBOL_IS_NULLING;
+    } else if (((symbolFlagbp[symboli] & EARLEYGRAMMAR_INCREMENTAL_NULLABLE) != 0) && (! nonEmptybp[symboli])) {
+      corep->symbolPropertyBitSetip[symboli] |= EARLEY_SYMBOL_IS_NULLING;
+    }
+    if ((symbolFlagbp[symboli] & (EARLEYGRAMMAR_INCREMENTAL_NONEMPTY | EARLEYGRAMMAR_INCREMENTAL_PRODUCTIVE)) == 0) {
+      continue;
+    }
+    for (i = corep->symbolRhsRuleOffsetip[symboli]; i < corep->symbolRhsRuleOffsetip[symboli + 1]; i++) {
+      rulei = corep->rhsRuleip[i];
+      if ((ruleFlagbp[rulei] & EARLEYGRAMMAR_INCREMENTAL_NULLING) == 0) {
+        ruleFlagbp[rulei]   |= EARLEYGRAMMAR_INCREMENTAL_NULLING;
+        ruleip[nRuleListi++] = rulei;
+      }
+    }
+    for (i = separatorOffsetip[symboli]; i < separatorOffsetip[symboli + 1]; i++) {
+      rulei = separatorip[i];
+      if ((ruleFlagbp[rulei] & EARLEYGRAMMAR_INCREMENTAL_NULLING) == 0) {
+        ruleFlagbp[rulei]   |= EARLEYGRAMMAR_INCREMENTAL_NULLING;
+        ruleip[nRuleListi++] = rulei;
+      }
+    }
+  }
+  for (k = 0; k < nRuleListi; k++) {
+    rulei = ruleip[k];
+    corep->rulePropertyBitSetip[rulei] &= ~EARLEY_RULE_IS_NULLING;
+    if (((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_NULLABLE) != 0) && (! earleyGrammar_precompute_rule_nonEmptyb(corep, rulei, nonEmptybp))) {
+      corep->rulePropertyBitSetip[rulei] |= EARLEY_RULE_IS_NULLING;
+    }
+  }
+
+  /* Accessible, from the accessible LHS of the new rules */
+  nWorklisti = 0;
+  for (rulei = firstRulei; rulei < nRulei; rulei++) {
+    lhsSymboli = corep->ruleLhsSymbolip[rulei];
+    if (((corep->symbolPropertyBitSetip[lhsSymboli] & EARLEY_SYMBOL_IS_ACCESSIBLE) != 0) && ((symbolFlagbp[lhsSymboli] & EARLEYGRAMMAR_INCREMENTAL_ACCESSIBLE) == 0)) {
+      symbolFlagbp[lhsSymboli] |= EARLEYGRAMMAR_INCREMENTAL_ACCESSIBLE;
+      worklistip[nWorklisti++]  = lhsSymboli;
+    }
+  }
+  earleyGrammar_precompute_accessiblev(corep, worklistip, nWorklisti);
+
+  /* Prediction edges that may be new: the ones of the rules that became   */
+  /* productive, and the ones after an RHS symbol that became nullable.    */
+  nRuleListi = 0;
+  for (k = 0; k < nProductiveRulei; k++) {
+    rulei                = productiveRuleip[k];
+    ruleFlagbp[rulei]   |= EARLEYGRAMMAR_INCREMENTAL_EDGE;
+    ruleip[nRuleListi++] = rulei;
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((symbolFlagbp[symboli] & EARLEYGRAMMAR_INCREMENTAL_NULLABLE) == 0) {
+      continue;
+    }
+    for (i = corep->symbolRhsRuleOffsetip[symboli]; i < corep->symbolRhsRuleOffsetip[symboli + 1]; i++) {
+      rulei = corep->rhsRuleip[i];
+      if (((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) != 0) && ((ruleFlagbp[rulei] & EARLEYGRAMMAR_INCREMENTAL_EDGE) == 0)) {
+        ruleFlagbp[rulei]   |= EARLEYGRAMMAR_INCREMENTAL_EDGE;
+        ruleip[nRuleListi++] = rulei;
+      }
+    }
+  }
+  if (! earleyGrammar_incremental_predictionb(earleyGrammarp, firstSymboli, firstRulei, productiveRuleip, nProductiveRulei, ruleip, nRuleListi)) {
+    goto err;
+  }
+
+  *incrementalbp = 1;
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  if (worklistip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, worklistip);
+  }
+  if (nullableRuleip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, nullableRuleip);
+  }
+  if (productiveRuleip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, productiveRuleip);
+  }
+  if (ruleip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, ruleip);
+  }
+  if (separatorOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, separatorOffsetip);
+  }
+  if (separatorip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, separatorip);
+  }
+  if (nonEmptybp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, nonEmptybp);
+  }
+  if (symbolFlagbp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, symbolFlagbp);
+  }
+  if (ruleFlagbp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, ruleFlagbp);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_incremental_predictionb(earleyGrammar_t *earleyGrammarp, int firstSymboli, int firstRulei, int *productiveRuleip, int nProductiveRulei, int *edgeRuleip, int nEdgeRulei)
+/****************************************************************************/
+/* The prediction row of x stays the productive rules of the closure of x: */
+/* - new symbols get their own rows, and rows are widened when needed,     */
+/* - a new productive rule goes to the rows whose closure has its LHS,     */
+/* - for a new edge A -> B, every row having A is OR-ed with the row of B, */
+/*   which keeps the closure transitive. There is nothing to do when B is  */
+/*   already in the closure of A.                                           */
+/* Every update is one pass over the rows, instead of a new closure.       */
+/****************************************************************************/
+{
+  earleyGrammarCore_t       *corep             = earleyGrammarp->corep;
+  earleyAllocator_t         *allocatorp        = &(corep->allocator);
+  earleyGrammarRuleOption_t *ruleOptionp;
+  int                        nSymboli          = corep->nSymboli;
+  int                        nRulei            = corep->nRulei;
+  size_t                     symbolWordl       = EARLEYGRAMMAR_BITSET_WORDL(nSymboli);
+  size_t                     ruleWordl         = EARLEYGRAMMAR_BITSET_WORDL(nRulei);
+  size_t                     oldSymbolWordl    = EARLEYGRAMMAR_BITSET_WORDL(firstSymboli);
+  size_t                     oldRuleWordl      = EARLEYGRAMMAR_BITSET_WORDL(firstRulei);
+  int                        nOldClosureRowi    = corep->nClosureRowi;
+  int                        nOldPredictionRowi = corep->nPredictionRowi;
+  int                       *symbolClosureRowip    = NULL;
+  int                       *symbolPredictionRowip = NULL;
+  earleyGrammarBitWord_t    *closurep          = NULL;
+  earleyGrammarBitWord_t    *predictionp       = NULL;
+  int                       *predictionClosureRowip = NULL;   /* The closure row of every prediction row */
+  earleyGrammarBitWord_t    *rowp;
+  earleyGrammarBitWord_t     bitl;
+  size_t                     wordl;
+  int                        nClosureRowi;
+  int                        nPredictionRowi;
+  int                        closureRowi;
+  int                        predictionRowi;
+  int                        rowi;
+  int                        symboli;
+  int                        lhsSymboli;
+  int                        rhsSymboli;
+  int                        rulei;
+  int                        i;
+  int                        k;
+  int                        endi;
+  short                      rcb;
+
+  /* Rows for the new symbols, wider rows when needed. The empty row of   */
+  /* the terminals stays the last one.                                     */
+  if ((firstSymboli < nSymboli) || (symbolWordl != oldSymbolWordl) || (ruleWordl != oldRuleWordl)) {
+    nClosureRowi    = nOldClosureRowi + (nSymboli - firstSymboli);
+    nPredictionRowi = nOldPredictionRowi;
+    for (symboli = firstSymboli; symboli < nSymboli; symboli++) {
+      if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) == 0) {
+        nPredictionRowi++;
+      }
+    }
+    if (((nClosureRowi > 0) && (symbolWordl > SIZE_MAX / sizeof(earleyGrammarBitWord_t) / (size_t) nClosureRowi)) ||
+        ((ruleWordl > 0) && (ruleWordl > SIZE_MAX / sizeof(earleyGrammarBitWord_t) / (size_t) nPredictionRowi))) {
+      EARLEYGRAMMAR_ERROR(earleyGrammarp, "Prediction closure is too large\n");
+      errno = EINVAL;
+      goto err;
+    }
+    if ((symbolWordl == oldSymbolWordl) && (ruleWordl == oldRuleWordl)) {
+      /* Same widths: rows are appended in place */
+      symbolClosureRowip = (int *) earleyAllocator_reallocp(allocatorp, corep->symbolClosureRowip, ((size_t) firstSymboli + 1) * sizeof(int), ((size_t) nSymboli + 1) * sizeof(int));
+      if (symbolClosureRowip == NULL) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno));
+        goto err;
+      }
+      corep->symbolClosureRowip = symbolClosureRowip;
+      symbolClosureRowip        = NULL;
+      symbolPredictionRowip = (int *) earleyAllocator_reallocp(allocatorp, corep->symbolPredictionRowip, ((size_t) firstSymboli + 1) * sizeof(int), ((size_t) nSymboli + 1) * sizeof(int));
+      if (symbolPredictionRowip == NULL) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno));
+        goto err;
+      }
+      corep->symbolPredictionRowip = symbolPredictionRowip;
+      symbolPredictionRowip        = NULL;
+      closurep = (earleyGrammarBitWord_t *) earleyAllocator_reallocp(allocatorp, corep->closurep,
+                                                                      ((size_t) nOldClosureRowi * symbolWordl + 1) * sizeof(earleyGrammarBitWord_t),
+                                                                      ((size_t) nClosureRowi * symbolWordl + 1) * sizeof(earleyGrammarBitWord_t));
+      if (closurep == NULL) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno));
+        goto err;
+      }
+      corep->closurep = closurep;
+      closurep        = NULL;
+      predictionp = (earleyGrammarBitWord_t *) earleyAllocator_reallocp(allocatorp, corep->predictionp,
+                                                                         ((size_t) nOldPredictionRowi * ruleWordl + 1) * sizeof(earleyGrammarBitWord_t),
+                                                                         ((size_t) nPredictionRowi * ruleWordl + 1) * sizeof(earleyGrammarBitWord_t));
+      if (predictionp == NULL) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno));
+        goto err;
+      }
+      corep->predictionp = predictionp;
+      predictionp        = NULL;
+      /* The old empty row becomes the first new one */
+      memset(corep->closurep + (size_t) nOldClosureRowi * symbolWordl, 0, (size_t) (nClosureRowi - nOldClosureRowi) * symbolWordl * sizeof(earleyGrammarBitWord_t));
+      memset(corep->predictionp + (size_t) (nOldPredictionRowi - 1) * ruleWordl, 0, (size_t) (nPredictionRowi - nOldPredictionRowi + 1) * ruleWordl * sizeof(earleyGrammarBitWord_t));
+      for (symboli = 0; symboli < firstSymboli; symboli++) {
+        if (corep->symbolPredictionRowip[symboli] == nOldPredictionRowi - 1) {
+          corep->symbolPredictionRowip[symboli] = nPredictionRowi - 1;
+        }
+      }
+    } else {
+      /* Wider rows: new layout */
+      symbolClosureRowip    = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) nSymboli + 1) * sizeof(int));
+      symbolPredictionRowip = (int *) earleyAllocator_mallocp(allocatorp, ((size_t) nSymboli + 1) * sizeof(int));
+      closurep              = (earleyGrammarBitWord_t *) earleyAllocator_mallocp(allocatorp, ((size_t) nClosureRowi * symbolWordl + 1) * sizeof(earleyGrammarBitWord_t));
+      predictionp           = (earleyGrammarBitWord_t *) earleyAllocator_mallocp(allocatorp, ((size_t) nPredictionRowi * ruleWordl + 1) * sizeof(earleyGrammarBitWord_t));
+      if ((symbolClosureRowip == NULL) || (symbolPredictionRowip == NULL) || (closurep == NULL) || (predictionp == NULL)) {
+        EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+        goto err;
+      }
+      memset(closurep,    0, (size_t) nClosureRowi * symbolWordl * sizeof(earleyGrammarBitWord_t));
+      memset(predictionp, 0, (size_t) nPredictionRowi * ruleWordl * sizeof(earleyGrammarBitWord_t));
+      for (rowi = 0; rowi < nOldClosureRowi; rowi++) {
+        memcpy(closurep + (size_t) rowi * symbolWordl, corep->closurep + (size_t) rowi * oldSymbolWordl, oldSymbolWordl * sizeof(earleyGrammarBitWord_t));
+      }
+      for (rowi = 0; rowi < nOldPredictionRowi - 1; rowi++) {
+        memcpy(predictionp + (size_t) rowi * ruleWordl, corep->predictionp + (size_t) rowi * oldRuleWordl, oldRuleWordl * sizeof(earleyGrammarBitWord_t));
+      }
+      for (symboli = 0; symboli < firstSymboli; symboli++) {
+        symbolClosureRowip[symboli]    = corep->symbolClosureRowip[symboli];
+        symbolPredictionRowip[symboli] = (corep->symbolPredictionRowip[symboli] == nOldPredictionRowi - 1) ? nPredictionRowi - 1 : corep->symbolPredictionRowip[symboli];
+      }
+      EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->symbolClosureRowip);
+      EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->closurep);
+      EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->symbolPredictionRowip);
+      EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->predictionp);
+      corep->symbolClosureRowip    = symbolClosureRowip;
+      corep->closurep              = closurep;
+      corep->symbolPredictionRowip = symbolPredictionRowip;
+      corep->predictionp           = predictionp;
+      symbolClosureRowip    = NULL;
+      symbolPredictionRowip = NULL;
+      closurep              = NULL;
+      predictionp           = NULL;
+    }
+    closureRowi    = nOldClosureRowi;
+    predictionRowi = nOldPredictionRowi - 1;
+    for (symboli = firstSymboli; symboli < nSymboli; symboli++) {
+      corep->symbolClosureRowip[symboli] = closureRowi;
+      corep->closurep[(size_t) closureRowi * symbolWordl + (size_t) (symboli / EARLEYGRAMMAR_BITWORD_BITS)] |= ((earleyGrammarBitWord_t) 1) << (symboli % EARLEYGRAMMAR_BITWORD_BITS);
+      closureRowi++;
+      corep->symbolPredictionRowip[symboli] = ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) == 0) ? predictionRowi++ : nPredictionRowi - 1;
+    }
+    corep->nClosureRowi    = nClosureRowi;
+    corep->nPredictionRowi = nPredictionRowi;
+  }
+  nClosureRowi    = corep->nClosureRowi;
+  nPredictionRowi = corep->nPredictionRowi;
+
+  predictionClosureRowip = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nPredictionRowi + 1) * sizeof(int));
+  if (predictionClosureRowip == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    predictionClosureRowip[corep->symbolPredictionRowip[symboli]] = corep->symbolClosureRowip[symboli];
+  }
+
+  /* New productive rules */
+  for (k = 0; k < nProductiveRulei; k++) {
+    rulei      = productiveRuleip[k];
+    lhsSymboli = corep->ruleLhsSymbolip[rulei];
+    wordl      = (size_t) (lhsSymboli / EARLEYGRAMMAR_BITWORD_BITS);
+    bitl       = ((earleyGrammarBitWord_t) 1) << (lhsSymboli % EARLEYGRAMMAR_BITWORD_BITS);
+    for (rowi = 0; rowi < nPredictionRowi - 1; rowi++) {
+      if ((corep->closurep[(size_t) predictionClosureRowip[rowi] * symbolWordl + wordl] & bitl) != 0) {
+        corep->predictionp[(size_t) rowi * ruleWordl + (size_t) (rulei / EARLEYGRAMMAR_BITWORD_BITS)] |= ((earleyGrammarBitWord_t) 1) << (rulei % EARLEYGRAMMAR_BITWORD_BITS);
+      }
+    }
+  }
+
+  /* New edges, enumerated as in predictionb */
+  for (k = 0; k < nEdgeRulei; k++) {
+    rulei       = edgeRuleip[k];
+    lhsSymboli  = corep->ruleLhsSymbolip[rulei];
+    ruleOptionp = &(corep->ruleOptionp[rulei]);
+    wordl       = (size_t) (lhsSymboli / EARLEYGRAMMAR_BITWORD_BITS);
+    bitl        = ((earleyGrammarBitWord_t) 1) << (lhsSymboli % EARLEYGRAMMAR_BITWORD_BITS);
+    i           = corep->ruleRhsOffsetip[rulei];
+    endi        = i + corep->ruleRhsLengthip[rulei];
+    for (; i <= endi; i++) {
+      if (i < endi) {
+        rhsSymboli = corep->rhsSymbolip[i];
+      } else if (ruleOptionp->sequenceb && (ruleOptionp->separatorSymboli >= 0)) {
+        rhsSymboli = ruleOptionp->separatorSymboli;
+      } else {
+        break;
+      }
+      rowp = corep->closurep + (size_t) corep->symbolClosureRowip[lhsSymboli] * symbolWordl;
+      if ((rowp[rhsSymboli / EARLEYGRAMMAR_BITWORD_BITS] & (((earleyGrammarBitWord_t) 1) << (rhsSymboli % EARLEYGRAMMAR_BITWORD_BITS))) == 0) {
+        /* Rows having A do not change, because only them are OR-ed */
+        closureRowi    = corep->symbolClosureRowip[rhsSymboli];
+        predictionRowi = corep->symbolPredictionRowip[rhsSymboli];
+        if (predictionRowi != nPredictionRowi - 1) {
+          for (rowi = 0; rowi < nPredictionRowi - 1; rowi++) {
+            if ((rowi != predictionRowi) && ((corep->closurep[(size_t) predictionClosureRowip[rowi] * symbolWordl + wordl] & bitl) != 0)) {
+              earleyGrammar_bitset_orv(corep->predictionp + (size_t) rowi * ruleWordl, corep->predictionp + (size_t) predictionRowi * ruleWordl, ruleWordl);
+            }
+          }
+        }
+        for (rowi = 0; rowi < nClosureRowi; rowi++) {
+          if ((rowi != closureRowi) && ((corep->closurep[(size_t) rowi * symbolWordl + wordl] & bitl) != 0)) {
+            earleyGrammar_bitset_orv(corep->closurep + (size_t) rowi * symbolWordl, corep->closurep + (size_t) closureRowi * symbolWordl, symbolWordl);
+          }
+        }
+      }
+      if ((corep->symbolPropertyBitSetip[rhsSymboli] & EARLEY_SYMBOL_IS_NULLABLE) == 0) {
+        break;
+      }
+    }
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, symbolClosureRowip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, symbolPredictionRowip);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, closurep);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, predictionp);
+  if (predictionClosureRowip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, predictionClosureRowip);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static inline void earleyGrammar_lookahead_widenv(earleyGrammarBitWord_t *dstp, size_t wordl, const earleyGrammarBitWord_t *srcp, size_t oldWordl, int oldEndi, int endi)
+/****************************************************************************/
+/* A lookahead row of oldWordl words, whose end of input is bit oldEndi,   */
+/* as a row of wordl words whose end of input is bit endi. dstp and srcp   */
+/* are the same when the width does not change.                            */
+/****************************************************************************/
+{
+  earleyGrammarBitWord_t oldBitl = ((earleyGrammarBitWord_t) 1) << (oldEndi % EARLEYGRAMMAR_BITWORD_BITS);
+
+  if (dstp != srcp) {
+    memcpy(dstp, srcp, oldWordl * sizeof(earleyGrammarBitWord_t));
+  }
+  if (wordl > oldWordl) {
+    memset(dstp + oldWordl, 0, (wordl - oldWordl) * sizeof(earleyGrammarBitWord_t));
+  }
+  if ((oldEndi != endi) && ((dstp[oldEndi / EARLEYGRAMMAR_BITWORD_BITS] & oldBitl) != 0)) {
+    dstp[oldEndi / EARLEYGRAMMAR_BITWORD_BITS] &= ~oldBitl;
+    dstp[endi / EARLEYGRAMMAR_BITWORD_BITS]    |= ((earleyGrammarBitWord_t) 1) << (endi % EARLEYGRAMMAR_BITWORD_BITS);
+  }
+}
+
+/****************************************************************************/
+static inline earleyGrammarBitWord_t *earleyGrammar_follow_rowp(earleyGrammarFollowUpdate_t *updatep, int symboli)
+/****************************************************************************/
+/* FOLLOW(symboli), loaded from lookaheadp the first time. Rows move when  */
+/* a new one is loaded.                                                     */
+/****************************************************************************/
+{
+  earleyGrammarCore_t *corep = updatep->corep;
+  size_t               wordl = updatep->wordl;
+  int                  rowi  = updatep->symbolRowip[symboli];
+
+  if (rowi < 0) {
+    if (! earleyGrammar_scratch_reserveb(&(corep->allocator), (void **) &(updatep->rowp), &(updatep->rowl), ((size_t) updatep->nRowi + 1) * wordl, sizeof(earleyGrammarBitWord_t))) {
+      return NULL;
+    }
+    rowi = updatep->symbolRowip[symboli] = updatep->nRowi++;
+    if ((symboli < updatep->firstSymboli) && (corep->symbolFollowRowip[symboli] >= 0)) {
+      memcpy(updatep->rowp + (size_t) rowi * wordl, corep->lookaheadp + (size_t) corep->symbolFollowRowip[symboli] * wordl, wordl * sizeof(earleyGrammarBitWord_t));
+    } else {
+      memset(updatep->rowp + (size_t) rowi * wordl, 0, wordl * sizeof(earleyGrammarBitWord_t));
+    }
+  }
+
+  return updatep->rowp + (size_t) rowi * wordl;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_follow_orb(earleyGrammarFollowUpdate_t *updatep, int symboli, const earleyGrammarBitWord_t *srcp, int srcSymboli)
+/****************************************************************************/
+/* FOLLOW(symboli) |= srcp, or FOLLOW(srcSymboli) when srcp is NULL, for a */
+/* nonterminal: terminals are never a LHS, so that their FOLLOW is never   */
+/* used. A FOLLOW that grows is queued once.                               */
+/****************************************************************************/
+{
+  earleyGrammarCore_t    *corep    = updatep->corep;
+  earleyGrammarBitWord_t  changedl = 0;
+  earleyGrammarBitWord_t *dstp;
+  size_t                  l;
+
+  if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) != 0) {
+    return 1;
+  }
+  if (((dstp = earleyGrammar_follow_rowp(updatep, symboli)) == NULL) || ((srcp == NULL) && ((srcp = earleyGrammar_follow_rowp(updatep, srcSymboli)) == NULL))) {
+    return 0;
+  }
+  /* Loading the source may have moved the destination */
+  dstp = updatep->rowp + (size_t) updatep->symbolRowip[symboli] * updatep->wordl;
+  for (l = 0; l < updatep->wordl; l++) {
+    changedl |= srcp[l] & ~dstp[l];
+    dstp[l]  |= srcp[l];
+  }
+  if (changedl != 0) {
+    updatep->symbolFlagbp[symboli] |= EARLEYGRAMMAR_INCREMENTAL_FOLLOW;
+    if ((updatep->symbolFlagbp[symboli] & EARLEYGRAMMAR_INCREMENTAL_QUEUED) == 0) {
+      updatep->symbolFlagbp[symboli]             |= EARLEYGRAMMAR_INCREMENTAL_QUEUED;
+      updatep->worklistip[updatep->nWorklisti++]  = symboli;
+    }
+  }
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_follow_edgeb(earleyGrammarFollowUpdate_t *updatep, int rulei)
+/****************************************************************************/
+/* FOLLOW inclusions of a productive rule, enumerated as in lookaheadb     */
+/****************************************************************************/
+{
+  earleyGrammarCore_t       *corep       = updatep->corep;
+  earleyGrammarRuleOption_t *ruleOptionp = &(corep->ruleOptionp[rulei]);
+  int                        lhsSymboli  = corep->ruleLhsSymbolip[rulei];
+  int                        firsti      = corep->ruleRhsOffsetip[rulei];
+  int                        rhsSymboli;
+  int                        i;
+
+#define EARLEYGRAMMAR_NULLABLEB(symboli) ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_NULLABLE) != 0)
+  for (i = firsti + corep->ruleRhsLengthip[rulei] - 1; i >= firsti - 1; i--) {
+    if (i >= firsti) {
+      rhsSymboli = corep->rhsSymbolip[i];
+    } else if (ruleOptionp->sequenceb && (ruleOptionp->separatorSymboli >= 0) && ((! ruleOptionp->properb) || EARLEYGRAMMAR_NULLABLEB(corep->rhsSymbolip[firsti]))) {
+      rhsSymboli = ruleOptionp->separatorSymboli;
+    } else {
+      break;
+    }
+    if ((rhsSymboli != lhsSymboli) && (! earleyGrammar_follow_orb(updatep, rhsSymboli, NULL, lhsSymboli))) {
+      return 0;
+    }
+    if ((i >= firsti) && (! ruleOptionp->sequenceb) && (! EARLEYGRAMMAR_NULLABLEB(rhsSymboli))) {
+      break;
+    }
+  }
+#undef EARLEYGRAMMAR_NULLABLEB
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyGrammar_incremental_lookaheadb(earleyGrammar_t *earleyGrammarp, int firstSymboli, int firstRulei, int *oldSymbolPropertyip, int *oldRulePropertyip, short *donebp)
+/****************************************************************************/
+/* After incrementalb, FIRST, nullability and productivity can only grow,  */
+/* and so does FOLLOW:                                                     */
+/* - FIRST is taken again from the closure, in place, and the old symbols  */
+/*   whose FIRST or nullability changed are flagged,                       */
+/* - FOLLOW starts from the rows kept by the last precompute. It gets the  */
+/*   own part and the inclusions of the new rules, of the rules that       */
+/*   became productive and of the rules using a flagged symbol, then what  */
+/*   grew goes through the inclusions with a worklist,                     */
+/* - only the dotted rules of these rules, and of the rules whose LHS has  */
+/*   a larger FOLLOW, are computed again.                                  */
+/* Rows are only moved when they need one more word, i.e. once every 64    */
+/* new symbols; otherwise the cost is a pass on FIRST, plus what changed.  */
+/* New rows are appended, and unused ones stay until a full build: that is */
+/* when *donebp is 0, and then nothing was done.                           */
+/****************************************************************************/
+{
+  earleyGrammarCore_t         *corep          = earleyGrammarp->corep;
+  earleyAllocator_t           *allocatorp     = &(corep->allocator);
+  earleyGrammarRuleOption_t   *ruleOptionp;
+  earleyGrammarRowSet_t        rowSet;
+  earleyGrammarFollowUpdate_t  update;
+  int                          nSymboli       = corep->nSymboli;
+  int                          nRulei         = corep->nRulei;
+  int                          nDottedi       = corep->nRhsi + nRulei;
+  int                          nOldDottedi    = ((firstRulei < nRulei) ? corep->ruleRhsOffsetip[firstRulei] : corep->nRhsi) + firstRulei;
+  int                          nOldClosureRowi = corep->nClosureRowi - (nSymboli - firstSymboli);
+  int                          nOldRowi       = corep->nLookaheadRowi;
+  size_t                       closureWordl   = EARLEYGRAMMAR_BITSET_WORDL(nSymboli);
+  size_t                       wordl          = EARLEYGRAMMAR_BITSET_WORDL((size_t) nSymboli + 1);
+  size_t                       oldWordl       = EARLEYGRAMMAR_BITSET_WORDL((size_t) firstSymboli + 1);
+  earleyGrammarBitWord_t      *firstp         = NULL;
+  earleyGrammarBitWord_t      *lookaheadp     = NULL;
+  earleyGrammarBitWord_t      *terminalp      = NULL;
+  earleyGrammarBitWord_t      *suffixp        = NULL;
+  int                         *ruleip         = NULL;   /* Rules whose dotted rules change */
+  int                         *separatorOffsetip = NULL;
+  int                         *separatorip    = NULL;
+  char                        *rowFlagbp      = NULL;   /* Old closure rows with another FIRST */
+  char                        *ruleFlagbp     = NULL;
+  int                         *dottedLookaheadRowip;
+  int                         *symbolFollowRowip;
+  earleyGrammarBitWord_t      *rowp;
+  earleyGrammarBitWord_t      *oldRowp;
+  earleyGrammarBitWord_t       firstl;
+  size_t                       l;
+  int                          nRuleListi;
+  int                          symboli;
+  int                          lhsSymboli;
+  int                          rhsSymboli;
+  int                          itemSymboli;
+  int                          separatorSymboli;
+  int                          rulei;
+  int                          rowi;
+  int                          firsti;
+  int                          i;
+  int                          k;
+  short                        rcb;
+
+  rowSet.allocatorp   = allocatorp;
+  rowSet.wordl        = wordl;
+  rowSet.rowp         = NULL;
+  rowSet.rowl         = 0;
+  rowSet.nRowi        = 0;
+  rowSet.rowHashlp    = NULL;
+  rowSet.rowHashl     = 0;
+  rowSet.haship       = NULL;
+  rowSet.hashl        = 0;
+  update.corep        = corep;
+  update.wordl        = wordl;
+  update.firstSymboli = firstSymboli;
+  update.symbolRowip  = NULL;
+  update.rowp         = NULL;
+  update.rowl         = 0;
+  update.nRowi        = 0;
+  update.symbolFlagbp = NULL;
+  update.worklistip   = NULL;
+  update.nWorklisti   = 0;
+
+  /* A full build when there is nothing to start from, or to drop the rows */
+  /* that are no longer used when they are as many as the used ones.       */
+  *donebp = 0;
+  if ((corep->firstp == NULL) || (corep->dottedLookaheadRowip == NULL) || (corep->lookaheadp == NULL) || (corep->symbolFollowRowip == NULL) ||
+      (nOldClosureRowi < 0) || (nOldRowi - corep->nLookaheadFullRowi > corep->nLookaheadFullRowi)) {
+    rcb = 1;
+    goto done;
+  }
+
+  if (wordl > SIZE_MAX / sizeof(earleyGrammarBitWord_t) / ((size_t) ((corep->nClosureRowi > nOldRowi) ? corep->nClosureRowi : nOldRowi) + 1)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Lookahead sets are too large\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  terminalp           = (earleyGrammarBitWord_t *) allocatorp->mallocp(allocatorp->userDatavp, wordl * sizeof(earleyGrammarBitWord_t));
+  suffixp             = (earleyGrammarBitWord_t *) allocatorp->mallocp(allocatorp->userDatavp, wordl * sizeof(earleyGrammarBitWord_t));
+  ruleip              = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nRulei + 1) * sizeof(int));
+  separatorOffsetip   = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  separatorip         = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nRulei + 1) * sizeof(int));
+  rowFlagbp           = (char *) allocatorp->mallocp(allocatorp->userDatavp, (size_t) nOldClosureRowi + 1);
+  ruleFlagbp          = (char *) allocatorp->mallocp(allocatorp->userDatavp, (size_t) nRulei + 1);
+  update.symbolRowip  = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  update.symbolFlagbp = (char *) allocatorp->mallocp(allocatorp->userDatavp, (size_t) nSymboli + 1);
+  update.worklistip   = (int *)  allocatorp->mallocp(allocatorp->userDatavp, ((size_t) nSymboli + 1) * sizeof(int));
+  if ((terminalp == NULL) || (suffixp == NULL) || (ruleip == NULL) || (separatorOffsetip == NULL) || (separatorip == NULL) || (rowFlagbp == NULL) ||
+      (ruleFlagbp == NULL) || (update.symbolRowip == NULL) || (update.symbolFlagbp == NULL) || (update.worklistip == NULL)) {
+    goto malloc_err;
+  }
+  memset(rowFlagbp,           0, (size_t) nOldClosureRowi + 1);
+  memset(ruleFlagbp,          0, (size_t) nRulei + 1);
+  memset(update.symbolFlagbp, 0, (size_t) nSymboli + 1);
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    update.symbolRowip[symboli] = -1;
+  }
+
+  /* FIRST again, from the closure. Old symbols keep their closure row,    */
+  /* and rows are updated in place when they have the same width.          */
+  if (wordl == oldWordl) {
+    firstp = (earleyGrammarBitWord_t *) earleyAllocator_reallocp(allocatorp, corep->firstp,
+                                                                  ((size_t) nOldClosureRowi * wordl + 1) * sizeof(earleyGrammarBitWord_t),
+                                                                  ((size_t) corep->nClosureRowi * wordl + 1) * sizeof(earleyGrammarBitWord_t));
+    if (firstp == NULL) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno));
+      goto err;
+    }
+    corep->firstp = firstp;
+    firstp        = NULL;
+  } else {
+    firstp = (earleyGrammarBitWord_t *) earleyAllocator_mallocp(allocatorp, ((size_t) corep->nClosureRowi * wordl + 1) * sizeof(earleyGrammarBitWord_t));
+    if (firstp == NULL) {
+      goto malloc_err;
+    }
+  }
+  memset(terminalp, 0, wordl * sizeof(earleyGrammarBitWord_t));
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) != 0) {
+      terminalp[symboli / EARLEYGRAMMAR_BITWORD_BITS] |= ((earleyGrammarBitWord_t) 1) << (symboli % EARLEYGRAMMAR_BITWORD_BITS);
+    }
+  }
+  for (rowi = 0; rowi < corep->nClosureRowi; rowi++) {
+    rowp    = ((firstp != NULL) ? firstp : corep->firstp) + (size_t) rowi * wordl;
+    oldRowp = (rowi < nOldClosureRowi) ? corep->firstp + (size_t) rowi * oldWordl : NULL;
+    for (l = 0; l < wordl; l++) {
+      firstl = (l < closureWordl) ? (corep->closurep[(size_t) rowi * closureWordl + l] & terminalp[l]) : 0;
+      if ((oldRowp != NULL) && (firstl != ((l < oldWordl) ? oldRowp[l] : 0))) {
+        rowFlagbp[rowi] = 1;
+      }
+      rowp[l] = firstl;
+    }
+  }
+  if (firstp != NULL) {
+    EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->firstp);
+    corep->firstp = firstp;
+    firstp        = NULL;
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((symboli >= firstSymboli) || rowFlagbp[corep->symbolClosureRowip[symboli]] ||
+        (((oldSymbolPropertyip[symboli] ^ corep->symbolPropertyBitSetip[symboli]) & EARLEY_SYMBOL_IS_NULLABLE) != 0)) {
+      update.symbolFlagbp[symboli] |= EARLEYGRAMMAR_INCREMENTAL_FIRST;
+    }
+  }
+
+  /* The end of input moves with the number of symbols */
+  if (wordl == oldWordl) {
+    if (firstSymboli != nSymboli) {
+      for (rowi = 0; rowi < nOldRowi; rowi++) {
+        rowp = corep->lookaheadp + (size_t) rowi * wordl;
+        earleyGrammar_lookahead_widenv(rowp, wordl, rowp, oldWordl, firstSymboli, nSymboli);
+      }
+    }
+  } else {
+    lookaheadp = (earleyGrammarBitWord_t *) earleyAllocator_mallocp(allocatorp, ((size_t) nOldRowi * wordl + 1) * sizeof(earleyGrammarBitWord_t));
+    if (lookaheadp == NULL) {
+      goto malloc_err;
+    }
+    for (rowi = 0; rowi < nOldRowi; rowi++) {
+      earleyGrammar_lookahead_widenv(lookaheadp + (size_t) rowi * wordl, wordl, corep->lookaheadp + (size_t) rowi * oldWordl, oldWordl, firstSymboli, nSymboli);
+    }
+    EARLEYGRAMMAR_TABLE_FREE(allocatorp, corep->lookaheadp);
+    corep->lookaheadp = lookaheadp;
+    lookaheadp        = NULL;
+  }
+
+  /* Rules to look at again: new, that became productive, or using a      */
+  /* flagged symbol in their RHS or as separator.                          */
+  earleyGrammar_precompute_separatorv(corep, separatorOffsetip, separatorip);
+  nRuleListi = 0;
+  for (rulei = 0; rulei < nRulei; rulei++) {
+    if ((rulei >= firstRulei) ||
+        (((oldRulePropertyip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) == 0) && ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) != 0))) {
+      ruleFlagbp[rulei]    = EARLEYGRAMMAR_INCREMENTAL_LOOKAHEAD;
+      ruleip[nRuleListi++] = rulei;
+    }
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((update.symbolFlagbp[symboli] & EARLEYGRAMMAR_INCREMENTAL_FIRST) == 0) {
+      continue;
+    }
+    for (i = corep->symbolRhsRuleOffsetip[symboli]; i < corep->symbolRhsRuleOffsetip[symboli + 1]; i++) {
+      rulei = corep->rhsRuleip[i];
+      if (((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) != 0) && (ruleFlagbp[rulei] == 0)) {
+        ruleFlagbp[rulei]    = EARLEYGRAMMAR_INCREMENTAL_LOOKAHEAD;
+        ruleip[nRuleListi++] = rulei;
+      }
+    }
+    for (i = separatorOffsetip[symboli]; i < separatorOffsetip[symboli + 1]; i++) {
+      rulei = separatorip[i];
+      if (((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) != 0) && (ruleFlagbp[rulei] == 0)) {
+        ruleFlagbp[rulei]    = EARLEYGRAMMAR_INCREMENTAL_LOOKAHEAD;
+        ruleip[nRuleListi++] = rulei;
+      }
+    }
+  }
+
+  /* FOLLOW, own part and inclusions of the rules to look at again */
+#define EARLEYGRAMMAR_FIRSTP(symboli) (corep->firstp + (size_t) corep->symbolClosureRowip[symboli] * wordl)
+#define EARLEYGRAMMAR_NULLABLEB(symboli) ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_NULLABLE) != 0)
+  for (k = 0; k < nRuleListi; k++) {
+    rulei = ruleip[k];
+    if ((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) == 0) {
+      continue;
+    }
+    ruleOptionp = &(corep->ruleOptionp[rulei]);
+    firsti      = corep->ruleRhsOffsetip[rulei];
+    if (ruleOptionp->sequenceb) {
+      itemSymboli      = corep->rhsSymbolip[firsti];
+      separatorSymboli = ruleOptionp->separatorSymboli;
+      if ((separatorSymboli >= 0) &&
+          ((! earleyGrammar_follow_orb(&update, itemSymboli, EARLEYGRAMMAR_FIRSTP(separatorSymboli), -1)) ||
+           (! earleyGrammar_follow_orb(&update, separatorSymboli, EARLEYGRAMMAR_FIRSTP(itemSymboli), -1)) ||
+           (EARLEYGRAMMAR_NULLABLEB(itemSymboli) && (! earleyGrammar_follow_orb(&update, separatorSymboli, EARLEYGRAMMAR_FIRSTP(separatorSymboli), -1))))) {
+        goto malloc_err;
+      }
+      if (((separatorSymboli < 0) || EARLEYGRAMMAR_NULLABLEB(separatorSymboli)) &&
+          (! earleyGrammar_follow_orb(&update, itemSymboli, EARLEYGRAMMAR_FIRSTP(itemSymboli), -1))) {
+        goto malloc_err;
+      }
+    } else {
+      memset(suffixp, 0, wordl * sizeof(earleyGrammarBitWord_t));
+      for (i = firsti + corep->ruleRhsLengthip[rulei] - 1; i >= firsti; i--) {
+        rhsSymboli = corep->rhsSymbolip[i];
+        if (! earleyGrammar_follow_orb(&update, rhsSymboli, suffixp, -1)) {
+          goto malloc_err;
+        }
+        if (! EARLEYGRAMMAR_NULLABLEB(rhsSymboli)) {
+          memset(suffixp, 0, wordl * sizeof(earleyGrammarBitWord_t));
+        }
+        earleyGrammar_bitset_orv(suffixp, EARLEYGRAMMAR_FIRSTP(rhsSymboli), wordl);
+      }
+    }
+    if (! earleyGrammar_follow_edgeb(&update, rulei)) {
+      goto malloc_err;
+    }
+  }
+#undef EARLEYGRAMMAR_FIRSTP
+#undef EARLEYGRAMMAR_NULLABLEB
+
+  /* FOLLOW, inherited part: what grew goes through the inclusions */
+  while (update.nWorklisti > 0) {
+    lhsSymboli = update.worklistip[--update.nWorklisti];
+    update.symbolFlagbp[lhsSymboli] &= ~EARLEYGRAMMAR_INCREMENTAL_QUEUED;
+    for (i = corep->symbolLhsRuleOffsetip[lhsSymboli]; i < corep->symbolLhsRuleOffsetip[lhsSymboli + 1]; i++) {
+      rulei = corep->lhsRuleip[i];
+      if (((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) != 0) && (! earleyGrammar_follow_edgeb(&update, rulei))) {
+        goto malloc_err;
+      }
+    }
+  }
+
+  /* Rules whose LHS has a larger FOLLOW */
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((update.symbolFlagbp[symboli] & EARLEYGRAMMAR_INCREMENTAL_FOLLOW) == 0) {
+      continue;
+    }
+    for (i = corep->symbolLhsRuleOffsetip[symboli]; i < corep->symbolLhsRuleOffsetip[symboli + 1]; i++) {
+      rulei = corep->lhsRuleip[i];
+      if (((corep->rulePropertyBitSetip[rulei] & EARLEY_RULE_IS_PRODUCTIVE) != 0) && (ruleFlagbp[rulei] == 0)) {
+        ruleFlagbp[rulei]    = EARLEYGRAMMAR_INCREMENTAL_LOOKAHEAD;
+        ruleip[nRuleListi++] = rulei;
+      }
+    }
+  }
+
+  /* Dotted rules, with new rows after the old ones */
+  dottedLookaheadRowip = (int *) earleyAllocator_reallocp(allocatorp, corep->dottedLookaheadRowip, ((size_t) nOldDottedi + 1) * sizeof(int), ((size_t) nDottedi + 1) * sizeof(int));
+  if (dottedLookaheadRowip == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  corep->dottedLookaheadRowip = dottedLookaheadRowip;
+  for (i = nOldDottedi; i < nDottedi; i++) {
+    corep->dottedLookaheadRowip[i] = -1;
+  }
+  for (k = 0; k < nRuleListi; k++) {
+    rulei = ruleip[k];
+    if (((rowp = earleyGrammar_follow_rowp(&update, corep->ruleLhsSymbolip[rulei])) == NULL) ||
+        (! earleyGrammar_lookahead_ruleb(corep, &rowSet, nOldRowi, 1, suffixp, wordl, rowp, rulei))) {
+      goto malloc_err;
+    }
+  }
+
+  symbolFollowRowip = (int *) earleyAllocator_reallocp(allocatorp, corep->symbolFollowRowip, ((size_t) firstSymboli + 1) * sizeof(int), ((size_t) nSymboli + 1) * sizeof(int));
+  if (symbolFollowRowip == NULL) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  corep->symbolFollowRowip = symbolFollowRowip;
+  for (symboli = firstSymboli; symboli < nSymboli; symboli++) {
+    corep->symbolFollowRowip[symboli] = -1;
+  }
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) != 0) {
+      continue;
+    }
+    if ((symboli >= firstSymboli) || ((update.symbolFlagbp[symboli] & EARLEYGRAMMAR_INCREMENTAL_FOLLOW) != 0)) {
+      if (((rowp = earleyGrammar_follow_rowp(&update, symboli)) == NULL) ||
+          (! earleyGrammar_lookahead_rowb(corep, &rowSet, nOldRowi, 1, rowp, wordl, &(corep->symbolFollowRowip[symboli])))) {
+        goto malloc_err;
+      }
+    }
+  }
+
+  if (rowSet.nRowi > 0) {
+    lookaheadp = (earleyGrammarBitWord_t *) earleyAllocator_reallocp(allocatorp, corep->lookaheadp,
+                                                                      ((size_t) nOldRowi * wordl + 1) * sizeof(earleyGrammarBitWord_t),
+                                                                      ((size_t) (nOldRowi + rowSet.nRowi) * wordl + 1) * sizeof(earleyGrammarBitWord_t));
+    if (lookaheadp == NULL) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno));
+      goto err;
+    }
+    memcpy(lookaheadp + (size_t) nOldRowi * wordl, rowSet.rowp, (size_t) rowSet.nRowi * wordl * sizeof(earleyGrammarBitWord_t));
+    corep->lookaheadp     = lookaheadp;
+    corep->nLookaheadRowi = nOldRowi + rowSet.nRowi;
+    lookaheadp            = NULL;
+  }
+
+  *donebp = 1;
+  rcb     = 1;
+  goto done;
+
+ malloc_err:
+  EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+
+ err:
+  rcb = 0;
+
+ done:
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, firstp);
+  EARLEYGRAMMAR_TABLE_FREE(allocatorp, lookaheadp);
+  if (terminalp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, terminalp);
+  }
+  if (suffixp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, suffixp);
+  }
+  if (ruleip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, ruleip);
+  }
+  if (separatorOffsetip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, separatorOffsetip);
+  }
+  if (separatorip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, separatorip);
+  }
+  if (rowFlagbp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, rowFlagbp);
+  }
+  if (ruleFlagbp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, ruleFlagbp);
+  }
+  if (update.symbolRowip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, update.symbolRowip);
+  }
+  if (update.rowp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, update.rowp);
+  }
+  if (update.symbolFlagbp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, update.symbolFlagbp);
+  }
+  if (update.worklistip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, update.worklistip);
+  }
+  if (rowSet.rowp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, rowSet.rowp);
+  }
+  if (rowSet.rowHashlp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, rowSet.rowHashlp);
+  }
+  if (rowSet.haship != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, rowSet.haship);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyGrammar_precompute_startb(earleyGrammar_t *earleyGrammarp, int starti)
+/****************************************************************************/
+/* Properties, then the tables that depend on them. When the grammar only  */
+/* got new symbols and rules since the last precompute, properties,        */
+/* prediction and lookahead tables are updated instead of computed again.  */
+/* Loops and the normal form are linear passes, always done again.         */
+/****************************************************************************/
+{
+  earleyGrammarCore_t         *corep      = NULL;
+  earleyAllocator_t           *allocatorp = NULL;
+  int                         *oldSymbolPropertyip = NULL;
+  int                         *oldRulePropertyip   = NULL;
+  int                          firstSymboli;
+  int                          firstRulei;
+  int                          nSymboli;
+  int                          symboli;
+  short                        incrementalb;
+  short                        lookaheadb;
+  short                        warningb = 0;
+  short                        rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (earleyGrammarp->precomputedb && (earleyGrammarp->corep->startSymboli == starti) && ((! earleyGrammarp->option.dfab) || (earleyGrammarp->corep->nDfaStatei > 0))) {
+    rcb = 1;
+    goto done;
+  }
+
+  if ((starti < 0) || (starti >= earleyGrammarp->corep->nSymboli)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such start symbol %d\n", starti);
+    errno = ENOENT;
+    goto err;
+  }
+
+  if (! earleyGrammar_core_ownb(earleyGrammarp)) {
+    goto err;
+  }
+
+  corep      = earleyGrammarp->corep;
+  allocatorp = &(corep->allocator);
+  nSymboli   = corep->nSymboli;
+
+  if (! earleyGrammar_precompute_indexb(earleyGrammarp)) {
+    goto err;
+  }
+
+  /* What the lookahead update compares with */
+  firstSymboli = corep->nPrecomputedSymboli;
+  firstRulei   = corep->nPrecomputedRulei;
+  if ((firstSymboli >= 0) && (firstRulei >= 0) && (firstSymboli <= nSymboli) && (firstRulei <= corep->nRulei)) {
+    oldSymbolPropertyip = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) firstSymboli + 1) * sizeof(int));
+    oldRulePropertyip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) firstRulei + 1) * sizeof(int));
+    if ((oldSymbolPropertyip == NULL) || (oldRulePropertyip == NULL)) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+      goto err;
+    }
+    memcpy(oldSymbolPropertyip, corep->symbolPropertyBitSetip, (size_t) firstSymboli * sizeof(int));
+    memcpy(oldRulePropertyip,   corep->rulePropertyBitSetip,   (size_t) firstRulei * sizeof(int));
+  }
+
+  /* Properties */
+  if (! earleyGrammar_precompute_incrementalb(earleyGrammarp, starti, &incrementalb)) {
+    goto err;
+  }
+  if ((! incrementalb) && (! earleyGrammar_precompute_propertyb(earleyGrammarp, starti))) {
+    goto err;
+  }
+
+  /* Loops */
+  if (! earleyGrammar_precompute_loopb(earleyGrammarp, &warningb)) {
+    goto err;
+  }
+
+  /* Prediction closure, already up to date when incremental */
+  if ((! incrementalb) && (! earleyGrammar_precompute_predictionb(earleyGrammarp))) {
+    goto err;
+  }
+
+  /* Nihilist normal form */
+  if (! earleyGrammar_precompute_nnfb(earleyGrammarp)) {
+    goto err;
+  }
+
+  /* Split epsilon-DFA, on demand. The start symbol is needed from now on. */
+  corep->startSymboli = starti;
+  if (! earleyGrammar_precompute_dfab(earleyGrammarp)) {
+    goto err;
+  }
+
+  /* FIRST, FOLLOW and dotted rules lookahead, updated when possible */
+  lookaheadb = 0;
+  if (incrementalb && (! earleyGrammar_incremental_lookaheadb(earleyGrammarp, firstSymboli, firstRulei, oldSymbolPropertyip, oldRulePropertyip, &lookaheadb))) {
+    goto err;
+  }
+  if ((! lookaheadb) && (! earleyGrammar_precompute_lookaheadb(earleyGrammarp))) {
+    goto err;
+  }
+
+  /* Diagnostics */
+  for (symboli = 0; symboli < nSymboli; symboli++) {
+    if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_ACCESSIBLE) == 0) {
+      EARLEYGRAMMAR_WARNF(earleyGrammarp, "Symbol %d is not accessible\n", symboli);
+      warningb = 1;
+    }
+    if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_PRODUCTIVE) == 0) {
+      EARLEYGRAMMAR_WARNF(earleyGrammarp, "Symbol %d is not productive\n", symboli);
+      warningb = 1;
     }
   }
+  if (warningb && earleyGrammarp->option.warningIsErrorb) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  corep->startSymboli          = starti;
+  corep->nPrecomputedSymboli   = corep->nSymboli;
+  corep->nPrecomputedRulei     = corep->nRulei;
+  corep->precomputeGenerationl++;
+  earleyGrammarp->precomputedb = 1;
 
+  rcb = 1;
   goto done;
 
  err:
-  earleyGrammar_freev(earleyGrammarp);
-  earleyGrammarp = NULL;
+  rcb = 0;
 
  done:
-  return earleyGrammarp;
-}
-
-/****************************************************************************/
-/* earleyGrammar_freev                                                      */
-/****************************************************************************/
-void earleyGrammar_freev(earleyGrammar_t *earleyGrammarp)
-{
-  genericStack_t *symbolStackp;
-  genericStack_t *ruleStackp;
-  earleySymbol_t *earleySymbolp;
-  earleyRule_t   *earleyRulep;
-  int             i;
-
-  if (earleyGrammarp != NULL) {
-
-    /* Free symbol stack */
-    symbolStackp = earleyGrammarp->symbolStackp;
-    if (symbolStackp != NULL) {
-      for (i = 0; i < GENERICSTACK_USED(symbolStackp); i++) {
-        earleySymbolp = (earleySymbol_t *) GENERICSTACK_GET_PTR(symbolStackp, i);
-        earleySymbol_freev(earleySymbolp);
-      }
-      GENERICSTACK_RESET(symbolStackp);
-    }
-
-    /* Free rule stack */
-    ruleStackp = earleyGrammarp->ruleStackp;
-    if (ruleStackp != NULL) {
-      for (i = 0; i < GENERICSTACK_USED(ruleStackp); i++) {
-        earleyRulep = (earleyRule_t *) GENERICSTACK_GET_PTR(ruleStackp, i);
-        earleyRule_freev(earleyRulep);
-      }
-      GENERICSTACK_RESET(ruleStackp);
-    }
-
-    free(earleyGrammarp);
+  if (oldSymbolPropertyip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, oldSymbolPropertyip);
+  }
+  if (oldRulePropertyip != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, oldRulePropertyip);
   }
+  return rcb;
 }
 
 /****************************************************************************/
-int earleyGrammar_newSymboli(earleyGrammar_t *earleyGrammarp, earleyGrammarSymbolOption_t *optionp)
+short earleyGrammar_predictedRulesb(earleyGrammar_t *earleyGrammarp, int symboli, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp)
 /****************************************************************************/
 {
-  earleySymbol_t *earleySymbolp = NULL;
-  genericStack_t *symbolStackp;
-  int             symboli;
+  earleyGrammarCore_t *corep;
+  size_t               wordl;
+  short                rcb;
 
   if (earleyGrammarp == NULL) {
     errno = EINVAL;
     goto err;
   }
 
-  symbolStackp = earleyGrammarp->symbolStackp;
-
-  earleySymbolp = (earleySymbol_t *) malloc(sizeof(earleySymbol_t));
-  if (earleySymbolp == NULL) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+  if (! earleyGrammarp->precomputedb) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Grammar must be precomputed\n");
+    errno = EINVAL;
     goto err;
   }
 
-  earleySymbolp->idi             = GENERICSTACK_USED(symbolStackp);
-  earleySymbolp->propertyBitSeti = 0;
-  earleySymbolp->eventBitSeti    = 0;
-  earleySymbolp->option          = (optionp != NULL) ? *optionp : earleyGrammarSymbolOptionDefault;
-
-  GENERICSTACK_PUSH_PTR(symbolStackp, earleySymbolp);
-  if (GENERICSTACK_ERROR(symbolStackp)) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "GENERICSTACK_PUSH_PTR failure, %s\n", strerror(errno));
+  if (! earleySymbol_existb(earleyGrammarp, symboli)) {
     goto err;
   }
 
-  symboli = earleySymbolp->idi;
+  corep = earleyGrammarp->corep;
+  wordl = EARLEYGRAMMAR_BITSET_WORDL(corep->nRulei);
+  if (bitSetpp != NULL) {
+    *bitSetpp = corep->predictionp + (size_t) corep->symbolPredictionRowip[symboli] * wordl;
+  }
+  if (wordlp != NULL) {
+    *wordlp = wordl;
+  }
+
+  rcb = 1;
   goto done;
 
  err:
-  earleySymbol_freev(earleySymbolp);
-  symboli = -1;
+  rcb = 0;
 
  done:
-  return symboli;
+  return rcb;
 }
 
 /****************************************************************************/
-short earleyGrammar_symbolPropertyb(earleyGrammar_t *earleyGrammarp, int symboli, int *earleySymbolPropertyBitSetp)
+short earleyGrammar_predictedSymbolsb(earleyGrammar_t *earleyGrammarp, int symboli, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp)
 /****************************************************************************/
 {
-  earleySymbol_t *earleySymbolp;
-  short           rcb;
+  earleyGrammarCore_t *corep;
+  size_t               wordl;
+  short                rcb;
 
   if (earleyGrammarp == NULL) {
     errno = EINVAL;
     goto err;
   }
 
-  earleySymbolp = earleySymbol_getp(earleyGrammarp, symboli);
-  if (earleySymbolp == NULL) {
+  if (! earleyGrammarp->precomputedb) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Grammar must be precomputed\n");
+    errno = EINVAL;
     goto err;
   }
 
-  if (earleySymbolPropertyBitSetp != NULL) {
-    *earleySymbolPropertyBitSetp = earleySymbolp->propertyBitSeti;
+  if (! earleySymbol_existb(earleyGrammarp, symboli)) {
+    goto err;
+  }
+
+  corep = earleyGrammarp->corep;
+  wordl = EARLEYGRAMMAR_BITSET_WORDL(corep->nSymboli);
+  if (bitSetpp != NULL) {
+    *bitSetpp = corep->closurep + (size_t) corep->symbolClosureRowip[symboli] * wordl;
+  }
+  if (wordlp != NULL) {
+    *wordlp = wordl;
   }
 
   rcb = 1;
@@ -389,24 +6665,35 @@ short earleyGrammar_symbolPropertyb(earleyGrammar_t *earleyGrammarp, int symboli
 }
 
 /****************************************************************************/
-short earleyGrammar_symbolEventb(earleyGrammar_t *earleyGrammarp, int symboli, int *earleySymbolEventBitSetp)
+short earleyGrammar_firstb(earleyGrammar_t *earleyGrammarp, int symboli, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp)
 /****************************************************************************/
 {
-  earleySymbol_t *earleySymbolp;
-  short           rcb;
+  earleyGrammarCore_t *corep;
+  size_t               wordl;
+  short                rcb;
 
   if (earleyGrammarp == NULL) {
     errno = EINVAL;
     goto err;
   }
 
-  earleySymbolp = earleySymbol_getp(earleyGrammarp, symboli);
-  if (earleySymbolp == NULL) {
+  if (! earleyGrammarp->precomputedb) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Grammar must be precomputed\n");
+    errno = EINVAL;
     goto err;
   }
 
-  if (earleySymbolEventBitSetp != NULL) {
-    *earleySymbolEventBitSetp = earleySymbolp->eventBitSeti;
+  if (! earleySymbol_existb(earleyGrammarp, symboli)) {
+    goto err;
+  }
+
+  corep = earleyGrammarp->corep;
+  wordl = EARLEYGRAMMAR_BITSET_WORDL((size_t) corep->nSymboli + 1);
+  if (bitSetpp != NULL) {
+    *bitSetpp = corep->firstp + (size_t) corep->symbolClosureRowip[symboli] * wordl;
+  }
+  if (wordlp != NULL) {
+    *wordlp = wordl;
   }
 
   rcb = 1;
@@ -420,92 +6707,75 @@ short earleyGrammar_symbolEventb(earleyGrammar_t *earleyGrammarp, int symboli, i
 }
 
 /****************************************************************************/
-int earleyGrammar_newRulei(earleyGrammar_t *earleyGrammarp, earleyGrammarRuleOption_t *optionp,
-                           int lhsSymboli,
-                           size_t rhsSymboll, int *rhsSymbolip
-                           )
+short earleyGrammar_lookaheadb(earleyGrammar_t *earleyGrammarp, int rulei, int doti, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp)
 /****************************************************************************/
 {
-  earleyRule_t   *earleyRulep = NULL;
-  earleySymbol_t *earleySymbolp;
-  genericStack_t *rhsStackp;
-  genericStack_t *ruleStackp;
-  int             rulei;
-  size_t          l;
+  earleyGrammarCore_t *corep;
+  size_t               wordl;
+  short                rcb;
 
   if (earleyGrammarp == NULL) {
     errno = EINVAL;
     goto err;
   }
 
-  ruleStackp   = earleyGrammarp->ruleStackp;
-
-  earleyRulep = (earleyRule_t *) malloc(sizeof(earleyRule_t));
-  if (earleyRulep == NULL) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+  if (! earleyGrammarp->precomputedb) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Grammar must be precomputed\n");
+    errno = EINVAL;
     goto err;
   }
 
-  earleyRulep->idi             = GENERICSTACK_USED(ruleStackp);
-  earleyRulep->lshSymbolp      = NULL;
-  earleyRulep->rhsStackp       = NULL;
-  earleyRulep->propertyBitSeti = 0;
-  earleyRulep->option          = (optionp != NULL) ? *optionp : earleyGrammarRuleOptionDefault;
-
-  rhsStackp = &(earleyRulep->_rhsStack);
-  GENERICSTACK_INIT(rhsStackp);
-  if (GENERICSTACK_ERROR(rhsStackp)) {
-    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "GENERICSTACK_INIT failure, %s\n", strerror(errno));
+  if (! earleyRule_existb(earleyGrammarp, rulei)) {
     goto err;
   }
-  earleyRulep->rhsStackp = rhsStackp;
 
-  earleyRulep->lshSymbolp = earleySymbol_getp(earleyGrammarp, lhsSymboli);
-  if (earleyRulep->lshSymbolp == NULL) {
+  corep = earleyGrammarp->corep;
+  if ((doti < 0) || (doti > corep->ruleRhsLengthip[rulei])) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No dot position %d in rule %d\n", doti, rulei);
+    errno = ENOENT;
     goto err;
   }
-  for (l = 0; l < rhsSymboll; l++) {
-    earleySymbolp = earleySymbol_getp(earleyGrammarp, rhsSymbolip[l]);
-    if (earleySymbolp == NULL) {
-      goto err;
-    }
-    GENERICSTACK_PUSH_PTR(rhsStackp, earleySymbolp);
-    if (GENERICSTACK_ERROR(rhsStackp)) {
-      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "GENERICSTACK_PUSH_PTR failure, %s\n", strerror(errno));
-      goto err;
-    }
+
+  wordl = EARLEYGRAMMAR_BITSET_WORDL((size_t) corep->nSymboli + 1);
+  if (bitSetpp != NULL) {
+    *bitSetpp = corep->lookaheadp + (size_t) corep->dottedLookaheadRowip[corep->ruleRhsOffsetip[rulei] + rulei + doti] * wordl;
+  }
+  if (wordlp != NULL) {
+    *wordlp = wordl;
   }
 
-  rulei = earleySymbolp->idi;
+  rcb = 1;
   goto done;
 
  err:
-  earleyRule_freev(earleyRulep);
-  rulei = -1;
+  rcb = 0;
 
  done:
-  return rulei;
+  return rcb;
 }
 
 /****************************************************************************/
-short earleyGrammar_rulePropertyb(earleyGrammar_t *earleyGrammarp, int rulei, int *earleyRulePropertyBitSetp)
+short earleyGrammar_nnfb(earleyGrammar_t *earleyGrammarp, int *nSymbolip, int *nRuleip)
 /****************************************************************************/
 {
-  earleyRule_t *earleyRulep;
-  short           rcb;
+  short rcb;
 
   if (earleyGrammarp == NULL) {
     errno = EINVAL;
     goto err;
   }
 
-  earleyRulep = earleyRule_getp(earleyGrammarp, rulei);
-  if (earleyRulep == NULL) {
+  if (! earleyGrammarp->precomputedb) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Grammar must be precomputed\n");
+    errno = EINVAL;
     goto err;
   }
 
-  if (earleyRulePropertyBitSetp != NULL) {
-    *earleyRulePropertyBitSetp = earleyRulep->propertyBitSeti;
+  if (nSymbolip != NULL) {
+    *nSymbolip = earleyGrammarp->corep->nNnfSymboli;
+  }
+  if (nRuleip != NULL) {
+    *nRuleip = earleyGrammarp->corep->nNnfRulei;
   }
 
   rcb = 1;
@@ -519,127 +6789,116 @@ short earleyGrammar_rulePropertyb(earleyGrammar_t *earleyGrammarp, int rulei, in
 }
 
 /****************************************************************************/
-int earleyGrammar_newSymbolExti(earleyGrammar_t *earleyGrammarp, short terminalb, short startb, int eventSeti)
-/****************************************************************************/
-{
-  earleyGrammarSymbolOption_t option = earleyGrammarSymbolOptionDefault;
-
-  option.terminalb = terminalb;
-  option.startb    = startb;
-  option.eventSeti = eventSeti;
-
-  return earleyGrammar_newSymboli(earleyGrammarp, &option);
-}
-
-/****************************************************************************/
-int earleyGrammar_newRuleExti(earleyGrammar_t *earleyGrammarp, int ranki, short nullRanksHighb, int lhsSymboli, ...)
+short earleyGrammar_nnfRuleb(earleyGrammar_t *earleyGrammarp, int nnfRulei, int *ruleip, int *lhsSymbolip, size_t *rhsSymbollp, const int **rhsSymbolipp, int *nulledip)
 /****************************************************************************/
 {
-  earleyGrammarRuleOption_t option               = earleyGrammarRuleOptionDefault;
-  static const size_t       rhsSymbolStartAllocl = 16; /* Totally subjective -; */
-  size_t                    rhsSymbolAllocl      = 0;
-  size_t                    rhsSymboll           = 0;
-  size_t                    l                    = 0;
-  int                      *rhsSymbolip          = NULL;
-  int                      *tmpip;
-  int                       rhsSymboli;
-  size_t                    tmpl;
-  va_list                   ap;
-  int                       rci;
+  earleyGrammarCore_t *corep;
+  short                rcb;
 
-  option.ranki          = ranki;
-  option.nullRanksHighb = nullRanksHighb;
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
 
-  va_start(ap, lhsSymboli);
-  while ((rhsSymboli = va_arg(ap, int)) >= 0) {
-    if (++rhsSymboll > rhsSymbolAllocl) {
-      if (rhsSymbolAllocl == 0) {
-        rhsSymbolip = (int *) malloc(rhsSymbolStartAllocl * sizeof(int));
-        if (rhsSymbolip == NULL) {
-          EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
-          goto err;
-        }
-        rhsSymbolAllocl = rhsSymbolStartAllocl;
-      } else {
-        tmpl = rhsSymbolAllocl * 2;
-        /* Detect very improbable turnaround */
-        if (tmpl < rhsSymbolAllocl) {
-          EARLEYGRAMMAR_ERROR(earleyGrammarp, "size_t turnaround\n");
-          errno = EINVAL;
-          goto err;
-        }
-        tmpip = (int *) realloc(rhsSymbolip, tmpl * sizeof(int));
-        if (tmpip == NULL) {
-          EARLEYGRAMMAR_ERRORF(earleyGrammarp, "realloc failure, %s\n", strerror(errno));
-          goto err;
-        }
-        rhsSymbolip = tmpip;
-        rhsSymbolAllocl = tmpl;
-      }
-    }
+  if (! earleyGrammarp->precomputedb) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Grammar must be precomputed\n");
+    errno = EINVAL;
+    goto err;
+  }
 
-    rhsSymbolip[l++] = rhsSymboli;
+  corep = earleyGrammarp->corep;
+  if ((nnfRulei < 0) || (nnfRulei >= corep->nNnfRulei)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such internal rule %d\n", nnfRulei);
+    errno = ENOENT;
+    goto err;
   }
-  va_end(ap);
 
-  rci =  earleyGrammar_newRulei(earleyGrammarp, &option, lhsSymboli, rhsSymboll, rhsSymbolip);
+  if (ruleip != NULL) {
+    *ruleip = corep->nnfRuleUserip[nnfRulei];
+  }
+  if (lhsSymbolip != NULL) {
+    *lhsSymbolip = corep->nnfRuleLhsSymbolip[nnfRulei];
+  }
+  if (rhsSymbollp != NULL) {
+    *rhsSymbollp = (size_t) corep->nnfRuleRhsLengthip[nnfRulei];
+  }
+  if (rhsSymbolipp != NULL) {
+    *rhsSymbolipp = corep->nnfRhsSymbolip + corep->nnfRuleRhsOffsetip[nnfRulei];
+  }
+  if (nulledip != NULL) {
+    *nulledip = corep->nnfRuleNulledip[nnfRulei];
+  }
 
+  rcb = 1;
   goto done;
 
  err:
-  rci = -1;
+  rcb = 0;
 
  done:
-  if (rhsSymbolip != NULL) {
-    free(rhsSymbolip);
-  }
-
-  return rci;
+  return rcb;
 }
 
 /****************************************************************************/
-int earley_newSequenceExti(earleyGrammar_t *earleyGrammarp, int ranki, short nullRanksHighb,
-                           int lhsSymboli,
-                           int rhsSymboli, int minimumi, int separatorSymboli, short properb)
+short earleyGrammar_dfab(earleyGrammar_t *earleyGrammarp, int *nStateip)
 /****************************************************************************/
 {
-  earleyGrammarRuleOption_t option;
-  int                       rhsSymbolip[1] = { rhsSymboli };
+  short rcb;
 
-  switch (minimumi) {
-  case '*':
-    minimumi = 0;
-    break;
-  case '+':
-    minimumi = 1;
-    break;
-  default:
-    break;
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
   }
-  
-  option.ranki            = ranki;
-  option.nullRanksHighb   = nullRanksHighb;
-  option.sequenceb        = 1;
-  option.separatorSymboli = separatorSymboli;
-  option.properb          = properb;
-  option.minimumi         = minimumi;
 
-  return earleyGrammar_newRulei(earleyGrammarp, &option, lhsSymboli, 1, rhsSymbolip);
+  if ((! earleyGrammarp->precomputedb) || (earleyGrammarp->corep->nDfaStatei <= 0)) {
+    EARLEYGRAMMAR_ERROR(earleyGrammarp, "Grammar must be precomputed with the dfab option\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (nStateip != NULL) {
+    *nStateip = earleyGrammarp->corep->nDfaStatei;
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
 }
 
 /****************************************************************************/
-short earleyGrammar_errorb(earleyGrammar_t *earleyGrammarp, int *errorip)
+short earleyGrammar_dfaStateb(earleyGrammar_t *earleyGrammarp, int statei, size_t *itemlp, const int **nnfRuleipp, const int **dotipp, int *nonKernelStateip)
 /****************************************************************************/
 {
-  short rcb;
+  earleyGrammarCore_t *corep;
+  short                rcb;
 
-  if (earleyGrammarp == NULL) {
-    errno = EINVAL;
+  if (! earleyGrammar_dfab(earleyGrammarp, NULL)) {
     goto err;
   }
 
-  if (errorip != NULL) {
-    *errorip = earleyGrammarp->errori;
+  corep = earleyGrammarp->corep;
+  if ((statei < 0) || (statei >= corep->nDfaStatei)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such DFA state %d\n", statei);
+    errno = ENOENT;
+    goto err;
+  }
+
+  if (itemlp != NULL) {
+    *itemlp = (size_t) (corep->dfaStateItemOffsetip[statei + 1] - corep->dfaStateItemOffsetip[statei]);
+  }
+  if (nnfRuleipp != NULL) {
+    *nnfRuleipp = corep->dfaItemRuleip + corep->dfaStateItemOffsetip[statei];
+  }
+  if (dotipp != NULL) {
+    *dotipp = corep->dfaItemDotip + corep->dfaStateItemOffsetip[statei];
+  }
+  if (nonKernelStateip != NULL) {
+    *nonKernelStateip = corep->dfaStateNonKernelip[statei];
   }
 
   rcb = 1;
@@ -653,17 +6912,46 @@ short earleyGrammar_errorb(earleyGrammar_t *earleyGrammarp, int *errorip)
 }
 
 /****************************************************************************/
-short earleyGrammar_error_clearb(earleyGrammar_t *earleyGrammarp)
+short earleyGrammar_dfaGotob(earleyGrammar_t *earleyGrammarp, int statei, int symboli, int *targetStateip)
+/****************************************************************************/
+/* Transitions of a state are sorted by symbol: binary search              */
 /****************************************************************************/
 {
-  short rcb;
+  earleyGrammarCore_t *corep;
+  int                  lowi;
+  int                  highi;
+  int                  middlei;
+  int                  targetStatei = -1;
+  short                rcb;
 
-  if (earleyGrammarp == NULL) {
-    errno = EINVAL;
+  if (! earleyGrammar_dfab(earleyGrammarp, NULL)) {
     goto err;
   }
 
-  earleyGrammarp->errori = 0;
+  corep = earleyGrammarp->corep;
+  if ((statei < 0) || (statei >= corep->nDfaStatei)) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "No such DFA state %d\n", statei);
+    errno = ENOENT;
+    goto err;
+  }
+
+  lowi  = corep->dfaStateTransitionOffsetip[statei];
+  highi = corep->dfaStateTransitionOffsetip[statei + 1];
+  while (lowi < highi) {
+    middlei = lowi + (highi - lowi) / 2;
+    if (corep->dfaTransitionSymbolip[middlei] < symboli) {
+      lowi = middlei + 1;
+    } else {
+      highi = middlei;
+    }
+  }
+  if ((lowi < corep->dfaStateTransitionOffsetip[statei + 1]) && (corep->dfaTransitionSymbolip[lowi] == symboli)) {
+    targetStatei = corep->dfaTransitionStateip[lowi];
+  }
+
+  if (targetStateip != NULL) {
+    *targetStateip = targetStatei;
+  }
 
   rcb = 1;
   goto done;
@@ -676,24 +6964,163 @@ short earleyGrammar_error_clearb(earleyGrammar_t *earleyGrammarp)
 }
 
 /****************************************************************************/
-short earleyGrammar_precomputeb(earleyGrammar_t *earleyGrammarp)
+static inline short earleyGrammar_event_maskb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+/* Event masks from the effective event sets, built once for a given number */
+/* of symbols. When symbols were added, masks of the others are kept as    */
+/* they are, runtime activations included. Triggers are cleared.           */
 /****************************************************************************/
 {
-  return earleyGrammar_precompute_startb(earleyGrammarp, 0);
+  earleyGrammarCore_t    *corep = earleyGrammarp->corep;
+  int                     nSymboli = corep->nSymboli;
+  int                     oldSymboli = (earleyGrammarp->nEventSymboli > 0) ? earleyGrammarp->nEventSymboli : 0;
+  size_t                  wordl      = EARLEYGRAMMAR_BITSET_WORDL(nSymboli);
+  size_t                  oldWordl   = EARLEYGRAMMAR_BITSET_WORDL(oldSymboli);
+  earleyGrammarBitWord_t *rowp;
+  earleyGrammarBitWord_t  bitl;
+  int                     eventSeti;
+  int                     symboli;
+  int                     rowi;
+
+  if (earleyGrammarp->nEventSymboli == nSymboli) {
+    return 1;
+  }
+  if (oldSymboli > nSymboli) {
+    /* Not a grown grammar, e.g. rows of another core */
+    oldSymboli = 0;
+    oldWordl   = 0;
+  }
+
+  if (! earleyGrammar_scratch_reserveb(&(earleyGrammarp->allocator), (void **) &(earleyGrammarp->eventBitSetp), &(earleyGrammarp->eventBitSetl), 2 * EARLEYGRAMMAR_EVENT_ROWI * wordl + 1, sizeof(earleyGrammarBitWord_t))) {
+    EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+  /* Masks move to their new place from the last one: rows only get longer */
+  for (rowi = EARLEYGRAMMAR_EVENT_ROWI - 1; rowi >= 0; rowi--) {
+    rowp = earleyGrammarp->eventBitSetp + (size_t) rowi * wordl;
+    if (oldWordl > 0) {
+      memmove(rowp, earleyGrammarp->eventBitSetp + (size_t) rowi * oldWordl, oldWordl * sizeof(earleyGrammarBitWord_t));
+    }
+    memset(rowp + oldWordl, 0, (wordl - oldWordl) * sizeof(earleyGrammarBitWord_t));
+  }
+  memset(earleyGrammarp->eventBitSetp + EARLEYGRAMMAR_EVENT_ROWI * wordl, 0, EARLEYGRAMMAR_EVENT_ROWI * wordl * sizeof(earleyGrammarBitWord_t));
+  for (symboli = oldSymboli; symboli < nSymboli; symboli++) {
+    eventSeti = EARLEYGRAMMAR_SYMBOLEVENTI(earleyGrammarp, symboli);
+    bitl      = ((earleyGrammarBitWord_t) 1) << (symboli % EARLEYGRAMMAR_BITWORD_BITS);
+    if ((eventSeti & EARLEYGRAMMAR_EVENTTYPE_COMPLETION) != 0) {
+      earleyGrammarp->eventBitSetp[EARLEYGRAMMAR_EVENT_COMPLETED * wordl + symboli / EARLEYGRAMMAR_BITWORD_BITS] |= bitl;
+    }
+    if ((eventSeti & EARLEYGRAMMAR_EVENTTYPE_NULLED) != 0) {
+      earleyGrammarp->eventBitSetp[EARLEYGRAMMAR_EVENT_NULLED * wordl + symboli / EARLEYGRAMMAR_BITWORD_BITS] |= bitl;
+    }
+    if ((eventSeti & EARLEYGRAMMAR_EVENTTYPE_PREDICTION) != 0) {
+      earleyGrammarp->eventBitSetp[EARLEYGRAMMAR_EVENT_EXPECTED * wordl + symboli / EARLEYGRAMMAR_BITWORD_BITS] |= bitl;
+    }
+  }
+  earleyGrammarp->nEventSymboli = nSymboli;
+  earleyGrammarp->exhaustedb    = 0;
+  earleyGrammarp->eventReloadb  = 1;
+
+  return 1;
 }
 
 /****************************************************************************/
-short earleyGrammar_precompute_startb(earleyGrammar_t *earleyGrammarp, int starti)
+short earleyGrammar_event_resetb(earleyGrammar_t *earleyGrammarp)
+/****************************************************************************/
+/* Forgets what was triggered, e.g. when moving to the next earleme         */
 /****************************************************************************/
 {
-  /* TO DO */
-  return 0;
+  size_t wordl;
+
+  if (earleyGrammarp->nEventSymboli != earleyGrammarp->corep->nSymboli) {
+    return earleyGrammar_event_maskb(earleyGrammarp);
+  }
+
+  wordl = EARLEYGRAMMAR_BITSET_WORDL(earleyGrammarp->nEventSymboli);
+  memset(earleyGrammarp->eventBitSetp + EARLEYGRAMMAR_EVENT_ROWI * wordl, 0, EARLEYGRAMMAR_EVENT_ROWI * wordl * sizeof(earleyGrammarBitWord_t));
+  earleyGrammarp->exhaustedb   = 0;
+  earleyGrammarp->eventReloadb = 1;
+
+  return 1;
 }
 
 /****************************************************************************/
-short earleyGrammar_eventb(earleyGrammar_t *earleyGrammarp, size_t *eventlp, earleyGrammarEvent_t **eventpp, short exhaustionEventb, short forceReladb)
+short earleyGrammar_eventb(earleyGrammar_t *earleyGrammarp, size_t *eventlp, earleyGrammarEvent_t **eventpp, short exhaustionEventb, short forceReloadb)
+/****************************************************************************/
+/* Triggers AND-ed with the masks, a word at a time, into the buffer of    */
+/* the grammar: once it is large enough, nothing is allocated.             */
 /****************************************************************************/
 {
-  /* TO DO */
-  return 0;
+  earleyGrammarBitWord_t *maskp;
+  earleyGrammarBitWord_t *triggerp;
+  earleyGrammarBitWord_t  bitWordl;
+  earleyGrammarEvent_t   *eventp;
+  size_t                  wordl;
+  size_t                  nEventl;
+  size_t                  l;
+  int                     eventi;
+  short                   rcb;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyGrammar_event_maskb(earleyGrammarp)) {
+    goto err;
+  }
+
+  exhaustionEventb = exhaustionEventb ? 1 : 0;
+  if (forceReloadb || earleyGrammarp->eventReloadb || (exhaustionEventb != earleyGrammarp->eventExhaustionb)) {
+    wordl    = EARLEYGRAMMAR_BITSET_WORDL(earleyGrammarp->nEventSymboli);
+    maskp    = earleyGrammarp->eventBitSetp;
+    triggerp = earleyGrammarp->eventBitSetp + EARLEYGRAMMAR_EVENT_ROWI * wordl;
+
+    /* Count first, so that the buffer grows at most once */
+    nEventl = (exhaustionEventb && earleyGrammarp->exhaustedb) ? 1 : 0;
+    for (l = 0; l < EARLEYGRAMMAR_EVENT_ROWI * wordl; l++) {
+      nEventl += (size_t) earleyGrammar_bitWord_counti(maskp[l] & triggerp[l]);
+    }
+    if (! earleyGrammar_scratch_reserveb(&(earleyGrammarp->allocator), (void **) &(earleyGrammarp->eventp), &(earleyGrammarp->eventl), nEventl, sizeof(earleyGrammarEvent_t))) {
+      EARLEYGRAMMAR_ERRORF(earleyGrammarp, "malloc failure, %s\n", strerror(errno));
+      goto err;
+    }
+
+    eventp = earleyGrammarp->eventp;
+    for (eventi = 0; eventi < EARLEYGRAMMAR_EVENT_ROWI; eventi++) {
+      for (l = 0; l < wordl; l++) {
+        bitWordl = maskp[(size_t) eventi * wordl + l] & triggerp[(size_t) eventi * wordl + l];
+        while (bitWordl != 0) {
+          eventp->eventType = eventi;
+          eventp->symboli   = (int) (l * EARLEYGRAMMAR_BITWORD_BITS) + earleyGrammar_bitWord_lowi(bitWordl);
+          eventp++;
+          bitWordl &= bitWordl - 1;
+        }
+      }
+    }
+    if (exhaustionEventb && earleyGrammarp->exhaustedb) {
+      eventp->eventType = EARLEYGRAMMAR_EVENT_EXHAUSTED;
+      eventp->symboli   = -1;
+    }
+
+    earleyGrammarp->nEventl          = nEventl;
+    earleyGrammarp->eventReloadb     = 0;
+    earleyGrammarp->eventExhaustionb = exhaustionEventb;
+  }
+
+  if (eventlp != NULL) {
+    *eventlp = earleyGrammarp->nEventl;
+  }
+  if (eventpp != NULL) {
+    *eventpp = earleyGrammarp->eventp;
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
 }
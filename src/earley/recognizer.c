@@ -0,0 +1,1423 @@
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <genericLogger.h>
+
+#include "earley/recognizer.h"
+#include "earley/internal/config.h"
+#include "earley/internal/structures.h"
+#include "earley/internal/grammar.h"
+
+earleyRecognizerOption_t earleyRecognizerOptionDefault = {
+  NULL, /* genericLoggerp */
+  0     /* recognizeOnlyb */
+};
+
+static inline short earleyRecognizer_grammarb(earleyRecognizer_t *earleyRecognizerp);
+static inline short earleyRecognizer_startb(earleyRecognizer_t *earleyRecognizerp);
+static inline short earleyRecognizer_token_checkb(earleyRecognizer_t *earleyRecognizerp, int symboli, size_t lengthl);
+static inline short earleyRecognizer_token_addb(earleyRecognizer_t *earleyRecognizerp, int symboli, size_t lengthl);
+static inline short earleyRecognizer_set_openb(earleyRecognizer_t *earleyRecognizerp, size_t earlemel);
+static inline short earleyRecognizer_set_refb(earleyRecognizer_t *earleyRecognizerp, size_t setl, size_t **setlpp, size_t *setlp, size_t *nSetlp);
+static inline void  earleyRecognizer_set_releasev(earleyRecognizer_t *earleyRecognizerp, size_t setl);
+static inline void  earleyRecognizer_set_pinv(earleyRecognizer_t *earleyRecognizerp, size_t setl);
+static inline void  earleyRecognizer_set_unpinv(earleyRecognizer_t *earleyRecognizerp, size_t setl);
+static inline short earleyRecognizer_set_scanb(earleyRecognizer_t *earleyRecognizerp);
+static inline short earleyRecognizer_set_processb(earleyRecognizer_t *earleyRecognizerp);
+static inline short earleyRecognizer_set_freezeb(earleyRecognizer_t *earleyRecognizerp);
+static inline void  earleyRecognizer_set_eventsv(earleyRecognizer_t *earleyRecognizerp);
+static inline short earleyRecognizer_predictb(earleyRecognizer_t *earleyRecognizerp, int symboli);
+static inline short earleyRecognizer_completeSymbolb(earleyRecognizer_t *earleyRecognizerp, int symboli, size_t originl);
+static inline short earleyRecognizer_item_addb(earleyRecognizer_t *earleyRecognizerp, int dottedi, size_t originl, short hashb);
+static inline short earleyRecognizer_hash_insertb(earleyRecognizer_t *earleyRecognizerp, earleyRecognizerItem_t iteml, short *newbp);
+static inline short earleyRecognizer_hash_growb(earleyRecognizer_t *earleyRecognizerp);
+static inline int   earleyRecognizer_postdot_findi(earleyRecognizerSet_t *setp, int symboli);
+static inline void  earleyRecognizer_postdot_rangev(earleyRecognizerSet_t *setp, int groupi, int *firstip, int *endip);
+static inline int   earleyRecognizer_group_cmpi(const void *p1, const void *p2);
+
+/* Packed items. The origin set is below EARLEYRECOGNIZER_SET_MAX and the  */
+/* dotted rule below INT_MAX, so that no item has all bits set: this is no */
+/* item at all, e.g. the empty hash slot.                                  */
+#define EARLEYRECOGNIZER_ITEM(dottedi, originl) ((((earleyRecognizerItem_t) (originl)) << 32) | (earleyRecognizerItem_t) (uint32_t) (dottedi))
+#define EARLEYRECOGNIZER_ITEM_DOTTEDI(iteml) ((int) ((iteml) & 0xFFFFFFFFU))
+#define EARLEYRECOGNIZER_ITEM_ORIGINL(iteml) ((size_t) ((iteml) >> 32))
+#define EARLEYRECOGNIZER_SET_MAX     0xFFFFFFFEU
+#define EARLEYRECOGNIZER_ITEM_NONE   UINT64_MAX
+#define EARLEYRECOGNIZER_HASH_EMPTY  EARLEYRECOGNIZER_ITEM_NONE
+#define EARLEYRECOGNIZER_HASH_START_SLOTL 64
+
+#define EARLEYRECOGNIZER_ERROR(earleyRecognizerp, strings) do {         \
+    if ((earleyRecognizerp != NULL) && (earleyRecognizerp->option.genericLoggerp != NULL)) { \
+      GENERICLOGGER_ERROR(earleyRecognizerp->option.genericLoggerp, strings); \
+    }                                                                   \
+  } while (0)
+
+#define EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, fmts, ...) do {      \
+    if ((earleyRecognizerp != NULL) && (earleyRecognizerp->option.genericLoggerp != NULL)) { \
+      GENERICLOGGER_ERRORF(earleyRecognizerp->option.genericLoggerp, fmts, __VA_ARGS__); \
+    }                                                                   \
+  } while (0)
+
+/****************************************************************************/
+earleyRecognizer_t *earleyRecognizer_newp(earleyGrammar_t *earleyGrammarp, earleyRecognizerOption_t *optionp)
+/****************************************************************************/
+{
+  earleyRecognizer_t  *earleyRecognizerp = NULL;
+  earleyGrammarCore_t       *corep;
+  earleyAllocator_t         *allocatorp;
+  earleyGrammarRuleOption_t *ruleOptionp;
+  size_t                     nDottedl;
+  int                        rulei;
+  int                        doti;
+  int                        dottedi;
+  int                        itemSymboli;
+  int                        errnoi;
+
+  if (earleyGrammarp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (optionp == NULL) {
+    optionp = &earleyRecognizerOptionDefault;
+  }
+
+  earleyRecognizerp = (earleyRecognizer_t *) earleyGrammarp->allocator.mallocp(earleyGrammarp->allocator.userDatavp, sizeof(earleyRecognizer_t));
+  if (earleyRecognizerp == NULL) {
+    goto err;
+  }
+  memset(earleyRecognizerp, 0, sizeof(earleyRecognizer_t));
+  earleyRecognizerp->earleyGrammarp = earleyGrammarp;
+  earleyRecognizerp->corep                 = earleyGrammarp->corep;
+  earleyRecognizerp->precomputeGenerationl = earleyGrammarp->corep->precomputeGenerationl;
+  earleyRecognizerp->allocator             = earleyGrammarp->allocator;
+  earleyRecognizerp->option                = *optionp;
+  allocatorp                               = &(earleyRecognizerp->allocator);
+  corep                                    = earleyRecognizerp->corep;
+
+  if ((! earleyGrammarp->precomputedb) || (corep->startSymboli < 0)) {
+    EARLEYRECOGNIZER_ERROR(earleyRecognizerp, "Grammar must be precomputed\n");
+    errno = EINVAL;
+    goto err;
+  }
+  /* A sequence has three dotted rules, whatever its RHS. Completions are */
+  /* remembered in the hash as items past the dotted rules.               */
+  nDottedl = 0;
+  for (rulei = 0; rulei < corep->nRulei; rulei++) {
+    nDottedl += corep->ruleOptionp[rulei].sequenceb ? 3 : (size_t) corep->ruleRhsLengthip[rulei] + 1;
+  }
+  if (nDottedl + (size_t) corep->nSymboli >= (size_t) INT_MAX) {
+    EARLEYRECOGNIZER_ERROR(earleyRecognizerp, "Grammar is too large for the recognizer\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  earleyRecognizerp->nDottedi          = (int) nDottedl;
+  earleyRecognizerp->ruleDottedip      = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nRulei + 1) * sizeof(int));
+  earleyRecognizerp->dottedRuleip      = (int *) allocatorp->mallocp(allocatorp->userDatavp, (nDottedl + 1) * sizeof(int));
+  earleyRecognizerp->dottedPostdotip   = (int *) allocatorp->mallocp(allocatorp->userDatavp, (nDottedl + 1) * sizeof(int));
+  earleyRecognizerp->dottedNextip      = (int *) allocatorp->mallocp(allocatorp->userDatavp, (nDottedl + 1) * sizeof(int));
+  earleyRecognizerp->dottedCompletedbp = (char *) allocatorp->mallocp(allocatorp->userDatavp, (nDottedl + 1) * sizeof(char));
+  earleyRecognizerp->rowStamplp        = (size_t *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nPredictionRowi + 1) * sizeof(size_t));
+  earleyRecognizerp->ruleStamplp       = (size_t *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nRulei + 1) * sizeof(size_t));
+  earleyRecognizerp->symbolStamplp     = (size_t *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nSymboli + 1) * sizeof(size_t));
+  earleyRecognizerp->symbolCountip     = (int *) allocatorp->mallocp(allocatorp->userDatavp, ((size_t) corep->nSymboli + 1) * sizeof(int));
+  earleyRecognizerp->expectedBitSetp   = (earleyGrammarBitWord_t *) allocatorp->mallocp(allocatorp->userDatavp, EARLEYGRAMMAR_BITSET_WORDL(corep->nSymboli) * sizeof(earleyGrammarBitWord_t));
+  if ((earleyRecognizerp->ruleDottedip == NULL) || (earleyRecognizerp->dottedRuleip == NULL) || (earleyRecognizerp->dottedPostdotip == NULL) ||
+      (earleyRecognizerp->dottedNextip == NULL) || (earleyRecognizerp->dottedCompletedbp == NULL) || (earleyRecognizerp->rowStamplp == NULL) ||
+      (earleyRecognizerp->ruleStamplp == NULL) || (earleyRecognizerp->symbolStamplp == NULL) || (earleyRecognizerp->symbolCountip == NULL) ||
+      (earleyRecognizerp->expectedBitSetp == NULL)) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "malloc failure, %s\n", strerror(errno));
+    goto err;
+  }
+  memset(earleyRecognizerp->rowStamplp,    0, ((size_t) corep->nPredictionRowi + 1) * sizeof(size_t));
+  memset(earleyRecognizerp->ruleStamplp,   0, ((size_t) corep->nRulei + 1) * sizeof(size_t));
+  memset(earleyRecognizerp->symbolStamplp, 0, ((size_t) corep->nSymboli + 1) * sizeof(size_t));
+
+  /* Dotted rule (r, d) is ruleDottedip[r]+d. The states of a sequence are */
+  /* d = 0 before the first item, 1 after an item and 2 after a separator: */
+  /* - 0 expects the item, and is complete when the minimum is 0           */
+  /* - 1 expects the separator, or the item when there is none, and is     */
+  /*   complete                                                            */
+  /* - 2 expects the item, and is complete when the sequence is not proper */
+  dottedi = 0;
+  for (rulei = 0; rulei < corep->nRulei; rulei++) {
+    earleyRecognizerp->ruleDottedip[rulei] = dottedi;
+    ruleOptionp = &(corep->ruleOptionp[rulei]);
+    if (ruleOptionp->sequenceb) {
+      itemSymboli = corep->rhsSymbolip[corep->ruleRhsOffsetip[rulei]];
+      for (doti = 0; doti < 3; doti++) {
+        earleyRecognizerp->dottedRuleip[dottedi + doti] = rulei;
+      }
+      earleyRecognizerp->dottedPostdotip[dottedi]       = itemSymboli;
+      earleyRecognizerp->dottedNextip[dottedi]          = dottedi + 1;
+      earleyRecognizerp->dottedCompletedbp[dottedi]     = (ruleOptionp->minimumi == 0);
+      earleyRecognizerp->dottedPostdotip[dottedi + 1]   = (ruleOptionp->separatorSymboli >= 0) ? ruleOptionp->separatorSymboli : itemSymboli;
+      earleyRecognizerp->dottedNextip[dottedi + 1]      = (ruleOptionp->separatorSymboli >= 0) ? dottedi + 2 : dottedi + 1;
+      earleyRecognizerp->dottedCompletedbp[dottedi + 1] = 1;
+      earleyRecognizerp->dottedPostdotip[dottedi + 2]   = itemSymboli;
+      earleyRecognizerp->dottedNextip[dottedi + 2]      = dottedi + 1;
+      earleyRecognizerp->dottedCompletedbp[dottedi + 2] = ! ruleOptionp->properb;
+      dottedi += 3;
+    } else {
+      for (doti = 0; doti <= corep->ruleRhsLengthip[rulei]; doti++, dottedi++) {
+        earleyRecognizerp->dottedRuleip[dottedi] = rulei;
+        if (doti < corep->ruleRhsLengthip[rulei]) {
+          earleyRecognizerp->dottedPostdotip[dottedi]   = corep->rhsSymbolip[corep->ruleRhsOffsetip[rulei] + doti];
+          earleyRecognizerp->dottedNextip[dottedi]      = dottedi + 1;
+          earleyRecognizerp->dottedCompletedbp[dottedi] = 0;
+        } else {
+          earleyRecognizerp->dottedPostdotip[dottedi]   = -1;
+          earleyRecognizerp->dottedNextip[dottedi]      = -1;
+          earleyRecognizerp->dottedCompletedbp[dottedi] = 1;
+        }
+      }
+    }
+  }
+
+  if (! earleyRecognizer_startb(earleyRecognizerp)) {
+    goto err;
+  }
+
+  goto done;
+
+ err:
+  if (earleyRecognizerp != NULL) {
+    errnoi = errno;
+    earleyRecognizer_freev(earleyRecognizerp);
+    earleyRecognizerp = NULL;
+    errno = errnoi;
+  }
+
+ done:
+  return earleyRecognizerp;
+}
+
+/****************************************************************************/
+void earleyRecognizer_freev(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+{
+  earleyAllocator_t *allocatorp;
+  size_t             l;
+
+  if (earleyRecognizerp != NULL) {
+    allocatorp = &(earleyRecognizerp->allocator);
+
+    if (earleyRecognizerp->setp != NULL) {
+      for (l = 0; l < earleyRecognizerp->setl; l++) {
+        if (earleyRecognizerp->setp[l].itemp != NULL) {
+          allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->setp[l].itemp);
+        }
+        if (earleyRecognizerp->setp[l].postdotip != NULL) {
+          allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->setp[l].postdotip);
+        }
+        if (earleyRecognizerp->setp[l].leop != NULL) {
+          allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->setp[l].leop);
+        }
+        if (earleyRecognizerp->setp[l].originSetlp != NULL) {
+          allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->setp[l].originSetlp);
+        }
+        if (earleyRecognizerp->setp[l].scanOriginSetlp != NULL) {
+          allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->setp[l].scanOriginSetlp);
+        }
+      }
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->setp);
+    }
+    if (earleyRecognizerp->freeSetlp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->freeSetlp);
+    }
+    if (earleyRecognizerp->tokenp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->tokenp);
+    }
+    if (earleyRecognizerp->scannedp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->scannedp);
+    }
+    if (earleyRecognizerp->hashp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->hashp);
+    }
+    if (earleyRecognizerp->hashSlotlp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->hashSlotlp);
+    }
+    if (earleyRecognizerp->groupp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->groupp);
+    }
+    if (earleyRecognizerp->groupSymbolip != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->groupSymbolip);
+    }
+    if (earleyRecognizerp->ruleDottedip != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->ruleDottedip);
+    }
+    if (earleyRecognizerp->dottedRuleip != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->dottedRuleip);
+    }
+    if (earleyRecognizerp->dottedPostdotip != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->dottedPostdotip);
+    }
+    if (earleyRecognizerp->dottedNextip != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->dottedNextip);
+    }
+    if (earleyRecognizerp->dottedCompletedbp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->dottedCompletedbp);
+    }
+    if (earleyRecognizerp->rowStamplp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->rowStamplp);
+    }
+    if (earleyRecognizerp->ruleStamplp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->ruleStamplp);
+    }
+    if (earleyRecognizerp->symbolStamplp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->symbolStamplp);
+    }
+    if (earleyRecognizerp->symbolCountip != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->symbolCountip);
+    }
+    if (earleyRecognizerp->expectedBitSetp != NULL) {
+      allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp->expectedBitSetp);
+    }
+
+    allocatorp->freep(allocatorp->userDatavp, earleyRecognizerp);
+  }
+}
+
+/****************************************************************************/
+short earleyRecognizer_resetb(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+/* Sets, tokens and the hash are emptied in place: their arrays are kept,  */
+/* and stamps keep increasing so that nothing has to be cleared.           */
+/****************************************************************************/
+{
+  if (earleyRecognizerp == NULL) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  if (! earleyRecognizer_grammarb(earleyRecognizerp)) {
+    return 0;
+  }
+
+  earleyRecognizerp->nSetl       = 0;
+  earleyRecognizerp->nFreeSetl   = 0;
+  earleyRecognizerp->currentSetl = 0;
+  earleyRecognizerp->openSetl    = 0;
+  earleyRecognizerp->earlemel    = 0;
+  earleyRecognizerp->nTokenl     = 0;
+  earleyRecognizerp->nReadl      = 0;
+  earleyRecognizerp->nScannedl   = 0;
+  earleyRecognizerp->acceptedb   = 0;
+  earleyRecognizerp->exhaustedb  = 0;
+  earleyRecognizerp->nResetl++;
+
+  return earleyRecognizer_startb(earleyRecognizerp);
+}
+
+/****************************************************************************/
+short earleyRecognizer_readb(earleyRecognizer_t *earleyRecognizerp, int symboli)
+/****************************************************************************/
+{
+  short rcb;
+
+  if (earleyRecognizerp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if ((! earleyRecognizer_grammarb(earleyRecognizerp)) ||
+      (! earleyRecognizer_token_checkb(earleyRecognizerp, symboli, 1))) {
+    goto err;
+  }
+
+  if (earleyRecognizer_postdot_findi(earleyRecognizerp->setp + earleyRecognizerp->currentSetl, symboli) < 0) {
+    /* Not expected: this is not an error */
+    errno = ENOENT;
+    goto err;
+  }
+
+  if (! earleyRecognizer_token_addb(earleyRecognizerp, symboli, 1)) {
+    goto err;
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyRecognizer_alternativesb(earleyRecognizer_t *earleyRecognizerp, earleyRecognizerAlternative_t *alternativep, size_t nAlternativel)
+/****************************************************************************/
+/* All alternatives are checked before anything is read, so that an error  */
+/* leaves the recognizer unchanged.                                         */
+/****************************************************************************/
+{
+  earleyRecognizerSet_t *setp;
+  size_t                 l;
+  short                  expectedb = 0;
+  short                  rcb;
+
+  if ((earleyRecognizerp == NULL) || ((alternativep == NULL) && (nAlternativel > 0))) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyRecognizer_grammarb(earleyRecognizerp)) {
+    goto err;
+  }
+
+  setp = earleyRecognizerp->setp + earleyRecognizerp->currentSetl;
+  for (l = 0; l < nAlternativel; l++) {
+    if (! earleyRecognizer_token_checkb(earleyRecognizerp, alternativep[l].symboli, alternativep[l].lengthl)) {
+      goto err;
+    }
+    if (earleyRecognizer_postdot_findi(setp, alternativep[l].symboli) >= 0) {
+      expectedb = 1;
+    }
+  }
+  if (! expectedb) {
+    /* Not expected: this is not an error */
+    errno = ENOENT;
+    goto err;
+  }
+
+  for (l = 0; l < nAlternativel; l++) {
+    if (earleyRecognizer_postdot_findi(setp, alternativep[l].symboli) < 0) {
+      continue;
+    }
+    if (! earleyRecognizer_token_addb(earleyRecognizerp, alternativep[l].symboli, alternativep[l].lengthl)) {
+      goto err;
+    }
+  }
+
+  rcb = earleyRecognizer_completeb(earleyRecognizerp);
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyRecognizer_completeb(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+{
+  short rcb;
+
+  if (earleyRecognizerp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyRecognizer_grammarb(earleyRecognizerp)) {
+    goto err;
+  }
+
+  if ((! earleyRecognizer_set_openb(earleyRecognizerp, earleyRecognizerp->earlemel + 1)) ||
+      (! earleyRecognizer_set_scanb(earleyRecognizerp)) ||
+      (! earleyRecognizer_set_processb(earleyRecognizerp)) ||
+      (! earleyRecognizer_set_freezeb(earleyRecognizerp))) {
+    goto err;
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyRecognizer_earlemeb(earleyRecognizer_t *earleyRecognizerp, size_t *earlemelp)
+/****************************************************************************/
+{
+  if (earleyRecognizerp == NULL) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  if (earlemelp != NULL) {
+    *earlemelp = earleyRecognizerp->earlemel;
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+short earleyRecognizer_acceptedb(earleyRecognizer_t *earleyRecognizerp, short *acceptedbp)
+/****************************************************************************/
+{
+  if (earleyRecognizerp == NULL) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  if (acceptedbp != NULL) {
+    *acceptedbp = earleyRecognizerp->acceptedb;
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+short earleyRecognizer_exhaustedb(earleyRecognizer_t *earleyRecognizerp, short *exhaustedbp)
+/****************************************************************************/
+{
+  if (earleyRecognizerp == NULL) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  if (exhaustedbp != NULL) {
+    *exhaustedbp = earleyRecognizerp->exhaustedb;
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+short earleyRecognizer_itemCountb(earleyRecognizer_t *earleyRecognizerp, size_t earlemel, size_t *itemlp)
+/****************************************************************************/
+{
+  short rcb;
+
+  if (earleyRecognizerp == NULL) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (earlemel > earleyRecognizerp->earlemel) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "Invalid earleme %lu\n", (unsigned long) earlemel);
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (earleyRecognizerp->option.recognizeOnlyb) {
+    if (earlemel != earleyRecognizerp->earlemel) {
+      EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "Earleme %lu is not kept when recognizing only\n", (unsigned long) earlemel);
+      errno = ENOENT;
+      goto err;
+    }
+    earlemel = earleyRecognizerp->currentSetl;
+  }
+
+  if (itemlp != NULL) {
+    *itemlp = (size_t) earleyRecognizerp->setp[earlemel].nItemi;
+  }
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+short earleyRecognizer_expectedTerminalsb(earleyRecognizer_t *earleyRecognizerp, const earleyGrammarBitWord_t **bitSetpp, size_t *wordlp)
+/****************************************************************************/
+{
+  if (earleyRecognizerp == NULL) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  if (bitSetpp != NULL) {
+    *bitSetpp = earleyRecognizerp->expectedBitSetp;
+  }
+  if (wordlp != NULL) {
+    *wordlp = EARLEYGRAMMAR_BITSET_WORDL(earleyRecognizerp->corep->nSymboli);
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+short earleyRecognizer_checkpointb(earleyRecognizer_t *earleyRecognizerp, earleyRecognizerCheckpoint_t *checkpointp)
+/****************************************************************************/
+{
+  if ((earleyRecognizerp == NULL) || (checkpointp == NULL)) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  if (earleyRecognizerp->option.recognizeOnlyb) {
+    EARLEYRECOGNIZER_ERROR(earleyRecognizerp, "Checkpoints are not available when recognizing only\n");
+    errno = EINVAL;
+    return 0;
+  }
+
+  checkpointp->earlemel = earleyRecognizerp->earlemel;
+  checkpointp->readl    = earleyRecognizerp->nReadl;
+  checkpointp->resetl   = earleyRecognizerp->nResetl;
+
+  return 1;
+}
+
+/****************************************************************************/
+short earleyRecognizer_rewindb(earleyRecognizer_t *earleyRecognizerp, earleyRecognizerCheckpoint_t *checkpointp)
+/****************************************************************************/
+/* Sets up to the checkpoint are never modified afterwards: the later ones  */
+/* are dropped, keeping their arrays. The hash only holds the items of the  */
+/* set being built, and is cleared when the next one is opened: there is    */
+/* nothing to undo there. Terminals read since the checkpoint are dropped,  */
+/* and those scanned since then are pending again: they all were at the     */
+/* checkpoint, so that there is room for them.                              */
+/****************************************************************************/
+{
+  earleyRecognizerToken_t *tokenp;
+  size_t                   nTokenl;
+  size_t                   l;
+  short                    rcb;
+
+  if ((earleyRecognizerp == NULL) || (checkpointp == NULL)) {
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (! earleyRecognizer_grammarb(earleyRecognizerp)) {
+    goto err;
+  }
+
+  if (earleyRecognizerp->option.recognizeOnlyb) {
+    EARLEYRECOGNIZER_ERROR(earleyRecognizerp, "Rewinding is not available when recognizing only\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  if (checkpointp->resetl != earleyRecognizerp->nResetl) {
+    EARLEYRECOGNIZER_ERROR(earleyRecognizerp, "Checkpoint is from before a reset\n");
+    errno = EINVAL;
+    goto err;
+  }
+
+  if ((checkpointp->earlemel > earleyRecognizerp->earlemel) || (checkpointp->readl > earleyRecognizerp->nReadl)) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "Invalid checkpoint at earleme %lu\n", (unsigned long) checkpointp->earlemel);
+    errno = EINVAL;
+    goto err;
+  }
+
+  nTokenl = 0;
+  for (l = 0; l < earleyRecognizerp->nTokenl; l++) {
+    if (earleyRecognizerp->tokenp[l].readl < checkpointp->readl) {
+      earleyRecognizerp->tokenp[nTokenl++] = earleyRecognizerp->tokenp[l];
+    }
+  }
+  while ((earleyRecognizerp->nScannedl > 0) && (earleyRecognizerp->scannedp[earleyRecognizerp->nScannedl - 1].endl > checkpointp->earlemel)) {
+    tokenp = earleyRecognizerp->scannedp + --earleyRecognizerp->nScannedl;
+    if (tokenp->readl < checkpointp->readl) {
+      earleyRecognizerp->tokenp[nTokenl++] = *tokenp;
+    }
+  }
+  earleyRecognizerp->nTokenl = nTokenl;
+  earleyRecognizerp->nReadl  = checkpointp->readl;
+
+  earleyRecognizerp->nSetl       = checkpointp->earlemel + 1;
+  earleyRecognizerp->currentSetl = checkpointp->earlemel;
+  earleyRecognizerp->openSetl    = checkpointp->earlemel;
+  earleyRecognizerp->earlemel    = checkpointp->earlemel;
+
+  if (! earleyGrammar_event_resetb(earleyRecognizerp->earleyGrammarp)) {
+    goto err;
+  }
+  earleyRecognizer_set_eventsv(earleyRecognizerp);
+
+  rcb = 1;
+  goto done;
+
+ err:
+  rcb = 0;
+
+ done:
+  return rcb;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_grammarb(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+/* The tables of the recognizer are those of the grammar at creation. An   */
+/* incremental precompute keeps the core but grows it: the generation      */
+/* tells.                                                                  */
+/****************************************************************************/
+{
+  earleyGrammar_t *earleyGrammarp = earleyRecognizerp->earleyGrammarp;
+
+  if ((! earleyGrammarp->precomputedb) ||
+      (earleyGrammarp->corep != earleyRecognizerp->corep) ||
+      (earleyGrammarp->corep->precomputeGenerationl != earleyRecognizerp->precomputeGenerationl)) {
+    EARLEYRECOGNIZER_ERROR(earleyRecognizerp, "Grammar changed since the recognizer was created\n");
+    errno = EINVAL;
+    return 0;
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_startb(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+/* Set 0 is the prediction of the start symbol. It is always kept, for     */
+/* acceptance.                                                             */
+/****************************************************************************/
+{
+  if ((! earleyRecognizer_set_openb(earleyRecognizerp, 0)) ||
+      (! earleyRecognizer_predictb(earleyRecognizerp, earleyRecognizerp->corep->startSymboli)) ||
+      (! earleyRecognizer_set_processb(earleyRecognizerp)) ||
+      (! earleyRecognizer_set_freezeb(earleyRecognizerp))) {
+    return 0;
+  }
+  if (earleyRecognizerp->option.recognizeOnlyb) {
+    earleyRecognizerp->setp[0].refcounti++;
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_token_checkb(earleyRecognizer_t *earleyRecognizerp, int symboli, size_t lengthl)
+/****************************************************************************/
+{
+  earleyGrammarCore_t *corep = earleyRecognizerp->corep;
+
+  if ((symboli < 0) || (symboli >= corep->nSymboli)) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "Invalid symbol %d\n", symboli);
+    errno = EINVAL;
+    return 0;
+  }
+  if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) == 0) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "Symbol %d is not a terminal\n", symboli);
+    errno = EINVAL;
+    return 0;
+  }
+  if ((lengthl == 0) || (lengthl > SIZE_MAX - earleyRecognizerp->earlemel)) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "Invalid length %lu\n", (unsigned long) lengthl);
+    errno = EINVAL;
+    return 0;
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_token_addb(earleyRecognizer_t *earleyRecognizerp, int symboli, size_t lengthl)
+/****************************************************************************/
+/* symboli is expected at the current earleme, whose set is kept until the */
+/* token is scanned.                                                        */
+/****************************************************************************/
+{
+  earleyRecognizerToken_t *tokenp;
+
+  if (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(earleyRecognizerp->tokenp), &(earleyRecognizerp->tokenl), earleyRecognizerp->nTokenl + 1, sizeof(earleyRecognizerToken_t))) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+  tokenp            = earleyRecognizerp->tokenp + earleyRecognizerp->nTokenl++;
+  tokenp->symboli   = symboli;
+  tokenp->startSetl = earleyRecognizerp->currentSetl;
+  tokenp->endl      = earleyRecognizerp->earlemel + lengthl;
+  tokenp->readl     = earleyRecognizerp->nReadl++;
+  if (earleyRecognizerp->option.recognizeOnlyb) {
+    earleyRecognizer_set_pinv(earleyRecognizerp, earleyRecognizerp->currentSetl);
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_set_openb(earleyRecognizer_t *earleyRecognizerp, size_t earlemel)
+/****************************************************************************/
+/* Set for earlemel, empty, and an empty hash. A recycled set is taken     */
+/* first, with its arrays.                                                  */
+/****************************************************************************/
+{
+  earleyRecognizerSet_t *setp;
+  size_t                 setl = earleyRecognizerp->setl;
+  size_t                 l;
+
+  if (earleyRecognizerp->nFreeSetl > 0) {
+    earleyRecognizerp->openSetl = earleyRecognizerp->freeSetlp[--earleyRecognizerp->nFreeSetl];
+  } else {
+    if (earleyRecognizerp->nSetl > EARLEYRECOGNIZER_SET_MAX) {
+      EARLEYRECOGNIZER_ERROR(earleyRecognizerp, "Too many Earley sets\n");
+      errno = ERANGE;
+      return 0;
+    }
+    if (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(earleyRecognizerp->setp), &(earleyRecognizerp->setl), earleyRecognizerp->nSetl + 1, sizeof(earleyRecognizerSet_t))) {
+      EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+      return 0;
+    }
+    if (earleyRecognizerp->setl > setl) {
+      memset(earleyRecognizerp->setp + setl, 0, (earleyRecognizerp->setl - setl) * sizeof(earleyRecognizerSet_t));
+    }
+    /* Releasing never fails: there is room for all the sets */
+    if (earleyRecognizerp->option.recognizeOnlyb) {
+      if (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(earleyRecognizerp->freeSetlp), &(earleyRecognizerp->freeSetl), earleyRecognizerp->nSetl + 1, sizeof(size_t))) {
+        EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+        return 0;
+      }
+    }
+    earleyRecognizerp->openSetl = earleyRecognizerp->nSetl++;
+  }
+
+  setp = earleyRecognizerp->setp + earleyRecognizerp->openSetl;
+  setp->nItemi      = 0;
+  setp->nPostdoti   = 0;
+  setp->earlemel    = earlemel;
+  setp->refcounti       = 0;
+  setp->pinCounti       = 0;
+  setp->refStampl       = 0;
+  setp->nOriginSetl     = 0;
+  setp->scanStampl      = 0;
+  setp->nScanOriginSetl = 0;
+  earleyRecognizerp->stampl++;
+
+  for (l = 0; l < earleyRecognizerp->nHashSlotl; l++) {
+    earleyRecognizerp->hashp[earleyRecognizerp->hashSlotlp[l]] = EARLEYRECOGNIZER_HASH_EMPTY;
+  }
+  earleyRecognizerp->nHashSlotl = 0;
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_set_refb(earleyRecognizer_t *earleyRecognizerp, size_t setl, size_t **setlpp, size_t *setlp, size_t *nSetlp)
+/****************************************************************************/
+/* References set setl from the open set, in the list of origin sets given */
+/* by setlpp, setlp and nSetlp.                                             */
+/****************************************************************************/
+{
+  if (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) setlpp, setlp, *nSetlp + 1, sizeof(size_t))) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+  (*setlpp)[(*nSetlp)++] = setl;
+  earleyRecognizerp->setp[setl].refcounti++;
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline void earleyRecognizer_set_releasev(earleyRecognizer_t *earleyRecognizerp, size_t setl)
+/****************************************************************************/
+/* Drops a reference to a set. A set without any is recycled, and drops    */
+/* the references to its origin sets: the recycled sets are the worklist.  */
+/****************************************************************************/
+{
+  earleyRecognizerSet_t *setp;
+  size_t                 firstl = earleyRecognizerp->nFreeSetl;
+  size_t                 l;
+  size_t                 i;
+
+  if (--earleyRecognizerp->setp[setl].refcounti > 0) {
+    return;
+  }
+  earleyRecognizerp->freeSetlp[earleyRecognizerp->nFreeSetl++] = setl;
+
+  for (l = firstl; l < earleyRecognizerp->nFreeSetl; l++) {
+    setp = earleyRecognizerp->setp + earleyRecognizerp->freeSetlp[l];
+    for (i = 0; i < setp->nOriginSetl; i++) {
+      if (--earleyRecognizerp->setp[setp->originSetlp[i]].refcounti == 0) {
+        earleyRecognizerp->freeSetlp[earleyRecognizerp->nFreeSetl++] = setp->originSetlp[i];
+      }
+    }
+  }
+}
+
+/****************************************************************************/
+static inline void earleyRecognizer_set_pinv(earleyRecognizer_t *earleyRecognizerp, size_t setl)
+/****************************************************************************/
+/* The set is current, or the start of a pending token: its items can be   */
+/* scanned.                                                                 */
+/****************************************************************************/
+{
+  earleyRecognizerp->setp[setl].pinCounti++;
+  earleyRecognizerp->setp[setl].refcounti++;
+}
+
+/****************************************************************************/
+static inline void earleyRecognizer_set_unpinv(earleyRecognizer_t *earleyRecognizerp, size_t setl)
+/****************************************************************************/
+/* The last pin drops the origin sets of the items expecting a terminal,   */
+/* that nothing will ever scan.                                             */
+/****************************************************************************/
+{
+  earleyRecognizerSet_t *setp = earleyRecognizerp->setp + setl;
+  size_t                 i;
+
+  if (--setp->pinCounti == 0) {
+    for (i = 0; i < setp->nScanOriginSetl; i++) {
+      earleyRecognizer_set_releasev(earleyRecognizerp, setp->scanOriginSetlp[i]);
+    }
+    setp->nScanOriginSetl = 0;
+  }
+  earleyRecognizer_set_releasev(earleyRecognizerp, setl);
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_set_scanb(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+/* Scanning: the tokens ending at the open set move there the items of     */
+/* their start set that expect them. They are dropped once the open set is */
+/* frozen, so that their start sets are kept until then.                   */
+/****************************************************************************/
+{
+  size_t                   earlemel = earleyRecognizerp->setp[earleyRecognizerp->openSetl].earlemel;
+  earleyRecognizerToken_t *tokenp;
+  earleyRecognizerSet_t   *setp;
+  earleyRecognizerItem_t   iteml;
+  size_t                   l;
+  int                      groupi;
+  int                      firsti;
+  int                      endi;
+  int                      i;
+
+  for (l = 0; l < earleyRecognizerp->nTokenl; l++) {
+    tokenp = earleyRecognizerp->tokenp + l;
+    if (tokenp->endl != earlemel) {
+      continue;
+    }
+    setp   = earleyRecognizerp->setp + tokenp->startSetl;
+    groupi = earleyRecognizer_postdot_findi(setp, tokenp->symboli);
+    earleyRecognizer_postdot_rangev(setp, groupi, &firsti, &endi);
+    for (i = firsti; i < endi; i++) {
+      iteml = setp->itemp[i];
+      if (! earleyRecognizer_item_addb(earleyRecognizerp, earleyRecognizerp->dottedNextip[EARLEYRECOGNIZER_ITEM_DOTTEDI(iteml)], EARLEYRECOGNIZER_ITEM_ORIGINL(iteml), 1)) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_set_processb(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+/* The open set is its own worklist. Items with the dot moved over nullable */
+/* symbols are added with the others (Aycock and Horspool), and this makes  */
+/* items originating in the open set needless to look at: their completion */
+/* is already there, and their predictions are in the closure of the        */
+/* prediction that made them. A sequence item can both complete and        */
+/* predict.                                                                 */
+/****************************************************************************/
+{
+  size_t                  openl = earleyRecognizerp->openSetl;
+  earleyRecognizerSet_t  *setp  = earleyRecognizerp->setp + openl;
+  earleyRecognizerItem_t  iteml;
+  size_t                  originl;
+  int                     dottedi;
+  int                     symboli;
+  int                     i;
+
+  for (i = 0; i < setp->nItemi; i++) {
+    iteml   = setp->itemp[i];
+    originl = EARLEYRECOGNIZER_ITEM_ORIGINL(iteml);
+    if (originl == openl) {
+      continue;
+    }
+    dottedi = EARLEYRECOGNIZER_ITEM_DOTTEDI(iteml);
+    if (earleyRecognizerp->dottedCompletedbp[dottedi]) {
+      if (! earleyRecognizer_completeSymbolb(earleyRecognizerp, earleyRecognizerp->corep->ruleLhsSymbolip[earleyRecognizerp->dottedRuleip[dottedi]], originl)) {
+        return 0;
+      }
+    }
+    symboli = earleyRecognizerp->dottedPostdotip[dottedi];
+    if (symboli >= 0) {
+      if (! earleyRecognizer_predictb(earleyRecognizerp, symboli)) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_set_freezeb(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+/* The open set becomes the current one. Its items are grouped by postdot  */
+/* symbol with a counting sort, and what happened there is triggered.      */
+/****************************************************************************/
+{
+  earleyGrammar_t        *earleyGrammarp = earleyRecognizerp->earleyGrammarp;
+  earleyGrammarCore_t    *corep          = earleyRecognizerp->corep;
+  size_t                  openl          = earleyRecognizerp->openSetl;
+  earleyRecognizerSet_t  *setp           = earleyRecognizerp->setp + openl;
+  size_t                  stampl         = earleyRecognizerp->stampl;
+  earleyRecognizerSet_t  *refSetp;
+  earleyRecognizerSet_t  *originSetp;
+  earleyGrammarBitWord_t *completedMaskp;
+  earleyRecognizerItem_t  iteml;
+  size_t                  originl;
+  size_t                  nTokenl;
+  size_t                  l;
+  int                     nGroupi = 0;
+  int                     groupi;
+  int                     keyi;
+  int                     firsti;
+  int                     endi;
+  int                     counti;
+  int                     dottedi;
+  int                     rulei;
+  int                     symboli;
+  int                     i;
+
+  if (! earleyGrammar_event_resetb(earleyGrammarp)) {
+    return 0;
+  }
+
+  /* Group sizes. Key 0 is for items without postdot symbol, key s+1 for  */
+  /* postdot symbol s. When recognizing only, the set keeps the origin     */
+  /* sets of the items with a postdot symbol: only they can be moved to a  */
+  /* later set. Those of the items expecting a terminal are kept apart,    */
+  /* for as long as the set is pinned.                                     */
+  for (i = 0; i < setp->nItemi; i++) {
+    iteml   = setp->itemp[i];
+    dottedi = EARLEYRECOGNIZER_ITEM_DOTTEDI(iteml);
+    originl = EARLEYRECOGNIZER_ITEM_ORIGINL(iteml);
+    keyi    = earleyRecognizerp->dottedPostdotip[dottedi] + 1;
+    if (earleyRecognizerp->option.recognizeOnlyb && (keyi > 0) && (originl != openl)) {
+      refSetp = earleyRecognizerp->setp + originl;
+      if ((corep->symbolPropertyBitSetip[keyi - 1] & EARLEY_SYMBOL_IS_TERMINAL) == 0) {
+        if (refSetp->refStampl != stampl) {
+          refSetp->refStampl = stampl;
+          if (! earleyRecognizer_set_refb(earleyRecognizerp, originl, &(setp->originSetlp), &(setp->originSetl), &(setp->nOriginSetl))) {
+            return 0;
+          }
+        }
+      } else if (refSetp->scanStampl != stampl) {
+        refSetp->scanStampl = stampl;
+        if (! earleyRecognizer_set_refb(earleyRecognizerp, originl, &(setp->scanOriginSetlp), &(setp->scanOriginSetl), &(setp->nScanOriginSetl))) {
+          return 0;
+        }
+      }
+    }
+    if (earleyRecognizerp->symbolStamplp[keyi] != stampl) {
+      earleyRecognizerp->symbolStamplp[keyi] = stampl;
+      earleyRecognizerp->symbolCountip[keyi] = 0;
+      if (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(earleyRecognizerp->groupSymbolip), &(earleyRecognizerp->groupSymboll), (size_t) nGroupi + 1, sizeof(int))) {
+        EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+        return 0;
+      }
+      earleyRecognizerp->groupSymbolip[nGroupi++] = keyi;
+    }
+    earleyRecognizerp->symbolCountip[keyi]++;
+  }
+  if (nGroupi > 1) {
+    qsort(earleyRecognizerp->groupSymbolip, (size_t) nGroupi, sizeof(int), earleyRecognizer_group_cmpi);
+  }
+
+  /* Group starts, the counts becoming the write positions */
+  if ((! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(setp->postdotip), &(setp->postdotl), 2 * (size_t) nGroupi + 1, sizeof(int))) ||
+      (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(earleyRecognizerp->groupp), &(earleyRecognizerp->groupl), (size_t) setp->nItemi + 1, sizeof(earleyRecognizerItem_t)))) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+  setp->nPostdoti = 0;
+  firsti          = 0;
+  for (i = 0; i < nGroupi; i++) {
+    keyi   = earleyRecognizerp->groupSymbolip[i];
+    counti = earleyRecognizerp->symbolCountip[keyi];
+    earleyRecognizerp->symbolCountip[keyi] = firsti;
+    if (keyi > 0) {
+      setp->postdotip[2 * setp->nPostdoti]     = keyi - 1;
+      setp->postdotip[2 * setp->nPostdoti + 1] = firsti;
+      setp->nPostdoti++;
+    }
+    firsti += counti;
+  }
+  for (i = 0; i < setp->nItemi; i++) {
+    iteml = setp->itemp[i];
+    keyi  = earleyRecognizerp->dottedPostdotip[EARLEYRECOGNIZER_ITEM_DOTTEDI(iteml)] + 1;
+    earleyRecognizerp->groupp[earleyRecognizerp->symbolCountip[keyi]++] = iteml;
+  }
+  /* The grouped items are copied back rather than swapped with the      */
+  /* scratch: each set keeps its own array, and its capacity, e.g. for   */
+  /* the next parse after a reset.                                       */
+  if (setp->nItemi > 0) {
+    memcpy(setp->itemp, earleyRecognizerp->groupp, (size_t) setp->nItemi * sizeof(earleyRecognizerItem_t));
+  }
+
+  /* Leo items. A deterministic reduction has its dot before the last RHS */
+  /* symbol and originates in an earlier set: the top of its chain is the  */
+  /* Leo item of its LHS there, if any, else itself completed. The chain   */
+  /* skips the completions of its LHS: this is not done when they must be  */
+  /* seen, i.e. for completion events. A sequence always expects more.     */
+  if (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(setp->leop), &(setp->leol), (size_t) setp->nPostdoti + 1, sizeof(earleyRecognizerItem_t))) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+  completedMaskp = earleyGrammarp->eventBitSetp + EARLEYGRAMMAR_EVENT_COMPLETED * EARLEYGRAMMAR_BITSET_WORDL(earleyGrammarp->nEventSymboli);
+  for (i = 0; i < setp->nPostdoti; i++) {
+    setp->leop[i] = EARLEYRECOGNIZER_ITEM_NONE;
+    earleyRecognizer_postdot_rangev(setp, i, &firsti, &endi);
+    if (endi - firsti != 1) {
+      continue;
+    }
+    iteml   = setp->itemp[firsti];
+    dottedi = EARLEYRECOGNIZER_ITEM_DOTTEDI(iteml);
+    originl = EARLEYRECOGNIZER_ITEM_ORIGINL(iteml);
+    dottedi = earleyRecognizerp->dottedNextip[dottedi];
+    if ((originl == openl) || (earleyRecognizerp->dottedPostdotip[dottedi] >= 0)) {
+      continue;
+    }
+    rulei   = earleyRecognizerp->dottedRuleip[dottedi];
+    symboli = corep->ruleLhsSymbolip[rulei];
+    if (EARLEYGRAMMAR_BITSET_GETB(completedMaskp, symboli)) {
+      continue;
+    }
+    originSetp = earleyRecognizerp->setp + originl;
+    groupi     = earleyRecognizer_postdot_findi(originSetp, symboli);
+    if ((groupi >= 0) && (originSetp->leop[groupi] != EARLEYRECOGNIZER_ITEM_NONE)) {
+      setp->leop[i] = originSetp->leop[groupi];
+    } else {
+      setp->leop[i] = EARLEYRECOGNIZER_ITEM(dottedi, originl);
+    }
+  }
+
+  /* Scanned tokens are dropped. When recognizing only, this unpins their */
+  /* start sets, and the previous current set is unpinned for the new     */
+  /* one. Otherwise they are kept by earleme, for rewinding.               */
+  if ((! earleyRecognizerp->option.recognizeOnlyb) &&
+      (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(earleyRecognizerp->scannedp), &(earleyRecognizerp->scannedl), earleyRecognizerp->nScannedl + earleyRecognizerp->nTokenl, sizeof(earleyRecognizerToken_t)))) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+  nTokenl = 0;
+  for (l = 0; l < earleyRecognizerp->nTokenl; l++) {
+    if (earleyRecognizerp->tokenp[l].endl != setp->earlemel) {
+      earleyRecognizerp->tokenp[nTokenl++] = earleyRecognizerp->tokenp[l];
+    } else if (earleyRecognizerp->option.recognizeOnlyb) {
+      earleyRecognizer_set_unpinv(earleyRecognizerp, earleyRecognizerp->tokenp[l].startSetl);
+    } else {
+      earleyRecognizerp->scannedp[earleyRecognizerp->nScannedl++] = earleyRecognizerp->tokenp[l];
+    }
+  }
+  earleyRecognizerp->nTokenl = nTokenl;
+  if (earleyRecognizerp->option.recognizeOnlyb) {
+    earleyRecognizer_set_pinv(earleyRecognizerp, openl);
+    if (earleyRecognizerp->currentSetl != openl) {
+      earleyRecognizer_set_unpinv(earleyRecognizerp, earleyRecognizerp->currentSetl);
+    }
+  }
+
+  earleyRecognizerp->earlemel    = setp->earlemel;
+  earleyRecognizerp->currentSetl = openl;
+  earleyRecognizer_set_eventsv(earleyRecognizerp);
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline void earleyRecognizer_set_eventsv(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+/* What happened in the current set, whose events were reset: completions, */
+/* acceptance, and expected symbols. A nullable postdot symbol was also    */
+/* skipped, i.e. nulled there. Expected terminals, and tokens still to be  */
+/* scanned, keep the recognizer going. The postdot groups are the expected */
+/* symbols: the expected terminals bitset is refilled from them.           */
+/****************************************************************************/
+{
+  earleyGrammar_t       *earleyGrammarp = earleyRecognizerp->earleyGrammarp;
+  earleyGrammarCore_t   *corep          = earleyRecognizerp->corep;
+  size_t                 currentl       = earleyRecognizerp->currentSetl;
+  earleyRecognizerSet_t *setp           = earleyRecognizerp->setp + currentl;
+  earleyRecognizerItem_t iteml;
+  size_t                 originl;
+  int                    dottedi;
+  int                    symboli;
+  int                    i;
+
+  earleyRecognizerp->acceptedb = 0;
+  for (i = 0; i < setp->nItemi; i++) {
+    iteml   = setp->itemp[i];
+    dottedi = EARLEYRECOGNIZER_ITEM_DOTTEDI(iteml);
+    if (! earleyRecognizerp->dottedCompletedbp[dottedi]) {
+      continue;
+    }
+    originl = EARLEYRECOGNIZER_ITEM_ORIGINL(iteml);
+    symboli = corep->ruleLhsSymbolip[earleyRecognizerp->dottedRuleip[dottedi]];
+    if (originl != currentl) {
+      earleyGrammar_event_triggerv(earleyGrammarp, EARLEYGRAMMAR_EVENT_COMPLETED, symboli);
+    }
+    if ((originl == 0) && (symboli == corep->startSymboli)) {
+      earleyRecognizerp->acceptedb = 1;
+    }
+  }
+
+  earleyRecognizerp->exhaustedb = (earleyRecognizerp->nTokenl == 0);
+  memset(earleyRecognizerp->expectedBitSetp, 0, EARLEYGRAMMAR_BITSET_WORDL(corep->nSymboli) * sizeof(earleyGrammarBitWord_t));
+  for (i = 0; i < setp->nPostdoti; i++) {
+    symboli = setp->postdotip[2 * i];
+    earleyGrammar_event_triggerv(earleyGrammarp, EARLEYGRAMMAR_EVENT_EXPECTED, symboli);
+    if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_NULLABLE) != 0) {
+      earleyGrammar_event_triggerv(earleyGrammarp, EARLEYGRAMMAR_EVENT_NULLED, symboli);
+    }
+    if ((corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_TERMINAL) != 0) {
+      earleyRecognizerp->expectedBitSetp[symboli / EARLEYGRAMMAR_BITWORD_BITS] |= ((earleyGrammarBitWord_t) 1) << (symboli % EARLEYGRAMMAR_BITWORD_BITS);
+      earleyRecognizerp->exhaustedb = 0;
+    }
+  }
+  if (earleyRecognizerp->exhaustedb) {
+    earleyGrammar_event_exhaustedv(earleyGrammarp);
+  }
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_predictb(earleyRecognizer_t *earleyRecognizerp, int symboli)
+/****************************************************************************/
+/* The precomputed prediction row of symboli is the whole closure: it is   */
+/* applied once per set, and a rule is predicted once per set.             */
+/****************************************************************************/
+{
+  earleyGrammarCore_t          *corep  = earleyRecognizerp->corep;
+  size_t                        stampl = earleyRecognizerp->stampl;
+  size_t                        wordl  = EARLEYGRAMMAR_BITSET_WORDL(corep->nRulei);
+  int                           rowi   = corep->symbolPredictionRowip[symboli];
+  const earleyGrammarBitWord_t *rowp;
+  earleyGrammarBitWord_t        bitWordl;
+  size_t                        l;
+  int                           rulei;
+
+  if ((rowi == corep->nPredictionRowi - 1) || (earleyRecognizerp->rowStamplp[rowi] == stampl)) {
+    return 1;
+  }
+  earleyRecognizerp->rowStamplp[rowi] = stampl;
+
+  rowp = corep->predictionp + (size_t) rowi * wordl;
+  for (l = 0; l < wordl; l++) {
+    bitWordl = rowp[l];
+    while (bitWordl != 0) {
+      rulei     = (int) (l * EARLEYGRAMMAR_BITWORD_BITS) + earleyGrammar_bitWord_lowi(bitWordl);
+      bitWordl &= bitWordl - 1;
+      if (earleyRecognizerp->ruleStamplp[rulei] == stampl) {
+        continue;
+      }
+      earleyRecognizerp->ruleStamplp[rulei] = stampl;
+      if (! earleyRecognizer_item_addb(earleyRecognizerp, earleyRecognizerp->ruleDottedip[rulei], earleyRecognizerp->openSetl, corep->ruleOptionp[rulei].sequenceb)) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_completeSymbolb(earleyRecognizer_t *earleyRecognizerp, int symboli, size_t originl)
+/****************************************************************************/
+/* symboli was completed from originl: the items of that set expecting it  */
+/* move in the open set, or the top of the chain when that is a Leo item.  */
+/* This is done once per (symbol, origin), that is remembered in the hash  */
+/* as an item past the dotted rules.                                       */
+/****************************************************************************/
+{
+  earleyRecognizerSet_t  *setp = earleyRecognizerp->setp + originl;
+  earleyRecognizerItem_t  iteml;
+  int                     groupi;
+  int                     firsti;
+  int                     endi;
+  int                     i;
+  short                   newb;
+
+  if (! earleyRecognizer_hash_insertb(earleyRecognizerp, EARLEYRECOGNIZER_ITEM(earleyRecognizerp->nDottedi + symboli, originl), &newb)) {
+    return 0;
+  }
+  if (! newb) {
+    return 1;
+  }
+  groupi = earleyRecognizer_postdot_findi(setp, symboli);
+  if (groupi < 0) {
+    return 1;
+  }
+
+  if (setp->leop[groupi] != EARLEYRECOGNIZER_ITEM_NONE) {
+    iteml = setp->leop[groupi];
+    return earleyRecognizer_item_addb(earleyRecognizerp, EARLEYRECOGNIZER_ITEM_DOTTEDI(iteml), EARLEYRECOGNIZER_ITEM_ORIGINL(iteml), 1);
+  }
+
+  earleyRecognizer_postdot_rangev(setp, groupi, &firsti, &endi);
+
+  for (i = firsti; i < endi; i++) {
+    iteml = setp->itemp[i];
+    if (! earleyRecognizer_item_addb(earleyRecognizerp, earleyRecognizerp->dottedNextip[EARLEYRECOGNIZER_ITEM_DOTTEDI(iteml)], EARLEYRECOGNIZER_ITEM_ORIGINL(iteml), 1)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_item_addb(earleyRecognizer_t *earleyRecognizerp, int dottedi, size_t originl, short hashb)
+/****************************************************************************/
+/* Adds an item to the open set, and the ones with the dot moved over the  */
+/* nullable symbols that follow. Predictions are known to be new and skip  */
+/* the hash: they are the only items originating in the open set. This is */
+/* not true of sequences, whose states can move back to each other.        */
+/****************************************************************************/
+{
+  earleyRecognizerSet_t  *setp = earleyRecognizerp->setp + earleyRecognizerp->openSetl;
+  earleyRecognizerItem_t  iteml;
+  int                     symboli;
+  short                   newb;
+
+  for (;;) {
+    iteml = EARLEYRECOGNIZER_ITEM(dottedi, originl);
+    if (hashb) {
+      if (! earleyRecognizer_hash_insertb(earleyRecognizerp, iteml, &newb)) {
+        return 0;
+      }
+      if (! newb) {
+        return 1;
+      }
+    }
+    if (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(setp->itemp), &(setp->iteml), (size_t) setp->nItemi + 1, sizeof(earleyRecognizerItem_t))) {
+      EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+      return 0;
+    }
+    setp->itemp[setp->nItemi++] = iteml;
+
+    symboli = earleyRecognizerp->dottedPostdotip[dottedi];
+    if ((symboli < 0) || ((earleyRecognizerp->corep->symbolPropertyBitSetip[symboli] & EARLEY_SYMBOL_IS_NULLABLE) == 0)) {
+      return 1;
+    }
+    dottedi = earleyRecognizerp->dottedNextip[dottedi];
+  }
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_hash_insertb(earleyRecognizer_t *earleyRecognizerp, earleyRecognizerItem_t iteml, short *newbp)
+/****************************************************************************/
+/* Linear probing, at most half full                                        */
+/****************************************************************************/
+{
+  size_t maskl;
+  size_t slotl;
+
+  if ((earleyRecognizerp->nHashSlotl + 1) * 2 > earleyRecognizerp->hashl) {
+    if (! earleyRecognizer_hash_growb(earleyRecognizerp)) {
+      return 0;
+    }
+  }
+  if (! earleyGrammar_scratch_reserveb(&(earleyRecognizerp->allocator), (void **) &(earleyRecognizerp->hashSlotlp), &(earleyRecognizerp->hashSlotl), earleyRecognizerp->nHashSlotl + 1, sizeof(size_t))) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "realloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+
+  maskl = earleyRecognizerp->hashl - 1;
+  slotl = (size_t) earleyGrammar_hash_mixl(iteml) & maskl;
+  while (earleyRecognizerp->hashp[slotl] != EARLEYRECOGNIZER_HASH_EMPTY) {
+    if (earleyRecognizerp->hashp[slotl] == iteml) {
+      *newbp = 0;
+      return 1;
+    }
+    slotl = (slotl + 1) & maskl;
+  }
+  earleyRecognizerp->hashp[slotl] = iteml;
+  earleyRecognizerp->hashSlotlp[earleyRecognizerp->nHashSlotl++] = slotl;
+  *newbp = 1;
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline short earleyRecognizer_hash_growb(earleyRecognizer_t *earleyRecognizerp)
+/****************************************************************************/
+{
+  earleyAllocator_t      *allocatorp = &(earleyRecognizerp->allocator);
+  earleyRecognizerItem_t *oldHashp   = earleyRecognizerp->hashp;
+  earleyRecognizerItem_t *hashp;
+  earleyRecognizerItem_t  iteml;
+  size_t                  hashl;
+  size_t                  maskl;
+  size_t                  slotl;
+  size_t                  l;
+
+  hashl = (earleyRecognizerp->hashl > 0) ? 2 * earleyRecognizerp->hashl : EARLEYRECOGNIZER_HASH_START_SLOTL;
+  if (hashl > SIZE_MAX / sizeof(earleyRecognizerItem_t)) {
+    errno = ENOMEM;
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "malloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+  hashp = (earleyRecognizerItem_t *) allocatorp->mallocp(allocatorp->userDatavp, hashl * sizeof(earleyRecognizerItem_t));
+  if (hashp == NULL) {
+    EARLEYRECOGNIZER_ERRORF(earleyRecognizerp, "malloc failure, %s\n", strerror(errno));
+    return 0;
+  }
+  /* All bits set is the empty slot */
+  memset(hashp, 0xFF, hashl * sizeof(earleyRecognizerItem_t));
+
+  maskl = hashl - 1;
+  for (l = 0; l < earleyRecognizerp->nHashSlotl; l++) {
+    iteml = oldHashp[earleyRecognizerp->hashSlotlp[l]];
+    slotl = (size_t) earleyGrammar_hash_mixl(iteml) & maskl;
+    while (hashp[slotl] != EARLEYRECOGNIZER_HASH_EMPTY) {
+      slotl = (slotl + 1) & maskl;
+    }
+    hashp[slotl] = iteml;
+    earleyRecognizerp->hashSlotlp[l] = slotl;
+  }
+
+  if (oldHashp != NULL) {
+    allocatorp->freep(allocatorp->userDatavp, oldHashp);
+  }
+  earleyRecognizerp->hashp = hashp;
+  earleyRecognizerp->hashl = hashl;
+
+  return 1;
+}
+
+/****************************************************************************/
+static inline int earleyRecognizer_postdot_findi(earleyRecognizerSet_t *setp, int symboli)
+/****************************************************************************/
+/* Group of the items of a frozen set expecting symboli, -1 when none      */
+/****************************************************************************/
+{
+  int lowi  = 0;
+  int highi = setp->nPostdoti;
+  int midi;
+
+  while (lowi < highi) {
+    midi = lowi + (highi - lowi) / 2;
+    if (setp->postdotip[2 * midi] < symboli) {
+      lowi = midi + 1;
+    } else {
+      highi = midi;
+    }
+  }
+
+  return ((lowi < setp->nPostdoti) && (setp->postdotip[2 * lowi] == symboli)) ? lowi : -1;
+}
+
+/****************************************************************************/
+static inline void earleyRecognizer_postdot_rangev(earleyRecognizerSet_t *setp, int groupi, int *firstip, int *endip)
+/****************************************************************************/
+/* Items of a group are [*firstip, *endip[                                  */
+/****************************************************************************/
+{
+  *firstip = setp->postdotip[2 * groupi + 1];
+  *endip   = (groupi + 1 < setp->nPostdoti) ? setp->postdotip[2 * (groupi + 1) + 1] : setp->nItemi;
+}
+
+/****************************************************************************/
+static inline int earleyRecognizer_group_cmpi(const void *p1, const void *p2)
+/****************************************************************************/
+{
+  int key1i = *((const int *) p1);
+  int key2i = *((const int *) p2);
+
+  return (key1i < key2i) ? -1 : ((key1i > key2i) ? 1 : 0);
+}
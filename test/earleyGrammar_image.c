@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earley.h"
+
+/* A saved grammar, loaded back and cloned, must be the same as the original one: same */
+/* symbols, rules, properties and events. Modifying the loaded grammar must not change */
+/* its clone, and a damaged image must be rejected.                                    */
+#define IMAGE_PATH "earleyGrammar_image.bin"
+
+static short sameb(genericLogger_t *loggerp, const char *whatp, earleyGrammar_t *earleyGrammarp, earleyGrammar_t *referencep, int nSymboli, int nRulei);
+static short damageb(genericLogger_t *loggerp, short truncateb);
+
+int main() {
+  genericLogger_t       *loggerp;
+  earleyGrammar_t       *earleyGrammarp = NULL;
+  earleyGrammar_t       *loadedp        = NULL;
+  earleyGrammar_t       *clonep         = NULL;
+  earleyGrammar_t       *damagedp       = NULL;
+  earleyGrammarOption_t  earleyGrammarOption;
+  int                    Ss, As, Bs, as, bs, cs, ds;
+  int                    nSymboli;
+  int                    nRulei;
+  int                    rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  memset(&earleyGrammarOption, 0, sizeof(earleyGrammarOption));
+  earleyGrammarOption.genericLoggerp = loggerp;
+
+  /* S ::= A B | S d, A ::= a | <empty>, B ::= b+ properly separated by c */
+  earleyGrammarp = earleyGrammar_newp(&earleyGrammarOption);
+  if (earleyGrammarp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+    goto err;
+  }
+  Ss = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 1, EARLEYGRAMMAR_EVENTTYPE_NONE);
+  As = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, EARLEYGRAMMAR_EVENTTYPE_COMPLETION | EARLEYGRAMMAR_EVENTTYPE_NULLED);
+  Bs = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, EARLEYGRAMMAR_EVENTTYPE_PREDICTION);
+  as = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, EARLEYGRAMMAR_EVENTTYPE_NONE);
+  bs = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, EARLEYGRAMMAR_EVENTTYPE_NONE);
+  cs = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, EARLEYGRAMMAR_EVENTTYPE_NONE);
+  ds = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, EARLEYGRAMMAR_EVENTTYPE_NONE);
+  if ((EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ss, As, Bs, -1) < 0)
+      || (earleyGrammar_newRuleExti(earleyGrammarp, 1, 0, Ss, Ss, ds, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, As, as, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, As, -1) < 0)
+      || (earleyGrammar_newSequenceExti(earleyGrammarp, 0, 0, Bs, bs, 1, cs, 1) < 0)
+      || (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Grammar failure, %s", strerror(errno));
+    goto err;
+  }
+  nSymboli = ds + 1;
+  nRulei   = 5;
+
+  if (! earleyGrammar_saveb(earleyGrammarp, IMAGE_PATH)) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_saveb failure, %s", strerror(errno));
+    goto err;
+  }
+  loadedp = earleyGrammar_loadp(IMAGE_PATH, &earleyGrammarOption);
+  if (loadedp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_loadp failure, %s", strerror(errno));
+    goto err;
+  }
+  if (! sameb(loggerp, "Loaded grammar", loadedp, earleyGrammarp, nSymboli, nRulei)) {
+    goto err;
+  }
+
+  clonep = earleyGrammar_clonep(loadedp, NULL);
+  if (clonep == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_clonep failure, %s", strerror(errno));
+    goto err;
+  }
+  if (! sameb(loggerp, "Clone", clonep, earleyGrammarp, nSymboli, nRulei)) {
+    goto err;
+  }
+
+  /* The loaded grammar gets its own tables: the clone still shares the image */
+  if ((EARLEYGRAMMAR_NEWRULE(loadedp, Bs, ds, -1) < 0) || (! earleyGrammar_precomputeb(loadedp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Loaded grammar modification failure, %s", strerror(errno));
+    goto err;
+  }
+  if ((! sameb(loggerp, "Modified loaded grammar", loadedp, earleyGrammarp, nSymboli, nRulei))
+      || (! sameb(loggerp, "Clone after a modification of its origin", clonep, earleyGrammarp, nSymboli, nRulei))) {
+    goto err;
+  }
+  if (earleyGrammar_ruleRhsb(clonep, nRulei, NULL, NULL) || (errno != ENOENT)) {
+    GENERICLOGGER_ERROR(loggerp, "The clone sees the rule added to its origin");
+    goto err;
+  }
+
+  /* A damaged table, then a truncated image */
+  if (! damageb(loggerp, 0)) {
+    goto err;
+  }
+  damagedp = earleyGrammar_loadp(IMAGE_PATH, &earleyGrammarOption);
+  if ((damagedp != NULL) || (errno != EINVAL)) {
+    GENERICLOGGER_ERROR(loggerp, "A damaged image is loaded");
+    goto err;
+  }
+  if ((! earleyGrammar_saveb(earleyGrammarp, IMAGE_PATH)) || (! damageb(loggerp, 1))) {
+    goto err;
+  }
+  damagedp = earleyGrammar_loadp(IMAGE_PATH, &earleyGrammarOption);
+  if ((damagedp != NULL) || (errno != EINVAL)) {
+    GENERICLOGGER_ERROR(loggerp, "A truncated image is loaded");
+    goto err;
+  }
+
+  rci = 0;
+
+ err:
+  if (damagedp != NULL) {
+    earleyGrammar_freev(damagedp);
+  }
+  if (clonep != NULL) {
+    earleyGrammar_freev(clonep);
+  }
+  if (loadedp != NULL) {
+    earleyGrammar_freev(loadedp);
+  }
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  remove(IMAGE_PATH);
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
+
+/* Compares the first nSymboli symbols and nRulei rules */
+static short sameb(genericLogger_t *loggerp, const char *whatp, earleyGrammar_t *earleyGrammarp, earleyGrammar_t *referencep, int nSymboli, int nRulei) {
+  int        propertyi, referencePropertyi;
+  int        eventi, referenceEventi;
+  size_t     rhsl, referenceRhsl;
+  const int *rhsip;
+  const int *referenceRhsip;
+  int        i;
+
+  for (i = 0; i < nSymboli; i++) {
+    if ((! earleyGrammar_symbolPropertyb(earleyGrammarp, i, &propertyi)) || (! earleyGrammar_symbolPropertyb(referencep, i, &referencePropertyi))
+        || (! earleyGrammar_symbolEventb(earleyGrammarp, i, &eventi)) || (! earleyGrammar_symbolEventb(referencep, i, &referenceEventi))) {
+      GENERICLOGGER_ERRORF(loggerp, "%s: symbol %d query failure, %s", whatp, i, strerror(errno));
+      return 0;
+    }
+    if ((propertyi != referencePropertyi) || (eventi != referenceEventi)) {
+      GENERICLOGGER_ERRORF(loggerp, "%s: symbol %d differs", whatp, i);
+      return 0;
+    }
+  }
+  for (i = 0; i < nRulei; i++) {
+    if ((! earleyGrammar_rulePropertyb(earleyGrammarp, i, &propertyi)) || (! earleyGrammar_rulePropertyb(referencep, i, &referencePropertyi))
+        || (! earleyGrammar_ruleRhsb(earleyGrammarp, i, &rhsl, &rhsip)) || (! earleyGrammar_ruleRhsb(referencep, i, &referenceRhsl, &referenceRhsip))) {
+      GENERICLOGGER_ERRORF(loggerp, "%s: rule %d query failure, %s", whatp, i, strerror(errno));
+      return 0;
+    }
+    if ((propertyi != referencePropertyi) || (rhsl != referenceRhsl) || ((rhsl > 0) && (memcmp(rhsip, referenceRhsip, rhsl * sizeof(int)) != 0))) {
+      GENERICLOGGER_ERRORF(loggerp, "%s: rule %d differs", whatp, i);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* Flips the bits of the last byte of the image, or truncates it to half its size */
+static short damageb(genericLogger_t *loggerp, short truncateb) {
+  FILE          *fp;
+  unsigned char *bytep = NULL;
+  long           sizel;
+  short          rcb   = 0;
+
+  fp = fopen(IMAGE_PATH, "rb");
+  if ((fp == NULL) || (fseek(fp, 0, SEEK_END) != 0) || ((sizel = ftell(fp)) <= 0) || (fseek(fp, 0, SEEK_SET) != 0)) {
+    GENERICLOGGER_ERRORF(loggerp, "%s: %s", IMAGE_PATH, strerror(errno));
+    goto done;
+  }
+  bytep = (unsigned char *) malloc((size_t) sizel);
+  if ((bytep == NULL) || (fread(bytep, 1, (size_t) sizel, fp) != (size_t) sizel)) {
+    GENERICLOGGER_ERRORF(loggerp, "%s: read failure", IMAGE_PATH);
+    goto done;
+  }
+  fclose(fp);
+
+  if (truncateb) {
+    sizel /= 2;
+  } else {
+    bytep[sizel - 1] ^= 0xFF;
+  }
+  fp = fopen(IMAGE_PATH, "wb");
+  if ((fp == NULL) || (fwrite(bytep, 1, (size_t) sizel, fp) != (size_t) sizel)) {
+    GENERICLOGGER_ERRORF(loggerp, "%s: write failure", IMAGE_PATH);
+    goto done;
+  }
+
+  rcb = 1;
+
+ done:
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  if (bytep != NULL) {
+    free(bytep);
+  }
+  return rcb;
+}
@@ -0,0 +1,234 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earley.h"
+
+/* Precomputing again a grammar that got more rules must give the same tables as */
+/* precomputing the whole grammar from scratch. Random grammars are grown round  */
+/* after round, with new nonterminals, new terminals, empty rules and cycles.    */
+/* The lookahead at the end of a rule is the FOLLOW set of its LHS.              */
+#define NGRAMMAR       100
+#define NROUND         6
+#define NRULEPERROUND  12
+#define NSYMBOLMAX     (NROUND * 8 + 8)
+#define NRULEMAX       (NROUND * NRULEPERROUND + 1)
+#define RHSMAX         4
+
+typedef struct grammarRules {
+  int    nSymboli;
+  short  terminalbp[NSYMBOLMAX];
+  int    nRulei;
+  int    lhsip[NRULEMAX];
+  int    rhsip[NRULEMAX][RHSMAX];
+  size_t rhslp[NRULEMAX];
+} grammarRules_t;
+
+static unsigned long randoml(unsigned long *seedlp, unsigned long nl);
+static short         symbolb(earleyGrammar_t *earleyGrammarp, grammarRules_t *rulesp, short terminalb);
+static short         ruleb(earleyGrammar_t *earleyGrammarp, grammarRules_t *rulesp, unsigned long *seedlp);
+static short         sameb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, grammarRules_t *rulesp, int roundi);
+static short         bitSetb(short rcb, short referenceRcb, const earleyGrammarBitWord_t *bitSetp, size_t wordl, const earleyGrammarBitWord_t *referenceBitSetp, size_t referenceWordl);
+
+int main() {
+  genericLogger_t *loggerp;
+  earleyGrammar_t *earleyGrammarp = NULL;
+  grammarRules_t   rules;
+  unsigned long    seedl = 1;
+  int              grammari;
+  int              roundi;
+  int              i;
+  int              rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  for (grammari = 0; grammari < NGRAMMAR; grammari++) {
+    earleyGrammarp = earleyGrammar_newp(NULL);
+    if (earleyGrammarp == NULL) {
+      GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+      goto err;
+    }
+    rules.nSymboli = 0;
+    rules.nRulei   = 0;
+    /* The start symbol, then a few nonterminals and terminals */
+    for (i = 0; i < 8; i++) {
+      if (! symbolb(earleyGrammarp, &rules, (short) (i >= 5))) {
+        GENERICLOGGER_ERRORF(loggerp, "Symbol failure, %s", strerror(errno));
+        goto err;
+      }
+    }
+    /* The start symbol is always productive */
+    rules.lhsip[0]    = 0;
+    rules.rhslp[0]    = 1;
+    rules.rhsip[0][0] = 5;
+    if (earleyGrammar_newRulei(earleyGrammarp, NULL, rules.lhsip[0], rules.rhslp[0], rules.rhsip[0]) != 0) {
+      GENERICLOGGER_ERRORF(loggerp, "Rule failure, %s", strerror(errno));
+      goto err;
+    }
+    rules.nRulei = 1;
+    for (roundi = 0; roundi < NROUND; roundi++) {
+      /* Later rounds bring new symbols: old terminals never become a LHS */
+      if (roundi > 0) {
+        for (i = 0; i < 8; i++) {
+          if (! symbolb(earleyGrammarp, &rules, (short) (randoml(&seedl, 3) == 0))) {
+            GENERICLOGGER_ERRORF(loggerp, "Symbol failure, %s", strerror(errno));
+            goto err;
+          }
+        }
+      }
+      for (i = 0; i < NRULEPERROUND; i++) {
+        if (! ruleb(earleyGrammarp, &rules, &seedl)) {
+          GENERICLOGGER_ERRORF(loggerp, "Rule failure, %s", strerror(errno));
+          goto err;
+        }
+      }
+      if (! earleyGrammar_precomputeb(earleyGrammarp)) {
+        GENERICLOGGER_ERRORF(loggerp, "Grammar %d round %d: earleyGrammar_precomputeb failure, %s", grammari, roundi, strerror(errno));
+        goto err;
+      }
+      if (! sameb(loggerp, earleyGrammarp, &rules, roundi)) {
+        GENERICLOGGER_ERRORF(loggerp, "Grammar %d differs from scratch after round %d", grammari, roundi);
+        goto err;
+      }
+    }
+    earleyGrammar_freev(earleyGrammarp);
+    earleyGrammarp = NULL;
+  }
+
+  rci = 0;
+
+ err:
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
+
+/* Portable linear congruential generator: the grammars are the same everywhere */
+static unsigned long randoml(unsigned long *seedlp, unsigned long nl) {
+  *seedlp = (*seedlp * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+  return (*seedlp >> 8) % nl;
+}
+
+static short symbolb(earleyGrammar_t *earleyGrammarp, grammarRules_t *rulesp, short terminalb) {
+  if (earleyGrammar_newSymbolExti(earleyGrammarp, terminalb, (short) (rulesp->nSymboli == 0), EARLEYGRAMMAR_EVENTTYPE_NONE) != rulesp->nSymboli) {
+    return 0;
+  }
+  rulesp->terminalbp[rulesp->nSymboli++] = terminalb;
+  return 1;
+}
+
+/* A rule with a random nonterminal LHS and a RHS of up to RHSMAX random symbols */
+static short ruleb(earleyGrammar_t *earleyGrammarp, grammarRules_t *rulesp, unsigned long *seedlp) {
+  int    lhsi;
+  int    rulei = rulesp->nRulei;
+  size_t l;
+
+  do {
+    lhsi = (int) randoml(seedlp, (unsigned long) rulesp->nSymboli);
+  } while (rulesp->terminalbp[lhsi]);
+  rulesp->lhsip[rulei] = lhsi;
+  rulesp->rhslp[rulei] = (size_t) randoml(seedlp, RHSMAX + 1);
+  for (l = 0; l < rulesp->rhslp[rulei]; l++) {
+    rulesp->rhsip[rulei][l] = (int) randoml(seedlp, (unsigned long) rulesp->nSymboli);
+  }
+  if (earleyGrammar_newRulei(earleyGrammarp, NULL, lhsi, rulesp->rhslp[rulei], rulesp->rhsip[rulei]) != rulei) {
+    return 0;
+  }
+  rulesp->nRulei++;
+  return 1;
+}
+
+/* Compares earleyGrammarp with the same rules precomputed from scratch */
+static short sameb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, grammarRules_t *rulesp, int roundi) {
+  earleyGrammar_t              *referencep = NULL;
+  const earleyGrammarBitWord_t *bitSetp;
+  const earleyGrammarBitWord_t *referenceBitSetp;
+  size_t                        wordl;
+  size_t                        referenceWordl;
+  int                           propertyi;
+  int                           referencePropertyi;
+  int                           i;
+  int                           doti;
+  short                         queryb;
+  short                         referenceQueryb;
+  short                         rcb = 0;
+
+  referencep = earleyGrammar_newp(NULL);
+  if (referencep == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+    goto done;
+  }
+  for (i = 0; i < rulesp->nSymboli; i++) {
+    if (earleyGrammar_newSymbolExti(referencep, rulesp->terminalbp[i], (short) (i == 0), EARLEYGRAMMAR_EVENTTYPE_NONE) != i) {
+      GENERICLOGGER_ERRORF(loggerp, "Reference symbol failure, %s", strerror(errno));
+      goto done;
+    }
+  }
+  for (i = 0; i < rulesp->nRulei; i++) {
+    if (earleyGrammar_newRulei(referencep, NULL, rulesp->lhsip[i], rulesp->rhslp[i], rulesp->rhsip[i]) != i) {
+      GENERICLOGGER_ERRORF(loggerp, "Reference rule failure, %s", strerror(errno));
+      goto done;
+    }
+  }
+  if (! earleyGrammar_precomputeb(referencep)) {
+    GENERICLOGGER_ERRORF(loggerp, "Reference precompute failure, %s", strerror(errno));
+    goto done;
+  }
+
+  for (i = 0; i < rulesp->nSymboli; i++) {
+    if ((! earleyGrammar_symbolPropertyb(earleyGrammarp, i, &propertyi)) || (! earleyGrammar_symbolPropertyb(referencep, i, &referencePropertyi)) || (propertyi != referencePropertyi)) {
+      GENERICLOGGER_ERRORF(loggerp, "Round %d: properties of symbol %d differ", roundi, i);
+      goto done;
+    }
+    queryb          = earleyGrammar_predictedRulesb(earleyGrammarp, i, &bitSetp, &wordl);
+    referenceQueryb = earleyGrammar_predictedRulesb(referencep, i, &referenceBitSetp, &referenceWordl);
+    if (! bitSetb(queryb, referenceQueryb, bitSetp, wordl, referenceBitSetp, referenceWordl)) {
+      GENERICLOGGER_ERRORF(loggerp, "Round %d: predicted rules of symbol %d differ", roundi, i);
+      goto done;
+    }
+    queryb          = earleyGrammar_predictedSymbolsb(earleyGrammarp, i, &bitSetp, &wordl);
+    referenceQueryb = earleyGrammar_predictedSymbolsb(referencep, i, &referenceBitSetp, &referenceWordl);
+    if (! bitSetb(queryb, referenceQueryb, bitSetp, wordl, referenceBitSetp, referenceWordl)) {
+      GENERICLOGGER_ERRORF(loggerp, "Round %d: predicted symbols of symbol %d differ", roundi, i);
+      goto done;
+    }
+    queryb          = earleyGrammar_firstb(earleyGrammarp, i, &bitSetp, &wordl);
+    referenceQueryb = earleyGrammar_firstb(referencep, i, &referenceBitSetp, &referenceWordl);
+    if (! bitSetb(queryb, referenceQueryb, bitSetp, wordl, referenceBitSetp, referenceWordl)) {
+      GENERICLOGGER_ERRORF(loggerp, "Round %d: FIRST of symbol %d differs", roundi, i);
+      goto done;
+    }
+  }
+  for (i = 0; i < rulesp->nRulei; i++) {
+    if ((! earleyGrammar_rulePropertyb(earleyGrammarp, i, &propertyi)) || (! earleyGrammar_rulePropertyb(referencep, i, &referencePropertyi)) || (propertyi != referencePropertyi)) {
+      GENERICLOGGER_ERRORF(loggerp, "Round %d: properties of rule %d differ", roundi, i);
+      goto done;
+    }
+    for (doti = 0; doti <= (int) rulesp->rhslp[i]; doti++) {
+      queryb          = earleyGrammar_lookaheadb(earleyGrammarp, i, doti, &bitSetp, &wordl);
+      referenceQueryb = earleyGrammar_lookaheadb(referencep, i, doti, &referenceBitSetp, &referenceWordl);
+      if (! bitSetb(queryb, referenceQueryb, bitSetp, wordl, referenceBitSetp, referenceWordl)) {
+        GENERICLOGGER_ERRORF(loggerp, "Round %d: lookahead of rule %d at %d differs", roundi, i, doti);
+        goto done;
+      }
+    }
+  }
+
+  rcb = 1;
+
+ done:
+  if (referencep != NULL) {
+    earleyGrammar_freev(referencep);
+  }
+  return rcb;
+}
+
+/* Both queries succeed and give the same bitset */
+static short bitSetb(short rcb, short referenceRcb, const earleyGrammarBitWord_t *bitSetp, size_t wordl, const earleyGrammarBitWord_t *referenceBitSetp, size_t referenceWordl) {
+  if ((! rcb) || (! referenceRcb) || (wordl != referenceWordl)) {
+    return 0;
+  }
+  return (wordl == 0) || (memcmp(bitSetp, referenceBitSetp, wordl * sizeof(earleyGrammarBitWord_t)) == 0);
+}
@@ -0,0 +1,122 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earleyTester.h"
+
+/* Acceptance and rejection on small grammars */
+
+int main() {
+  genericLogger_t          *loggerp;
+  earleyGrammar_t          *earleyGrammarp = NULL;
+  earleyRecognizer_t       *earleyRecognizerp = NULL;
+  earleyTesterExpression_t  expression;
+  int                       symbolip[128];
+  int                       Ss, As, Bs, Ls;
+  int                       rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  earleyGrammarp = earleyTester_expressionp(loggerp, NULL, EARLEYGRAMMAR_EVENTTYPE_NONE, &expression);
+  if (earleyGrammarp == NULL) {
+    goto err;
+  }
+  symbolip['n'] = expression.ns;
+  symbolip['+'] = expression.ps;
+  symbolip['*'] = expression.ts;
+  symbolip['a'] = expression.as;
+  if ((! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "n", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "n+aa*n", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "aaaa", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "", -1, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "n*", -1, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "+n", 0, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "nn", 1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "n+*n", 2, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "aan", 2, 1))) {
+    goto err;
+  }
+  earleyGrammar_freev(earleyGrammarp);
+
+  /* S ::= A B, A ::= a | <empty>, B ::= b | <empty>: the empty input is accepted */
+  earleyGrammarp = earleyGrammar_newp(NULL);
+  if (earleyGrammarp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+    goto err;
+  }
+  Ss = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 1, 0);
+  As = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, 0);
+  Bs = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, 0);
+  symbolip['a'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  symbolip['b'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  if ((EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ss, As, Bs, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, As, symbolip['a'], -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, As, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Bs, symbolip['b'], -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Bs, -1) < 0)
+      || (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Nullable grammar failure, %s", strerror(errno));
+    goto err;
+  }
+  if ((! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "a", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "b", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "ab", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "ba", 1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "aa", 1, 1))) {
+    goto err;
+  }
+  earleyGrammar_freev(earleyGrammarp);
+
+  /* Left-recursive L ::= L x | x */
+  earleyGrammarp = earleyGrammar_newp(NULL);
+  if (earleyGrammarp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+    goto err;
+  }
+  Ls = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 1, 0);
+  symbolip['x'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  if ((EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ls, Ls, symbolip['x'], -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ls, symbolip['x'], -1) < 0)
+      || (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Left-recursive grammar failure, %s", strerror(errno));
+    goto err;
+  }
+  if ((! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "", -1, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "xxxxxxxx", -1, 1))) {
+    goto err;
+  }
+
+  /* Precomputing the grammar again, with more rules, invalidates the recognizers created before */
+  earleyRecognizerp = earleyRecognizer_newp(earleyGrammarp, NULL);
+  if ((earleyRecognizerp == NULL) || (! earleyRecognizer_readb(earleyRecognizerp, symbolip['x']))) {
+    GENERICLOGGER_ERRORF(loggerp, "Recognizer failure, %s", strerror(errno));
+    goto err;
+  }
+  symbolip['y'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  if ((EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ls, symbolip['y'], -1) < 0) || (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Grammar modification failure, %s", strerror(errno));
+    goto err;
+  }
+  if (earleyRecognizer_completeb(earleyRecognizerp) || (errno != EINVAL)
+      || earleyRecognizer_readb(earleyRecognizerp, symbolip['y']) || (errno != EINVAL)
+      || earleyRecognizer_resetb(earleyRecognizerp) || (errno != EINVAL)) {
+    GENERICLOGGER_ERROR(loggerp, "A recognizer still works after its grammar was precomputed again");
+    goto err;
+  }
+  if (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "yxxx", -1, 1)) {
+    goto err;
+  }
+
+  rci = 0;
+
+ err:
+  if (earleyRecognizerp != NULL) {
+    earleyRecognizer_freev(earleyRecognizerp);
+  }
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earleyTester.h"
+
+/* Ambiguous tokens of several lengths, read in one call per earleme. With S ::= T T | L, */
+/* T ::= t and L ::= l, "t" spanning 2 earlemes and "l" 4, both readings end at earleme 4. */
+
+static short stateb(genericLogger_t *loggerp, earleyRecognizer_t *earleyRecognizerp, size_t earlemel, short acceptedb, short exhaustedb);
+
+int main() {
+  genericLogger_t               *loggerp;
+  earleyGrammar_t               *earleyGrammarp = NULL;
+  earleyRecognizer_t            *earleyRecognizerp = NULL;
+  earleyTesterExpression_t       expression;
+  earleyRecognizerAlternative_t  alternativep[3];
+  int                            Ss, Ts, Ls, ts, ls, xs;
+  int                            symbolip[128];
+  int                            rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  earleyGrammarp = earleyGrammar_newp(NULL);
+  if (earleyGrammarp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+    goto err;
+  }
+  Ss = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 1, 0);
+  Ts = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, 0);
+  Ls = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, 0);
+  ts = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  ls = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  xs = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  if ((EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ss, Ts, Ts, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ss, Ls, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ts, ts, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ls, ls, -1) < 0)
+      || (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Grammar failure, %s", strerror(errno));
+    goto err;
+  }
+  earleyRecognizerp = earleyRecognizer_newp(earleyGrammarp, NULL);
+  if (earleyRecognizerp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_newp failure, %s", strerror(errno));
+    goto err;
+  }
+
+  /* Earleme 0: t and l, x being ignored since it is not expected */
+  alternativep[0].symboli = ts;
+  alternativep[0].lengthl = 2;
+  alternativep[1].symboli = xs;
+  alternativep[1].lengthl = 1;
+  alternativep[2].symboli = ls;
+  alternativep[2].lengthl = 4;
+  if ((! earleyRecognizer_alternativesb(earleyRecognizerp, alternativep, 3)) || (! stateb(loggerp, earleyRecognizerp, 1, 0, 0))) {
+    GENERICLOGGER_ERRORF(loggerp, "Earleme 0 failure, %s", strerror(errno));
+    goto err;
+  }
+  /* Earleme 1: nothing to read, but the recognizer is not exhausted while tokens are pending */
+  if ((! earleyRecognizer_completeb(earleyRecognizerp)) || (! stateb(loggerp, earleyRecognizerp, 2, 0, 0))) {
+    GENERICLOGGER_ERRORF(loggerp, "Earleme 1 failure, %s", strerror(errno));
+    goto err;
+  }
+  /* Earleme 2: l is not expected, and refusing all the alternatives changes nothing */
+  alternativep[0].symboli = ls;
+  alternativep[0].lengthl = 2;
+  alternativep[1].symboli = xs;
+  alternativep[1].lengthl = 2;
+  if (earleyRecognizer_alternativesb(earleyRecognizerp, alternativep, 2) || (errno != ENOENT) || (! stateb(loggerp, earleyRecognizerp, 2, 0, 0))) {
+    GENERICLOGGER_ERROR(loggerp, "Earleme 2: unexpected alternatives are not refused");
+    goto err;
+  }
+  alternativep[0].symboli = ts;
+  if ((! earleyRecognizer_alternativesb(earleyRecognizerp, alternativep, 1)) || (! stateb(loggerp, earleyRecognizerp, 3, 0, 0))) {
+    GENERICLOGGER_ERRORF(loggerp, "Earleme 2 failure, %s", strerror(errno));
+    goto err;
+  }
+  /* Earleme 3, then both readings complete at earleme 4, where nothing can follow */
+  if ((! earleyRecognizer_completeb(earleyRecognizerp)) || (! stateb(loggerp, earleyRecognizerp, 4, 1, 1))) {
+    GENERICLOGGER_ERRORF(loggerp, "Earleme 3 failure, %s", strerror(errno));
+    goto err;
+  }
+  earleyRecognizer_freev(earleyRecognizerp);
+  earleyRecognizerp = NULL;
+  earleyGrammar_freev(earleyGrammarp);
+
+  /* Ambiguous length-1 tokens: n and a both start an expression, and either can go on */
+  earleyGrammarp = earleyTester_expressionp(loggerp, NULL, EARLEYGRAMMAR_EVENTTYPE_NONE, &expression);
+  if (earleyGrammarp == NULL) {
+    goto err;
+  }
+  earleyRecognizerp = earleyRecognizer_newp(earleyGrammarp, NULL);
+  if (earleyRecognizerp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_newp failure, %s", strerror(errno));
+    goto err;
+  }
+  alternativep[0].symboli = expression.ns;
+  alternativep[0].lengthl = 1;
+  alternativep[1].symboli = expression.as;
+  alternativep[1].lengthl = 1;
+  if ((! earleyRecognizer_alternativesb(earleyRecognizerp, alternativep, 2)) || (! stateb(loggerp, earleyRecognizerp, 1, 1, 0))) {
+    GENERICLOGGER_ERRORF(loggerp, "Ambiguous expression failure, %s", strerror(errno));
+    goto err;
+  }
+  /* a can follow the a reading only, + both: the input is still accepted either way */
+  if ((! earleyRecognizer_readb(earleyRecognizerp, expression.as)) || (! earleyRecognizer_completeb(earleyRecognizerp)) || (! stateb(loggerp, earleyRecognizerp, 2, 1, 0))) {
+    GENERICLOGGER_ERRORF(loggerp, "Ambiguous expression failure, %s", strerror(errno));
+    goto err;
+  }
+  symbolip['n'] = expression.ns;
+  symbolip['+'] = expression.ps;
+  if ((! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "n+n", -1, 1))) {
+    goto err;
+  }
+
+  rci = 0;
+
+ err:
+  if (earleyRecognizerp != NULL) {
+    earleyRecognizer_freev(earleyRecognizerp);
+  }
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
+
+/* Checks the current earleme, and whether the recognizer accepts or is exhausted there */
+static short stateb(genericLogger_t *loggerp, earleyRecognizer_t *earleyRecognizerp, size_t earlemel, short acceptedb, short exhaustedb) {
+  size_t currentEarlemel;
+  short  currentAcceptedb;
+  short  currentExhaustedb;
+
+  if ((! earleyRecognizer_earlemeb(earleyRecognizerp, &currentEarlemel))
+      || (! earleyRecognizer_acceptedb(earleyRecognizerp, &currentAcceptedb))
+      || (! earleyRecognizer_exhaustedb(earleyRecognizerp, &currentExhaustedb))) {
+    GENERICLOGGER_ERRORF(loggerp, "Recognizer query failure, %s", strerror(errno));
+    return 0;
+  }
+  if ((currentEarlemel != earlemel) || (currentAcceptedb != acceptedb) || (currentExhaustedb != exhaustedb)) {
+    GENERICLOGGER_ERRORF(loggerp, "Earleme %lu, accepted %d, exhausted %d instead of earleme %lu, accepted %d, exhausted %d",
+                         (unsigned long) currentEarlemel, (int) currentAcceptedb, (int) currentExhaustedb,
+                         (unsigned long) earlemel, (int) acceptedb, (int) exhaustedb);
+    return 0;
+  }
+
+  return 1;
+}
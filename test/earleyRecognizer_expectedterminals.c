@@ -0,0 +1,153 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earley.h"
+
+/* The expected terminals at every earleme, written by hand for E ::= G T, G ::= - | <empty>, */
+/* T ::= T + T | n | ( E ). Terminals are characters, and each earleme has the string of the */
+/* terminals expected there: the input ends with an unexpected (, after which nothing is.     */
+#define NSYMBOL   8
+#define TERMINALS "-n+()"
+#define INPUT     "-(n+(-n)+n)+n("
+
+static const char *expectedsp[] = {
+  "-n(",  /* E ::= . G T, G ::= . -, T ::= . n, T ::= . ( E ) */
+  "n(",   /* - */
+  "-n(",  /* ( */
+  "+)",   /* n: T ::= T . + T, T ::= ( E . ) */
+  "n(",   /* + */
+  "-n(",  /* ( */
+  "n(",   /* - */
+  "+)",   /* n */
+  "+)",   /* ) */
+  "n(",   /* + */
+  "+)",   /* n */
+  "+",    /* ): the input is accepted, only + can follow */
+  "n(",   /* + */
+  "+",    /* n */
+  ""      /* (: not expected, the recognizer is exhausted */
+};
+
+static short expectedb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, short recognizeOnlyb, int *symbolip);
+
+int main() {
+  genericLogger_t *loggerp;
+  earleyGrammar_t *earleyGrammarp = NULL;
+  int              symbolip[128];
+  int              Es, Gs, Ts;
+  int              rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  earleyGrammarp = earleyGrammar_newp(NULL);
+  if (earleyGrammarp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+    goto err;
+  }
+  Es = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 1, 0);
+  Gs = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, 0);
+  Ts = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, 0);
+  symbolip['-'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  symbolip['n'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  symbolip['+'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  symbolip['('] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  symbolip[')'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  if ((EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Es, Gs, Ts, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Gs, symbolip['-'], -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Gs, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ts, Ts, symbolip['+'], Ts, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ts, symbolip['n'], -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ts, symbolip['('], Es, symbolip[')'], -1) < 0)
+      || (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Grammar failure, %s", strerror(errno));
+    goto err;
+  }
+
+  if ((! expectedb(loggerp, earleyGrammarp, 0, symbolip)) || (! expectedb(loggerp, earleyGrammarp, 1, symbolip))) {
+    goto err;
+  }
+
+  rci = 0;
+
+ err:
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
+
+/* Reads the input and compares the expected terminals with expectedsp at every earleme */
+static short expectedb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, short recognizeOnlyb, int *symbolip) {
+  earleyRecognizer_t           *earleyRecognizerp;
+  earleyRecognizerOption_t      earleyRecognizerOption;
+  const earleyGrammarBitWord_t *bitSetp;
+  const earleyGrammarBitWord_t *firstBitSetp = NULL;
+  size_t                        wordl;
+  size_t                        l;
+  const char                   *terminalp;
+  short                         expectedb;
+  int                           nExpectedi;
+  int                           symboli;
+  short                         rcb = 0;
+
+  earleyRecognizerOption.genericLoggerp = loggerp;
+  earleyRecognizerOption.recognizeOnlyb = recognizeOnlyb;
+  earleyRecognizerp = earleyRecognizer_newp(earleyGrammarp, &earleyRecognizerOption);
+  if (earleyRecognizerp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_newp failure, %s", strerror(errno));
+    goto done;
+  }
+
+  for (l = 0; l <= strlen(INPUT); l++) {
+    if (! earleyRecognizer_expectedTerminalsb(earleyRecognizerp, &bitSetp, &wordl)) {
+      GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_expectedTerminalsb failure, %s", strerror(errno));
+      goto done;
+    }
+    if (wordl != EARLEYGRAMMAR_BITSET_WORDL(NSYMBOL)) {
+      GENERICLOGGER_ERRORF(loggerp, "Bitset of %lu words", (unsigned long) wordl);
+      goto done;
+    }
+    if (firstBitSetp == NULL) {
+      firstBitSetp = bitSetp;
+    } else if (bitSetp != firstBitSetp) {
+      GENERICLOGGER_ERROR(loggerp, "The bitset moved");
+      goto done;
+    }
+    for (terminalp = TERMINALS; *terminalp != '\0'; terminalp++) {
+      expectedb = (strchr(expectedsp[l], *terminalp) != NULL);
+      if (EARLEYGRAMMAR_BITSET_GETB(bitSetp, symbolip[(unsigned char) *terminalp]) != expectedb) {
+        GENERICLOGGER_ERRORF(loggerp, "Recognize-only %d: %c is %sexpected at earleme %lu", (int) recognizeOnlyb, *terminalp, expectedb ? "" : "not ", (unsigned long) l);
+        goto done;
+      }
+    }
+    /* Nonterminals are never expected */
+    nExpectedi = 0;
+    for (symboli = 0; symboli < NSYMBOL; symboli++) {
+      nExpectedi += EARLEYGRAMMAR_BITSET_GETB(bitSetp, symboli) ? 1 : 0;
+    }
+    if (nExpectedi != (int) strlen(expectedsp[l])) {
+      GENERICLOGGER_ERRORF(loggerp, "Recognize-only %d: %d symbols expected at earleme %lu", (int) recognizeOnlyb, nExpectedi, (unsigned long) l);
+      goto done;
+    }
+    if (l < strlen(INPUT)) {
+      if ((! earleyRecognizer_readb(earleyRecognizerp, symbolip[(unsigned char) INPUT[l]])) && ((errno != ENOENT) || (expectedsp[l + 1][0] != '\0'))) {
+        GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_readb failure at token %lu, %s", (unsigned long) l, strerror(errno));
+        goto done;
+      }
+      if (! earleyRecognizer_completeb(earleyRecognizerp)) {
+        GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_completeb failure at token %lu, %s", (unsigned long) l, strerror(errno));
+        goto done;
+      }
+    }
+  }
+
+  rcb = 1;
+
+ done:
+  if (earleyRecognizerp != NULL) {
+    earleyRecognizer_freev(earleyRecognizerp);
+  }
+  return rcb;
+}
@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earleyTester.h"
+
+/* Leo memoization keeps the Earley sets of a right recursion bounded: reading "a a a ..." with */
+/* R ::= a R | a gives a handful of items per set, instead of one per earleme. A completion    */
+/* event on R turns it off, since every completion of R must then be seen.                     */
+#define NTOKEN    2000
+#define LEO_ITEML 16
+
+static short maxItemCountb(genericLogger_t *loggerp, int rEventSeti, size_t *maxItemlp);
+
+int main() {
+  genericLogger_t *loggerp;
+  size_t           maxIteml;
+  int              rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  if (! maxItemCountb(loggerp, EARLEYGRAMMAR_EVENTTYPE_NONE, &maxIteml)) {
+    goto err;
+  }
+  if (maxIteml > LEO_ITEML) {
+    GENERICLOGGER_ERRORF(loggerp, "%lu items in a set with Leo memoization", (unsigned long) maxIteml);
+    goto err;
+  }
+
+  /* Without Leo memoization the sets grow with the input: the check above is meaningful */
+  if (! maxItemCountb(loggerp, EARLEYGRAMMAR_EVENTTYPE_COMPLETION, &maxIteml)) {
+    goto err;
+  }
+  if (maxIteml < NTOKEN) {
+    GENERICLOGGER_ERRORF(loggerp, "Only %lu items in a set with a completion event", (unsigned long) maxIteml);
+    goto err;
+  }
+
+  rci = 0;
+
+ err:
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
+
+/* Reads NTOKEN a's and returns the largest number of items in a set */
+static short maxItemCountb(genericLogger_t *loggerp, int rEventSeti, size_t *maxItemlp) {
+  earleyGrammar_t          *earleyGrammarp;
+  earleyRecognizer_t       *earleyRecognizerp = NULL;
+  earleyTesterExpression_t  expression;
+  size_t                    maxIteml = 0;
+  size_t                    iteml;
+  short                     acceptedb;
+  size_t                    l;
+  short                     rcb = 0;
+
+  earleyGrammarp = earleyTester_expressionp(loggerp, NULL, rEventSeti, &expression);
+  if (earleyGrammarp == NULL) {
+    goto done;
+  }
+  earleyRecognizerp = earleyRecognizer_newp(earleyGrammarp, NULL);
+  if (earleyRecognizerp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_newp failure, %s", strerror(errno));
+    goto done;
+  }
+
+  for (l = 0; l < NTOKEN; l++) {
+    if ((! earleyRecognizer_readb(earleyRecognizerp, expression.as))
+        || (! earleyRecognizer_completeb(earleyRecognizerp))
+        || (! earleyRecognizer_itemCountb(earleyRecognizerp, l + 1, &iteml))) {
+      GENERICLOGGER_ERRORF(loggerp, "Recognizer failure at token %lu, %s", (unsigned long) l, strerror(errno));
+      goto done;
+    }
+    if (iteml > maxIteml) {
+      maxIteml = iteml;
+    }
+  }
+  if ((! earleyRecognizer_acceptedb(earleyRecognizerp, &acceptedb)) || (! acceptedb)) {
+    GENERICLOGGER_ERROR(loggerp, "Input is not accepted");
+    goto done;
+  }
+
+  *maxItemlp = maxIteml;
+  rcb = 1;
+
+ done:
+  if (earleyRecognizerp != NULL) {
+    earleyRecognizer_freev(earleyRecognizerp);
+  }
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  return rcb;
+}
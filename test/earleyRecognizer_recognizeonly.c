@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earleyTester.h"
+
+/* When recognizing only, Earley sets that cannot be referenced anymore are recycled: once the */
+/* pool holds the live origin window, reading more input must not allocate anything.         */
+#define NTOKEN    20000
+#define NWARMUP   1000
+
+static earleyGrammar_t *listp(genericLogger_t *loggerp, earleyGrammarOption_t *earleyGrammarOptionp, short sequenceb, int *asp, int *csp);
+static short            boundedb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, earleyTesterAllocator_t *allocatorp, int as, int cs, int periodi);
+static short            recognizeb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, earleyTesterAllocator_t *allocatorp, short recognizeOnlyb, int as, int cs, int periodi, size_t *nAllocationlp);
+
+int main() {
+  genericLogger_t         *loggerp;
+  earleyGrammar_t         *earleyGrammarp = NULL;
+  earleyGrammarOption_t    earleyGrammarOption;
+  earleyTesterAllocator_t  allocator;
+  int                      as, cs;
+  int                      rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  memset(&earleyGrammarOption, 0, sizeof(earleyGrammarOption));
+  earleyGrammarOption.genericLoggerp = loggerp;
+  earleyTester_allocatorv(&earleyGrammarOption, &allocator);
+
+  /* "a c a c ..." */
+  earleyGrammarp = listp(loggerp, &earleyGrammarOption, 0, &as, &cs);
+  if ((earleyGrammarp == NULL) || (! boundedb(loggerp, earleyGrammarp, &allocator, as, cs, 2))) {
+    goto err;
+  }
+  earleyGrammar_freev(earleyGrammarp);
+
+  /* "a a c a a c ...": items of the sequence expecting a terminal must not keep their origin sets alive */
+  earleyGrammarp = listp(loggerp, &earleyGrammarOption, 1, &as, &cs);
+  if ((earleyGrammarp == NULL) || (! boundedb(loggerp, earleyGrammarp, &allocator, as, cs, 3))) {
+    goto err;
+  }
+
+  rci = 0;
+
+ err:
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
+
+/* S ::= L, L ::= L E | E, with E ::= a c, or E ::= a+ properly separated by c when sequenceb is set */
+static earleyGrammar_t *listp(genericLogger_t *loggerp, earleyGrammarOption_t *earleyGrammarOptionp, short sequenceb, int *asp, int *csp) {
+  earleyGrammar_t *earleyGrammarp;
+  int              Ss, Ls, Es;
+
+  earleyGrammarp = earleyGrammar_newp(earleyGrammarOptionp);
+  if (earleyGrammarp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+    return NULL;
+  }
+  Ss   = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 1, 0);
+  Ls   = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, 0);
+  Es   = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, 0);
+  *asp = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  *csp = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  if ((EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ss, Ls, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ls, Ls, Es, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ls, Es, -1) < 0)
+      || (sequenceb ? (earleyGrammar_newSequenceExti(earleyGrammarp, 0, 0, Es, *asp, 1, *csp, 1) < 0) : (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Es, *asp, *csp, -1) < 0))
+      || (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Grammar failure, %s", strerror(errno));
+    earleyGrammar_freev(earleyGrammarp);
+    return NULL;
+  }
+
+  return earleyGrammarp;
+}
+
+/* No allocation after the warmup when recognizing only, while keeping all the sets does allocate */
+static short boundedb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, earleyTesterAllocator_t *allocatorp, int as, int cs, int periodi) {
+  size_t nAllocationl;
+
+  if (! recognizeb(loggerp, earleyGrammarp, allocatorp, 1, as, cs, periodi, &nAllocationl)) {
+    return 0;
+  }
+  if (nAllocationl != 0) {
+    GENERICLOGGER_ERRORF(loggerp, "Recognize-only: %lu allocations after %d tokens, the live sets are not bounded", (unsigned long) nAllocationl, NWARMUP);
+    return 0;
+  }
+
+  /* The check above is meaningful */
+  if (! recognizeb(loggerp, earleyGrammarp, allocatorp, 0, as, cs, periodi, &nAllocationl)) {
+    return 0;
+  }
+  if (nAllocationl == 0) {
+    GENERICLOGGER_ERROR(loggerp, "No allocation when keeping all the sets");
+    return 0;
+  }
+
+  return 1;
+}
+
+/* Reads NTOKEN tokens, c every periodi tokens and a otherwise, and returns the number of allocations after the warmup */
+static short recognizeb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, earleyTesterAllocator_t *allocatorp, short recognizeOnlyb, int as, int cs, int periodi, size_t *nAllocationlp) {
+  earleyRecognizer_t       *earleyRecognizerp;
+  earleyRecognizerOption_t  earleyRecognizerOption;
+  size_t                    nAllocationl = 0;
+  short                     acceptedb;
+  int                       i;
+  short                     rcb = 0;
+
+  earleyRecognizerOption.genericLoggerp = loggerp;
+  earleyRecognizerOption.recognizeOnlyb = recognizeOnlyb;
+  earleyRecognizerp = earleyRecognizer_newp(earleyGrammarp, &earleyRecognizerOption);
+  if (earleyRecognizerp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_newp failure, %s", strerror(errno));
+    goto done;
+  }
+
+  for (i = 0; i < NTOKEN; i++) {
+    if (i == NWARMUP) {
+      nAllocationl = allocatorp->nAllocationl;
+    }
+    if ((! earleyRecognizer_readb(earleyRecognizerp, ((i % periodi) == (periodi - 1)) ? cs : as)) || (! earleyRecognizer_completeb(earleyRecognizerp))) {
+      GENERICLOGGER_ERRORF(loggerp, "Recognizer failure at token %d, %s", i, strerror(errno));
+      goto done;
+    }
+  }
+  if ((! earleyRecognizer_acceptedb(earleyRecognizerp, &acceptedb)) || (! acceptedb)) {
+    GENERICLOGGER_ERROR(loggerp, "Input is not accepted");
+    goto done;
+  }
+
+  *nAllocationlp = allocatorp->nAllocationl - nAllocationl;
+  rcb = 1;
+
+ done:
+  if (earleyRecognizerp != NULL) {
+    earleyRecognizer_freev(earleyRecognizerp);
+  }
+  return rcb;
+}
@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earleyTester.h"
+
+/* After a reset, the recognizer keeps all its memory: parsing again an input that is not larger */
+/* than one already seen must not allocate anything, and must give the same Earley sets.        */
+#define NTOKEN 201
+
+static short parseb(genericLogger_t *loggerp, earleyRecognizer_t *earleyRecognizerp, int *symbolip, size_t nSymboll, size_t *itemlp);
+static short resetb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, earleyTesterAllocator_t *allocatorp, short recognizeOnlyb, int *symbolip);
+
+int main() {
+  genericLogger_t          *loggerp;
+  earleyGrammar_t          *earleyGrammarp = NULL;
+  earleyGrammarOption_t     earleyGrammarOption;
+  earleyTesterAllocator_t   allocator;
+  earleyTesterExpression_t  expression;
+  int                       symbolip[NTOKEN];
+  int                       i;
+  int                       rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  memset(&earleyGrammarOption, 0, sizeof(earleyGrammarOption));
+  earleyGrammarOption.genericLoggerp = loggerp;
+  earleyTester_allocatorv(&earleyGrammarOption, &allocator);
+
+  earleyGrammarp = earleyTester_expressionp(loggerp, &earleyGrammarOption, EARLEYGRAMMAR_EVENTTYPE_NONE, &expression);
+  if (earleyGrammarp == NULL) {
+    goto err;
+  }
+
+  /* n + a a a * n + ... */
+  for (i = 0; i < NTOKEN; i++) {
+    switch (i % 8) {
+    case 1:
+      symbolip[i] = expression.ps;
+      break;
+    case 2:
+    case 3:
+    case 4:
+      symbolip[i] = expression.as;
+      break;
+    case 5:
+      symbolip[i] = expression.ts;
+      break;
+    case 7:
+      symbolip[i] = expression.ps;
+      break;
+    default:
+      symbolip[i] = expression.ns;
+      break;
+    }
+  }
+
+  if ((! resetb(loggerp, earleyGrammarp, &allocator, 0, symbolip)) || (! resetb(loggerp, earleyGrammarp, &allocator, 1, symbolip))) {
+    goto err;
+  }
+
+  rci = 0;
+
+ err:
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
+
+/* Parses the whole input, resets, then parses it again and a prefix of it after another reset */
+static short resetb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, earleyTesterAllocator_t *allocatorp, short recognizeOnlyb, int *symbolip) {
+  earleyRecognizer_t       *earleyRecognizerp;
+  earleyRecognizerOption_t  earleyRecognizerOption;
+  size_t                    itemlp[NTOKEN];
+  size_t                    resetItemlp[NTOKEN];
+  size_t                    nAllocationl;
+  short                     rcb = 0;
+
+  earleyRecognizerOption.genericLoggerp = loggerp;
+  earleyRecognizerOption.recognizeOnlyb = recognizeOnlyb;
+  earleyRecognizerp = earleyRecognizer_newp(earleyGrammarp, &earleyRecognizerOption);
+  if (earleyRecognizerp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_newp failure, %s", strerror(errno));
+    goto done;
+  }
+
+  if (! parseb(loggerp, earleyRecognizerp, symbolip, NTOKEN, itemlp)) {
+    goto done;
+  }
+
+  nAllocationl = allocatorp->nAllocationl;
+  if ((! earleyRecognizer_resetb(earleyRecognizerp))
+      || (! parseb(loggerp, earleyRecognizerp, symbolip, NTOKEN, resetItemlp))
+      || (! earleyRecognizer_resetb(earleyRecognizerp))
+      || (! parseb(loggerp, earleyRecognizerp, symbolip, NTOKEN / 2, resetItemlp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Reset failure, %s", strerror(errno));
+    goto done;
+  }
+  if (allocatorp->nAllocationl != nAllocationl) {
+    GENERICLOGGER_ERRORF(loggerp, "Recognize-only %d: %lu allocations after a reset", (int) recognizeOnlyb, (unsigned long) (allocatorp->nAllocationl - nAllocationl));
+    goto done;
+  }
+  if (memcmp(itemlp, resetItemlp, (NTOKEN / 2) * sizeof(size_t)) != 0) {
+    GENERICLOGGER_ERRORF(loggerp, "Recognize-only %d: Earley sets differ after a reset", (int) recognizeOnlyb);
+    goto done;
+  }
+
+  rcb = 1;
+
+ done:
+  if (earleyRecognizerp != NULL) {
+    earleyRecognizer_freev(earleyRecognizerp);
+  }
+  return rcb;
+}
+
+/* Reads the input, storing the number of items of every new set, and checks it is accepted */
+static short parseb(genericLogger_t *loggerp, earleyRecognizer_t *earleyRecognizerp, int *symbolip, size_t nSymboll, size_t *itemlp) {
+  short  acceptedb;
+  size_t l;
+
+  for (l = 0; l < nSymboll; l++) {
+    if ((! earleyRecognizer_readb(earleyRecognizerp, symbolip[l]))
+        || (! earleyRecognizer_completeb(earleyRecognizerp))
+        || (! earleyRecognizer_itemCountb(earleyRecognizerp, l + 1, &(itemlp[l])))) {
+      GENERICLOGGER_ERRORF(loggerp, "Recognizer failure at token %lu, %s", (unsigned long) l, strerror(errno));
+      return 0;
+    }
+  }
+  if ((! earleyRecognizer_acceptedb(earleyRecognizerp, &acceptedb)) || (! acceptedb)) {
+    GENERICLOGGER_ERROR(loggerp, "Input is not accepted");
+    return 0;
+  }
+
+  return 1;
+}
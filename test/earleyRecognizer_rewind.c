@@ -0,0 +1,241 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earleyTester.h"
+
+/* Rewinding to a checkpoint must give exactly the state at the checkpoint: a recognizer that */
+/* makes detours and comes back must be indistinguishable from one that parses the same input */
+/* directly, and going on with another input after a rewind must be the same as a fresh parse. */
+#define NTOKEN 97
+
+typedef struct recognizerState {
+  size_t                 earlemel;
+  short                  acceptedb;
+  short                  exhaustedb;
+  size_t                 itemHashl;
+  earleyGrammarBitWord_t expectedHash;
+} recognizerState_t;
+
+static short stateb(genericLogger_t *loggerp, earleyRecognizer_t *earleyRecognizerp, recognizerState_t *statep);
+static short readb(genericLogger_t *loggerp, earleyRecognizer_t *earleyRecognizerp, int symboli);
+static void  detourv(earleyRecognizer_t *earleyRecognizerp, int *terminalip);
+
+int main() {
+  genericLogger_t              *loggerp;
+  earleyGrammar_t              *earleyGrammarp = NULL;
+  earleyRecognizer_t           *freshp = NULL;
+  earleyRecognizer_t           *rewoundp = NULL;
+  earleyRecognizerCheckpoint_t  checkpoint;
+  earleyRecognizerCheckpoint_t  middleCheckpoint;
+  earleyRecognizerCheckpoint_t  staleCheckpoint;
+  recognizerState_t             freshStatep[NTOKEN + 1];
+  recognizerState_t             state;
+  int                           symbolip[NTOKEN];
+  int                           terminalip[4];
+  earleyTesterExpression_t      expression;
+  int                           i;
+  int                           rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  earleyGrammarp = earleyTester_expressionp(loggerp, NULL, EARLEYGRAMMAR_EVENTTYPE_NONE, &expression);
+  if (earleyGrammarp == NULL) {
+    goto err;
+  }
+  terminalip[0] = expression.ns;
+  terminalip[1] = expression.ps;
+  terminalip[2] = expression.ts;
+  terminalip[3] = expression.as;
+
+  /* n + a a * n + n + a a * n + ... */
+  for (i = 0; i < NTOKEN; i++) {
+    switch (i % 7) {
+    case 1:
+    case 6:
+      symbolip[i] = expression.ps;
+      break;
+    case 2:
+    case 3:
+      symbolip[i] = expression.as;
+      break;
+    case 4:
+      symbolip[i] = expression.ts;
+      break;
+    default:
+      symbolip[i] = expression.ns;
+      break;
+    }
+  }
+
+  freshp   = earleyRecognizer_newp(earleyGrammarp, NULL);
+  rewoundp = earleyRecognizer_newp(earleyGrammarp, NULL);
+  if ((freshp == NULL) || (rewoundp == NULL)) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_newp failure, %s", strerror(errno));
+    goto err;
+  }
+
+  /* Reference */
+  if (! stateb(loggerp, freshp, &(freshStatep[0]))) {
+    goto err;
+  }
+  for (i = 0; i < NTOKEN; i++) {
+    if ((i == NTOKEN / 4) && (! earleyRecognizer_checkpointb(freshp, &staleCheckpoint))) {
+      GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_checkpointb failure, %s", strerror(errno));
+      goto err;
+    }
+    if ((! readb(loggerp, freshp, symbolip[i])) || (! earleyRecognizer_completeb(freshp)) || (! stateb(loggerp, freshp, &(freshStatep[i + 1])))) {
+      GENERICLOGGER_ERRORF(loggerp, "Reference failure at token %d, %s", i, strerror(errno));
+      goto err;
+    }
+  }
+
+  /* A detour before every token, and one between reading a token and completing the earleme */
+  for (i = 0; i < NTOKEN; i++) {
+    if (! earleyRecognizer_checkpointb(rewoundp, &checkpoint)) {
+      GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_checkpointb failure at token %d, %s", i, strerror(errno));
+      goto err;
+    }
+    if (i == NTOKEN / 2) {
+      middleCheckpoint = checkpoint;
+    }
+    detourv(rewoundp, terminalip);
+    if ((! earleyRecognizer_rewindb(rewoundp, &checkpoint)) || (! stateb(loggerp, rewoundp, &state))) {
+      GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_rewindb failure at token %d, %s", i, strerror(errno));
+      goto err;
+    }
+    if (memcmp(&state, &(freshStatep[i]), sizeof(state)) != 0) {
+      GENERICLOGGER_ERRORF(loggerp, "State differs after a rewind at token %d", i);
+      goto err;
+    }
+    if ((! readb(loggerp, rewoundp, symbolip[i])) || (! earleyRecognizer_checkpointb(rewoundp, &checkpoint))) {
+      goto err;
+    }
+    detourv(rewoundp, terminalip);
+    if ((! earleyRecognizer_rewindb(rewoundp, &checkpoint)) || (! earleyRecognizer_completeb(rewoundp)) || (! stateb(loggerp, rewoundp, &state))) {
+      GENERICLOGGER_ERRORF(loggerp, "Failure after a rewind within token %d, %s", i, strerror(errno));
+      goto err;
+    }
+    if (memcmp(&state, &(freshStatep[i + 1]), sizeof(state)) != 0) {
+      GENERICLOGGER_ERRORF(loggerp, "State differs after a rewind within token %d", i);
+      goto err;
+    }
+  }
+
+  /* Back to the middle, and another end of input: "* a a a ..." instead */
+  if (! earleyRecognizer_resetb(freshp)) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_resetb failure, %s", strerror(errno));
+    goto err;
+  }
+  for (i = 0; i < NTOKEN; i++) {
+    if (i >= NTOKEN / 2) {
+      symbolip[i] = (i == NTOKEN / 2) ? expression.ts : expression.as;
+    }
+  }
+  for (i = 0; i < NTOKEN; i++) {
+    if ((! readb(loggerp, freshp, symbolip[i])) || (! earleyRecognizer_completeb(freshp)) || (! stateb(loggerp, freshp, &(freshStatep[i + 1])))) {
+      GENERICLOGGER_ERRORF(loggerp, "Reference failure at token %d, %s", i, strerror(errno));
+      goto err;
+    }
+  }
+  if (! earleyRecognizer_rewindb(rewoundp, &middleCheckpoint)) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_rewindb failure, %s", strerror(errno));
+    goto err;
+  }
+  for (i = NTOKEN / 2; i < NTOKEN; i++) {
+    if ((! readb(loggerp, rewoundp, symbolip[i])) || (! earleyRecognizer_completeb(rewoundp)) || (! stateb(loggerp, rewoundp, &state))) {
+      GENERICLOGGER_ERRORF(loggerp, "Failure at token %d after a rewind, %s", i, strerror(errno));
+      goto err;
+    }
+    if (memcmp(&state, &(freshStatep[i + 1]), sizeof(state)) != 0) {
+      GENERICLOGGER_ERRORF(loggerp, "State differs from a fresh parse at token %d", i);
+      goto err;
+    }
+  }
+  if (! state.acceptedb) {
+    GENERICLOGGER_ERROR(loggerp, "Input is not accepted");
+    goto err;
+  }
+
+  /* A checkpoint from before a reset is rejected, even within the earlemes read since */
+  if (earleyRecognizer_rewindb(freshp, &staleCheckpoint) || (errno != EINVAL)) {
+    GENERICLOGGER_ERROR(loggerp, "A checkpoint from before a reset is accepted");
+    goto err;
+  }
+
+  rci = 0;
+
+ err:
+  if (rewoundp != NULL) {
+    earleyRecognizer_freev(rewoundp);
+  }
+  if (freshp != NULL) {
+    earleyRecognizer_freev(freshp);
+  }
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
+
+/* Everything that a rewind must restore: position, acceptance, all the sets and the expected terminals */
+static short stateb(genericLogger_t *loggerp, earleyRecognizer_t *earleyRecognizerp, recognizerState_t *statep) {
+  const earleyGrammarBitWord_t *bitSetp;
+  size_t                        wordl;
+  size_t                        iteml;
+  size_t                        l;
+
+  memset(statep, 0, sizeof(*statep));
+  if ((! earleyRecognizer_earlemeb(earleyRecognizerp, &(statep->earlemel)))
+      || (! earleyRecognizer_acceptedb(earleyRecognizerp, &(statep->acceptedb)))
+      || (! earleyRecognizer_exhaustedb(earleyRecognizerp, &(statep->exhaustedb)))
+      || (! earleyRecognizer_expectedTerminalsb(earleyRecognizerp, &bitSetp, &wordl))) {
+    GENERICLOGGER_ERRORF(loggerp, "Recognizer query failure, %s", strerror(errno));
+    return 0;
+  }
+  for (l = 0; l <= statep->earlemel; l++) {
+    if (! earleyRecognizer_itemCountb(earleyRecognizerp, l, &iteml)) {
+      GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_itemCountb failure at earleme %lu, %s", (unsigned long) l, strerror(errno));
+      return 0;
+    }
+    statep->itemHashl = statep->itemHashl * 1000003 + iteml;
+  }
+  for (l = 0; l < wordl; l++) {
+    statep->expectedHash = statep->expectedHash * 31 + bitSetp[l];
+  }
+
+  return 1;
+}
+
+static short readb(genericLogger_t *loggerp, earleyRecognizer_t *earleyRecognizerp, int symboli) {
+  if (! earleyRecognizer_readb(earleyRecognizerp, symboli)) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_readb failure on symbol %d, %s", symboli, strerror(errno));
+    return 0;
+  }
+  return 1;
+}
+
+/* Reads ambiguous tokens and tokens spanning several earlemes, whether they are expected or not */
+static void detourv(earleyRecognizer_t *earleyRecognizerp, int *terminalip) {
+  earleyRecognizerAlternative_t alternativep[3];
+  int                           i;
+
+  for (i = 0; i < 4; i++) {
+    earleyRecognizer_readb(earleyRecognizerp, terminalip[i]);
+  }
+  earleyRecognizer_completeb(earleyRecognizerp);
+  for (i = 0; i < 3; i++) {
+    alternativep[i].symboli = terminalip[i + 1];
+    alternativep[i].lengthl = (size_t) i + 1;
+  }
+  if (! earleyRecognizer_alternativesb(earleyRecognizerp, alternativep, 3)) {
+    earleyRecognizer_completeb(earleyRecognizerp);
+  }
+  alternativep[0].symboli = terminalip[0];
+  alternativep[0].lengthl = 2;
+  if (! earleyRecognizer_alternativesb(earleyRecognizerp, alternativep, 1)) {
+    earleyRecognizer_completeb(earleyRecognizerp);
+  }
+  earleyRecognizer_readb(earleyRecognizerp, terminalip[3]);
+}
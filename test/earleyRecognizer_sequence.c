@@ -0,0 +1,153 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "earleyTester.h"
+
+/* Sequence rules, with and without a separator, proper or not, with a minimum of 0 or 1. A */
+/* sequence is one item per origin whatever its length: the sets stay small on long inputs. */
+#define NTOKEN    999
+#define MAX_ITEML 8
+
+static earleyGrammar_t *sequencep(genericLogger_t *loggerp, int *symbolip, int minimumi, short separatorb, short properb);
+static short            maxItemCountb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, int *symbolip, size_t *maxItemlp);
+
+int main() {
+  genericLogger_t *loggerp;
+  earleyGrammar_t *earleyGrammarp = NULL;
+  int              symbolip[128];
+  size_t           maxIteml;
+  int              rci = 1;
+
+  loggerp = GENERICLOGGER_NEW(GENERICLOGGER_LOGLEVEL_INFO);
+
+  /* S ::= a L b, L ::= x* */
+  earleyGrammarp = sequencep(loggerp, symbolip, 0, 0, 0);
+  if ((earleyGrammarp == NULL)
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "ab", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axb", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axxxxb", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axx", -1, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axcx", 2, 0))) {
+    goto err;
+  }
+  earleyGrammar_freev(earleyGrammarp);
+
+  /* L ::= x+ */
+  earleyGrammarp = sequencep(loggerp, symbolip, 1, 0, 0);
+  if ((earleyGrammarp == NULL)
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "ab", 1, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axb", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axxxb", -1, 1))) {
+    goto err;
+  }
+  earleyGrammar_freev(earleyGrammarp);
+
+  /* L ::= x* separated by c, a trailing separator being allowed */
+  earleyGrammarp = sequencep(loggerp, symbolip, 0, 1, 0);
+  if ((earleyGrammarp == NULL)
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "ab", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axcxb", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axcxcb", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "acb", 1, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axxb", 2, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axccb", 3, 0))) {
+    goto err;
+  }
+  earleyGrammar_freev(earleyGrammarp);
+
+  /* L ::= x+ properly separated by c */
+  earleyGrammarp = sequencep(loggerp, symbolip, 1, 1, 1);
+  if ((earleyGrammarp == NULL)
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "ab", 1, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axb", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axcxcxb", -1, 1))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axcb", 3, 0))
+      || (! earleyTester_recognizeb(loggerp, earleyGrammarp, symbolip, "axxb", 2, 0))) {
+    goto err;
+  }
+  if (! maxItemCountb(loggerp, earleyGrammarp, symbolip, &maxIteml)) {
+    goto err;
+  }
+  if (maxIteml > MAX_ITEML) {
+    GENERICLOGGER_ERRORF(loggerp, "%lu items in a set of a long sequence", (unsigned long) maxIteml);
+    goto err;
+  }
+
+  rci = 0;
+
+ err:
+  if (earleyGrammarp != NULL) {
+    earleyGrammar_freev(earleyGrammarp);
+  }
+  GENERICLOGGER_FREE(loggerp);
+  return rci;
+}
+
+/* S ::= a L b, with the sequence L ::= x, separated by c when separatorb is set */
+static earleyGrammar_t *sequencep(genericLogger_t *loggerp, int *symbolip, int minimumi, short separatorb, short properb) {
+  earleyGrammar_t *earleyGrammarp;
+  int              Ss, Ls;
+
+  earleyGrammarp = earleyGrammar_newp(NULL);
+  if (earleyGrammarp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+    return NULL;
+  }
+  Ss = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 1, 0);
+  Ls = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, 0);
+  symbolip['a'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  symbolip['b'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  symbolip['c'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  symbolip['x'] = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  if ((EARLEYGRAMMAR_NEWRULE(earleyGrammarp, Ss, symbolip['a'], Ls, symbolip['b'], -1) < 0)
+      || (earleyGrammar_newSequenceExti(earleyGrammarp, 0, 0, Ls, symbolip['x'], minimumi, separatorb ? symbolip['c'] : -1, properb) < 0)
+      || (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Sequence grammar failure, %s", strerror(errno));
+    earleyGrammar_freev(earleyGrammarp);
+    return NULL;
+  }
+
+  return earleyGrammarp;
+}
+
+/* Reads "a x c x c ... x b" and returns the largest number of items in a set */
+static short maxItemCountb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, int *symbolip, size_t *maxItemlp) {
+  earleyRecognizer_t *earleyRecognizerp;
+  size_t              maxIteml = 0;
+  size_t              iteml;
+  short               acceptedb;
+  size_t              l;
+  short               rcb = 0;
+
+  earleyRecognizerp = earleyRecognizer_newp(earleyGrammarp, NULL);
+  if (earleyRecognizerp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_newp failure, %s", strerror(errno));
+    goto done;
+  }
+
+  for (l = 0; l < NTOKEN; l++) {
+    if ((! earleyRecognizer_readb(earleyRecognizerp, symbolip[(l == 0) ? 'a' : (l == NTOKEN - 1) ? 'b' : ((l % 2) == 1) ? 'x' : 'c']))
+        || (! earleyRecognizer_completeb(earleyRecognizerp))
+        || (! earleyRecognizer_itemCountb(earleyRecognizerp, l + 1, &iteml))) {
+      GENERICLOGGER_ERRORF(loggerp, "Recognizer failure at token %lu, %s", (unsigned long) l, strerror(errno));
+      goto done;
+    }
+    if (iteml > maxIteml) {
+      maxIteml = iteml;
+    }
+  }
+  if ((! earleyRecognizer_acceptedb(earleyRecognizerp, &acceptedb)) || (! acceptedb)) {
+    GENERICLOGGER_ERROR(loggerp, "Long sequence is not accepted");
+    goto done;
+  }
+
+  *maxItemlp = maxIteml;
+  rcb = 1;
+
+ done:
+  if (earleyRecognizerp != NULL) {
+    earleyRecognizer_freev(earleyRecognizerp);
+  }
+  return rcb;
+}
@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include "earleyTester.h"
+
+static void *earleyTester_mallocp(void *userDatavp, size_t sizel);
+static void *earleyTester_reallocp(void *userDatavp, void *p, size_t sizel);
+static void  earleyTester_freev(void *userDatavp, void *p);
+
+/****************************************************************************/
+void earleyTester_allocatorv(earleyGrammarOption_t *earleyGrammarOptionp, earleyTesterAllocator_t *allocatorp)
+/****************************************************************************/
+{
+  allocatorp->nAllocationl                  = 0;
+  earleyGrammarOptionp->mallocp             = earleyTester_mallocp;
+  earleyGrammarOptionp->reallocp            = earleyTester_reallocp;
+  earleyGrammarOptionp->freep               = earleyTester_freev;
+  earleyGrammarOptionp->allocatorUserDatavp = allocatorp;
+}
+
+/****************************************************************************/
+earleyGrammar_t *earleyTester_expressionp(genericLogger_t *loggerp, earleyGrammarOption_t *earleyGrammarOptionp, int rEventSeti, earleyTesterExpression_t *expressionp)
+/****************************************************************************/
+{
+  earleyGrammar_t *earleyGrammarp;
+
+  earleyGrammarp = earleyGrammar_newp(earleyGrammarOptionp);
+  if (earleyGrammarp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyGrammar_newp failure, %s", strerror(errno));
+    return NULL;
+  }
+  expressionp->Es = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 1, 0);
+  expressionp->Rs = earleyGrammar_newSymbolExti(earleyGrammarp, 0, 0, rEventSeti);
+  expressionp->ns = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  expressionp->ps = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  expressionp->ts = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  expressionp->as = earleyGrammar_newSymbolExti(earleyGrammarp, 1, 0, 0);
+  if ((EARLEYGRAMMAR_NEWRULE(earleyGrammarp, expressionp->Es, expressionp->Es, expressionp->ps, expressionp->Es, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, expressionp->Es, expressionp->Es, expressionp->ts, expressionp->Es, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, expressionp->Es, expressionp->ns, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, expressionp->Es, expressionp->Rs, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, expressionp->Rs, expressionp->as, expressionp->Rs, -1) < 0)
+      || (EARLEYGRAMMAR_NEWRULE(earleyGrammarp, expressionp->Rs, expressionp->as, -1) < 0)
+      || (! earleyGrammar_precomputeb(earleyGrammarp))) {
+    GENERICLOGGER_ERRORF(loggerp, "Expression grammar failure, %s", strerror(errno));
+    earleyGrammar_freev(earleyGrammarp);
+    return NULL;
+  }
+
+  return earleyGrammarp;
+}
+
+/****************************************************************************/
+short earleyTester_recognizeb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, const int *symbolip, const char *inputs, int rejectedi, short acceptedb)
+/****************************************************************************/
+{
+  earleyRecognizer_t *earleyRecognizerp;
+  size_t              earlemel;
+  short               resultb;
+  int                 i;
+  short               rcb = 0;
+
+  earleyRecognizerp = earleyRecognizer_newp(earleyGrammarp, NULL);
+  if (earleyRecognizerp == NULL) {
+    GENERICLOGGER_ERRORF(loggerp, "earleyRecognizer_newp failure, %s", strerror(errno));
+    goto done;
+  }
+
+  for (i = 0; inputs[i] != '\0'; i++) {
+    if (i == rejectedi) {
+      if (earleyRecognizer_readb(earleyRecognizerp, symbolip[(unsigned char) inputs[i]]) || (errno != ENOENT)) {
+        GENERICLOGGER_ERRORF(loggerp, "\"%s\": character %d is not refused", inputs, i);
+        goto done;
+      }
+      break;
+    }
+    if ((! earleyRecognizer_readb(earleyRecognizerp, symbolip[(unsigned char) inputs[i]])) || (! earleyRecognizer_completeb(earleyRecognizerp))) {
+      GENERICLOGGER_ERRORF(loggerp, "\"%s\": failure at character %d, %s", inputs, i, strerror(errno));
+      goto done;
+    }
+  }
+
+  if ((! earleyRecognizer_earlemeb(earleyRecognizerp, &earlemel)) || (earlemel != (size_t) i)) {
+    GENERICLOGGER_ERRORF(loggerp, "\"%s\": wrong earleme", inputs);
+    goto done;
+  }
+  if ((! earleyRecognizer_acceptedb(earleyRecognizerp, &resultb)) || (resultb != acceptedb)) {
+    GENERICLOGGER_ERRORF(loggerp, "\"%s\": accepted should be %d", inputs, (int) acceptedb);
+    goto done;
+  }
+  if (rejectedi >= 0) {
+    if ((! earleyRecognizer_completeb(earleyRecognizerp)) || (! earleyRecognizer_exhaustedb(earleyRecognizerp, &resultb)) || (! resultb)) {
+      GENERICLOGGER_ERRORF(loggerp, "\"%s\": not exhausted after an earleme where nothing was read", inputs);
+      goto done;
+    }
+    if ((! earleyRecognizer_acceptedb(earleyRecognizerp, &resultb)) || resultb) {
+      GENERICLOGGER_ERRORF(loggerp, "\"%s\": accepted once exhausted", inputs);
+      goto done;
+    }
+  }
+
+  rcb = 1;
+
+ done:
+  if (earleyRecognizerp != NULL) {
+    earleyRecognizer_freev(earleyRecognizerp);
+  }
+  return rcb;
+}
+
+/****************************************************************************/
+static void *earleyTester_mallocp(void *userDatavp, size_t sizel)
+/****************************************************************************/
+{
+  earleyTesterAllocator_t *allocatorp = (earleyTesterAllocator_t *) userDatavp;
+
+  allocatorp->nAllocationl++;
+  return malloc(sizel);
+}
+
+/****************************************************************************/
+static void *earleyTester_reallocp(void *userDatavp, void *p, size_t sizel)
+/****************************************************************************/
+{
+  earleyTesterAllocator_t *allocatorp = (earleyTesterAllocator_t *) userDatavp;
+
+  allocatorp->nAllocationl++;
+  return realloc(p, sizel);
+}
+
+/****************************************************************************/
+static void earleyTester_freev(void *userDatavp, void *p)
+/****************************************************************************/
+{
+  (void) userDatavp;
+  free(p);
+}
@@ -0,0 +1,36 @@
+#ifndef EARLEYTESTER_H
+#define EARLEYTESTER_H
+
+#include "earley.h"
+
+/* Fixtures shared by the test programs */
+
+/* Symbols of the expression grammar */
+typedef struct earleyTesterExpression {
+  int Es;
+  int Rs;
+  int ns;
+  int ps;
+  int ts;
+  int as;
+} earleyTesterExpression_t;
+
+/* Memory hooks counting the allocations */
+typedef struct earleyTesterAllocator {
+  size_t nAllocationl;
+} earleyTesterAllocator_t;
+
+/* Sets the memory hooks of *earleyGrammarOptionp, counting in *allocatorp */
+void earleyTester_allocatorv(earleyGrammarOption_t *earleyGrammarOptionp, earleyTesterAllocator_t *allocatorp);
+
+/* Precomputed ambiguous E ::= E + E | E * E | n | R, with a right-recursive R ::= a R | a whose */
+/* LHS has the events rEventSeti. Returns NULL on failure, after logging it.                    */
+earleyGrammar_t *earleyTester_expressionp(genericLogger_t *loggerp, earleyGrammarOption_t *earleyGrammarOptionp, int rEventSeti, earleyTesterExpression_t *expressionp);
+
+/* Reads inputs, whose characters are mapped to terminals by symbolip, up to its end or up to the   */
+/* character at rejectedi: that one must be refused with ENOENT, leaving the recognizer unchanged, */
+/* and completing the earleme where nothing was read then exhausts the recognizer. What was read   */
+/* must be accepted or not, as acceptedb says. Returns 0 on mismatch, after logging it.            */
+short earleyTester_recognizeb(genericLogger_t *loggerp, earleyGrammar_t *earleyGrammarp, const int *symbolip, const char *inputs, int rejectedi, short acceptedb);
+
+#endif /* EARLEYTESTER_H */